@@ -30,4 +30,16 @@ bool dlu_drm_retrieve_input(dlu_drm_core *core, uint32_t *key_code);
 /* Get FD associated with all input events */
 int dlu_drm_retrieve_input_fd(dlu_drm_core *core);
 
+/**
+* Input-to-photon latency. dlu_drm_retrieve_input() remembers the timestamp of the
+* oldest event not yet consumed. Once a frame has been built from that input, tag the
+* buffer it was rendered into. dlu_drm_do_handle_event_core() reports the flip when the
+* buffer's page flip event comes in, tv_sec/tv_usec being the event's vblank timestamp.
+* Only flips scheduled with dlu_drm_do_page_flip() or dlu_drm_atomic_commit() are tracked.
+* Latencies go to the CPU profiler as DLU_PROF_INPUT_TO_PHOTON, so
+* dlu_prof_get_stats() gives the rolling distribution (needs dlu_prof_enable(true)).
+*/
+void dlu_drm_input_tag_frame(dlu_drm_core *core, uint32_t cur_bi);
+void dlu_drm_input_frame_shown(dlu_drm_core *core, uint32_t cur_bi, unsigned int tv_sec, unsigned int tv_usec);
+
 #endif
\ No newline at end of file
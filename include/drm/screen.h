@@ -31,6 +31,13 @@ bool dlu_drm_do_page_flip(dlu_drm_core *core, uint32_t cur_bi, void *user_data);
 
 int dlu_drm_do_handle_event(int fd, drmEventContext *ev);
 
+/**
+* Same as above on core->device.kmsfd, but page flip events are seen first:
+* the flipped buffer's frame is reported shown to the input latency tracker
+* (dlu_drm_input_frame_shown()) before ev's page flip handler runs.
+*/
+int dlu_drm_do_handle_event_core(dlu_drm_core *core, drmEventContext *ev);
+
 void *dlu_drm_gbm_bo_map(dlu_drm_core *core, uint32_t cur_bi, void **data, uint32_t flags);
 
 void dlu_drm_gbm_bo_unmap(struct gbm_bo *bo, void *map_data);
@@ -41,6 +48,41 @@ bool dlu_drm_do_atomic_req(dlu_drm_core *core, uint32_t cur_bd, drmModeAtomicReq
 
 int dlu_drm_do_atomic_commit(dlu_drm_core *core, drmModeAtomicReq *req, bool allow_modeset);
 
+/**
+* Stateful atomic commit builder. Remembers what the last successful commit set
+* on each output and only adds properties that changed, so a plain flip is a
+* single FB_ID property. A frame goes:
+* dlu_drm_atomic_begin(), dlu_drm_atomic_add_output() per buffer to show, dlu_drm_atomic_commit()
+* The request lives in core->atomic and is reused, begin rewinds it to its base cursor.
+*/
+bool dlu_drm_atomic_begin(dlu_drm_core *core);
+
+/**
+* Properties added to core->atomic.req so far are kept and sent with every commit,
+* ALLOW_MODESET too if any of them needed it
+*/
+void dlu_drm_atomic_set_base(dlu_drm_core *core);
+
+/**
+* Queue the changes needed to scan out buffer cur_bd on the output it was created for.
+* On failure the request is left as it was before the call.
+*/
+bool dlu_drm_atomic_add_output(dlu_drm_core *core, uint32_t cur_bd);
+
+/**
+* Nonblocking commit with a page flip event, ALLOW_MODESET is only set when
+* MODE_ID, ACTIVE or the connector's CRTC_ID are queued. On failure nothing is
+* recorded as committed, so the next frame sends the same changes again.
+*/
+int dlu_drm_atomic_commit(dlu_drm_core *core);
+
+/**
+* Forget what was committed on cur_od, the next commit sends every property.
+* Needed when KMS state changed elsewhere (VT switch, another master).
+* dlu_drm_do_modeset() calls it on its own.
+*/
+void dlu_drm_atomic_invalidate(dlu_drm_core *core, uint32_t cur_od);
+
 drmModeAtomicReq *dlu_drm_do_atomic_alloc();
 void dlu_drm_do_atomic_free(drmModeAtomicReq *req);
 
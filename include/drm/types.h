@@ -152,6 +152,9 @@ typedef struct _dlu_drm_core {
 
     /* true if a buffer (scan out buffer) is currently owned by KMS. */ 
     bool in_use;
+
+    /* Timestamp (ns) of the oldest input event the frame in this buffer consumed, 0 if none */
+    uint64_t input_ns;
   
     /* Generally four (BO, framebuffer, image) planes */
     uint32_t num_planes;
@@ -202,8 +205,41 @@ typedef struct _dlu_drm_core {
       struct drm_prop_info crtc[DLU_DRM_CRTC__CNT];
       struct drm_prop_info conn[DLU_DRM_CONNECTOR__CNT];
     } props;
+
+    /**
+    * Atomic commit builder state, see dlu_drm_atomic_add_output()
+    * committed: Property values the last successful dlu_drm_atomic_commit() left on this output
+    * pending: Values queued in core->atomic.req, they become committed once it succeeds
+    * valid: committed matches the kernel's state, when false every property is sent
+    * queued: Output has properties in core->atomic.req
+    */
+    struct _atomic_state {
+      uint64_t plane[DLU_DRM_PLANE__CNT];
+      uint64_t crtc[DLU_DRM_CRTC__CNT];
+      uint64_t conn[DLU_DRM_CONNECTOR__CNT];
+    } committed, pending;
+    bool valid, queued;
+
+    /**
+    * queued_bi: Buffer dlu_drm_atomic_add_output() queued on this output
+    * flip_bi: Buffer whose page flip event hasn't arrived yet, UINT32_MAX if none
+    */
+    uint32_t queued_bi, flip_bi;
   } *output_data;
 
+  /**
+  * Atomic request reused from frame to frame, see dlu_drm_atomic_begin()
+  * base: Cursor req is rewound to, properties past it only last one commit
+  * modeset: A queued property requires DRM_MODE_ATOMIC_ALLOW_MODESET
+  * base_modeset: modeset for the properties before base, begin starts from it
+  */
+  struct _atomic {
+    drmModeAtomicReq *req;
+    int base;
+    bool modeset;
+    bool base_modeset;
+  } atomic;
+
   struct _device {
     /* KMS API Device node */
     uint32_t kmsfd;
@@ -211,6 +247,9 @@ typedef struct _dlu_drm_core {
     uint32_t vtfd; /* Virtual Terminal File Descriptor */
     uint32_t bkbm; /* Backup Keyboard mode */
 
+    /* Page flip events carry CLOCK_MONOTONIC timestamps (DRM_CAP_TIMESTAMP_MONOTONIC) */
+    bool ts_monotonic;
+
     /* A GBM device is used to create gbm_bo (it's a buffer allocator) */
     struct gbm_device *gbm_device;
   } device;
@@ -228,6 +267,9 @@ typedef struct _dlu_drm_core {
   struct _input {
     struct udev *udev;
     struct libinput *inp;
+
+    /* Timestamp (ns) of the oldest event not yet tagged onto a frame, 0 if none */
+    uint64_t pending_ns;
   } input;
 } dlu_drm_core;
 
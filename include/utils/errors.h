@@ -25,9 +25,10 @@
 #ifndef DLU_UTILS_ERRORS_H
 #define DLU_UTILS_ERRORS_H
 
-void _show_err_msg(uint32_t dlu_err, int vkerr, const char *dlu_msg);
+void _show_err_msg(uint32_t dlu_err, int vkerr, const char *dlu_msg, dlu_log_module module);
 
+/* Filtered as the module of the file it's used in, not as utils where the message is built */
 #define PERR(dlu_err, vkerr, dlu_msg) \
-  _show_err_msg(dlu_err, vkerr, dlu_msg);
+  _show_err_msg(dlu_err, vkerr, dlu_msg, DLU_LOG_MODULE);
 
 #endif
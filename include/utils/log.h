@@ -29,12 +29,66 @@ void _dlu_log_me(dlu_log_type type, FILE *stream, const char *fmt, ...);
 void _dlu_print_me(dlu_log_type type, const char *fmt, ...);
 const char *_dlu_strip_path(const char *filepath);
 
-/* Macros defined to help better structure the message */
+/**
+* dlu_log_me()/dlu_log_err() only copy their arguments into a lock-free ring,
+* a background thread formats and writes them in batches. Messages that don't
+* fit in a ring slot or arrive while the ring is full are written on the
+* caller's thread, after the queued ones.
+* The ring keeps the fmt pointer and only formats it later on the writer
+* thread, so fmt must be a string literal (or otherwise outlive the message).
+* The macros below paste "[%s:%d] " in front of fmt, which already makes any
+* non-literal format fail to compile, callers of _dlu_log_me() are on their own.
+*/
+void dlu_log_async(bool enable); /* On by default, off writes every message synchronously */
+void dlu_log_flush(void); /* Blocks until every queued message has been written */
+
+/**
+* Messages below DLU_LOG_MIN_LEVEL (meson -Dlog_level=) are compiled out, the
+* rest are checked against the runtime level of the module they come from.
+* module: DLU_LOG_MODULE_MAX sets every module
+*/
+void dlu_log_set_level(dlu_log_module module, dlu_log_level level);
+bool _dlu_log_ratelimit(uint64_t *last, uint64_t interval_ns);
+extern unsigned char _dlu_log_levels[DLU_LOG_MODULE_MAX];
+
+#ifndef DLU_LOG_MIN_LEVEL
+#define DLU_LOG_MIN_LEVEL DLU_LOG_LEVEL_INFO
+#endif
+
+#ifndef DLU_LOG_MODULE
+#define DLU_LOG_MODULE DLU_LOG_APP
+#endif
+
+#define DLU_LOG_SEVERITY(log_type) \
+  ((log_type) == DLU_DANGER ? DLU_LOG_LEVEL_DANGER : (log_type) == DLU_WARNING ? DLU_LOG_LEVEL_WARNING : \
+   (log_type) == DLU_SUCCESS ? DLU_LOG_LEVEL_SUCCESS : (log_type) == DLU_DEBUG ? DLU_LOG_LEVEL_DEBUG : DLU_LOG_LEVEL_INFO)
+
+#define dlu_log_enabled(log_type) \
+  (DLU_LOG_SEVERITY(log_type) >= DLU_LOG_MIN_LEVEL && \
+   DLU_LOG_SEVERITY(log_type) >= __atomic_load_n(&_dlu_log_levels[DLU_LOG_MODULE], __ATOMIC_RELAXED))
+
+/* Macros defined to help better structure the message, fmt has to be a string literal */
 #define dlu_log_me(log_type, fmt, ...) \
-  _dlu_log_me(log_type, stdout, "[%s:%d] " fmt, _dlu_strip_path(__FILE__), __LINE__, ##__VA_ARGS__)
+  ((dlu_log_enabled(log_type)) ? _dlu_log_me(log_type, stdout, "[%s:%d] " fmt, _dlu_strip_path(__FILE__), __LINE__, ##__VA_ARGS__) : (void) 0)
 
 #define dlu_log_err(log_type, fmt, ...) \
-  _dlu_log_me(log_type, stderr, "[%s:%d] " fmt, _dlu_strip_path(__FILE__), __LINE__, ##__VA_ARGS__)
+  ((dlu_log_enabled(log_type)) ? _dlu_log_me(log_type, stderr, "[%s:%d] " fmt, _dlu_strip_path(__FILE__), __LINE__, ##__VA_ARGS__) : (void) 0)
+
+/* For per-frame call sites: at most one message every interval_ms from this line */
+#define dlu_log_every(interval_ms, log_type, fmt, ...) \
+  do { \
+    static uint64_t _dlu_log_last = 0; \
+    if (dlu_log_enabled(log_type) && _dlu_log_ratelimit(&_dlu_log_last, (uint64_t) (interval_ms) * 1000000)) \
+      _dlu_log_me(log_type, stdout, "[%s:%d] " fmt, _dlu_strip_path(__FILE__), __LINE__, ##__VA_ARGS__); \
+  } while (0)
+
+/* Only the first message from this line is ever logged */
+#define dlu_log_once(log_type, fmt, ...) \
+  do { \
+    static bool _dlu_log_done = false; \
+    if (dlu_log_enabled(log_type) && !__atomic_exchange_n(&_dlu_log_done, true, __ATOMIC_RELAXED)) \
+      _dlu_log_me(log_type, stdout, "[%s:%d] " fmt, _dlu_strip_path(__FILE__), __LINE__, ##__VA_ARGS__); \
+  } while (0)
 
 #define dlu_print_msg(log_type, msg, ...) \
   _dlu_print_me(log_type, msg, ##__VA_ARGS__)
@@ -0,0 +1,85 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright (c) 2019-2020 Vincent Davis Jr.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*/
+
+#ifndef DLU_UTILS_PROF_H
+#define DLU_UTILS_PROF_H
+
+/**
+* CPU frame-phase profiler. Zones are written to a per-thread lock-free ring
+* with nanosecond timestamps from dlu_hrnst(), and their durations feed a
+* rolling window per phase. Everything is a no-op until dlu_prof_enable(true).
+* Zone names must outlive the profiler (string literals).
+*/
+typedef struct _dlu_prof_zone {
+  dlu_prof_phase phase;
+  const char *name;
+  uint64_t start;
+} dlu_prof_zone;
+
+typedef struct _dlu_prof_stats {
+  uint64_t count; /* Samples in the window */
+  uint64_t p50; /* nanoseconds */
+  uint64_t p99;
+  uint64_t max;
+} dlu_prof_stats;
+
+void dlu_prof_enable(bool enable);
+bool dlu_prof_enabled(void);
+
+dlu_prof_zone dlu_prof_zone_begin(dlu_prof_phase phase, const char *name);
+void dlu_prof_zone_end(dlu_prof_zone *zone);
+
+/* Record a zone measured by other means, start/end in dlu_hrnst() nanoseconds */
+void dlu_prof_record(dlu_prof_phase phase, const char *name, uint64_t start, uint64_t end);
+
+/**
+* For phases that begin and end in different functions (i.e recording spans
+* dlu_exec_begin_cmd_buffs() to dlu_exec_stop_cmd_buffs()). One open mark per phase per thread
+*/
+void dlu_prof_mark_begin(dlu_prof_phase phase);
+void dlu_prof_mark_end(dlu_prof_phase phase, const char *name);
+
+/* p50/p99/max over the most recent samples of phase */
+bool dlu_prof_get_stats(dlu_prof_phase phase, dlu_prof_stats *stats);
+
+/**
+* Write every zone still held in the per-thread rings to path as Chrome
+* trace-event JSON (load in chrome://tracing or ui.perfetto.dev)
+*/
+bool dlu_prof_export_chrome(const char *path);
+
+/**
+* Free per-thread rings. No thread may be recording zones at this point, threads
+* that record again afterwards get a fresh ring instead of their freed one
+*/
+void dlu_prof_freeup(void);
+
+#define DLU_PROF_CAT_(a, b) a##b
+#define DLU_PROF_CAT(a, b) DLU_PROF_CAT_(a, b)
+
+/* Time the rest of the enclosing scope */
+#define DLU_PROF_ZONE(phase, name) \
+  dlu_prof_zone DLU_PROF_CAT(_dlu_prof_zone_, __LINE__) __attribute__((cleanup(dlu_prof_zone_end))) = dlu_prof_zone_begin(phase, name)
+
+#endif
@@ -33,9 +33,31 @@ typedef enum _dlu_log_type {
   DLU_INFO    = 0x0003,
   DLU_WARNING = 0x00004,
   DLU_RESET   = 0x0005,
+  DLU_DEBUG   = 0x0006,
   DLU_MAX_LOG_ENUM = 0xFFFF
 } dlu_log_type;
 
+/* Severity levels dlu_log_type maps onto, for filtering see dlu_log_set_level() */
+typedef enum _dlu_log_level {
+  DLU_LOG_LEVEL_DEBUG = 0x0000,
+  DLU_LOG_LEVEL_INFO = 0x0001,    /* DLU_INFO, DLU_NONE */
+  DLU_LOG_LEVEL_SUCCESS = 0x0002,
+  DLU_LOG_LEVEL_WARNING = 0x0003,
+  DLU_LOG_LEVEL_DANGER = 0x0004,
+  DLU_LOG_LEVEL_OFF = 0x0005
+} dlu_log_level;
+
+/* Each static library logs as its own module, apps log as DLU_LOG_APP */
+typedef enum _dlu_log_module {
+  DLU_LOG_APP = 0x0000,
+  DLU_LOG_UTILS = 0x0001,
+  DLU_LOG_VKCOMP = 0x0002,
+  DLU_LOG_DRM = 0x0003,
+  DLU_LOG_SPIRV = 0x0004,
+  DLU_LOG_MATH = 0x0005,
+  DLU_LOG_MODULE_MAX = 0x0006
+} dlu_log_module;
+
 typedef enum _dlu_block_type {
   DLU_LARGE_BLOCK_PRIV = 0x0000,
   DLU_SMALL_BLOCK_PRIV = 0x0001,
@@ -43,6 +65,19 @@ typedef enum _dlu_block_type {
   DLU_SMALL_BLOCK_SHARED = 0x0004
 } dlu_block_type;
 
+/* Frame phases tracked by the CPU profiler, see dlu_prof_*() */
+typedef enum _dlu_prof_phase {
+  DLU_PROF_ACQUIRE = 0x0000,
+  DLU_PROF_RECORD = 0x0001,
+  DLU_PROF_SUBMIT = 0x0002,
+  DLU_PROF_PRESENT = 0x0003,
+  DLU_PROF_ATOMIC_COMMIT = 0x0004,
+  DLU_PROF_INPUT = 0x0005,
+  DLU_PROF_USER = 0x0006,
+  DLU_PROF_INPUT_TO_PHOTON = 0x0007, /* Input event to the vblank that displayed it, see dlu_drm_input_frame_shown() */
+  DLU_PROF_PHASE_MAX = 0x0008
+} dlu_prof_phase;
+
 typedef enum _dlu_data_type {
   DLU_SC_DATA = 0x0000,
   DLU_GP_DATA = 0x0001,
@@ -104,6 +139,11 @@ typedef enum _dlu_err_msg_type {
   DLU_VKCOMP_CMD_POOL = 0x010C,
   DLU_VKCOMP_CMD_BUFFS = 0x010D,
   DLU_VKCOMP_DEVICE_NOT_ASSOC = 0x010E,
+  DLU_VKCOMP_PIPE_CACHE = 0x010F,
+  DLU_VKCOMP_DESC_ALLOC = 0x0110,
+  DLU_VKCOMP_BINDLESS = 0x0111,
+  DLU_VKCOMP_GPU_PROF = 0x0112,
+  DLU_VKCOMP_COMPOSITOR = 0x0113,
   DLU_BUFF_NOT_ALLOC = 0x0FFC,
   DLU_OP_NOT_PERMITED = 0x0FFD,
   DLU_ALLOC_FAILED = 0x0FFE,
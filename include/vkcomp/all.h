@@ -35,6 +35,18 @@
 #include "utils.h"
 #include "vlayer.h"
 #include "vk_calls.h"
+#include "cache.h"
+#include "pcache.h"
+#include "pipeline.h"
+#include "desc.h"
+#include "bindless.h"
+#include "gprof.h"
+#include "swapchain.h"
+#include "composite.h"
+#include "headless.h"
+#include "msaa.h"
+#include "defer.h"
+#include "frame.h"
 
 #ifdef INAPI_CALLS
 #include "device.h"
@@ -58,6 +70,11 @@
     var = (PFN_vk##func) vkGetDeviceProcAddr(dev, "vk" #func); \
     if (!var) PERR(DLU_DR_DEVICE_PROC_ADDR_ERR, 0, #func); \
   } while(0);
+
+/* Dispatch table of a logical device, or of the one a command pool/swap chain belongs to */
+#define DLU_VK(app, ldi) ((app)->ld_data[(ldi)].vk)
+#define DLU_CMD_VK(app, cur_pool) DLU_VK(app, (app)->cmd_data[(cur_pool)].ldi)
+#define DLU_SC_VK(app, cur_scd) DLU_VK(app, (app)->sc_data[(cur_scd)].ldi)
 #endif
 
 #endif
@@ -0,0 +1,78 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright (c) 2019-2020 Vincent Davis Jr.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*/
+
+#ifndef DLU_VKCOMP_BINDLESS_H
+#define DLU_VKCOMP_BINDLESS_H
+
+/**
+* Create the bindless texture table (app->bindless), one descriptor set holding
+* an array of up to capacity combined image samplers at binding 0. The logical
+* device must have VK_EXT_descriptor_indexing enabled along with the
+* descriptorBindingPartiallyBound, descriptorBindingSampledImageUpdateAfterBind,
+* runtimeDescriptorArray and shaderSampledImageArrayNonUniformIndexing features,
+* dlu_create_logical_device() turns these on when the device supports them.
+* In the shader:
+*   #extension GL_EXT_nonuniform_qualifier : require
+*   layout(set = N, binding = 0) uniform sampler2D textures[];
+*   o_Color = texture(textures[nonuniformEXT(v_TexID)], v_TexCoord);
+* v_TexID comes from a per-instance attribute (or push constant) holding text_data[i].slot
+*/
+VkResult dlu_create_bindless_table(vkcomp *app, uint32_t cur_ld, uint32_t capacity, VkShaderStageFlags stageFlags);
+
+/**
+* Layout info for the table, pass it to dlu_create_pipeline_layout() at the set
+* number the shaders use. Pipeline layouts created from it are compatible with the table
+*/
+const VkDescriptorSetLayoutCreateInfo *dlu_get_bindless_layout_info(vkcomp *app);
+
+/**
+* Write text_data[cur_tex] (view + sampler) into a free slot of the table.
+* Safe while the table is bound in command buffers that are pending execution,
+* as long as those don't sample the slot being written. Slot stored in text_data[cur_tex].slot
+*/
+VkResult dlu_bindless_register_texture(vkcomp *app, uint32_t cur_tex, VkImageLayout imageLayout);
+
+/**
+* Give text_data[cur_tex]'s slot back to the table. The descriptor isn't cleared,
+* partially bound arrays only require that shaders never sample it again.
+* The slot is only handed out again once the frame being recorded now has
+* retired, see dlu_defer_end_frame()
+*/
+void dlu_bindless_release_texture(vkcomp *app, uint32_t cur_tex);
+
+/* Bind the whole table once, every registered texture is then reachable through its slot */
+void dlu_bind_bindless_table(
+  vkcomp *app,
+  uint32_t cur_pool,
+  uint32_t cur_buff,
+  uint32_t cur_gpd,
+  VkPipelineBindPoint pipelineBindPoint,
+  uint32_t set
+);
+
+#ifdef INAPI_CALLS
+void dlu_freeup_bindless_table(vkcomp *app);
+#endif
+
+#endif
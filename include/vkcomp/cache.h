@@ -0,0 +1,112 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright (c) 2019-2020 Vincent Davis Jr.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*/
+
+#ifndef DLU_VKCOMP_CACHE_H
+#define DLU_VKCOMP_CACHE_H
+
+/**
+* Destroy every cached VkFramebuffer that references view. Called automatically
+* by dlu_vk_destroy(DLU_DESTROY_VK_IMAGE_VIEW) and dlu_freeup_sc(), call this
+* yourself if you destroy image views by other means.
+*/
+void dlu_cache_evict_image_view(vkcomp *app, VkImageView view);
+
+/**
+* Destroy a cached VkRenderPass along with every cached VkFramebuffer created
+* against it. Returns false if render_pass isn't owned by the cache
+*/
+bool dlu_cache_evict_render_pass(vkcomp *app, VkRenderPass render_pass);
+
+/* Destroy a cached VkFramebuffer. Returns false if fb isn't owned by the cache */
+bool dlu_cache_evict_framebuffer(vkcomp *app, VkFramebuffer fb);
+
+/**
+* Returns a VkPipeline for info from the pipeline state cache, only compiling
+* on a miss. The key covers every fixed function state, the SPIR-V of each stage
+* (module handle for modules not made by dlu_create_shader_module()), entry points,
+* specialization constants, layout, render pass and subpass (pNext chains are ignored).
+* New variants of an already cached family become derivatives of the family's
+* first pipeline unless info sets its own base. dlu_create_graphics_pipelines() goes
+* through here, the batch, parallel and async variants don't. The returned pipeline is owned by the cache and stays valid after
+* its shader modules are destroyed. Not thread safe.
+*/
+VkResult dlu_cache_graphics_pipeline(vkcomp *app, uint32_t cur_ld, const VkGraphicsPipelineCreateInfo *info, VkPipeline *pipeline);
+
+/**
+* Must happen before module/layout is destroyed, handles can be recycled. Done for you
+* by dlu_vk_destroy() and dlu_freeup_sc(). A module from dlu_create_shader_module() only
+* has its SPIR-V hash forgotten, pipelines keyed by any other module or by layout are dropped.
+*/
+void dlu_cache_evict_shader_module(vkcomp *app, VkShaderModule module);
+void dlu_cache_evict_pipeline_layout(vkcomp *app, VkPipelineLayout layout);
+
+/* Destroy a cached VkPipeline. Returns false if pipeline isn't owned by the cache */
+bool dlu_cache_evict_pipeline(vkcomp *app, VkPipeline pipeline);
+
+/**
+* Reference counted lookups, identical create infos share one handle. Every
+* successful call takes a reference that must be given back with the matching
+* dlu_cache_release_*(). Create infos with pNext chains the cache can't key
+* (anything but descriptor indexing binding flags) bypass the cache.
+* Cached pipeline layouts hold a reference on cached set layouts they use.
+*/
+VkResult dlu_cache_sampler(vkcomp *app, uint32_t cur_ld, const VkSamplerCreateInfo *create_info, VkSampler *sampler);
+VkResult dlu_cache_desc_set_layout(vkcomp *app, uint32_t cur_ld, const VkDescriptorSetLayoutCreateInfo *create_info, VkDescriptorSetLayout *layout);
+VkResult dlu_cache_pipeline_layout(vkcomp *app, uint32_t cur_ld, const VkPipelineLayoutCreateInfo *create_info, VkPipelineLayout *layout);
+
+/**
+* Drop a reference, the handle is destroyed with the last one. Releasing a
+* pipeline layout evicts cached pipelines built with it. Returns false if the
+* handle isn't owned by the cache (caller should destroy it)
+*/
+bool dlu_cache_release_sampler(vkcomp *app, VkSampler sampler);
+bool dlu_cache_release_desc_set_layout(vkcomp *app, VkDescriptorSetLayout layout);
+bool dlu_cache_release_pipeline_layout(vkcomp *app, VkPipelineLayout layout);
+
+#ifdef INAPI_CALLS
+#define DLU_HASH_SEED 0xcbf29ce484222325ULL
+
+/* FNV-1a, used to hash vulkan create info structs */
+uint64_t dlu_hash_bytes(uint64_t hash, const void *data, size_t size);
+
+/* Remember module's SPIR-V hash, called by dlu_create_shader_module() */
+void dlu_cache_register_shader_module(vkcomp *app, uint32_t cur_ld, VkShaderModule module, const void *code, size_t code_size);
+
+/**
+* Serialize info into key (size only when key is NULL), the pipeline state cache's key.
+* family_size is set to the length of the leading stages/layout/render pass/subpass part.
+*/
+size_t dlu_cache_pso_key(vkcomp *app, uint32_t cur_ld, unsigned char *key, const VkGraphicsPipelineCreateInfo *info, size_t *family_size);
+
+/* Return a cached VkRenderPass matching create_info, create one on a miss */
+VkResult dlu_cache_render_pass(vkcomp *app, uint32_t cur_ld, const VkRenderPassCreateInfo *create_info, VkRenderPass *render_pass);
+
+/* Return a cached VkFramebuffer matching create_info, create one on a miss */
+VkResult dlu_cache_framebuffer(vkcomp *app, uint32_t cur_ld, const VkFramebufferCreateInfo *create_info, VkFramebuffer *fb);
+
+/* Destroy all cached objects */
+void dlu_cache_freeup(vkcomp *app);
+#endif
+
+#endif
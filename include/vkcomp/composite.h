@@ -0,0 +1,122 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright (c) 2019-2020 Vincent Davis Jr.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*/
+
+#ifndef DLU_VKCOMP_COMPOSITE_H
+#define DLU_VKCOMP_COMPOSITE_H
+
+/**
+* Compute compositing back end, an alternative to drawing one blended quad per
+* surface. Surfaces are binned into tile x tile pixel lists on the CPU and a single
+* dispatch blends each tile's list in registers, so every output pixel is written
+* once no matter how many translucent surfaces overlap it.
+* Surfaces sample textures through the bindless table, which must exist (created
+* with VK_SHADER_STAGE_COMPUTE_BIT) before the compositor.
+*/
+
+/**
+* GLSL source of the compositor's compute shader. Compile it with
+* dlu_compile_to_spirv(VK_SHADER_STAGE_COMPUTE_BIT, ...) and dlu_create_shader_module()
+*/
+const char *dlu_comp_shader_source(void);
+
+/**
+* frame_count: Number of frames in flight, each gets its own surface/tile lists
+* max_surfaces: Max dlu_comp_add_surface() calls per frame
+* max_extent: Largest output the compositor will be asked to fill
+* format: Format of the images dlu_comp_record() targets. R8G8B8A8_UNORM with storage
+* support is written by the shader directly, the target then needs VK_IMAGE_USAGE_STORAGE_BIT.
+* Any other format is blitted to from an intermediate rgba8 image, the target then
+* needs VK_IMAGE_USAGE_TRANSFER_DST_BIT and the format VK_FORMAT_FEATURE_BLIT_DST_BIT
+* tile: Tile edge in pixels (i.e 16), must fit in maxComputeWorkGroupInvocations squared
+* module: Compiled dlu_comp_shader_source(), may be destroyed after this returns
+*/
+VkResult dlu_create_compositor(
+  vkcomp *app,
+  uint32_t cur_ld,
+  uint32_t frame_count,
+  uint32_t max_surfaces,
+  VkExtent2D max_extent,
+  VkFormat format,
+  uint32_t tile,
+  VkShaderModule module
+);
+
+/* Start a new surface list for frame, covering an output of extent */
+VkResult dlu_comp_begin_frame(vkcomp *app, uint32_t frame, VkExtent2D extent);
+
+/**
+* Add a surface on top of everything added before it this frame (back to front)
+* x, y, width, height: Output rectangle in pixels, the texture is stretched over it
+* cur_tex: text_data index, must be registered with dlu_bindless_register_texture()
+* opaque: Surface and texture have no transparency. Tiles it fully covers drop
+* everything beneath it, which is where most overdraw goes away
+* A tile holds DLU_COMP_TILE_SURFACES surfaces, past that the whole tile is left to
+* the raster path, see dlu_comp_raster_tiles()
+*/
+VkResult dlu_comp_add_surface(
+  vkcomp *app,
+  float x,
+  float y,
+  float width,
+  float height,
+  float opacity,
+  uint32_t cur_tex,
+  VkBool32 opaque
+);
+
+/**
+* Tiles of the current frame holding more surfaces than a tile list fits. The
+* compositor leaves their pixels alone, after dlu_comp_record() the caller draws
+* each rectangle with its raster path: scissored to it, cleared to the clear
+* color, then every surface of the frame blended back to front.
+* Returns the count, rects points at app->composite.raster_tiles
+*/
+uint32_t dlu_comp_raster_tiles(vkcomp *app, const VkRect2D **rects);
+
+/**
+* Record compositing the current frame into target, including the layout
+* transitions. Prior contents are discarded, so the frame's extent should match the target.
+* Timed as the "composite" zone when the GPU profiler is running, compare it against
+* the zone around the raster path's render pass for the same scene.
+* Submit waiting for a swapchain image at VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT
+* target, target_view: Image to fill. The view is only used when the shader writes target directly
+* finalLayout: Layout target is left in (i.e VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, or
+* VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL when raster tiles are drawn next)
+* clear: Color of pixels no surface covers
+*/
+void dlu_comp_record(
+  vkcomp *app,
+  uint32_t cur_pool,
+  uint32_t cur_buff,
+  VkImage target,
+  VkImageView target_view,
+  VkImageLayout finalLayout,
+  VkClearColorValue clear
+);
+
+#ifdef INAPI_CALLS
+void dlu_freeup_compositor(vkcomp *app);
+#endif
+
+#endif
@@ -44,9 +44,24 @@ VkResult dlu_create_instance(
 */
 VkResult dlu_create_vkwayland_surfaceKHR(vkcomp *app, void *wl_display, void *wl_surface);
 
+/**
+* Scores every physical device against criteria (see dlu_pd_criteria) and
+* keeps the best one: user preference, then the DRM node match, then device
+* type, then dedicated compute/transfer families, then device local memory.
+* device_props/device_feats are filled for the device picked.
+*/
+VkResult dlu_select_physical_device(
+  vkcomp *app,
+  uint32_t cur_pd,
+  const dlu_pd_criteria *criteria,
+  VkPhysicalDeviceProperties *device_props,
+  VkPhysicalDeviceFeatures *device_feats
+);
+
 /**
 * This function will select the physical device of
-* your choosing based off of VkPhysicalDeviceType
+* your choosing based off of VkPhysicalDeviceType.
+* When several match, the best scored one is used.
 */
 VkResult dlu_create_physical_device(
   vkcomp *app,
@@ -60,7 +75,8 @@ VkResult dlu_create_physical_device(
 * Almost every operation in Vulkan, from submitting command buffers
 * to presenting images to a surface, requires commands to be submitted
 * to a hardware queue. This will create multiple queue family indices
-* that are supported by a device.
+* that are supported by a device. Compute and transfer families that
+* don't also do graphics are preferred, they run alongside rendering.
 */
 VkBool32 dlu_create_queue_families(vkcomp *app, uint32_t cur_pd, VkQueueFlagBits vkqfbits);
 
@@ -69,6 +85,12 @@ VkBool32 dlu_create_queue_families(vkcomp *app, uint32_t cur_pd, VkQueueFlagBits
 * Set up a logical device to interface with your physical device
 * This function is also used to set Vulkan Device Level Extensions
 * that entail what a device does
+* Enabling both VK_KHR_present_id and VK_KHR_present_wait also turns on their
+* features, so dlu_wait_present_latency() can wait on actual presentation.
+* Either is left out if the device doesn't support it, and the features are only
+* turned on when vkGetPhysicalDeviceFeatures2 reports both, fences are used otherwise.
+* With VK_EXT_descriptor_indexing the features bindless textures need are turned on
+* when supported, see dlu_create_bindless_table()
 */
 VkResult dlu_create_logical_device(
   vkcomp *app,
@@ -123,6 +145,26 @@ VkResult dlu_create_depth_buff(
   VkMemoryPropertyFlags requirements_mask
 );
 
+/**
+* Creates attachments that only need to exist for the duration of a render pass
+* and binds all of them to a single VkDeviceMemory object. Attachments given the
+* same alias_groups[i] value alias each other (must not be alive at the same time
+* within a frame, initialLayout should be VK_IMAGE_LAYOUT_UNDEFINED). If alias_groups
+* is NULL every attachment gets its own region of the allocation.
+* Attachment only images get VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT. When all of
+* them qualify VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT memory is preferred, so
+* tile-based GPUs may never back them with real memory.
+* alias_groups values must be less than count
+*/
+VkResult dlu_create_transient_attachments(
+  vkcomp *app,
+  uint32_t cur_scd,
+  uint32_t count,
+  VkImageCreateInfo *img_infos,
+  VkImageViewCreateInfo *ivis,
+  const uint32_t *alias_groups
+);
+
 /**
 * Function creates buffers like a uniform buffer so that shaders can access
 * in a read-only fashion constant parameter data. Function also
@@ -249,6 +291,27 @@ VkResult dlu_create_desc_set_layout(
   VkDescriptorSetLayoutCreateInfo *desc_set_info
 );
 
+/**
+* Create a descriptor update template for layout cur_dl, so a whole set can be
+* written from one packed struct with dlu_update_desc_template()/dlu_push_desc_template().
+* Without VK_KHR_descriptor_update_template the entries are kept and
+* dlu_update_desc_template() expands them into vkUpdateDescriptorSets, push
+* descriptor templates still need the extension. Entries describe where each binding
+* lives in the struct (offset/stride), see dlu_write_desc_template_entry()
+* cur_gpd/set: Only used for VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR
+*/
+VkResult dlu_create_desc_template(
+  vkcomp *app,
+  uint32_t cur_dd,
+  uint32_t cur_dl,
+  uint32_t descriptorUpdateEntryCount,
+  const VkDescriptorUpdateTemplateEntryKHR *pDescriptorUpdateEntries,
+  VkDescriptorUpdateTemplateTypeKHR templateType,
+  VkPipelineBindPoint pipelineBindPoint,
+  uint32_t cur_gpd,
+  uint32_t set
+);
+
 /* Inorder to allocate descriptor sets you must create a descriptor pool */
 VkResult dlu_create_desc_pool(
   vkcomp *app,
@@ -0,0 +1,70 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright (c) 2019-2020 Vincent Davis Jr.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*/
+
+#ifndef DLU_VKCOMP_DEFER_H
+#define DLU_VKCOMP_DEFER_H
+
+/**
+* Same as dlu_vk_destroy(), but the object is only destroyed once the GPU
+* is done with the frame currently being recorded, so nothing has to wait
+* for the queue to go idle. Frames end with every dlu_queue_graphics_queue()
+* call, work submitted by other means can be covered with dlu_defer_end_frame()
+* or dlu_defer_complete(). Buffers, memory, images, views, pipelines and
+* every other dlu_destroy_type except DLU_DESTROY_VK_LOGIC_DEVICE are accepted.
+*/
+VkResult dlu_defer_destroy(dlu_destroy_type type, vkcomp *app, uint32_t cur_ld, void *data);
+
+/* Frame value destroy requests made now are tagged with */
+uint64_t dlu_defer_frame(vkcomp *app, uint32_t cur_ld);
+
+/**
+* Ends the frame being recorded, fence signals once its work is done.
+* A fence that gets reused must have been waited on first, so seeing it again
+* retires the frame it used to cover. Also calls dlu_defer_collect().
+*/
+void dlu_defer_end_frame(vkcomp *app, uint32_t cur_ld, VkFence fence);
+
+/**
+* Compute queue work submitted during the frame being recorded. The frame only
+* retires once fence has signaled too, dlu_queue_compute_queue() calls this.
+* Compute work the graphics submission waits on is already covered by its fence.
+*/
+void dlu_defer_compute_fence(vkcomp *app, uint32_t cur_ld, VkFence fence);
+
+/**
+* Marks every frame up to and including frame as done, for callers that track
+* GPU progress themselves (timeline semaphore values, vkDeviceWaitIdle()).
+* Also calls dlu_defer_collect().
+*/
+void dlu_defer_complete(vkcomp *app, uint32_t cur_ld, uint64_t frame);
+
+/* Polls in flight fences and destroys every object the GPU is done with */
+void dlu_defer_collect(vkcomp *app, uint32_t cur_ld);
+
+#ifdef INAPI_CALLS
+/* Destroys everything still queued, the device must be idle */
+void dlu_freeup_deferred(vkcomp *app, uint32_t cur_ld);
+#endif
+
+#endif
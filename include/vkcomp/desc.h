@@ -0,0 +1,66 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright (c) 2019-2020 Vincent Davis Jr.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*/
+
+#ifndef DLU_VKCOMP_DESC_H
+#define DLU_VKCOMP_DESC_H
+
+/**
+* Setup the growable descriptor allocator (app->desc_alloc)
+* frame_count: Number of independent pool chains, usually one per frame in flight.
+*              Use an extra frame that's never reset for long lived sets
+* sets_per_pool: How many sets each newly chained pool can hold
+*/
+VkResult dlu_create_desc_allocator(vkcomp *app, uint32_t cur_ld, uint32_t frame_count, uint32_t sets_per_pool);
+
+/**
+* Register a layout with the allocator. Pools in the bucket are sized from
+* the bindings in layout_info, so allocations never fail due to a type mix
+* meant for some other layout. bucket is set to the index to allocate from.
+* Registering the same layout twice returns the existing bucket.
+*/
+VkResult dlu_create_desc_bucket(
+  vkcomp *app,
+  VkDescriptorSetLayout layout,
+  const VkDescriptorSetLayoutCreateInfo *layout_info,
+  uint32_t *bucket
+);
+
+/**
+* Allocate a set from a bucket's pool chain for frame. A new pool is chained
+* on when the current one returns VK_ERROR_OUT_OF_POOL_MEMORY/VK_ERROR_FRAGMENTED_POOL
+*/
+VkResult dlu_alloc_desc_set(vkcomp *app, uint32_t bucket, uint32_t frame, VkDescriptorSet *set);
+
+/**
+* Release every set allocated for frame across all buckets. Pools are kept for reuse.
+* Caller must make sure the GPU is done with the frame (i.e wait on its render fence)
+*/
+VkResult dlu_reset_desc_frame(vkcomp *app, uint32_t frame);
+
+#ifdef INAPI_CALLS
+/* Destroys all pools owned by app->desc_alloc */
+void dlu_freeup_desc_allocator(vkcomp *app);
+#endif
+
+#endif
@@ -50,6 +50,34 @@ VkSurfaceFormatKHR dlu_choose_swap_surface_format(vkcomp *app, uint32_t cur_pd,
 */
 VkPresentModeKHR dlu_choose_swap_present_mode(vkcomp *app, uint32_t cur_pd);
 
+/**
+* Same as above, but picks the mode according to a latency policy (see dlu_present_policy)
+* Falls back to VK_PRESENT_MODE_FIFO_KHR when none of the policy's modes are supported
+*/
+VkPresentModeKHR dlu_choose_present_mode(vkcomp *app, uint32_t cur_pd, dlu_present_policy policy);
+
+/**
+* Swapchain minImageCount for a policy and the mode dlu_choose_present_mode() returned.
+* Every image past what the mode needs is another frame the presentation engine can queue.
+*/
+uint32_t dlu_present_policy_image_count(dlu_present_policy policy, VkPresentModeKHR mode, VkSurfaceCapabilitiesKHR cap);
+
+/**
+* Limit how many frames may be queued ahead of the display on cur_scd
+* max_queued: 0 picks the policy default, 1 for the latency policies, no limit for power saving
+* Enforced by dlu_wait_present_latency()
+*/
+void dlu_set_present_policy(vkcomp *app, uint32_t cur_scd, dlu_present_policy policy, uint32_t max_queued);
+
+/**
+* Call right before sampling input for a new frame. Blocks until no more than
+* max_queued - 1 frames are waiting to be displayed, so input is read as late as possible.
+* With VK_KHR_present_wait enabled it waits on the present reaching the screen,
+* otherwise on the render fence of that frame's submission (GPU done, not scanned out).
+* timeout: In nanoseconds, VK_TIMEOUT is returned as is
+*/
+VkResult dlu_wait_present_latency(vkcomp *app, uint32_t cur_scd, uint64_t timeout);
+
 /**
 * Needed to create the swap chain
 * Function returns the best resolution for the images in the swap chain
@@ -61,6 +89,7 @@ VkExtent2D dlu_choose_swap_extent(VkSurfaceCapabilitiesKHR capabilities, uint32_
 * cur_scd: Current Swapchain Data Members. Will auto choose current swapchain and synchronization members
 * cur_sync: Current Synchronization Members. Will auto select image semaphore to signal (vkcomp->sc_data->syncs)
 * cur_img: Allows for vkAcquireNextImageKHR to set the image index
+* VK_ERROR_OUT_OF_DATE_KHR/VK_SUBOPTIMAL_KHR are returned as is and set sc_data[cur_scd].stale
 */
 VkResult dlu_acquire_sc_image_index(vkcomp *app, uint32_t cur_scd, uint32_t cur_sync, uint32_t *cur_img);
 
@@ -82,7 +111,31 @@ VkResult dlu_queue_graphics_queue(
   const VkSemaphore *pSignalSemaphores
 );
 
-/* Submit results back to the swap chain, to be presented on the screen */
+/**
+* Puts command buffers into the async compute queue (ld_data.compute), so compute work
+* such as culling or post-processing overlaps rasterization on the graphics queue.
+* Signals sc_data[cur_scd].syncs[synci].sem.compute once done, pass it to
+* dlu_queue_graphics_queue() pWaitSemaphores with the stage that consumes the results.
+* Every signal must be waited on before this synci is submitted again.
+* fence: Optional, VK_NULL_HANDLE if the CPU doesn't need to know. When given,
+* objects handed to dlu_defer_destroy() this frame also wait for it
+*/
+VkResult dlu_queue_compute_queue(
+  vkcomp *app,
+  uint32_t cur_scd,
+  uint32_t synci,
+  uint32_t commandBufferCount,
+  VkCommandBuffer *pCommandBuffers,
+  uint32_t waitSemaphoreCount,
+  const VkSemaphore *pWaitSemaphores,
+  const VkPipelineStageFlags *pWaitDstStageMask,
+  VkFence fence
+);
+
+/**
+* Submit results back to the swap chain, to be presented on the screen
+* VK_ERROR_OUT_OF_DATE_KHR/VK_SUBOPTIMAL_KHR set stale on the sc_data owning pSwapchains
+*/
 VkResult dlu_queue_present_queue(
   vkcomp *app,
   uint32_t cur_ld,
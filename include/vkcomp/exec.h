@@ -78,6 +78,44 @@ void dlu_exec_pipeline_barrier(
   VkCommandBuffer cmd_buff
 );
 
+/**
+* Same as above, recorded through the dispatch table of cur_pool's logical device
+* cur_pool: Pool cmd_buff was allocated from
+*/
+void dlu_exec_cmd_pipeline_barrier(
+  vkcomp *app,
+  uint32_t cur_pool,
+  VkPipelineStageFlags srcStageMask,
+  VkPipelineStageFlags dstStageMask,
+  VkDependencyFlags dependencyFlags,
+  uint32_t memoryBarrierCount,
+  const VkMemoryBarrier *pMemoryBarriers,
+  uint32_t bufferMemoryBarrierCount,
+  const VkBufferMemoryBarrier *pBufferMemoryBarriers,
+  uint32_t imageMemoryBarrierCount,
+  const VkImageMemoryBarrier *pImageMemoryBarriers,
+  VkCommandBuffer cmd_buff
+);
+
+/**
+* Moves ownership of a VK_SHARING_MODE_EXCLUSIVE buffer between queue families,
+* i.e from the async compute queue to the graphics queue. Record it on a command
+* buffer of both queues, release on the source (dstStageMask/dstAccessMask ignored)
+* and acquire on the destination (srcStageMask/srcAccessMask ignored), with
+* a semaphore ordering the two submissions. Not needed when both indices match.
+*/
+void dlu_exec_buffer_ownership_barrier(
+  vkcomp *app,
+  uint32_t cur_bd,
+  uint32_t srcQueueFamilyIndex,
+  uint32_t dstQueueFamilyIndex,
+  VkPipelineStageFlags srcStageMask,
+  VkPipelineStageFlags dstStageMask,
+  VkAccessFlags srcAccessMask,
+  VkAccessFlags dstAccessMask,
+  VkCommandBuffer cmd_buff
+);
+
 void dlu_exec_begin_render_pass(
   vkcomp *app,
   uint32_t cur_pool,
@@ -108,6 +146,24 @@ VkResult dlu_exec_begin_cmd_buffs(
 
 VkResult dlu_exec_stop_cmd_buffs(vkcomp *app, uint32_t cur_pool, uint32_t cur_scd); 
 
+void dlu_exec_cmd_dispatch(
+  vkcomp *app,
+  uint32_t cur_pool,
+  uint32_t cur_buff,
+  uint32_t groupCountX,
+  uint32_t groupCountY,
+  uint32_t groupCountZ
+);
+
+/* cur_bd: Buffer holding a VkDispatchIndirectCommand at offset */
+void dlu_exec_cmd_dispatch_indirect(
+  vkcomp *app,
+  uint32_t cur_pool,
+  uint32_t cur_buff,
+  uint32_t cur_bd,
+  VkDeviceSize offset
+);
+
 void dlu_exec_cmd_draw(
   vkcomp *app,
   uint32_t cur_pool,
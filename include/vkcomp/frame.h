@@ -0,0 +1,77 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright (c) 2019-2020 Vincent Davis Jr.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*/
+
+#ifndef DLU_VKCOMP_FRAME_H
+#define DLU_VKCOMP_FRAME_H
+
+/**
+* Frame API variants that take a dlu_frame_ctx instead of vkcomp + indices.
+* Same behavior as dlu_acquire_sc_image_index(), dlu_queue_graphics_queue(),
+* dlu_queue_present_queue() and dlu_wait_present_latency(), without the chained
+* index lookups. Present ids and submissions are tracked in app->sc_data[cur_scd]
+* either way, so re-initializing the ctx never rewinds them.
+*/
+
+/**
+* Resolve the handles cur_scd and cur_pool use, both must belong to the same logical device.
+* Call again after dlu_recreate_swap_chain() or dlu_set_present_policy(), the ctx
+* copies the swap chain handle and max_queued.
+*/
+VkResult dlu_frame_ctx_init(vkcomp *app, dlu_frame_ctx *ctx, uint32_t cur_scd, uint32_t cur_pool);
+
+/* Select the command buffer and synchronizers the next frame records into and waits on */
+void dlu_frame_next(dlu_frame_ctx *ctx, uint32_t cur_buff, uint32_t synci);
+
+/**
+* Wait for the GPU to finish the last frame that used ctx->fence.
+* timeout: In nanoseconds, VK_TIMEOUT is returned as is
+*/
+VkResult dlu_frame_wait(dlu_frame_ctx *ctx, uint64_t timeout);
+
+/**
+* dlu_wait_present_latency() for the ctx, call before sampling input for a frame.
+* timeout: In nanoseconds, VK_TIMEOUT is returned as is
+*/
+VkResult dlu_frame_pace(dlu_frame_ctx *ctx, uint64_t timeout);
+
+/**
+* Acquire a swapchain image into ctx->cur_img, signals ctx->image.
+* VK_ERROR_OUT_OF_DATE_KHR/VK_SUBOPTIMAL_KHR are returned as is and set ctx->stale
+*/
+VkResult dlu_frame_acquire(dlu_frame_ctx *ctx);
+
+/**
+* Submit ctx->cmd_buff to the graphics queue waiting on ctx->image at wait_stage,
+* signals ctx->render and ctx->fence. The fence is reset here rather than after
+* dlu_frame_wait(), so an acquire that fails can't leave it unsignaled forever.
+*/
+VkResult dlu_frame_submit(dlu_frame_ctx *ctx, VkPipelineStageFlags wait_stage);
+
+/**
+* Present ctx->cur_img once ctx->render is signaled.
+* VK_ERROR_OUT_OF_DATE_KHR/VK_SUBOPTIMAL_KHR are returned as is and set ctx->stale
+*/
+VkResult dlu_frame_present(dlu_frame_ctx *ctx);
+
+#endif
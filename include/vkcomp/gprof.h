@@ -0,0 +1,73 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright (c) 2019-2020 Vincent Davis Jr.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*/
+
+#ifndef DLU_VKCOMP_GPROF_H
+#define DLU_VKCOMP_GPROF_H
+
+/**
+* Setup the GPU profiler (app->gpu_prof)
+* frame_count: Ring size, at least the number of frames in flight. Results are read
+*              back frame_count frames after being recorded, so they're never waited on
+* max_zones: Max dlu_gpu_prof_begin() calls per frame
+* stat_flags: Optional pipeline statistics gathered around top level zones (0 to disable).
+*             Needs the pipelineStatisticsQuery device feature
+*/
+VkResult dlu_create_gpu_profiler(
+  vkcomp *app,
+  uint32_t cur_ld,
+  uint32_t frame_count,
+  uint32_t max_zones,
+  VkQueryPipelineStatisticFlags stat_flags
+);
+
+/**
+* Start recording frame slot frame into the command buffer. Resolves whatever
+* the slot held from frame_count frames ago, then resets its queries.
+* Must be recorded outside of a render pass, before any zone
+*/
+void dlu_gpu_prof_begin_frame(vkcomp *app, uint32_t cur_pool, uint32_t cur_buff, uint32_t frame);
+
+/**
+* Open a labelled zone. Emits a debug utils label (if dlu_set_device_debug_ext()
+* was called) and a top of pipe timestamp. Zones nest up to DLU_GPU_PROF_DEPTH deep
+* color: Label color, may be NULL
+*/
+void dlu_gpu_prof_begin(vkcomp *app, uint32_t cur_pool, uint32_t cur_buff, const char *name, const float color[4]);
+
+/* Close the innermost open zone with a bottom of pipe timestamp and end its label */
+void dlu_gpu_prof_end(vkcomp *app, uint32_t cur_pool, uint32_t cur_buff);
+
+/**
+* Most recently resolved zones, in the order they were opened. zones[i].ms holds
+* the GPU time spent in the zone, zones[i].stats the pipeline statistics (in
+* VkQueryPipelineStatisticFlagBits order) when has_stats is set.
+* Returns NULL with count 0 until the first frame has been resolved
+*/
+const struct _gpu_prof_zone *dlu_gpu_prof_results(vkcomp *app, uint32_t *count);
+
+#ifdef INAPI_CALLS
+void dlu_freeup_gpu_profiler(vkcomp *app);
+#endif
+
+#endif
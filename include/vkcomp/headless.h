@@ -0,0 +1,86 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright (c) 2019-2020 Vincent Davis Jr.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*/
+
+#ifndef DLU_VKCOMP_HEADLESS_H
+#define DLU_VKCOMP_HEADLESS_H
+
+/**
+* Image backed stand-in for a swapchain, for benchmarks, golden image tests and
+* server side rendering where there's no display. Fills sc_data[cur_scd] like
+* dlu_create_swap_chain() does (sc_buffs[i].image/view, format, extent, sic), so
+* framebuffers, command buffers and syncs are created the usual way. Needs no
+* VkSurfaceKHR or WSI extension and works on software devices such as lavapipe.
+* image_count: Must not exceed the sc_buffs count given to dlu_otba()
+* usage: Added to VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT
+* format: Must be a color format with 1, 2, 4, 8 or 16 byte texels
+*/
+VkResult dlu_create_headless_target(
+  vkcomp *app,
+  uint32_t cur_ld,
+  uint32_t cur_scd,
+  VkFormat format,
+  VkExtent2D extent,
+  uint32_t image_count,
+  VkImageUsageFlags usage
+);
+
+/* Replaces dlu_acquire_sc_image_index(), images are handed out round robin */
+uint32_t dlu_headless_acquire(vkcomp *app, uint32_t cur_scd);
+
+/**
+* Replaces presenting. Records a copy of sc_buffs[cur_img].image into its readback
+* buffer at the end of a frame's command buffer. The image is left in
+* VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL.
+* oldLayout: Layout the image is in at this point (render pass finalLayout)
+*/
+void dlu_headless_record_readback(
+  vkcomp *app,
+  uint32_t cur_pool,
+  uint32_t cur_buff,
+  uint32_t cur_scd,
+  uint32_t cur_img,
+  VkImageLayout oldLayout
+);
+
+/**
+* Call right after the command buffer holding the copy is submitted to the
+* graphics queue. Signals cur_img's own readback fence once that work is done,
+* which is what dlu_headless_get_frame() waits on.
+*/
+VkResult dlu_headless_queue_readback(vkcomp *app, uint32_t cur_scd, uint32_t cur_img);
+
+/**
+* Pixels of the last readback of cur_img, tightly packed rows of row_pitch bytes.
+* With wait == VK_FALSE returns NULL right away if the GPU hasn't finished the
+* copy yet, so the render loop never stalls on it. With wait == VK_TRUE waits
+* GENERAL_TIMEOUT at most, NULL if the copy still isn't done. The pointer stays
+* valid until cur_img is read back again.
+*/
+const void *dlu_headless_get_frame(vkcomp *app, uint32_t cur_scd, uint32_t cur_img, VkBool32 wait, VkDeviceSize *row_pitch);
+
+#ifdef INAPI_CALLS
+void dlu_freeup_headless_target(vkcomp *app, uint32_t cur_scd);
+#endif
+
+#endif
@@ -0,0 +1,61 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright (c) 2019-2020 Vincent Davis Jr.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*/
+
+#ifndef DLU_VKCOMP_MSAA_H
+#define DLU_VKCOMP_MSAA_H
+
+/**
+* Highest sample count not above wanted that the device supports for color
+* framebuffer attachments (and depth ones when depth is VK_TRUE)
+*/
+VkSampleCountFlagBits dlu_msaa_sample_count(vkcomp *app, uint32_t cur_pd, VkSampleCountFlagBits wanted, VkBool32 depth);
+
+/**
+* Creates the multisampled color (trans[0]) and, unless depth_format is
+* VK_FORMAT_UNDEFINED, depth (trans[1]) attachments for sc_data[cur_scd]
+* through dlu_create_transient_attachments(). Both are attachment only, so
+* they get TRANSIENT usage and lazily allocated memory where the device has
+* it: on tile-based GPUs the samples never leave tile memory.
+* Must be called after dlu_create_swap_chain() or dlu_create_headless_target()
+*/
+VkResult dlu_create_msaa_attachments(vkcomp *app, uint32_t cur_scd, VkSampleCountFlagBits samples, VkFormat depth_format);
+
+/**
+* Single subpass render pass that renders into the multisampled attachments and
+* resolves into the swapchain image at the end of the subpass through
+* pResolveAttachments, so the samples are never stored. Framebuffer attachments
+* are, in order: trans[0].view, sc_buffs[i].view, trans[1].view (with depth).
+* finalLayout: Layout of the resolved image, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR usually
+* Pipelines used with it need rasterizationSamples set to samples.
+*/
+VkResult dlu_create_msaa_render_pass(
+  vkcomp *app,
+  uint32_t cur_gpd,
+  uint32_t cur_scd,
+  VkSampleCountFlagBits samples,
+  VkFormat depth_format,
+  VkImageLayout finalLayout
+);
+
+#endif
@@ -0,0 +1,58 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright (c) 2019-2020 Vincent Davis Jr.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*/
+
+#ifndef DLU_VKCOMP_PCACHE_H
+#define DLU_VKCOMP_PCACHE_H
+
+/**
+* Creates app->gp_cache from $XDG_CACHE_HOME/lucurious/<name>.pcache
+* (defaults to ~/.cache/lucurious). The file is only used if it was written
+* by a device with the same pipelineCacheUUID, vendorID, deviceID and
+* driverVersion, otherwise an empty cache is created. The path is remembered
+* so dlu_freeup_vk() writes the cache back out at shutdown.
+*/
+VkResult dlu_load_pipeline_cache(vkcomp *app, uint32_t cur_ld, const char *name);
+
+/**
+* Write app->gp_cache to the file given to dlu_load_pipeline_cache().
+* The file is written to a temporary then renamed into place, so a crash
+* mid-write never leaves a truncated cache behind.
+*/
+VkResult dlu_save_pipeline_cache(vkcomp *app);
+
+#ifdef INAPI_CALLS
+/**
+* Returns the blob of the cache file at path (calloc'd) if it was written for props'
+* device and driver, and its header agrees with the file's size and contents. NULL otherwise.
+*/
+void *dlu_pcache_read(const char *path, const VkPhysicalDeviceProperties *props, size_t *size);
+
+/* Header + blob to path for props' device, via a temporary file renamed into place */
+bool dlu_pcache_write(const char *path, const VkPhysicalDeviceProperties *props, const void *data, size_t size);
+
+/* Record VK_EXT_pipeline_creation_feedback results into app->gp_cache hit/miss stats */
+void dlu_pipeline_cache_feedback(vkcomp *app, const VkPipelineCreationFeedbackEXT *feedback);
+#endif
+
+#endif
@@ -0,0 +1,105 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright (c) 2019-2020 Vincent Davis Jr.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*/
+
+#ifndef DLU_VKCOMP_PIPELINE_H
+#define DLU_VKCOMP_PIPELINE_H
+
+/**
+* Create every pipeline variant of a gp_data slot in one call.
+* infos[i] is written to app->gp_data[cur_gpd].graphics_pipelines[i],
+* count must not exceed the slots gpc. A VK_NULL_HANDLE layout/renderPass
+* in infos[i] is replaced with the slots pipeline_layout/render_pass.
+* Like the parallel and async variants this bypasses the pipeline state cache
+* (dlu_cache_graphics_pipeline()), only app->gp_cache is used. The pipelines
+* belong to the slot and are destroyed with it.
+*/
+VkResult dlu_create_graphics_pipelines_batch(
+  vkcomp *app,
+  uint32_t cur_gpd,
+  uint32_t count,
+  VkGraphicsPipelineCreateInfo *infos
+);
+
+/**
+* Same as dlu_create_graphics_pipelines_batch(), but pipelines are compiled
+* on thread_count worker threads sharing app->gp_cache (VkPipelineCache is
+* internally synchronized). thread_count == 0 uses one thread per online CPU.
+* The pipeline state cache isn't thread safe, so it's bypassed here too.
+*/
+VkResult dlu_create_graphics_pipelines_parallel(
+  vkcomp *app,
+  uint32_t cur_gpd,
+  uint32_t count,
+  VkGraphicsPipelineCreateInfo *infos,
+  uint32_t thread_count
+);
+
+/**
+* Returns immediately, pipelines are compiled in the background the same way
+* dlu_create_graphics_pipelines_parallel() does. cb (may be NULL) is called from
+* a worker thread as each pipeline becomes ready. infos and everything it points
+* to must stay alive until dlu_wait_graphics_pipelines() returns. Render with
+* dlu_get_graphics_pipeline() so a fallback pipeline is used in the mean time.
+*/
+VkResult dlu_create_graphics_pipelines_async(
+  vkcomp *app,
+  uint32_t cur_gpd,
+  uint32_t count,
+  VkGraphicsPipelineCreateInfo *infos,
+  uint32_t thread_count,
+  dlu_pipeline_ready_cb cb,
+  void *data
+);
+
+/**
+* Block until all pipelines started by dlu_create_graphics_pipelines_async()
+* for cur_gpd have been created. Returns the first failure if any.
+*/
+VkResult dlu_wait_graphics_pipelines(vkcomp *app, uint32_t cur_gpd);
+
+/* Returns graphics_pipelines[index] if it's ready, otherwise fallback */
+VkPipeline dlu_get_graphics_pipeline(vkcomp *app, uint32_t cur_gpd, uint32_t index, VkPipeline fallback);
+
+/**
+* Create count compute pipelines, pStages[i] (a VK_SHADER_STAGE_COMPUTE_BIT stage)
+* is written to app->gp_data[cur_gpd].compute_pipelines[i]. They use the slots
+* pipeline_layout and app->gp_cache. Bind with dlu_bind_pipeline(..., VK_PIPELINE_BIND_POINT_COMPUTE)
+*/
+VkResult dlu_create_compute_pipelines(
+  vkcomp *app,
+  uint32_t cur_gpd,
+  uint32_t count,
+  const VkPipelineShaderStageCreateInfo *pStages,
+  VkPipelineCreateFlags flags
+);
+
+#ifdef INAPI_CALLS
+/**
+* Creates a single pipeline using app->gp_cache. If VK_EXT_pipeline_creation_feedback
+* is enabled and info->pNext is NULL, feedback is chained and recorded.
+*/
+VkResult dlu_create_pipeline_with_feedback(vkcomp *app, uint32_t cur_ld, const VkGraphicsPipelineCreateInfo *info, VkPipeline *pipeline);
+#endif
+
+#endif
@@ -0,0 +1,56 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright (c) 2019-2020 Vincent Davis Jr.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*/
+
+#ifndef DLU_VKCOMP_SWAPCHAIN_H
+#define DLU_VKCOMP_SWAPCHAIN_H
+
+/**
+* Replace sc_data[cur_scd]'s swapchain in place, i.e on resize or when
+* sc_data[cur_scd].stale gets set. The current swapchain is passed as oldSwapchain,
+* then only what depends on it is rebuilt: image views, the depth buffer and
+* transient attachments (at create_info->imageExtent) and the swapchain framebuffers.
+* Pipelines, render passes, descriptors and buffers are left alone, so viewport
+* and scissor should be dynamic state. Command buffers must be re-recorded.
+* The old swapchain and everything made for it is retired, not destroyed, see
+* dlu_retire_swap_chains(). format_changed (may be NULL) is set when imageFormat
+* differs from before, in that case framebuffers aren't rebuilt as render passes
+* and pipelines need to be recreated against the new format first.
+*/
+VkResult dlu_recreate_swap_chain(
+  vkcomp *app,
+  uint32_t cur_scd,
+  VkSwapchainCreateInfoKHR *create_info,
+  VkImageViewCreateInfo *ivi,
+  VkBool32 *format_changed
+);
+
+/**
+* Destroy retired swapchains of cur_scd whose images the GPU is done with,
+* that is once every render fence of cur_scd is signaled. Call once per frame.
+* force: Destroy without checking, only when the device is known to be idle
+* Returns the number still waiting
+*/
+uint32_t dlu_retire_swap_chains(vkcomp *app, uint32_t cur_scd, VkBool32 force);
+
+#endif
@@ -36,6 +36,76 @@
 */
 #define GENERAL_TIMEOUT 100000000
 
+/* GPU profiler limits: zone name length, nesting depth and pipeline statistic counters */
+#define DLU_GPU_PROF_NAME 32
+#define DLU_GPU_PROF_DEPTH 16
+#define DLU_GPU_PROF_STATS 11
+
+/* Compute compositor: surfaces a single tile can blend, see dlu_comp_add_surface() */
+#define DLU_COMP_TILE_SURFACES 31
+
+/* Most frames dlu_wait_present_latency() can keep track of without VK_KHR_present_wait */
+#define DLU_PRESENT_MAX_QUEUED 8
+
+/* In flight frames the deferred destruction queue tracks fences for, see dlu_defer_end_frame() */
+#define DLU_DEFER_FRAMES 8
+
+/* dlu_frame_ctx is aligned to this, so its hot members share one cache line */
+#define DLU_CACHE_LINE 64
+
+/**
+* Device level entry points called every frame. dlu_create_logical_device()
+* fetches them with vkGetDeviceProcAddr() into ld_data[].vk, calls through
+* it skip the loader's trampoline and dispatch lookup.
+*/
+#define DLU_VK_DEVICE_FUNCS(X) \
+  X(QueueSubmit) X(QueueWaitIdle) X(AcquireNextImageKHR) X(QueuePresentKHR) \
+  X(WaitForFences) X(ResetFences) X(GetFenceStatus) \
+  X(BeginCommandBuffer) X(EndCommandBuffer) X(CmdBeginRenderPass) X(CmdEndRenderPass) \
+  X(CmdBindPipeline) X(CmdBindDescriptorSets) X(CmdBindVertexBuffers) X(CmdBindIndexBuffer) \
+  X(CmdPushConstants) X(CmdSetViewport) X(CmdSetScissor) X(CmdDraw) X(CmdDrawIndexed) \
+  X(CmdDispatch) X(CmdDispatchIndirect) X(CmdPipelineBarrier) X(CmdCopyBuffer) X(CmdBlitImage) \
+  X(CmdCopyBufferToImage) X(CmdCopyImageToBuffer) X(CmdWriteTimestamp) X(CmdResetQueryPool) \
+  X(CmdBeginQuery) X(CmdEndQuery) X(GetQueryPoolResults) \
+  X(AllocateDescriptorSets) X(UpdateDescriptorSets) X(ResetDescriptorPool)
+
+#define DLU_VK_DISPATCH_MEMBER(func) PFN_vk##func func;
+
+/**
+* Present mode policies, see dlu_choose_present_mode()
+* DLU_PRESENT_LOWEST_LATENCY: IMMEDIATE > MAILBOX > FIFO_RELAXED > FIFO, may tear
+* DLU_PRESENT_LOW_LATENCY_NO_TEAR: MAILBOX > FIFO, one frame queued at most
+* DLU_PRESENT_POWER_SAVING: FIFO, the GPU idles between vblanks
+*/
+typedef enum _dlu_present_policy {
+  DLU_PRESENT_LOWEST_LATENCY = 0x0000,
+  DLU_PRESENT_LOW_LATENCY_NO_TEAR = 0x0001,
+  DLU_PRESENT_POWER_SAVING = 0x0002
+} dlu_present_policy;
+
+/**
+* Ranks physical devices in dlu_select_physical_device(), zero initialize
+* then fill in whatever matters. Devices missing a required extension, or
+* unable to present to app->surface when one exists, are never picked.
+* type: Preferred device type, VK_PHYSICAL_DEVICE_TYPE_MAX_ENUM to rank
+* discrete > integrated > virtual > cpu. require_type rejects other types.
+* drm_major/drm_minor: Device number of a DRM primary or render node (st_rdev),
+* the device driving it is preferred. Needs VK_EXT_physical_device_drm and an
+* instance created with VK_KHR_get_physical_device_properties2.
+* name: User preference, substring of deviceName. Overridden by the
+* DLU_DEVICE_NAME environment variable.
+*/
+typedef struct _dlu_pd_criteria {
+  VkPhysicalDeviceType type;
+  VkBool32 require_type;
+  uint32_t extc;
+  const char *const *exts;
+  VkBool32 match_drm;
+  int64_t drm_major;
+  int64_t drm_minor;
+  const char *name;
+} dlu_pd_criteria;
+
 typedef enum _dlu_sync_type {
   DLU_VK_WAIT_RENDER_FENCE = 0x0000,     /* Set render fence to signal state */
   DLU_VK_WAIT_IMAGE_FENCE = 0x0001,        /* Set image fence to signal state */
@@ -100,13 +170,74 @@ typedef struct _vkcomp {
     VkQueue transfer;
     VkQueue compute;
     VkDevice device;
+    VkBool32 pipe_feedback; /* VK_EXT_pipeline_creation_feedback enabled */
+    VkBool32 desc_indexing; /* VK_EXT_descriptor_indexing enabled along with the bindless features */
+    VkBool32 desc_unused_pending; /* descriptorBindingUpdateUnusedWhilePending enabled */
+
+    /* VK_KHR_descriptor_update_template/VK_KHR_push_descriptor entry points, NULL when not enabled */
+    PFN_vkCreateDescriptorUpdateTemplateKHR create_desc_template;
+    PFN_vkDestroyDescriptorUpdateTemplateKHR destroy_desc_template;
+    PFN_vkUpdateDescriptorSetWithTemplateKHR update_desc_template;
+    PFN_vkCmdPushDescriptorSetKHR push_desc_set;
+    PFN_vkCmdPushDescriptorSetWithTemplateKHR push_desc_template;
+
+    /* VK_KHR_present_id + VK_KHR_present_wait enabled, presents get tagged with an id */
+    VkBool32 present_wait;
+    PFN_vkWaitForPresentKHR wait_for_present;
+
+    /* Per device dispatch table, see DLU_VK_DEVICE_FUNCS */
+    struct _vk_dispatch {
+      DLU_VK_DEVICE_FUNCS(DLU_VK_DISPATCH_MEMBER)
+    } vk;
+
+    /**
+    * Deferred destruction queue, see dlu_defer_destroy()
+    * frame: Frame being recorded, destroy requests are tagged with it
+    * completed: Frames before this one are known to be done on the GPU
+    * inflight: Fence covering each ended frame that isn't known to be done
+    * compute: Last compute queue fence of the frame being recorded, see dlu_defer_compute_fence()
+    */
+    struct _deferred {
+      uint64_t frame;
+      uint64_t completed;
+      VkFence compute;
+      uint32_t fc; /* in flight frame count */
+      struct _deferred_frame {
+        VkFence fence;
+        VkFence compute; /* VK_NULL_HANDLE if the frame submitted no fenced compute work */
+        uint64_t frame;
+      } inflight[DLU_DEFER_FRAMES];
+      uint32_t objc, cap;
+      struct _deferred_obj {
+        dlu_destroy_type type;
+        void *data;
+        uint64_t frame;
+      } *objs;
+    } deferred;
     uint32_t pdi; /* Physical device data index */
   } *ld_data;
 
   uint32_t sdc; /* swap chain data count */
   struct _sc_data {
     uint32_t sic; /* swap chain image count */
+    uint32_t sbc; /* sc_buffs/syncs capacity, set by dlu_otba() */
     VkSwapchainKHR swap_chain;
+    VkFormat format;
+    VkExtent2D extent;
+    VkBool32 stale; /* Acquire/present reported VK_ERROR_OUT_OF_DATE_KHR or VK_SUBOPTIMAL_KHR */
+
+    /**
+    * Bounds how far the CPU may run ahead of the display, see dlu_set_present_policy()
+    * max_queued: Frames allowed in flight past the one being built, 0 for no limit
+    * present_id: Last VkPresentIdKHR value handed to vkQueuePresentKHR
+    * submitted: Submissions made through dlu_queue_graphics_queue(), queued[] keeps
+    * the sync index used by the last DLU_PRESENT_MAX_QUEUED of them.
+    * All three start over whenever a new swapchain is created
+    */
+    uint32_t max_queued;
+    uint64_t present_id;
+    uint64_t submitted;
+    uint32_t queued[DLU_PRESENT_MAX_QUEUED];
     struct _swap_chain_buffers {
       VkImage image;
       VkImageView view;
@@ -128,6 +259,7 @@ typedef struct _vkcomp {
       struct {
         VkSemaphore image;
         VkSemaphore render;
+        VkSemaphore compute; /* Signaled by dlu_queue_compute_queue(), graphics waits on it */
       } sem;
     } *syncs;
 
@@ -136,25 +268,189 @@ typedef struct _vkcomp {
       VkImage image;
       VkImageView view;
       VkDeviceMemory mem;
+
+      /* Kept so dlu_recreate_swap_chain() can rebuild it at a new size */
+      VkImageCreateInfo img_info;
+      VkImageViewCreateInfo view_info;
+      VkMemoryPropertyFlags mem_flags;
     } depth;
 
+    /**
+    * Transient attachments (depth, MSAA, intermediate effect targets).
+    * Attachments sharing an alias group never live at the same time within
+    * a frame, so they're bound to the same offset inside of trans_mem.
+    * trans_lazy: trans_mem came from a LAZILY_ALLOCATED memory type
+    */
+    uint32_t tac; /* transient attachment count */
+    struct _transient_attachment {
+      VkImage image;
+      VkImageView view;
+      VkDeviceSize offset;
+      uint32_t alias; /* alias group */
+      VkImageCreateInfo img_info;
+      VkImageViewCreateInfo view_info;
+    } *trans;
+    VkDeviceMemory trans_mem;
+    VkBool32 trans_lazy;
+
+    /**
+    * Swapchains replaced by dlu_recreate_swap_chain(), along with the views and
+    * size dependent attachments made for them. In flight frames may still use
+    * them, dlu_retire_swap_chains() destroys them once the GPU is done.
+    */
+    uint32_t rsc; /* retired swapchain count */
+    struct _retired_sc {
+      VkSwapchainKHR swap_chain;
+      uint32_t viewc;
+      VkImageView *views;
+      uint32_t imgc;
+      VkImage *images;
+      VkDeviceMemory mems[2]; /* depth, transient */
+    } *retired;
+
+    /**
+    * Headless targets (dlu_create_headless_target()) own their images instead of
+    * a swapchain. img_mem backs every sc_buffs[i].image, readback[i] receives
+    * its copy in host cached memory, row_pitch bytes per row.
+    */
+    VkBool32 headless;
+    uint32_t next_img;
+    VkDeviceMemory img_mem;
+    VkDeviceSize row_pitch;
+    struct _readback {
+      VkBuffer buff;
+      VkDeviceMemory mem;
+      void *mapped;
+      VkBool32 coherent;
+      VkFence fence; /* Signalled by dlu_headless_queue_readback() once the copy is done */
+      VkBool32 pending; /* Copy recorded, not yet seen complete */
+    } *readback;
+
     /* logical device index, Used to keep track of active VkDevice */
     uint32_t ldi;
   } *sc_data;
 
   struct _gp_cache {
     VkPipelineCache pipe_cache;
+    char *path; /* on-disk location, set by dlu_load_pipeline_cache() */
+
+    /* Stats from VK_EXT_pipeline_creation_feedback */
+    uint32_t hits;
+    uint32_t misses;
+    uint64_t duration; /* nanoseconds spent creating pipelines */
 
     /* logical device index, Used to keep track of active VkDevice */
     uint32_t ldi;
   } gp_cache;
 
+  /**
+  * Render pass and framebuffer caches keyed by a hash of their create info.
+  * Objects stored here are owned by the cache. gp_data/sc_data only borrow
+  * the handles, so identical descriptions resolve to the same object.
+  */
+  struct _rp_cache {
+    uint32_t count;
+    struct _rp_cache_entry {
+      uint64_t hash;
+      size_t key_size;
+      void *key; /* serialized VkRenderPassCreateInfo */
+      VkRenderPass render_pass;
+
+      /* logical device index, Used to keep track of active VkDevice */
+      uint32_t ldi;
+    } *entries;
+  } rp_cache;
+
+  struct _fb_cache {
+    uint32_t count;
+    struct _fb_cache_entry {
+      uint64_t hash;
+      VkFramebufferCreateFlags flags;
+      VkRenderPass render_pass;
+      uint32_t attc; /* attachment count */
+      VkImageView *views;
+      uint32_t width;
+      uint32_t height;
+      uint32_t layers;
+      VkFramebuffer fb;
+
+      /* logical device index, Used to keep track of active VkDevice */
+      uint32_t ldi;
+    } *entries;
+  } fb_cache;
+
+  /**
+  * Graphics pipelines keyed by a hash of their full state. The first pipeline
+  * of a family (same shader stages, layout, render pass and subpass) is
+  * created with VK_PIPELINE_CREATE_ALLOW_DERIVATIVES_BIT, later variants of
+  * that family are created as derivatives of it.
+  */
+  struct _pso_cache {
+    uint32_t count;
+    struct _pso_cache_entry {
+      uint64_t hash;
+      uint64_t family;
+      size_t key_size;
+      void *key; /* serialized VkGraphicsPipelineCreateInfo */
+      VkPipeline pipeline;
+      VkBool32 parent;
+      VkPipelineLayout layout;
+      VkRenderPass render_pass;
+      uint32_t stagec; /* shader stage count */
+      VkShaderModule *modules; /* Stages keyed by handle (module not in shader_cache), VK_NULL_HANDLE otherwise */
+
+      /* logical device index, Used to keep track of active VkDevice */
+      uint32_t ldi;
+    } *entries;
+  } pso_cache;
+
+  /**
+  * SPIR-V hash of every module made by dlu_create_shader_module(). The pipeline
+  * state cache keys stages by these instead of module handles, so cached
+  * pipelines outlive the modules they were built from.
+  */
+  struct _shader_cache {
+    uint32_t count;
+    struct _shader_cache_entry {
+      VkShaderModule module;
+      uint64_t hash;
+      size_t code_size;
+      uint32_t ldi;
+    } *entries;
+  } shader_cache;
+
+  /**
+  * Samplers, descriptor set layouts and pipeline layouts deduplicated by their
+  * create info. Entries are reference counted, a handle is only destroyed once
+  * its last user releases it with dlu_cache_release_*().
+  */
+  struct _ref_cache {
+    uint32_t count;
+    struct _ref_cache_entry {
+      uint64_t hash;
+      size_t key_size;
+      void *key; /* serialized create info */
+      uint64_t handle; /* VkSampler, VkDescriptorSetLayout or VkPipelineLayout */
+      uint32_t refs;
+      uint32_t depc; /* dependency count */
+      VkDescriptorSetLayout *deps; /* Set layouts a pipeline layout holds references on */
+
+      /* logical device index, Used to keep track of active VkDevice */
+      uint32_t ldi;
+    } *entries;
+  } smp_cache, dsl_cache, pl_cache;
+
   uint32_t gdc;
   struct _gp_data {
     VkRenderPass render_pass;
     VkPipelineLayout pipeline_layout;
     uint32_t gpc; /* graphics piplines count */
     VkPipeline *graphics_pipelines;
+    struct _dlu_pipe_job *job; /* In flight dlu_create_graphics_pipelines_async() work */
+
+    /* Share pipeline_layout with the graphics pipelines, see dlu_create_compute_pipelines() */
+    uint32_t cpc; /* compute pipelines count */
+    VkPipeline *compute_pipelines;
 
     /* logical device index, Used to keep track of active VkDevice */
     uint32_t ldi;
@@ -184,21 +480,207 @@ typedef struct _vkcomp {
     uint32_t dlsc; /* descriptor layout/set count */
     VkDescriptorSetLayout *layouts;
     VkDescriptorSet *desc_set;
+    VkDescriptorUpdateTemplateKHR *templates; /* One per layout, see dlu_create_desc_template() */
+    /* Copy of each template's entries, only kept when VK_KHR_descriptor_update_template is absent */
+    struct _desc_tmpl {
+      uint32_t cnt;
+      VkDescriptorUpdateTemplateEntryKHR *entries;
+    } *tmpl_entries;
 
     /* logical device index, Used to keep track of active VkDevice */
     uint32_t ldi;
   } *desc_data;
   
+  /**
+  * Growable descriptor set allocator. Each bucket serves one VkDescriptorSetLayout
+  * and owns a chain of pools per frame sized for that layout. When a pool
+  * runs dry another is chained on, and a frame's pools are recycled in one go
+  * with vkResetDescriptorPool instead of freeing sets individually.
+  */
+  struct _desc_alloc {
+    uint32_t fc; /* frame count */
+    uint32_t sets_per_pool;
+    uint32_t bc; /* bucket count */
+    struct _desc_bucket {
+      VkDescriptorSetLayout layout;
+      VkDescriptorPoolCreateFlags flags;
+      uint32_t psize;
+      VkDescriptorPoolSize *pool_sizes;
+      struct _desc_chain {
+        uint32_t pc; /* pool count */
+        uint32_t cur_pool; /* Pool currently being allocated from */
+        VkDescriptorPool *pools;
+      } *chains; /* One chain per frame */
+    } *buckets;
+
+    /* logical device index, Used to keep track of active VkDevice */
+    uint32_t ldi;
+  } desc_alloc;
+
+  /**
+  * Bindless texture table (VK_EXT_descriptor_indexing). One partially bound,
+  * update-after-bind array of combined image samplers that text_data slots
+  * register into. Shaders index it, so a frame binds a single set.
+  */
+  struct _bindless {
+    VkDescriptorSetLayoutBinding binding;
+    VkDescriptorBindingFlagsEXT binding_flags;
+    VkDescriptorSetLayoutBindingFlagsCreateInfoEXT flags_info;
+    VkDescriptorSetLayoutCreateInfo layout_info;
+    VkDescriptorSetLayout layout;
+    VkDescriptorPool pool;
+    VkDescriptorSet set;
+    uint32_t capacity;
+    uint32_t used; /* Slots ever handed out, [0, used) */
+    uint32_t fsc; /* free slot count */
+    uint32_t *free_slots;
+
+    /* Released slots wait here until the frame that last used them retires, see dlu_defer_frame() */
+    uint32_t rsc; /* retired slot count */
+    struct _bindless_retired {
+      uint32_t slot;
+      uint64_t frame;
+    } *retired;
+
+    /* logical device index, Used to keep track of active VkDevice */
+    uint32_t ldi;
+  } bindless;
+
+  /**
+  * GPU profiler. A ring of query pools, one slot per frame in flight, holding a
+  * timestamp pair (and optionally pipeline statistics) for each labelled zone.
+  * A slot's queries are read back without waiting the next time it comes round.
+  */
+  struct _gpu_prof {
+    uint32_t fc; /* frame count */
+    uint32_t max_zones; /* per frame */
+    uint32_t cur_frame;
+    float period; /* nanoseconds per timestamp tick */
+    uint64_t ts_mask; /* timestampValidBits worth of bits */
+    VkQueryPipelineStatisticFlags stat_flags;
+    uint32_t statc; /* pipeline statistic count */
+    struct _gpu_prof_frame {
+      VkQueryPool ts_pool;
+      VkQueryPool stat_pool;
+      uint32_t zonec; /* zones written this frame */
+      uint32_t depth; /* open zone count */
+      uint32_t skipped; /* open zones begin() didn't time, over max_zones or DLU_GPU_PROF_DEPTH */
+      uint32_t stack[DLU_GPU_PROF_DEPTH];
+      VkBool32 pending; /* Recorded, results not read back yet */
+      struct _gpu_prof_zone {
+        char name[DLU_GPU_PROF_NAME];
+        uint32_t depth;
+        VkBool32 has_stats;
+        double ms; /* Filled in on resolve */
+        uint64_t stats[DLU_GPU_PROF_STATS];
+      } *zones;
+    } *frames;
+    uint32_t resc; /* resolved zone count */
+    struct _gpu_prof_zone *results; /* Copy of the most recently resolved frame */
+    uint32_t dropped; /* Frames whose results weren't ready when their slot was reused */
+
+    /* logical device index, Used to keep track of active VkDevice */
+    uint32_t ldi;
+  } gpu_prof;
+
+  /**
+  * Compute compositor. Surfaces are binned into per tile lists on the CPU, then
+  * one dispatch blends every tile's list back to front and writes each output
+  * pixel once. surfaces/tiles live in a host visible buffer, one region per frame.
+  */
+  struct _composite {
+    uint32_t fc; /* frame count */
+    uint32_t cur_frame;
+    uint32_t tile; /* tile edge in pixels, also the workgroup size */
+    uint32_t max_surfaces;
+    uint32_t max_tiles;
+    uint32_t tiles_x, tiles_y;
+    uint32_t surfc; /* surfaces added this frame */
+    uint32_t overflow; /* tiles handed to the raster path this frame */
+    VkRect2D *raster_tiles; /* their rectangles, see dlu_comp_raster_tiles() */
+    VkExtent2D extent; /* output extent this frame */
+    uint32_t *bins; /* CPU copy of the tile lists, copied out by dlu_comp_record() */
+    VkDeviceSize surf_bytes; /* per frame */
+    VkDeviceSize tile_bytes; /* per frame */
+    VkDeviceSize frame_bytes; /* aligned surf_bytes + tile_bytes */
+    VkBuffer buff;
+    VkDeviceMemory mem;
+    void *mapped;
+    VkDescriptorSetLayout layout;
+    VkDescriptorPool pool;
+    VkDescriptorSet *sets; /* one per frame */
+    VkPipelineLayout pipeline_layout;
+    VkPipeline pipeline;
+
+    /**
+    * rgba8 image the shader writes when the target's format can't be a storage
+    * image, dlu_comp_record() blits it onto the target. VK_NULL_HANDLE otherwise
+    */
+    VkImage image;
+    VkImageView view;
+    VkDeviceMemory image_mem;
+
+    /* logical device index, Used to keep track of active VkDevice */
+    uint32_t ldi;
+  } composite;
+
   uint32_t tdc; /* texture data count */
   struct _text_data {
     VkImage image;
     VkImageView view;
     VkDeviceMemory mem;
     VkSampler sampler;
+    uint32_t slot; /* Index into the bindless table, UINT32_MAX if not registered */
 
     /* logical device index, Used to keep track of active VkDevice */
     uint32_t ldi;
   } *text_data;
 } vkcomp;
 
+/**
+* Render loop handles of one swap chain + command pool, see dlu_frame_ctx_init().
+* Resolved once so per frame calls don't walk app->ld_data[app->sc_data[cur_scd].ldi]
+* and friends. The first cache line holds the handles acquire, submit and present
+* pass to Vulkan, the second the entry points they call and what dlu_frame_next()
+* reads. Present ids and the submissions dlu_frame_pace() waits on stay in sc, so
+* they carry over when the ctx is initialized again for the same swap chain.
+* cur_img: Set by dlu_frame_acquire()
+* stale: Acquire/present reported VK_ERROR_OUT_OF_DATE_KHR or VK_SUBOPTIMAL_KHR
+*/
+typedef struct _dlu_frame_ctx {
+  _Alignas(DLU_CACHE_LINE) VkDevice device;
+  VkQueue graphics;
+  VkSwapchainKHR swap_chain;
+  VkCommandBuffer cmd_buff;
+  VkSemaphore image;  /* syncs[synci].sem.image */
+  VkSemaphore render; /* syncs[synci].sem.render */
+  VkFence fence;      /* syncs[synci].fence.render */
+  uint32_t cur_img;
+  uint32_t synci;
+
+  _Alignas(DLU_CACHE_LINE) PFN_vkAcquireNextImageKHR AcquireNextImageKHR;
+  PFN_vkQueueSubmit QueueSubmit;
+  PFN_vkQueuePresentKHR QueuePresentKHR;
+  PFN_vkWaitForFences WaitForFences;
+  PFN_vkResetFences ResetFences;
+  struct _synchronizers *syncs;
+  VkCommandBuffer *cmd_buffs;
+  struct _sc_data *sc; /* present_id, submitted and queued[] */
+
+  _Alignas(DLU_CACHE_LINE) VkBool32 present_wait;
+  VkBool32 stale;
+  uint32_t max_queued; /* sc_data[cur_scd].max_queued when dlu_frame_ctx_init() was called */
+  uint32_t ldi;
+  PFN_vkGetFenceStatus GetFenceStatus;
+  PFN_vkWaitForPresentKHR WaitForPresentKHR;
+  vkcomp *app; /* Deferred destruction only, see dlu_defer_end_frame() */
+} dlu_frame_ctx;
+
+/**
+* Called from a worker thread each time a pipeline created by
+* dlu_create_graphics_pipelines_async() is ready (or failed to build)
+* index: Index into app->gp_data[cur_gpd].graphics_pipelines
+*/
+typedef void (*dlu_pipeline_ready_cb)(vkcomp *app, uint32_t cur_gpd, uint32_t index, VkResult res, void *data);
+
 #endif
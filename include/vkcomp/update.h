@@ -49,4 +49,65 @@ void dlu_update_desc_sets(
   const VkCopyDescriptorSet *pDescriptorCopies
 );
 
+/* Same as above, called through the dispatch table of app->ld_data[cur_ld] */
+void dlu_update_desc_sets_ld(
+  vkcomp *app,
+  uint32_t cur_ld,
+  uint32_t descriptorWriteCount,
+  const VkWriteDescriptorSet *pDescriptorWrites,
+  uint32_t descriptorCopyCount,
+  const VkCopyDescriptorSet *pDescriptorCopies
+);
+
+/**
+* Describes where one binding lives inside the packed struct handed to
+* dlu_update_desc_template()/dlu_push_desc_template().
+* offset: offsetof() the first VkDescriptor{Image,Buffer}Info/VkBufferView
+* stride: Distance between array elements, usually sizeof() of the info struct
+*/
+VkDescriptorUpdateTemplateEntryKHR dlu_write_desc_template_entry(
+  uint32_t dstBinding,
+  uint32_t dstArrayElement,
+  uint32_t descriptorCount,
+  VkDescriptorType descriptorType,
+  size_t offset,
+  size_t stride
+);
+
+/**
+* Write every descriptor in a set from one packed struct in a single call,
+* using the template made by dlu_create_desc_template(app, cur_dd, cur_dl, ...).
+* set: VK_NULL_HANDLE updates app->desc_data[cur_dd].desc_set[cur_dl], pass a set
+*      from dlu_alloc_desc_set() to update that instead
+*/
+void dlu_update_desc_template(vkcomp *app, uint32_t cur_dd, uint32_t cur_dl, VkDescriptorSet set, const void *data);
+
+/**
+* Record descriptor writes straight into the command buffer (VK_KHR_push_descriptor),
+* no set needs to be allocated. Meant for small per-draw data. The set number must
+* use a layout created with VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR
+*/
+void dlu_push_desc_set(
+  vkcomp *app,
+  uint32_t cur_pool,
+  uint32_t cur_buff,
+  uint32_t cur_gpd,
+  VkPipelineBindPoint pipelineBindPoint,
+  uint32_t set,
+  uint32_t descriptorWriteCount,
+  const VkWriteDescriptorSet *pDescriptorWrites
+);
+
+/* Same as above but from a packed struct through a VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR template */
+void dlu_push_desc_template(
+  vkcomp *app,
+  uint32_t cur_pool,
+  uint32_t cur_buff,
+  uint32_t cur_gpd,
+  uint32_t cur_dd,
+  uint32_t cur_dl,
+  uint32_t set,
+  const void *data
+);
+
 #endif
@@ -37,6 +37,15 @@ bool memory_type_from_properties(
   VkFlags requirements_mask,
   uint32_t *typeIndex
 );
+
+/* Same as above, but every bit in requirements_mask must be supported */
+bool memory_type_from_all_properties(
+  vkcomp *app,
+  uint32_t pdi,
+  uint32_t typeBits,
+  VkFlags requirements_mask,
+  uint32_t *typeIndex
+);
 #endif
 
 #endif
@@ -28,7 +28,10 @@
 /* Allows for vulkan synchronization function calling within lucurious */
 VkResult dlu_vk_sync(dlu_sync_type type, vkcomp *app, uint32_t cur_scd, uint32_t synci);
 
-/* Allows for more developer vulkan object destruction control */
+/**
+* Allows for more developer vulkan object destruction control. Destroys right
+* away, see dlu_defer_destroy() for objects the GPU may still be using
+*/
 void dlu_vk_destroy(dlu_destroy_type type, vkcomp *app, uint32_t cur_ld, void *data);
 
 VkResult dlu_vk_map_mem(
@@ -84,6 +84,7 @@ static bool check_if_good_candidate(dlu_drm_core *core, const char *device_name)
 
   cap = 0;
   err = drmGetCap(core->device.kmsfd, DRM_CAP_TIMESTAMP_MONOTONIC, &cap);
+  core->device.ts_monotonic = (!err && cap);
   if (err || !cap)
     dlu_log_me(DLU_WARNING, "KMS node '%s' doesn't support clock monotonic timestamps", device_name);
   else
@@ -29,6 +29,8 @@ bool dlu_drm_retrieve_input(dlu_drm_core *core, uint32_t *key_code) {
   enum libinput_event_type type;
   struct libinput_event *event = NULL;
 
+  DLU_PROF_ZONE(DLU_PROF_INPUT, "libinput_dispatch");
+
   /* Read events from libinput FDs and processes them */
   if (libinput_dispatch(core->input.inp)) {
     dlu_log_me(DLU_DANGER, "[x] libinput_dispatch: %s", strerror(errno));
@@ -44,6 +46,10 @@ bool dlu_drm_retrieve_input(dlu_drm_core *core, uint32_t *key_code) {
       {
         struct libinput_event_keyboard *key_event = libinput_event_get_keyboard_event(event);
         *key_code = libinput_event_keyboard_get_key(key_event);
+
+        /* libinput timestamps are CLOCK_MONOTONIC, same as vblank timestamps */
+        if (!core->input.pending_ns)
+          core->input.pending_ns = libinput_event_keyboard_get_time_usec(key_event) * 1000;
       }
       break;
     default: break;
@@ -58,3 +64,25 @@ end_func:
 int dlu_drm_retrieve_input_fd(dlu_drm_core *core) {
   return libinput_get_fd(core->input.inp);
 }
+
+void dlu_drm_input_tag_frame(dlu_drm_core *core, uint32_t cur_bi) {
+  if (!core->input.pending_ns) return;
+
+  /* A buffer that wasn't shown yet keeps its older event */
+  if (!core->buff_data[cur_bi].input_ns || core->input.pending_ns < core->buff_data[cur_bi].input_ns)
+    core->buff_data[cur_bi].input_ns = core->input.pending_ns;
+
+  core->input.pending_ns = 0;
+}
+
+void dlu_drm_input_frame_shown(dlu_drm_core *core, uint32_t cur_bi, unsigned int tv_sec, unsigned int tv_usec) {
+  uint64_t input_ns = core->buff_data[cur_bi].input_ns;
+  uint64_t vblank_ns = (uint64_t) tv_sec * 1000000000ULL + (uint64_t) tv_usec * 1000ULL;
+
+  core->buff_data[cur_bi].input_ns = 0;
+
+  /* Without monotonic vblank timestamps the two clocks can't be compared */
+  if (!input_ns || !core->device.ts_monotonic || vblank_ns < input_ns) return;
+
+  dlu_prof_record(DLU_PROF_INPUT_TO_PHOTON, "input_to_photon", input_ns, vblank_ns);
+}
@@ -42,6 +42,9 @@ bool dlu_drm_do_modeset(dlu_drm_core *core, uint32_t cur_bi) {
     return false;
   }
 
+  /* Changed behind the atomic commit builder's back */
+  dlu_drm_atomic_invalidate(core, core->buff_data[cur_bi].odid);
+
   return true;
 }
 
@@ -50,17 +53,59 @@ bool dlu_drm_do_page_flip(dlu_drm_core *core, uint32_t cur_bi, void *user_data)
   /* Schedules a buffer flip for the next vblank. Fully asynchronous */
   if (drmModePageFlip(core->device.kmsfd, core->output_data[core->buff_data[cur_bi].odid].crtc_id,
                       core->buff_data[cur_bi].fb_id, DRM_MODE_PAGE_FLIP_EVENT, user_data)) {
-    dlu_log_me(DLU_DANGER, "[x] drmModePageFlip: %s", strerror(errno));
+    dlu_log_every(1000, DLU_DANGER, "[x] drmModePageFlip: %s", strerror(errno));
     return false;
   }
 
+  core->output_data[core->buff_data[cur_bi].odid].flip_bi = cur_bi;
+
   return true;
 }
 
+/* drmHandleEvent() gives handlers only the flip's user data, the core is kept here while dispatching */
+static _Thread_local struct _flip_dispatch {
+  dlu_drm_core *core;
+  drmEventContext *ev;
+} flip_dispatch;
+
+static void page_flip_handler(int fd, unsigned int seq, unsigned int tv_sec, unsigned int tv_usec, unsigned int crtc_id, void *data) {
+  dlu_drm_core *core = flip_dispatch.core;
+  drmEventContext *ev = flip_dispatch.ev;
+
+  for (uint32_t i = 0; i < core->odc; i++) {
+    if (core->output_data[i].crtc_id != crtc_id || core->output_data[i].flip_bi == UINT32_MAX) continue;
+    dlu_drm_input_frame_shown(core, core->output_data[i].flip_bi, tv_sec, tv_usec);
+    core->output_data[i].flip_bi = UINT32_MAX;
+  }
+
+  if (ev->version >= 3 && ev->page_flip_handler2)
+    ev->page_flip_handler2(fd, seq, tv_sec, tv_usec, crtc_id, data);
+  else if (ev->page_flip_handler)
+    ev->page_flip_handler(fd, seq, tv_sec, tv_usec, data);
+}
+
 int dlu_drm_do_handle_event(int fd, drmEventContext *ev) {
   return drmHandleEvent(fd, ev);
 }
 
+int dlu_drm_do_handle_event_core(dlu_drm_core *core, drmEventContext *ev) {
+  drmEventContext ctx = *ev;
+  int ret;
+
+  /* Every other event goes straight to the caller's handlers */
+  ctx.version = (ev->version < 3) ? 3 : ev->version;
+  ctx.page_flip_handler = NULL;
+  ctx.page_flip_handler2 = page_flip_handler;
+
+  flip_dispatch.core = core;
+  flip_dispatch.ev = ev;
+  ret = drmHandleEvent(core->device.kmsfd, &ctx);
+  flip_dispatch.core = NULL;
+  flip_dispatch.ev = NULL;
+
+  return ret;
+}
+
 void *dlu_drm_gbm_bo_map(dlu_drm_core *core, uint32_t cur_bi, void **data, uint32_t flags) {
   return gbm_bo_map(core->buff_data[cur_bi].bo, 0, 0, core->output_data[core->buff_data[cur_bi].odid].mode.hdisplay,
          core->output_data[core->buff_data[cur_bi].odid].mode.vdisplay, flags, &core->buff_data[cur_bi].pitches[0], data);
@@ -81,11 +126,12 @@ static int add_conn_prop(dlu_drm_core *core, uint32_t cur_od, drmModeAtomicReq *
   if (!core->output_data[cur_od].props.conn[prop].prop_id) return ret;
 
   ret = drmModeAtomicAddProperty(req, core->output_data[cur_od].conn_id, core->output_data[cur_od].props.conn[prop].prop_id, val);
-  dlu_log_me(DLU_INFO, "[CONN:%lu] %lu (%s) -> %llu (0x%llx)",
-                       (unsigned long) core->output_data[cur_od].conn_id,
-                       (unsigned long) core->output_data[cur_od].props.conn[prop].prop_id,
-                       core->output_data[cur_od].props.conn[prop].name,
-                       (unsigned long long) val, (unsigned long long) val);
+
+  dlu_log_me(DLU_DEBUG, "[CONN:%lu] %lu (%s) -> %llu (0x%llx)",
+                        (unsigned long) core->output_data[cur_od].conn_id,
+                        (unsigned long) core->output_data[cur_od].props.conn[prop].prop_id,
+                        core->output_data[cur_od].props.conn[prop].name,
+                        (unsigned long long) val, (unsigned long long) val);
 
   return (ret <= 0) ? -1 : 0;
 }
@@ -97,11 +143,12 @@ static int add_crtc_prop(dlu_drm_core *core, uint32_t cur_od, drmModeAtomicReq *
   if (!core->output_data[cur_od].props.crtc[prop].prop_id) return ret;
 
   ret = drmModeAtomicAddProperty(req, core->output_data[cur_od].crtc_id, core->output_data[cur_od].props.crtc[prop].prop_id, val);
-  dlu_log_me(DLU_INFO, "[CONN:%lu] %lu (%s) -> %llu (0x%llx)",
-                       (unsigned long) core->output_data[cur_od].crtc_id,
-                       (unsigned long) core->output_data[cur_od].props.crtc[prop].prop_id,
-                       core->output_data[cur_od].props.crtc[prop].name,
-                       (unsigned long long) val, (unsigned long long) val);
+
+  dlu_log_me(DLU_DEBUG, "[CRTC:%lu] %lu (%s) -> %llu (0x%llx)",
+                        (unsigned long) core->output_data[cur_od].crtc_id,
+                        (unsigned long) core->output_data[cur_od].props.crtc[prop].prop_id,
+                        core->output_data[cur_od].props.crtc[prop].name,
+                        (unsigned long long) val, (unsigned long long) val);
 
   return (ret <= 0) ? -1 : 0;
 }
@@ -113,66 +160,68 @@ static int add_plane_prop(dlu_drm_core *core, uint32_t cur_od, drmModeAtomicReq
   if (!core->output_data[cur_od].props.plane[prop].prop_id) return ret;
 
   ret = drmModeAtomicAddProperty(req, core->output_data[cur_od].pp_id, core->output_data[cur_od].props.plane[prop].prop_id, val);
-  dlu_log_me(DLU_INFO, "[CONN:%lu] %lu (%s) -> %llu (0x%llx)",
-                       (unsigned long) core->output_data[cur_od].pp_id,
-                       (unsigned long) core->output_data[cur_od].props.plane[prop].prop_id,
-                       core->output_data[cur_od].props.plane[prop].name,
-                       (unsigned long long) val, (unsigned long long) val);
+
+  dlu_log_me(DLU_DEBUG, "[PLANE:%lu] %lu (%s) -> %llu (0x%llx)",
+                        (unsigned long) core->output_data[cur_od].pp_id,
+                        (unsigned long) core->output_data[cur_od].props.plane[prop].prop_id,
+                        core->output_data[cur_od].props.plane[prop].name,
+                        (unsigned long long) val, (unsigned long long) val);
 
   return (ret <= 0) ? -1 : 0;
 }
 
-bool dlu_drm_do_atomic_req(dlu_drm_core *core, uint32_t cur_bd, drmModeAtomicReq *req) {
-  int ret;
+/* Plane properties a scan out sets, in the order they're added to a request */
+static const dlu_drm_plane_props plane_props[] = {
+  DLU_DRM_PLANE_CRTC_ID, DLU_DRM_PLANE_FB_ID, DLU_DRM_PLANE_SRC_X, DLU_DRM_PLANE_SRC_Y, DLU_DRM_PLANE_SRC_W,
+  DLU_DRM_PLANE_SRC_H, DLU_DRM_PLANE_CRTC_X, DLU_DRM_PLANE_CRTC_Y, DLU_DRM_PLANE_CRTC_W, DLU_DRM_PLANE_CRTC_H
+};
 
-  /* Output device */
+/* Property values scanning out buffer cur_bd takes on its output */
+static void output_state(dlu_drm_core *core, uint32_t cur_bd, struct _atomic_state *st) {
   uint32_t cur_od = core->buff_data[cur_bd].odid;
   uint32_t width = core->output_data[cur_od].mode.hdisplay;
   uint32_t height = core->output_data[cur_od].mode.vdisplay;
 
-  dlu_log_me(DLU_WARNING, "[%s] atomic state for commit:", core->output_data[cur_od].name);
-
-  ret = add_plane_prop(core, cur_od, req, DLU_DRM_PLANE_CRTC_ID, core->output_data[cur_od].crtc_id);
-  if (ret == NEG_ONE) { dlu_log_me(DLU_DANGER, "[x] add_plane_prop: %s", strerror(errno)); return false; }
-
-  ret = add_plane_prop(core, cur_od, req, DLU_DRM_PLANE_FB_ID, core->buff_data[cur_bd].fb_id);
-  if (ret == NEG_ONE) { dlu_log_me(DLU_DANGER, "[x] add_plane_prop: %s", strerror(errno)); return false; }
-
-  ret = add_plane_prop(core, cur_od, req, DLU_DRM_PLANE_SRC_X, 0);
-  if (ret == NEG_ONE) { dlu_log_me(DLU_DANGER, "[x] add_plane_prop: %s", strerror(errno)); return false; }
-
-  ret = add_plane_prop(core, cur_od, req, DLU_DRM_PLANE_SRC_Y, 0);
-  if (ret == NEG_ONE) { dlu_log_me(DLU_DANGER, "[x] add_plane_prop: %s", strerror(errno)); return false; }
-
-  ret = add_plane_prop(core, cur_od, req, DLU_DRM_PLANE_SRC_W, width << 16);
-  if (ret == NEG_ONE) { dlu_log_me(DLU_DANGER, "[x] add_plane_prop: %s", strerror(errno)); return false; }
+  memset(st, 0, sizeof(struct _atomic_state));
+
+  st->plane[DLU_DRM_PLANE_CRTC_ID] = core->output_data[cur_od].crtc_id;
+  st->plane[DLU_DRM_PLANE_FB_ID] = core->buff_data[cur_bd].fb_id;
+  st->plane[DLU_DRM_PLANE_SRC_W] = width << 16;
+  st->plane[DLU_DRM_PLANE_SRC_H] = height << 16;
+  st->plane[DLU_DRM_PLANE_CRTC_W] = width;
+  st->plane[DLU_DRM_PLANE_CRTC_H] = height;
+  st->crtc[DLU_DRM_CRTC_MODE_ID] = core->output_data[cur_od].mode_blob_id;
+  st->crtc[DLU_DRM_CRTC_ACTIVE] = 1;
+  st->conn[DLU_DRM_CONNECTOR_CRTC_ID] = core->output_data[cur_od].crtc_id;
+}
 
-  ret = add_plane_prop(core, cur_od, req, DLU_DRM_PLANE_SRC_H, height << 16);
-  if (ret == NEG_ONE) { dlu_log_me(DLU_DANGER, "[x] add_plane_prop: %s", strerror(errno)); return false; }
+bool dlu_drm_do_atomic_req(dlu_drm_core *core, uint32_t cur_bd, drmModeAtomicReq *req) {
+  int ret;
 
-  ret = add_plane_prop(core, cur_od, req, DLU_DRM_PLANE_CRTC_X, 0);
-  if (ret == NEG_ONE) { dlu_log_me(DLU_DANGER, "[x] add_plane_prop: %s", strerror(errno)); return false; }
+  /* Output device */
+  uint32_t cur_od = core->buff_data[cur_bd].odid;
+  struct _atomic_state st;
 
-  ret = add_plane_prop(core, cur_od, req, DLU_DRM_PLANE_CRTC_Y, 0);
-  if (ret == NEG_ONE) { dlu_log_me(DLU_DANGER, "[x] add_plane_prop: %s", strerror(errno)); return false; }
+  output_state(core, cur_bd, &st);
 
-  ret = add_plane_prop(core, cur_od, req, DLU_DRM_PLANE_CRTC_W, width);
-  if (ret == NEG_ONE) { dlu_log_me(DLU_DANGER, "[x] add_plane_prop: %s", strerror(errno)); return false; }
+  dlu_log_me(DLU_DEBUG, "[%s] atomic state for commit:", core->output_data[cur_od].name);
 
-  ret = add_plane_prop(core, cur_od, req, DLU_DRM_PLANE_CRTC_H, height);
-  if (ret == NEG_ONE) { dlu_log_me(DLU_DANGER, "[x] add_plane_prop: %s", strerror(errno)); return false; }
+  for (uint32_t i = 0; i < ARR_LEN(plane_props); i++) {
+    ret = add_plane_prop(core, cur_od, req, plane_props[i], st.plane[plane_props[i]]);
+    if (ret == NEG_ONE) { dlu_log_me(DLU_DANGER, "[x] add_plane_prop: %s", strerror(errno)); return false; }
+  }
 
   /**
   * Changing any of these two properties requires the ALLOW_MODESET
   * flag to be set on the atomic commit.
   */
-  ret = add_crtc_prop(core, cur_od, req, DLU_DRM_CRTC_MODE_ID, core->output_data[cur_od].mode_blob_id);
+  ret = add_crtc_prop(core, cur_od, req, DLU_DRM_CRTC_MODE_ID, st.crtc[DLU_DRM_CRTC_MODE_ID]);
   if (ret == NEG_ONE) { dlu_log_me(DLU_DANGER, "[x] add_crtc_prop: %s", strerror(errno)); return false; }
 
-  ret = add_crtc_prop(core, cur_od, req, DLU_DRM_CRTC_ACTIVE, 1);
+  ret = add_crtc_prop(core, cur_od, req, DLU_DRM_CRTC_ACTIVE, st.crtc[DLU_DRM_CRTC_ACTIVE]);
   if (ret == NEG_ONE) { dlu_log_me(DLU_DANGER, "[x] add_crtc_prop: %s", strerror(errno)); return false; }
 
-  ret = add_conn_prop(core, cur_od, req, DLU_DRM_CONNECTOR_CRTC_ID, core->output_data[cur_od].crtc_id);
+  ret = add_conn_prop(core, cur_od, req, DLU_DRM_CONNECTOR_CRTC_ID, st.conn[DLU_DRM_CONNECTOR_CRTC_ID]);
   if (ret == NEG_ONE) { dlu_log_me(DLU_DANGER, "[x] add_conn_prop: %s", strerror(errno)); return false; }
 
   return true;
@@ -180,6 +229,8 @@ bool dlu_drm_do_atomic_req(dlu_drm_core *core, uint32_t cur_bd, drmModeAtomicReq
 
 int dlu_drm_do_atomic_commit(dlu_drm_core *core, drmModeAtomicReq *req, bool allow_modeset) {
   uint32_t flags = DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT;
+
+  DLU_PROF_ZONE(DLU_PROF_ATOMIC_COMMIT, "drmModeAtomicCommit");
   
   if (allow_modeset) /* If not set still works fine */
     flags |= DRM_MODE_ATOMIC_ALLOW_MODESET;
@@ -187,5 +238,109 @@ int dlu_drm_do_atomic_commit(dlu_drm_core *core, drmModeAtomicReq *req, bool all
   return drmModeAtomicCommit(core->device.kmsfd, req, flags, core);
 }
 
+bool dlu_drm_atomic_begin(dlu_drm_core *core) {
+
+  if (!core->atomic.req) {
+    core->atomic.req = drmModeAtomicAlloc();
+    if (!core->atomic.req) { dlu_log_me(DLU_DANGER, "[x] drmModeAtomicAlloc: %s", strerror(errno)); return false; }
+    core->atomic.base = drmModeAtomicGetCursor(core->atomic.req);
+    core->atomic.base_modeset = false;
+  }
+
+  /* Drop the last frame's properties, the request's storage is kept */
+  drmModeAtomicSetCursor(core->atomic.req, core->atomic.base);
+  core->atomic.modeset = core->atomic.base_modeset;
+
+  for (uint32_t i = 0; i < core->odc; i++)
+    core->output_data[i].queued = false;
+
+  return true;
+}
+
+void dlu_drm_atomic_set_base(dlu_drm_core *core) {
+  if (!core->atomic.req) return;
+  core->atomic.base = drmModeAtomicGetCursor(core->atomic.req);
+  core->atomic.base_modeset = core->atomic.modeset;
+}
+
+bool dlu_drm_atomic_add_output(dlu_drm_core *core, uint32_t cur_bd) {
+  int ret;
+
+  if (!core->atomic.req) { dlu_log_me(DLU_DANGER, "[x] Must make a call to dlu_drm_atomic_begin()"); return false; }
+  if (core->buff_data[cur_bd].odid == UINT32_MAX) {
+    dlu_log_me(DLU_DANGER, "[x] Must make a call to dlu_drm_create_fb(3). Before an atomic commit is possible");
+    return false;
+  }
+
+  uint32_t cur_od = core->buff_data[cur_bd].odid;
+  struct _output_data *od = &core->output_data[cur_od];
+  drmModeAtomicReq *req = core->atomic.req;
+  bool full = !od->valid;
+
+  /* A property that fails to go in takes the ones added before it out again */
+  int cursor = drmModeAtomicGetCursor(req);
+  bool modeset = core->atomic.modeset;
+
+  output_state(core, cur_bd, &od->pending);
+
+  /* FB_ID always goes in, it's the flip itself and what the page flip event hangs off of */
+  for (uint32_t i = 0; i < ARR_LEN(plane_props); i++) {
+    dlu_drm_plane_props prop = plane_props[i];
+    if (!full && prop != DLU_DRM_PLANE_FB_ID && od->pending.plane[prop] == od->committed.plane[prop]) continue;
+
+    ret = add_plane_prop(core, cur_od, req, prop, od->pending.plane[prop]);
+    if (ret == NEG_ONE) { dlu_log_me(DLU_DANGER, "[x] add_plane_prop: %s", strerror(errno)); goto err_rewind; }
+  }
+
+  /* Anything past this point is a modeset */
+  for (dlu_drm_crtc_props prop = DLU_DRM_CRTC_MODE_ID; prop <= DLU_DRM_CRTC_ACTIVE; prop++) {
+    if (!full && od->pending.crtc[prop] == od->committed.crtc[prop]) continue;
+
+    ret = add_crtc_prop(core, cur_od, req, prop, od->pending.crtc[prop]);
+    if (ret == NEG_ONE) { dlu_log_me(DLU_DANGER, "[x] add_crtc_prop: %s", strerror(errno)); goto err_rewind; }
+    core->atomic.modeset = true;
+  }
+
+  if (full || od->pending.conn[DLU_DRM_CONNECTOR_CRTC_ID] != od->committed.conn[DLU_DRM_CONNECTOR_CRTC_ID]) {
+    ret = add_conn_prop(core, cur_od, req, DLU_DRM_CONNECTOR_CRTC_ID, od->pending.conn[DLU_DRM_CONNECTOR_CRTC_ID]);
+    if (ret == NEG_ONE) { dlu_log_me(DLU_DANGER, "[x] add_conn_prop: %s", strerror(errno)); goto err_rewind; }
+    core->atomic.modeset = true;
+  }
+
+  od->queued = true;
+  od->queued_bi = cur_bd;
+
+  return true;
+
+err_rewind:
+  drmModeAtomicSetCursor(req, cursor);
+  core->atomic.modeset = modeset;
+  return false;
+}
+
+int dlu_drm_atomic_commit(dlu_drm_core *core) {
+  int ret = NEG_ONE;
+
+  if (!core->atomic.req) { dlu_log_me(DLU_DANGER, "[x] Must make a call to dlu_drm_atomic_begin()"); return ret; }
+
+  ret = dlu_drm_do_atomic_commit(core, core->atomic.req, core->atomic.modeset);
+  if (ret) return ret;
+
+  /* The kernel took it, queued values are now what's on screen (or about to be) */
+  for (uint32_t i = 0; i < core->odc; i++) {
+    if (!core->output_data[i].queued) continue;
+    core->output_data[i].committed = core->output_data[i].pending;
+    core->output_data[i].valid = true;
+    core->output_data[i].queued = false;
+    core->output_data[i].flip_bi = core->output_data[i].queued_bi;
+  }
+
+  return ret;
+}
+
+void dlu_drm_atomic_invalidate(dlu_drm_core *core, uint32_t cur_od) {
+  core->output_data[cur_od].valid = false;
+}
+
 drmModeAtomicReq *dlu_drm_do_atomic_alloc() { return drmModeAtomicAlloc(); }
 void dlu_drm_do_atomic_free(drmModeAtomicReq *req) { drmModeAtomicFree(req); }
@@ -72,6 +72,9 @@ void dlu_drm_freeup_core(dlu_drm_core *core) {
     }
   }
 
+  if (core->atomic.req)
+    drmModeAtomicFree(core->atomic.req);
+
   if (core->device.gbm_device)
     gbm_device_destroy(core->device.gbm_device);
 
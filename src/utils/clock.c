@@ -27,19 +27,11 @@
 
 /* Taken From: https://www.roxlu.com/2014/047/high-resolution-timer-function-in-c-c-- */
 uint64_t dlu_hrnst(void) {
-  static uint64_t is_init = 0;
-  static struct timespec linux_rate;
-
-  if (is_init == 0) {
-    clock_getres(CLOCKID, &linux_rate);
-    is_init = 1;
-  }
-
-  uint64_t now;
   struct timespec spec;
   clock_gettime(CLOCKID, &spec);
-  now = spec.tv_sec * 1.0e9 + spec.tv_nsec;
-  return now;
+
+  /* Stay in integer math, a double only holds 53 bits and costs a conversion each call */
+  return (uint64_t) spec.tv_sec * 1000000000ULL + (uint64_t) spec.tv_nsec;
 }
 
 /**
@@ -120,7 +120,11 @@ static const char *vkres_msg(int err) {
   return "An unknown error has occurred. Either the application has provided invalid input, or an implementation failure has occurred";
 }
 
-void _show_err_msg(uint32_t dlu_err, int vkerr, const char *dlu_msg) {
+/* dlu_log_me() below checks the level of the module PERR() was called from */
+#undef DLU_LOG_MODULE
+#define DLU_LOG_MODULE module
+
+void _show_err_msg(uint32_t dlu_err, int vkerr, const char *dlu_msg, dlu_log_module module) {
   switch (dlu_err) {
     case DLU_DR_INSTANCE_PROC_ADDR_ERR:
       dlu_log_me(DLU_DANGER, "[x] GetInstanceProcAddr: Unable to find %s function", dlu_msg);
@@ -193,6 +197,26 @@ void _show_err_msg(uint32_t dlu_err, int vkerr, const char *dlu_msg) {
       dlu_log_me(DLU_DANGER, "[x] Must have a VkDevice or a VkPhysicalDevice association");
       dlu_log_me(DLU_DANGER, "[x] Must make a call to %s to create that association", dlu_msg);
       break;
+    case DLU_VKCOMP_PIPE_CACHE:
+      dlu_log_me(DLU_DANGER, "[x] VkPipelineCache not created");
+      dlu_log_me(DLU_DANGER, "[x] Must make a call to dlu_create_pipeline_cache() or dlu_load_pipeline_cache()");
+      break;
+    case DLU_VKCOMP_DESC_ALLOC:
+      dlu_log_me(DLU_DANGER, "[x] Descriptor allocator not setup");
+      dlu_log_me(DLU_DANGER, "[x] Must make a call to dlu_create_desc_allocator()");
+      break;
+    case DLU_VKCOMP_BINDLESS:
+      dlu_log_me(DLU_DANGER, "[x] Bindless texture table not setup");
+      dlu_log_me(DLU_DANGER, "[x] Must make a call to dlu_create_bindless_table()");
+      break;
+    case DLU_VKCOMP_GPU_PROF:
+      dlu_log_me(DLU_DANGER, "[x] GPU profiler not setup");
+      dlu_log_me(DLU_DANGER, "[x] Must make a call to dlu_create_gpu_profiler()");
+      break;
+    case DLU_VKCOMP_COMPOSITOR:
+      dlu_log_me(DLU_DANGER, "[x] Compute compositor not setup");
+      dlu_log_me(DLU_DANGER, "[x] Must make a call to dlu_create_compositor()");
+      break;
     case DLU_BUFF_NOT_ALLOC:
       dlu_log_me(DLU_DANGER, "[x] Must make a call to dlu_otba(): %s", dlu_msg);
       break;
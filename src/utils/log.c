@@ -24,6 +24,13 @@
 
 #include <lucom.h>
 #include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define LOG_SLOTS 1024 /* Messages in flight, power of two */
+#define LOG_ARGS 464 /* Encoded argument bytes a message may carry */
+#define LOG_OUT 65536 /* Formatted bytes the writer batches per write */
+#define LOG_SPEC 32 /* Longest conversion specification, "%-08.3lx" and the like */
 
 /* ANSI Escape Codes */
 static const char *term_colors[] = {
@@ -32,12 +39,383 @@ static const char *term_colors[] = {
   [DLU_DANGER]  = "\e[31;1m",
   [DLU_INFO]    = "\e[37;1m",
   [DLU_WARNING] = "\e[33;1m",
-  [DLU_RESET]   = "\x1b[0m"
+  [DLU_RESET]   = "\x1b[0m",
+  [DLU_DEBUG]   = "\e[36m"
 };
 
-void _dlu_log_me(dlu_log_type type, FILE *stream, const char *fmt, ...) {
+/**
+* Callers don't format anything. A message is the format string's address
+* (the macros only pass literals) plus its arguments copied out in binary,
+* the writer thread turns it into text later. seq follows the bounded MPMC
+* queue scheme: a slot is free for position pos when seq == pos and holds
+* a published message when seq == pos + 1.
+*/
+struct log_slot {
+  _Atomic uint64_t seq;
+  dlu_log_type type;
+  FILE *stream;
+  const char *fmt;
+  struct timespec ts;
+  unsigned char args[LOG_ARGS];
+};
+
+typedef enum _log_arg {
+  LOG_ARG_NONE, LOG_ARG_INT, LOG_ARG_LONG, LOG_ARG_LLONG, LOG_ARG_INTMAX, LOG_ARG_SIZE,
+  LOG_ARG_DOUBLE, LOG_ARG_LDOUBLE, LOG_ARG_PTR, LOG_ARG_STR
+} log_arg;
+
+/* One conversion specification of a printf format */
+struct log_spec {
+  const char *start;
+  size_t len;
+  uint32_t stars; /* '*' field width/precision */
+  int prec; /* -1 when not given */
+  bool prec_star; /* Precision is the last star */
+  log_arg arg;
+};
+
+static struct log_slot log_ring[LOG_SLOTS];
+static _Atomic uint64_t log_head = 0; /* Next position producers claim */
+static _Atomic uint64_t log_done = 0; /* Messages written out, read by dlu_log_flush() */
+static _Atomic bool log_on = true;
+static _Atomic bool log_running = false;
+static _Atomic bool log_stop = false;
+static pthread_once_t log_once = PTHREAD_ONCE_INIT;
+static pthread_t log_thread;
+static bool log_hooked = false; /* atexit()/pthread_atfork() handlers registered */
+
+/**
+* The writer sleeps on log_wake once the ring is drained, producers only take
+* log_lock to signal it when log_idle says it's asleep. dlu_log_flush() waits
+* on log_drained, broadcast each time the writer catches up.
+*/
+static pthread_mutex_t log_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t log_wake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t log_drained = PTHREAD_COND_INITIALIZER;
+static _Atomic bool log_idle = false;
+
+/* Writer thread state */
+static struct {
+  FILE *stream;
+  size_t len;
+  char buf[LOG_OUT];
+} log_out;
+
+/**
+* Finds the next conversion in fmt. Returns a pointer past it, or NULL once the
+* format is exhausted. Returns spec->start == NULL for conversions that can't
+* be carried over to another thread (%n, wide strings).
+*/
+static const char *log_next_spec(const char *fmt, struct log_spec *spec) {
+  const char *p = strchr(fmt, '%');
+  if (!p) return NULL;
+
+  spec->start = p++;
+  spec->stars = 0;
+  spec->prec = -1;
+  spec->prec_star = false;
+  spec->arg = LOG_ARG_INT;
+
+  while (*p && strchr("-+ #0'", *p)) p++;
+  if (*p == '*') { spec->stars++; p++; }
+  else while (*p >= '0' && *p <= '9') p++;
+
+  if (*p == '.') {
+    p++;
+    if (*p == '*') { spec->stars++; spec->prec_star = true; p++; }
+    else { spec->prec = 0; while (*p >= '0' && *p <= '9') spec->prec = spec->prec * 10 + (*p++ - '0'); }
+  }
+
+  log_arg length = LOG_ARG_INT;
+  bool ldouble = false;
+  switch (*p) {
+    case 'h': p++; if (*p == 'h') p++; break;
+    case 'l': p++; length = LOG_ARG_LONG; if (*p == 'l') { p++; length = LOG_ARG_LLONG; } break;
+    case 'q': p++; length = LOG_ARG_LLONG; break;
+    case 'j': p++; length = LOG_ARG_INTMAX; break;
+    case 'z': case 't': p++; length = LOG_ARG_SIZE; break;
+    case 'L': p++; ldouble = true; break;
+    default: break;
+  }
+
+  switch (*p) {
+    case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': spec->arg = length; break;
+    case 'c': spec->arg = LOG_ARG_INT; break;
+    case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+      spec->arg = (ldouble) ? LOG_ARG_LDOUBLE : LOG_ARG_DOUBLE; break;
+    case 'p': spec->arg = LOG_ARG_PTR; break;
+    case 's': spec->arg = LOG_ARG_STR; if (length != LOG_ARG_INT) spec->start = NULL; break;
+    case '%': spec->arg = LOG_ARG_NONE; break;
+    default: spec->start = NULL; return (*p) ? p + 1 : p;
+  }
+
+  spec->len = p + 1 - spec->start;
+  if (spec->len >= LOG_SPEC) spec->start = NULL;
+
+  return p + 1;
+}
+
+#define LOG_PUT(type, val) \
+  do { \
+    type _v = (val); \
+    if (*len + sizeof(type) > LOG_ARGS) return false; \
+    memcpy(buf + *len, &_v, sizeof(type)); *len += sizeof(type); \
+  } while (0)
+
+/* Copies every argument fmt consumes into buf, false if they don't fit */
+static bool log_encode(unsigned char *buf, uint32_t *len, const char *fmt, va_list args) {
+  struct log_spec spec;
+  int prec = -1;
+
+  *len = 0;
+  while ((fmt = log_next_spec(fmt, &spec))) {
+    if (!spec.start) return false;
+
+    prec = spec.prec;
+    for (uint32_t i = 0; i < spec.stars; i++) {
+      int star = va_arg(args, int);
+      LOG_PUT(int, star);
+      if (spec.prec_star && i == spec.stars - 1) prec = star;
+    }
+
+    switch (spec.arg) {
+      case LOG_ARG_NONE: break;
+      case LOG_ARG_INT: LOG_PUT(int, va_arg(args, int)); break;
+      case LOG_ARG_LONG: LOG_PUT(long, va_arg(args, long)); break;
+      case LOG_ARG_LLONG: LOG_PUT(long long, va_arg(args, long long)); break;
+      case LOG_ARG_INTMAX: LOG_PUT(intmax_t, va_arg(args, intmax_t)); break;
+      case LOG_ARG_SIZE: LOG_PUT(size_t, va_arg(args, size_t)); break;
+      case LOG_ARG_DOUBLE: LOG_PUT(double, va_arg(args, double)); break;
+      case LOG_ARG_LDOUBLE: LOG_PUT(long double, va_arg(args, long double)); break;
+      case LOG_ARG_PTR: LOG_PUT(void *, va_arg(args, void *)); break;
+      case LOG_ARG_STR:
+        {
+          /* Strings are often short lived (strerror(), stack buffers), copy them */
+          const char *str = va_arg(args, const char *);
+          if (!str) str = "(null)";
+          size_t n = (prec >= 0) ? strnlen(str, prec) : strlen(str);
+          if (*len + n + 1 > LOG_ARGS) return false;
+          memcpy(buf + *len, str, n);
+          buf[*len + n] = '\0';
+          *len += n + 1;
+        }
+        break;
+    }
+  }
+
+  return true;
+}
+
+static void log_out_flush(void) {
+  if (log_out.len) fwrite(log_out.buf, 1, log_out.len, log_out.stream);
+  if (log_out.stream) fflush(log_out.stream);
+  log_out.len = 0;
+}
+
+static void log_out_printf(const char *fmt, ...) {
+  va_list args;
+  size_t room = LOG_OUT - log_out.len;
+
+  va_start(args, fmt);
+  int n = vsnprintf(log_out.buf + log_out.len, room, fmt, args);
+  va_end(args);
+  if (n < 0) return;
+
+  if ((size_t) n < room) { log_out.len += n; return; }
+
+  /* Didn't fit, write what's batched and try again */
+  log_out_flush();
+  va_start(args, fmt);
+  if ((size_t) n < LOG_OUT) log_out.len = vsnprintf(log_out.buf, LOG_OUT, fmt, args);
+  else vfprintf(log_out.stream, fmt, args);
+  va_end(args);
+}
+
+#define LOG_GET(type) ({ type _v; memcpy(&_v, args, sizeof(type)); args += sizeof(type); _v; })
+
+#define LOG_OUT_ARG(val) \
+  do { \
+    if (spec.stars == 0) log_out_printf(sbuf, val); \
+    else if (spec.stars == 1) log_out_printf(sbuf, stars[0], val); \
+    else log_out_printf(sbuf, stars[0], stars[1], val); \
+  } while (0)
+
+/* Writer thread side of _dlu_log_me() */
+static void log_format(struct log_slot *slot) {
+  const unsigned char *args = slot->args;
+  const char *fmt = slot->fmt, *next = NULL;
+  struct log_spec spec;
+  char sbuf[LOG_SPEC], tbuf[26];
+  int stars[2];
+
+  if (log_out.stream != slot->stream) {
+    log_out_flush();
+    log_out.stream = slot->stream;
+  }
+
+  /* create message time stamp */
+  strftime(tbuf, sizeof(tbuf), "%F %T - ", localtime_r(&slot->ts.tv_sec, &(struct tm){}));
+  log_out_printf("%s%s", tbuf, term_colors[slot->type]);
+
+  while ((next = log_next_spec(fmt, &spec))) {
+    log_out_printf("%.*s", (int) (spec.start - fmt), fmt);
+
+    memcpy(sbuf, spec.start, spec.len);
+    sbuf[spec.len] = '\0';
+    for (uint32_t i = 0; i < spec.stars; i++) stars[i] = LOG_GET(int);
+
+    switch (spec.arg) {
+      case LOG_ARG_NONE: log_out_printf("%%"); break;
+      case LOG_ARG_INT: LOG_OUT_ARG(LOG_GET(int)); break;
+      case LOG_ARG_LONG: LOG_OUT_ARG(LOG_GET(long)); break;
+      case LOG_ARG_LLONG: LOG_OUT_ARG(LOG_GET(long long)); break;
+      case LOG_ARG_INTMAX: LOG_OUT_ARG(LOG_GET(intmax_t)); break;
+      case LOG_ARG_SIZE: LOG_OUT_ARG(LOG_GET(size_t)); break;
+      case LOG_ARG_DOUBLE: LOG_OUT_ARG(LOG_GET(double)); break;
+      case LOG_ARG_LDOUBLE: LOG_OUT_ARG(LOG_GET(long double)); break;
+      case LOG_ARG_PTR: LOG_OUT_ARG(LOG_GET(void *)); break;
+      case LOG_ARG_STR:
+        LOG_OUT_ARG((const char *) args);
+        args += strlen((const char *) args) + 1;
+        break;
+    }
+
+    fmt = next;
+  }
+
+  log_out_printf("%s%s\n", fmt, term_colors[DLU_RESET]);
+}
+
+static void *log_writer(void UNUSED *data) {
+  uint64_t tail = 0;
+
+  for (;;) {
+    struct log_slot *slot = &log_ring[tail & (LOG_SLOTS - 1)];
+
+    if (atomic_load_explicit(&slot->seq, memory_order_acquire) != tail + 1) {
+      /* Drained, write the batch out and tell flushers */
+      log_out_flush();
+
+      pthread_mutex_lock(&log_lock);
+      atomic_store_explicit(&log_done, tail, memory_order_release);
+      pthread_cond_broadcast(&log_drained);
+
+      /**
+      * Announce the sleep before looking at the slot again. A producer publishes
+      * before checking log_idle, so one of the two always sees the other
+      */
+      atomic_store(&log_idle, true);
+      while (atomic_load(&slot->seq) != tail + 1 && !atomic_load(&log_stop))
+        pthread_cond_wait(&log_wake, &log_lock);
+      atomic_store(&log_idle, false);
+      pthread_mutex_unlock(&log_lock);
+
+      if (atomic_load(&slot->seq) != tail + 1 && atomic_load(&log_stop)) break;
+      continue;
+    }
+
+    log_format(slot);
+    atomic_store_explicit(&slot->seq, tail + LOG_SLOTS, memory_order_release);
+    tail++;
+  }
+
+  return NULL;
+}
+
+static void log_wake_writer(void) {
+  pthread_mutex_lock(&log_lock);
+  pthread_cond_signal(&log_wake);
+  pthread_mutex_unlock(&log_lock);
+}
+
+static void log_shutdown(void) {
+  if (!atomic_exchange(&log_running, false)) return;
+  atomic_store(&log_stop, true);
+  log_wake_writer();
+  pthread_join(log_thread, NULL);
+}
+
+/**
+* Only the forking thread survives in the child, the writer is gone and the lock
+* may be held by a thread that no longer exists. Start over, whatever the parent
+* had queued is the parent's to write.
+*/
+static void log_atfork_child(void) {
+  pthread_mutex_init(&log_lock, NULL);
+  pthread_cond_init(&log_wake, NULL);
+  pthread_cond_init(&log_drained, NULL);
+
+  log_once = (pthread_once_t) PTHREAD_ONCE_INIT;
+  atomic_store(&log_running, false);
+  atomic_store(&log_stop, false);
+  atomic_store(&log_idle, false);
+  atomic_store(&log_head, 0);
+  atomic_store(&log_done, 0);
+  log_out.len = 0;
+  log_out.stream = NULL;
+}
+
+static void log_start(void) {
+  for (uint32_t i = 0; i < LOG_SLOTS; i++)
+    atomic_init(&log_ring[i].seq, i);
+
+  if (pthread_create(&log_thread, NULL, log_writer, NULL)) return;
+
+  atomic_store(&log_running, true);
+
+  /* Forked children start the writer again through log_once, register the handlers once */
+  if (log_hooked) return;
+  log_hooked = true;
+  atexit(log_shutdown);
+  pthread_atfork(NULL, NULL, log_atfork_child);
+}
+
+static bool log_enqueue(dlu_log_type type, FILE *stream, const char *fmt, va_list args) {
+  unsigned char buf[LOG_ARGS];
+  uint32_t len = 0;
+  struct log_slot *slot = NULL;
+  va_list cp;
+
+  if (!atomic_load_explicit(&log_on, memory_order_relaxed)) return false;
+
+  pthread_once(&log_once, log_start);
+  if (!atomic_load_explicit(&log_running, memory_order_relaxed)) return false;
+
+  va_copy(cp, args);
+  bool fits = log_encode(buf, &len, fmt, cp);
+  va_end(cp);
+  if (!fits) return false;
+
+  /* Claim a slot, a full ring makes the caller write synchronously */
+  uint64_t pos = atomic_load_explicit(&log_head, memory_order_relaxed);
+  for (;;) {
+    slot = &log_ring[pos & (LOG_SLOTS - 1)];
+    int64_t diff = (int64_t) (atomic_load_explicit(&slot->seq, memory_order_acquire) - pos);
+    if (diff == 0) {
+      if (atomic_compare_exchange_weak_explicit(&log_head, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) break;
+    } else if (diff < 0) {
+      return false;
+    } else {
+      pos = atomic_load_explicit(&log_head, memory_order_relaxed);
+    }
+  }
+
+  slot->type = type;
+  slot->stream = stream;
+  /* Not copied, fmt is a literal for every dlu_log_* macro (see log.h) */
+  slot->fmt = fmt;
+  clock_gettime(CLOCK_REALTIME, &slot->ts);
+  memcpy(slot->args, buf, len);
+
+  /* seq_cst, pairs with the writer setting log_idle before its last look */
+  atomic_store(&slot->seq, pos + 1);
+  if (atomic_load(&log_idle)) log_wake_writer();
+
+  return true;
+}
+
+static void log_write(dlu_log_type type, FILE *stream, const char *fmt, va_list args) {
   char buffer[26];
-  va_list args; /* type that holds variable arguments */
 
   /* create message time stamp */
   time_t rawtime = time(NULL);
@@ -48,18 +426,71 @@ void _dlu_log_me(dlu_log_type type, FILE *stream, const char *fmt, ...) {
 
   /* Set terminal color */
   fprintf(stream, term_colors[type]);
-  va_start(args, fmt);
   vfprintf(stream, fmt, args);
-  va_end(args); /* Reset terminal color */
   fprintf(stream, term_colors[DLU_RESET]);
 
   fprintf(stream, "\n");
   fflush(stream);
 }
 
+void _dlu_log_me(dlu_log_type type, FILE *stream, const char *fmt, ...) {
+  va_list args; /* type that holds variable arguments */
+
+  va_start(args, fmt);
+  if (!log_enqueue(type, stream, fmt, args)) {
+    /* Oversized message or full ring, let what's queued out first to keep the order */
+    dlu_log_flush();
+    log_write(type, stream, fmt, args);
+  } else if (type == DLU_DANGER) {
+    /* Errors tend to come right before exiting, don't leave them queued */
+    dlu_log_flush();
+  }
+  va_end(args);
+}
+
+/* Debug messages are compiled in with -Dlog_level=debug, dlu_log_set_level() still has to turn them on */
+unsigned char _dlu_log_levels[DLU_LOG_MODULE_MAX] = { [0 ... DLU_LOG_MODULE_MAX - 1] = DLU_LOG_LEVEL_INFO };
+
+void dlu_log_set_level(dlu_log_module module, dlu_log_level level) {
+  for (uint32_t i = 0; i < DLU_LOG_MODULE_MAX; i++)
+    if (module == DLU_LOG_MODULE_MAX || module == i)
+      __atomic_store_n(&_dlu_log_levels[i], level, __ATOMIC_RELAXED);
+}
+
+bool _dlu_log_ratelimit(uint64_t *last, uint64_t interval_ns) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  uint64_t now = (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+  uint64_t prev = __atomic_load_n(last, __ATOMIC_RELAXED);
+
+  /* Only the thread that moves last forward gets to log */
+  if (prev && now - prev < interval_ns) return false;
+  return __atomic_compare_exchange_n(last, &prev, now, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+}
+
+void dlu_log_flush(void) {
+  if (!atomic_load_explicit(&log_running, memory_order_acquire)) return;
+
+  uint64_t head = atomic_load_explicit(&log_head, memory_order_acquire);
+
+  pthread_mutex_lock(&log_lock);
+  pthread_cond_signal(&log_wake);
+  while (atomic_load_explicit(&log_done, memory_order_acquire) < head && atomic_load(&log_running))
+    pthread_cond_wait(&log_drained, &log_lock);
+  pthread_mutex_unlock(&log_lock);
+}
+
+void dlu_log_async(bool enable) {
+  if (!enable) dlu_log_flush();
+  atomic_store_explicit(&log_on, enable, memory_order_relaxed);
+}
+
 void _dlu_print_me(dlu_log_type type, const char *msg, ...) {
   va_list args;
 
+  dlu_log_flush();
+
   /* Set terminal color */
   fprintf(stdout, term_colors[type]);
   va_start(args, msg);
@@ -281,6 +281,8 @@ bool dlu_otma(dlu_block_type type, dlu_otma_mems ma) {
 
   size += (ma.desc_cnt) ? (BLOCK_SIZE + (ma.desc_cnt * sizeof(VkDescriptorSet))) : 0;
   size += (ma.desc_cnt) ? (BLOCK_SIZE + (ma.desc_cnt * sizeof(VkDescriptorSetLayout))) : 0;
+  size += (ma.desc_cnt) ? (BLOCK_SIZE + (ma.desc_cnt * sizeof(VkDescriptorUpdateTemplateKHR))) : 0;
+  size += (ma.desc_cnt) ? (BLOCK_SIZE + (ma.desc_cnt * sizeof(struct _desc_tmpl))) : 0;
   size += (ma.dd_cnt  ) ? (BLOCK_SIZE + (ma.dd_cnt * sizeof(struct _desc_data))) : 0;
 
   size += (ma.td_cnt ) ? (BLOCK_SIZE + (ma.td_cnt * sizeof(struct _text_data))) : 0;
@@ -366,9 +368,11 @@ bool dlu_otba(dlu_data_type type, void *addr, uint32_t index, uint32_t arr_size)
         app->text_data = dlu_alloc(DLU_SMALL_BLOCK_PRIV, arr_size * sizeof(struct _text_data));
         if (!app->text_data) { PERR(DLU_ALLOC_FAILED, 0, NULL); return false; }
 
-        /* Populate ldi for error checking */
-        for (uint32_t i = 0; i < arr_size; i++)
-          app->gp_data[i].ldi = UINT32_MAX;
+        /* Populate ldi for error checking, textures don't start out in the bindless table */
+        for (uint32_t i = 0; i < arr_size; i++) {
+          app->text_data[i].ldi = UINT32_MAX;
+          app->text_data[i].slot = UINT32_MAX;
+        }
 
         app->tdc = arr_size; return true;
       }
@@ -420,6 +424,7 @@ bool dlu_otba(dlu_data_type type, void *addr, uint32_t index, uint32_t arr_size)
         /* Allocate Semaphores */
         app->sc_data[index].syncs = dlu_alloc(DLU_SMALL_BLOCK_PRIV, arr_size * sizeof(struct _synchronizers));
         if (!app->sc_data[index].syncs) { PERR(DLU_ALLOC_FAILED, 0, NULL); return false; }
+        app->sc_data[index].sbc = arr_size;
         app->sc_data[index].sic = arr_size; return true;
       }
     case DLU_DESC_DATA_MEMS:
@@ -432,6 +437,12 @@ bool dlu_otba(dlu_data_type type, void *addr, uint32_t index, uint32_t arr_size)
         app->desc_data[index].desc_set = dlu_alloc(DLU_SMALL_BLOCK_PRIV, arr_size * sizeof(VkDescriptorSet));
         if (!app->desc_data[index].desc_set) { PERR(DLU_ALLOC_FAILED, 0, NULL); return false; }
 
+        app->desc_data[index].templates = dlu_alloc(DLU_SMALL_BLOCK_PRIV, arr_size * sizeof(VkDescriptorUpdateTemplateKHR));
+        if (!app->desc_data[index].templates) { PERR(DLU_ALLOC_FAILED, 0, NULL); return false; }
+
+        app->desc_data[index].tmpl_entries = dlu_alloc(DLU_SMALL_BLOCK_PRIV, arr_size * sizeof(struct _desc_tmpl));
+        if (!app->desc_data[index].tmpl_entries) { PERR(DLU_ALLOC_FAILED, 0, NULL); return false; }
+
         app->desc_data[index].dlsc = arr_size; return true;
       }
     case DLU_GP_DATA_MEMS:
@@ -446,6 +457,12 @@ bool dlu_otba(dlu_data_type type, void *addr, uint32_t index, uint32_t arr_size)
         dlu_drm_core *core = (dlu_drm_core *) addr;
         core->output_data = dlu_alloc(DLU_SMALL_BLOCK_PRIV, arr_size * sizeof(struct _output_data));
         if (!core->output_data) { PERR(DLU_ALLOC_FAILED, 0, NULL); return false; }
+
+        for (uint32_t i = 0; i < arr_size; i++) {
+          core->output_data[i].queued_bi = UINT32_MAX;
+          core->output_data[i].flip_bi = UINT32_MAX;
+        }
+
         core->odc = arr_size; return true;
       }
     case DLU_DEVICE_OUTPUT_BUFF_DATA:
@@ -457,6 +474,7 @@ bool dlu_otba(dlu_data_type type, void *addr, uint32_t index, uint32_t arr_size)
         for (uint32_t i = 0; i < arr_size; i++) {
           core->buff_data[i].fb_id = UINT32_MAX;
           core->buff_data[i].odid = UINT32_MAX;
+          core->buff_data[i].input_ns = 0;
           for (uint32_t j = 0; j < 4; j++)
             core->buff_data[i].dma_buf_fds[j] = NEG_ONE;
         }
@@ -0,0 +1,220 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright (c) 2019-2020 Vincent Davis Jr.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*/
+
+#define LUCUR_CLOCK_API
+#include <lucom.h>
+
+#include <stdatomic.h>
+#include <sys/syscall.h>
+
+#define PROF_RING 4096 /* Zones kept per thread, power of two */
+#define PROF_WINDOW 1024 /* Samples per phase used for p50/p99/max */
+
+static const char *phase_names[DLU_PROF_PHASE_MAX] = {
+  "acquire", "record", "submit", "present", "atomic_commit", "input", "user",
+  "input_to_photon"
+};
+
+struct prof_event {
+  uint64_t start;
+  uint64_t dur;
+  const char *name;
+  dlu_prof_phase phase;
+};
+
+/* Single writer (the owning thread), any number of readers */
+struct prof_thread {
+  struct prof_thread *next;
+  pid_t tid;
+  _Atomic uint64_t head;
+  struct prof_event ring[PROF_RING];
+};
+
+static _Atomic bool prof_on = false;
+static struct prof_thread *_Atomic prof_threads = NULL;
+static _Thread_local struct prof_thread *prof_self = NULL;
+
+/* Bumped by dlu_prof_freeup(), a thread's cached ring is only valid for the generation it was made in */
+static _Atomic uint64_t prof_gen = 1;
+static _Thread_local uint64_t prof_self_gen = 0;
+static _Thread_local uint64_t prof_marks[DLU_PROF_PHASE_MAX];
+
+static struct {
+  _Atomic uint64_t next;
+  _Atomic uint64_t samples[PROF_WINDOW];
+} prof_window[DLU_PROF_PHASE_MAX];
+
+void dlu_prof_enable(bool enable) {
+  atomic_store_explicit(&prof_on, enable, memory_order_relaxed);
+}
+
+bool dlu_prof_enabled(void) {
+  return atomic_load_explicit(&prof_on, memory_order_relaxed);
+}
+
+/* First zone on a thread allocates its ring and pushes it onto the global list */
+static struct prof_thread *prof_thread_get(void) {
+  uint64_t gen = atomic_load_explicit(&prof_gen, memory_order_acquire);
+  if (prof_self && prof_self_gen == gen) return prof_self;
+
+  struct prof_thread *thread = calloc(1, sizeof(struct prof_thread));
+  if (!thread) { dlu_log_me(DLU_DANGER, "[x] calloc: %s", strerror(errno)); return NULL; }
+
+  thread->tid = syscall(SYS_gettid);
+  thread->next = atomic_load_explicit(&prof_threads, memory_order_relaxed);
+  while (!atomic_compare_exchange_weak_explicit(&prof_threads, &thread->next, thread, memory_order_release, memory_order_relaxed));
+
+  prof_self = thread;
+  prof_self_gen = gen;
+  return thread;
+}
+
+void dlu_prof_record(dlu_prof_phase phase, const char *name, uint64_t start, uint64_t end) {
+  if (!dlu_prof_enabled() || phase >= DLU_PROF_PHASE_MAX) return;
+
+  struct prof_thread *thread = prof_thread_get();
+  if (!thread) return;
+
+  uint64_t head = atomic_load_explicit(&thread->head, memory_order_relaxed);
+  struct prof_event *event = &thread->ring[head & (PROF_RING - 1)];
+  event->start = start;
+  event->dur = end - start;
+  event->name = (name) ? name : phase_names[phase];
+  event->phase = phase;
+
+  /* Publish the event, readers only look at entries below head */
+  atomic_store_explicit(&thread->head, head + 1, memory_order_release);
+
+  uint64_t idx = atomic_fetch_add_explicit(&prof_window[phase].next, 1, memory_order_relaxed);
+  atomic_store_explicit(&prof_window[phase].samples[idx % PROF_WINDOW], end - start, memory_order_relaxed);
+}
+
+dlu_prof_zone dlu_prof_zone_begin(dlu_prof_phase phase, const char *name) {
+  dlu_prof_zone zone = { phase, name, (dlu_prof_enabled()) ? dlu_hrnst() : 0 };
+  return zone;
+}
+
+void dlu_prof_zone_end(dlu_prof_zone *zone) {
+  if (!zone->start) return; /* Profiler was off when the zone opened */
+  dlu_prof_record(zone->phase, zone->name, zone->start, dlu_hrnst());
+}
+
+void dlu_prof_mark_begin(dlu_prof_phase phase) {
+  if (phase >= DLU_PROF_PHASE_MAX) return;
+  prof_marks[phase] = (dlu_prof_enabled()) ? dlu_hrnst() : 0;
+}
+
+void dlu_prof_mark_end(dlu_prof_phase phase, const char *name) {
+  if (phase >= DLU_PROF_PHASE_MAX || !prof_marks[phase]) return;
+  dlu_prof_record(phase, name, prof_marks[phase], dlu_hrnst());
+  prof_marks[phase] = 0;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+  return (x > y) - (x < y);
+}
+
+bool dlu_prof_get_stats(dlu_prof_phase phase, dlu_prof_stats *stats) {
+  if (phase >= DLU_PROF_PHASE_MAX) return false;
+
+  memset(stats, 0, sizeof(dlu_prof_stats));
+
+  uint64_t n = atomic_load_explicit(&prof_window[phase].next, memory_order_relaxed);
+  if (n > PROF_WINDOW) n = PROF_WINDOW;
+  if (!n) return true;
+
+  uint64_t *samples = calloc(n, sizeof(uint64_t));
+  if (!samples) { dlu_log_me(DLU_DANGER, "[x] calloc: %s", strerror(errno)); return false; }
+
+  for (uint64_t i = 0; i < n; i++)
+    samples[i] = atomic_load_explicit(&prof_window[phase].samples[i], memory_order_relaxed);
+
+  qsort(samples, n, sizeof(uint64_t), cmp_u64);
+  stats->count = n;
+  stats->p50 = samples[(n - 1) * 50 / 100];
+  stats->p99 = samples[(n - 1) * 99 / 100];
+  stats->max = samples[n - 1];
+
+  free(samples);
+  return true;
+}
+
+/* Zone names are expected to be plain identifiers, but don't let one break the JSON */
+static void json_puts(FILE *stream, const char *str) {
+  for (; *str; str++) {
+    if (*str == '"' || *str == '\\') fputc('\\', stream);
+    if ((unsigned char) *str >= 0x20) fputc(*str, stream);
+  }
+}
+
+bool dlu_prof_export_chrome(const char *path) {
+  FILE *stream = fopen(path, "w");
+  if (!stream) { dlu_log_me(DLU_DANGER, "[x] fopen: %s", strerror(errno)); return false; }
+
+  bool first = true;
+  pid_t pid = getpid();
+
+  fprintf(stream, "{\"traceEvents\":[");
+  for (struct prof_thread *thread = atomic_load_explicit(&prof_threads, memory_order_acquire); thread; thread = thread->next) {
+    uint64_t head = atomic_load_explicit(&thread->head, memory_order_acquire);
+    uint64_t tail = (head > PROF_RING) ? head - PROF_RING : 0;
+
+    for (uint64_t i = tail; i < head; i++) {
+      struct prof_event event = thread->ring[i & (PROF_RING - 1)];
+
+      /* The owner may have lapped us while reading, drop anything it could have overwritten */
+      uint64_t now = atomic_load_explicit(&thread->head, memory_order_acquire);
+      if (now > PROF_RING && i < now - PROF_RING) continue;
+
+      fprintf(stream, "%s\n{\"name\":\"", (first) ? "" : ",");
+      json_puts(stream, event.name);
+      fprintf(stream, "\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%d}",
+              phase_names[event.phase], event.start / 1000.0, event.dur / 1000.0, pid, thread->tid);
+      first = false;
+    }
+  }
+  fprintf(stream, "\n],\"displayTimeUnit\":\"ns\"}\n");
+
+  if (fclose(stream)) { dlu_log_me(DLU_DANGER, "[x] fclose: %s", strerror(errno)); return false; }
+  return true;
+}
+
+void dlu_prof_freeup(void) {
+  /* Other threads still hold their old ring, the new generation makes them drop it on their next zone */
+  atomic_fetch_add_explicit(&prof_gen, 1, memory_order_release);
+
+  struct prof_thread *thread = atomic_exchange_explicit(&prof_threads, NULL, memory_order_acquire);
+
+  while (thread) {
+    struct prof_thread *next = thread->next;
+    free(thread);
+    thread = next;
+  }
+
+  prof_self = NULL;
+
+  for (uint32_t i = 0; i < DLU_PROF_PHASE_MAX; i++)
+    atomic_store_explicit(&prof_window[i].next, 0, memory_order_relaxed);
+}
@@ -34,8 +34,10 @@ void dlu_bind_pipeline(
   VkPipelineBindPoint pipelineBindPoint
 ) {
 
-  vkCmdBindPipeline(app->cmd_data[cur_pool].cmd_buffs[cur_buff], pipelineBindPoint,
-                    app->gp_data[cur_gpd].graphics_pipelines[cur_pl]);
+  VkPipeline pipeline = (pipelineBindPoint == VK_PIPELINE_BIND_POINT_COMPUTE) ?
+    app->gp_data[cur_gpd].compute_pipelines[cur_pl] : app->gp_data[cur_gpd].graphics_pipelines[cur_pl];
+
+  DLU_CMD_VK(app, cur_pool).CmdBindPipeline(app->cmd_data[cur_pool].cmd_buffs[cur_buff], pipelineBindPoint, pipeline);
 }
 
 void dlu_bind_desc_sets(
@@ -50,8 +52,8 @@ void dlu_bind_desc_sets(
 ) {
   
   /* Predefine the firstSet argument to be 0 for ease of use. " 'firstSet' is the set number of the first descriptor set to be bound." */
-  vkCmdBindDescriptorSets(app->cmd_data[cur_pool].cmd_buffs[cur_buff], pipelineBindPoint, app->gp_data[cur_gpd].pipeline_layout, 0,
-                          app->desc_data[cur_dd].dlsc, app->desc_data[cur_dd].desc_set, dynamicOffsetCount, pDynamicOffsets);
+  DLU_CMD_VK(app, cur_pool).CmdBindDescriptorSets(app->cmd_data[cur_pool].cmd_buffs[cur_buff], pipelineBindPoint, app->gp_data[cur_gpd].pipeline_layout, 0,
+                                                  app->desc_data[cur_dd].dlsc, app->desc_data[cur_dd].desc_set, dynamicOffsetCount, pDynamicOffsets);
 }
 
 void dlu_bind_vertex_buff_to_cmd_buff(
@@ -64,7 +66,7 @@ void dlu_bind_vertex_buff_to_cmd_buff(
 ) {
 
   /* The only way the offsets variable makes since is to bind one VkBuffer to a command buffer */ 
-  vkCmdBindVertexBuffers(app->cmd_data[cur_pool].cmd_buffs[cur_buff], firstBinding, 1, &app->buff_data[cur_bd].buff, offsets);
+  DLU_CMD_VK(app, cur_pool).CmdBindVertexBuffers(app->cmd_data[cur_pool].cmd_buffs[cur_buff], firstBinding, 1, &app->buff_data[cur_bd].buff, offsets);
 }
 
 void dlu_bind_index_buff_to_cmd_buff(
@@ -76,5 +78,5 @@ void dlu_bind_index_buff_to_cmd_buff(
   VkIndexType indexType
 ) {
 
-  vkCmdBindIndexBuffer(app->cmd_data[cur_pool].cmd_buffs[cur_buff], app->buff_data[cur_bd].buff, offset, indexType);
+  DLU_CMD_VK(app, cur_pool).CmdBindIndexBuffer(app->cmd_data[cur_pool].cmd_buffs[cur_buff], app->buff_data[cur_bd].buff, offset, indexType);
 }
@@ -0,0 +1,262 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright (c) 2019-2020 Vincent Davis Jr.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*/
+
+#define LUCUR_VKCOMP_API
+#include <lucom.h>
+
+static uint32_t max_update_after_bind(vkcomp *app, uint32_t cur_ld) {
+  VkPhysicalDevice phys_dev = app->pd_data[app->ld_data[cur_ld].pdi].phys_dev;
+
+  PFN_vkGetPhysicalDeviceProperties2KHR get_props2 = (PFN_vkGetPhysicalDeviceProperties2KHR)
+    vkGetInstanceProcAddr(app->instance, "vkGetPhysicalDeviceProperties2KHR");
+
+  if (!get_props2) {
+    VkPhysicalDeviceProperties props;
+    vkGetPhysicalDeviceProperties(phys_dev, &props);
+    return props.limits.maxPerStageDescriptorSamplers;
+  }
+
+  VkPhysicalDeviceDescriptorIndexingPropertiesEXT idx_props = {};
+  idx_props.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+  idx_props.pNext = NULL;
+
+  VkPhysicalDeviceProperties2 props2 = {};
+  props2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+  props2.pNext = &idx_props;
+
+  get_props2(phys_dev, &props2);
+
+  uint32_t limit = idx_props.maxPerStageDescriptorUpdateAfterBindSamplers;
+  if (idx_props.maxPerStageDescriptorUpdateAfterBindSampledImages < limit) limit = idx_props.maxPerStageDescriptorUpdateAfterBindSampledImages;
+  if (idx_props.maxDescriptorSetUpdateAfterBindSamplers < limit) limit = idx_props.maxDescriptorSetUpdateAfterBindSamplers;
+  if (idx_props.maxDescriptorSetUpdateAfterBindSampledImages < limit) limit = idx_props.maxDescriptorSetUpdateAfterBindSampledImages;
+
+  return limit;
+}
+
+/* Moves released slots whose last frame has retired onto the free list */
+static void reclaim_slots(vkcomp *app) {
+  struct _bindless *bl = &app->bindless;
+  uint64_t completed = app->ld_data[bl->ldi].deferred.completed;
+
+  for (uint32_t i = 0; i < bl->rsc;) {
+    if (bl->retired[i].frame < completed) {
+      bl->free_slots[bl->fsc++] = bl->retired[i].slot;
+      bl->retired[i] = bl->retired[--bl->rsc];
+    } else {
+      i++;
+    }
+  }
+}
+
+VkResult dlu_create_bindless_table(vkcomp *app, uint32_t cur_ld, uint32_t capacity, VkShaderStageFlags stageFlags) {
+  VkResult res = VK_RESULT_MAX_ENUM;
+  struct _bindless *bl = &app->bindless;
+
+  if (!app->ld_data[cur_ld].device) { PERR(DLU_VKCOMP_DEVICE, 0, NULL); return res; }
+  if (!app->ld_data[cur_ld].desc_indexing) {
+    dlu_log_me(DLU_DANGER, "[x] %s not enabled on this device", VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+    return res;
+  }
+
+  if (bl->set) {
+    dlu_log_me(DLU_WARNING, "Bindless texture table already created");
+    return VK_SUCCESS;
+  }
+
+  /**
+  * Stay within what a single shader stage can see. Update after bind sets have
+  * their own (usually far larger) limits, a combined image sampler counts
+  * against both the sampler and sampled image ones
+  */
+  uint32_t limit = max_update_after_bind(app, cur_ld);
+  if (capacity > limit) {
+    dlu_log_me(DLU_WARNING, "Bindless capacity %u clamped to %u", capacity, limit);
+    capacity = limit;
+  }
+
+  bl->free_slots = calloc(capacity, sizeof(uint32_t));
+  bl->retired = calloc(capacity, sizeof(struct _bindless_retired));
+  if (!bl->free_slots || !bl->retired) {
+    dlu_log_me(DLU_DANGER, "[x] calloc: %s", strerror(errno));
+    goto err_free;
+  }
+
+  bl->binding.binding = 0;
+  bl->binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  bl->binding.descriptorCount = capacity;
+  bl->binding.stageFlags = stageFlags;
+  bl->binding.pImmutableSamplers = NULL;
+
+  /**
+  * Unused slots are never touched by the GPU, and slots may be written while the set is bound.
+  * Unused while pending lets slots no pending command buffer samples be rewritten
+  */
+  bl->binding_flags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT;
+  if (app->ld_data[cur_ld].desc_unused_pending)
+    bl->binding_flags |= VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT;
+
+  bl->flags_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+  bl->flags_info.pNext = NULL;
+  bl->flags_info.bindingCount = 1;
+  bl->flags_info.pBindingFlags = &bl->binding_flags;
+
+  bl->layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  bl->layout_info.pNext = &bl->flags_info;
+  bl->layout_info.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+  bl->layout_info.bindingCount = 1;
+  bl->layout_info.pBindings = &bl->binding;
+
+  res = vkCreateDescriptorSetLayout(app->ld_data[cur_ld].device, &bl->layout_info, NULL, &bl->layout);
+  if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkCreateDescriptorSetLayout"); goto err_free; }
+
+  VkDescriptorPoolSize pool_size = {};
+  pool_size.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  pool_size.descriptorCount = capacity;
+
+  VkDescriptorPoolCreateInfo pool_info = {};
+  pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  pool_info.pNext = NULL;
+  pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+  pool_info.maxSets = 1;
+  pool_info.poolSizeCount = 1;
+  pool_info.pPoolSizes = &pool_size;
+
+  res = vkCreateDescriptorPool(app->ld_data[cur_ld].device, &pool_info, NULL, &bl->pool);
+  if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkCreateDescriptorPool"); goto err_layout; }
+
+  VkDescriptorSetAllocateInfo alloc_info = {};
+  alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  alloc_info.pNext = NULL;
+  alloc_info.descriptorPool = bl->pool;
+  alloc_info.descriptorSetCount = 1;
+  alloc_info.pSetLayouts = &bl->layout;
+
+  res = vkAllocateDescriptorSets(app->ld_data[cur_ld].device, &alloc_info, &bl->set);
+  if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkAllocateDescriptorSets"); goto err_pool; }
+
+  bl->capacity = capacity;
+  bl->used = bl->fsc = bl->rsc = 0;
+  bl->ldi = cur_ld;
+
+  return res;
+
+err_pool:
+  vkDestroyDescriptorPool(app->ld_data[cur_ld].device, bl->pool, NULL);
+  bl->pool = VK_NULL_HANDLE;
+err_layout:
+  vkDestroyDescriptorSetLayout(app->ld_data[cur_ld].device, bl->layout, NULL);
+  bl->layout = VK_NULL_HANDLE;
+err_free:
+  free(bl->free_slots);
+  free(bl->retired);
+  bl->free_slots = NULL;
+  bl->retired = NULL;
+  return res;
+}
+
+const VkDescriptorSetLayoutCreateInfo *dlu_get_bindless_layout_info(vkcomp *app) {
+  if (!app->bindless.set) { PERR(DLU_VKCOMP_BINDLESS, 0, NULL); return NULL; }
+  return &app->bindless.layout_info;
+}
+
+VkResult dlu_bindless_register_texture(vkcomp *app, uint32_t cur_tex, VkImageLayout imageLayout) {
+  VkResult res = VK_RESULT_MAX_ENUM;
+  struct _bindless *bl = &app->bindless;
+  uint32_t slot = 0;
+
+  if (!bl->set) { PERR(DLU_VKCOMP_BINDLESS, 0, NULL); return res; }
+  if (!app->text_data) { PERR(DLU_BUFF_NOT_ALLOC, 0, "DLU_TEXT_DATA"); return res; }
+  if (!app->text_data[cur_tex].view || !app->text_data[cur_tex].sampler) {
+    dlu_log_me(DLU_DANGER, "[x] text_data[%u] needs both an image view and a sampler", cur_tex);
+    return res;
+  }
+
+  if (!bl->fsc && bl->rsc) reclaim_slots(app);
+  if (!bl->fsc && bl->rsc && bl->used == bl->capacity) {
+    /* Only poll fences when the table would otherwise be full */
+    dlu_defer_collect(app, bl->ldi);
+    reclaim_slots(app);
+  }
+
+  if (app->text_data[cur_tex].slot != UINT32_MAX) {
+    slot = app->text_data[cur_tex].slot; /* Re-register rewrites the descriptor in place */
+  } else if (bl->fsc) {
+    slot = bl->free_slots[--bl->fsc];
+  } else if (bl->used < bl->capacity) {
+    slot = bl->used++;
+  } else {
+    dlu_log_me(DLU_DANGER, "[x] Bindless texture table full (%u slots)", bl->capacity);
+    return res;
+  }
+
+  VkDescriptorImageInfo img_info = {};
+  img_info.sampler = app->text_data[cur_tex].sampler;
+  img_info.imageView = app->text_data[cur_tex].view;
+  img_info.imageLayout = imageLayout;
+
+  VkWriteDescriptorSet write = dlu_write_desc_set(bl->set, 0, slot, 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, &img_info, NULL, NULL);
+  DLU_VK(app, bl->ldi).UpdateDescriptorSets(app->ld_data[bl->ldi].device, 1, &write, 0, NULL);
+
+  app->text_data[cur_tex].slot = slot;
+
+  return VK_SUCCESS;
+}
+
+void dlu_bindless_release_texture(vkcomp *app, uint32_t cur_tex) {
+  struct _bindless *bl = &app->bindless;
+
+  if (!bl->set || !app->text_data || app->text_data[cur_tex].slot == UINT32_MAX) return;
+
+  /* Command buffers already recorded may still sample the slot, hold it until their frame retires */
+  bl->retired[bl->rsc].slot = app->text_data[cur_tex].slot;
+  bl->retired[bl->rsc++].frame = dlu_defer_frame(app, bl->ldi);
+  app->text_data[cur_tex].slot = UINT32_MAX;
+}
+
+void dlu_bind_bindless_table(
+  vkcomp *app,
+  uint32_t cur_pool,
+  uint32_t cur_buff,
+  uint32_t cur_gpd,
+  VkPipelineBindPoint pipelineBindPoint,
+  uint32_t set
+) {
+
+  DLU_CMD_VK(app, cur_pool).CmdBindDescriptorSets(app->cmd_data[cur_pool].cmd_buffs[cur_buff], pipelineBindPoint, app->gp_data[cur_gpd].pipeline_layout,
+                                                  set, 1, &app->bindless.set, 0, NULL);
+}
+
+void dlu_freeup_bindless_table(vkcomp *app) {
+  struct _bindless *bl = &app->bindless;
+
+  if (bl->pool) /* Frees the set as well */
+    vkDestroyDescriptorPool(app->ld_data[bl->ldi].device, bl->pool, NULL);
+  if (bl->layout)
+    vkDestroyDescriptorSetLayout(app->ld_data[bl->ldi].device, bl->layout, NULL);
+
+  free(bl->free_slots);
+  free(bl->retired);
+  memset(bl, 0, sizeof(struct _bindless));
+}
@@ -0,0 +1,877 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright (c) 2019-2020 Vincent Davis Jr.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*/
+
+#define LUCUR_VKCOMP_API
+#include <lucom.h>
+
+#include <stddef.h>
+
+#define FNV_PRIME 0x100000001b3ULL
+
+uint64_t dlu_hash_bytes(uint64_t hash, const void *data, size_t size) {
+  const unsigned char *bytes = data;
+
+  for (size_t i = 0; i < size; i++) {
+    hash ^= bytes[i];
+    hash *= FNV_PRIME;
+  }
+
+  return hash;
+}
+
+/* Append size bytes to key at off. When key is NULL only the size is accumulated */
+static size_t key_put(unsigned char *key, size_t off, const void *data, size_t size) {
+  if (key && size) memcpy(key + off, data, size);
+  return off + size;
+}
+
+/**
+* Flatten a VkRenderPassCreateInfo into a byte string. Every struct copied
+* here is made up of 32-bit members so there's no padding to worry about.
+* Optional arrays are prefixed with their element count so NULL and empty differ.
+*/
+static size_t rp_key(unsigned char *key, const VkRenderPassCreateInfo *info) {
+  size_t off = 0;
+  uint32_t cnt = 0;
+
+  off = key_put(key, off, &info->flags, sizeof(info->flags));
+  off = key_put(key, off, &info->attachmentCount, sizeof(uint32_t));
+  off = key_put(key, off, info->pAttachments, info->attachmentCount * sizeof(VkAttachmentDescription));
+
+  off = key_put(key, off, &info->subpassCount, sizeof(uint32_t));
+  for (uint32_t i = 0; i < info->subpassCount; i++) {
+    const VkSubpassDescription *sp = &info->pSubpasses[i];
+    off = key_put(key, off, &sp->flags, sizeof(sp->flags));
+    off = key_put(key, off, &sp->pipelineBindPoint, sizeof(sp->pipelineBindPoint));
+    off = key_put(key, off, &sp->inputAttachmentCount, sizeof(uint32_t));
+    off = key_put(key, off, sp->pInputAttachments, sp->inputAttachmentCount * sizeof(VkAttachmentReference));
+    off = key_put(key, off, &sp->colorAttachmentCount, sizeof(uint32_t));
+    off = key_put(key, off, sp->pColorAttachments, sp->colorAttachmentCount * sizeof(VkAttachmentReference));
+
+    cnt = (sp->pResolveAttachments) ? sp->colorAttachmentCount : 0;
+    off = key_put(key, off, &cnt, sizeof(uint32_t));
+    off = key_put(key, off, sp->pResolveAttachments, cnt * sizeof(VkAttachmentReference));
+
+    cnt = (sp->pDepthStencilAttachment) ? 1 : 0;
+    off = key_put(key, off, &cnt, sizeof(uint32_t));
+    off = key_put(key, off, sp->pDepthStencilAttachment, cnt * sizeof(VkAttachmentReference));
+
+    off = key_put(key, off, &sp->preserveAttachmentCount, sizeof(uint32_t));
+    off = key_put(key, off, sp->pPreserveAttachments, sp->preserveAttachmentCount * sizeof(uint32_t));
+  }
+
+  off = key_put(key, off, &info->dependencyCount, sizeof(uint32_t));
+  off = key_put(key, off, info->pDependencies, info->dependencyCount * sizeof(VkSubpassDependency));
+
+  return off;
+}
+
+/**
+* Append the members of *s from first through last. Lets a struct be copied
+* without its sType/pNext header or any pointer members, and without trailing padding.
+*/
+#define KEY_PUT_RANGE(key, off, s, first, last) \
+  key_put(key, off, &(s)->first, offsetof(__typeof__(*(s)), last) + sizeof((s)->last) - offsetof(__typeof__(*(s)), first))
+
+static struct _shader_cache_entry *shader_find(vkcomp *app, uint32_t cur_ld, VkShaderModule module) {
+  for (uint32_t i = 0; i < app->shader_cache.count; i++)
+    if (app->shader_cache.entries[i].module == module && app->shader_cache.entries[i].ldi == cur_ld)
+      return &app->shader_cache.entries[i];
+  return NULL;
+}
+
+/**
+* Modules made by dlu_create_shader_module() are keyed by their SPIR-V, so equal
+* code in two modules is one pipeline and the module can go away without the pipeline.
+* Anything else falls back to the handle.
+*/
+static size_t pso_stage_key(vkcomp *app, uint32_t cur_ld, unsigned char *key, size_t off, const VkPipelineShaderStageCreateInfo *stage) {
+  struct _shader_cache_entry *shader = shader_find(app, cur_ld, stage->module);
+  uint32_t cnt = 0;
+
+  off = key_put(key, off, &stage->flags, sizeof(stage->flags));
+  off = key_put(key, off, &stage->stage, sizeof(stage->stage));
+
+  cnt = (shader) ? 1 : 0;
+  off = key_put(key, off, &cnt, sizeof(uint32_t));
+  if (shader) {
+    off = key_put(key, off, &shader->hash, sizeof(shader->hash));
+    off = key_put(key, off, &shader->code_size, sizeof(shader->code_size));
+  } else {
+    off = key_put(key, off, &stage->module, sizeof(stage->module));
+  }
+
+  off = key_put(key, off, stage->pName, strlen(stage->pName) + 1);
+
+  cnt = (stage->pSpecializationInfo) ? 1 : 0;
+  off = key_put(key, off, &cnt, sizeof(uint32_t));
+  if (cnt) {
+    const VkSpecializationInfo *spec = stage->pSpecializationInfo;
+    off = key_put(key, off, &spec->mapEntryCount, sizeof(uint32_t));
+    off = key_put(key, off, spec->pMapEntries, spec->mapEntryCount * sizeof(VkSpecializationMapEntry));
+    off = key_put(key, off, &spec->dataSize, sizeof(size_t));
+    off = key_put(key, off, spec->pData, spec->dataSize);
+  }
+
+  return off;
+}
+
+/**
+* Flatten a VkGraphicsPipelineCreateInfo into a byte string. The family part
+* (shader stages, layout, render pass, subpass) comes first, family_size
+* is set to its length so the family can be hashed on its own.
+*/
+size_t dlu_cache_pso_key(vkcomp *app, uint32_t cur_ld, unsigned char *key, const VkGraphicsPipelineCreateInfo *info, size_t *family_size) {
+  size_t off = 0;
+  uint32_t cnt = 0;
+
+  off = key_put(key, off, &info->stageCount, sizeof(uint32_t));
+  for (uint32_t i = 0; i < info->stageCount; i++)
+    off = pso_stage_key(app, cur_ld, key, off, &info->pStages[i]);
+
+  off = key_put(key, off, &info->layout, sizeof(VkPipelineLayout));
+  off = key_put(key, off, &info->renderPass, sizeof(VkRenderPass));
+  off = key_put(key, off, &info->subpass, sizeof(uint32_t));
+  *family_size = off;
+
+  off = key_put(key, off, &info->flags, sizeof(info->flags));
+
+  cnt = (info->pVertexInputState) ? 1 : 0;
+  off = key_put(key, off, &cnt, sizeof(uint32_t));
+  if (cnt) {
+    const VkPipelineVertexInputStateCreateInfo *vi = info->pVertexInputState;
+    off = key_put(key, off, &vi->flags, sizeof(vi->flags));
+    off = key_put(key, off, &vi->vertexBindingDescriptionCount, sizeof(uint32_t));
+    off = key_put(key, off, vi->pVertexBindingDescriptions, vi->vertexBindingDescriptionCount * sizeof(VkVertexInputBindingDescription));
+    off = key_put(key, off, &vi->vertexAttributeDescriptionCount, sizeof(uint32_t));
+    off = key_put(key, off, vi->pVertexAttributeDescriptions, vi->vertexAttributeDescriptionCount * sizeof(VkVertexInputAttributeDescription));
+  }
+
+  cnt = (info->pInputAssemblyState) ? 1 : 0;
+  off = key_put(key, off, &cnt, sizeof(uint32_t));
+  if (cnt) off = KEY_PUT_RANGE(key, off, info->pInputAssemblyState, flags, primitiveRestartEnable);
+
+  cnt = (info->pTessellationState) ? 1 : 0;
+  off = key_put(key, off, &cnt, sizeof(uint32_t));
+  if (cnt) off = KEY_PUT_RANGE(key, off, info->pTessellationState, flags, patchControlPoints);
+
+  cnt = (info->pViewportState) ? 1 : 0;
+  off = key_put(key, off, &cnt, sizeof(uint32_t));
+  if (cnt) {
+    const VkPipelineViewportStateCreateInfo *vp = info->pViewportState;
+    off = key_put(key, off, &vp->flags, sizeof(vp->flags));
+    cnt = (vp->pViewports) ? vp->viewportCount : 0; /* NULL when viewports are dynamic */
+    off = key_put(key, off, &vp->viewportCount, sizeof(uint32_t));
+    off = key_put(key, off, vp->pViewports, cnt * sizeof(VkViewport));
+    cnt = (vp->pScissors) ? vp->scissorCount : 0;
+    off = key_put(key, off, &vp->scissorCount, sizeof(uint32_t));
+    off = key_put(key, off, vp->pScissors, cnt * sizeof(VkRect2D));
+  }
+
+  cnt = (info->pRasterizationState) ? 1 : 0;
+  off = key_put(key, off, &cnt, sizeof(uint32_t));
+  if (cnt) off = KEY_PUT_RANGE(key, off, info->pRasterizationState, flags, lineWidth);
+
+  cnt = (info->pMultisampleState) ? 1 : 0;
+  off = key_put(key, off, &cnt, sizeof(uint32_t));
+  if (cnt) {
+    const VkPipelineMultisampleStateCreateInfo *ms = info->pMultisampleState;
+    off = KEY_PUT_RANGE(key, off, ms, flags, minSampleShading);
+    cnt = (ms->pSampleMask) ? (ms->rasterizationSamples + 31) / 32 : 0;
+    off = key_put(key, off, &cnt, sizeof(uint32_t));
+    off = key_put(key, off, ms->pSampleMask, cnt * sizeof(VkSampleMask));
+    off = KEY_PUT_RANGE(key, off, ms, alphaToCoverageEnable, alphaToOneEnable);
+  }
+
+  cnt = (info->pDepthStencilState) ? 1 : 0;
+  off = key_put(key, off, &cnt, sizeof(uint32_t));
+  if (cnt) off = KEY_PUT_RANGE(key, off, info->pDepthStencilState, flags, maxDepthBounds);
+
+  cnt = (info->pColorBlendState) ? 1 : 0;
+  off = key_put(key, off, &cnt, sizeof(uint32_t));
+  if (cnt) {
+    const VkPipelineColorBlendStateCreateInfo *cb = info->pColorBlendState;
+    off = KEY_PUT_RANGE(key, off, cb, flags, attachmentCount);
+    off = key_put(key, off, cb->pAttachments, cb->attachmentCount * sizeof(VkPipelineColorBlendAttachmentState));
+    off = key_put(key, off, cb->blendConstants, sizeof(cb->blendConstants));
+  }
+
+  cnt = (info->pDynamicState) ? 1 : 0;
+  off = key_put(key, off, &cnt, sizeof(uint32_t));
+  if (cnt) {
+    const VkPipelineDynamicStateCreateInfo *dyn = info->pDynamicState;
+    off = key_put(key, off, &dyn->flags, sizeof(dyn->flags));
+    off = key_put(key, off, &dyn->dynamicStateCount, sizeof(uint32_t));
+    off = key_put(key, off, dyn->pDynamicStates, dyn->dynamicStateCount * sizeof(VkDynamicState));
+  }
+
+  return off;
+}
+
+static uint64_t fb_hash(const VkFramebufferCreateInfo *info) {
+  uint64_t hash = DLU_HASH_SEED;
+  hash = dlu_hash_bytes(hash, &info->flags, sizeof(info->flags));
+  hash = dlu_hash_bytes(hash, &info->renderPass, sizeof(VkRenderPass));
+  hash = dlu_hash_bytes(hash, &info->attachmentCount, sizeof(uint32_t));
+  hash = dlu_hash_bytes(hash, info->pAttachments, info->attachmentCount * sizeof(VkImageView));
+  hash = dlu_hash_bytes(hash, &info->width, sizeof(uint32_t));
+  hash = dlu_hash_bytes(hash, &info->height, sizeof(uint32_t));
+  hash = dlu_hash_bytes(hash, &info->layers, sizeof(uint32_t));
+  return hash;
+}
+
+static bool fb_match(struct _fb_cache_entry *entry, uint64_t hash, uint32_t cur_ld, const VkFramebufferCreateInfo *info) {
+  if (entry->hash != hash || entry->ldi != cur_ld) return false;
+  if (entry->flags != info->flags || entry->render_pass != info->renderPass) return false;
+  if (entry->width != info->width || entry->height != info->height || entry->layers != info->layers) return false;
+  if (entry->attc != info->attachmentCount) return false;
+  return !memcmp(entry->views, info->pAttachments, info->attachmentCount * sizeof(VkImageView));
+}
+
+/* Destroy the framebuffer at idx, then fill the hole with the last entry */
+static void fb_cache_remove(vkcomp *app, uint32_t idx) {
+  struct _fb_cache_entry *entry = &app->fb_cache.entries[idx];
+
+  vkDestroyFramebuffer(app->ld_data[entry->ldi].device, entry->fb, NULL);
+
+  /* Don't leave swapchain slots holding on to a dead handle */
+  for (uint32_t i = 0; i < app->sdc; i++) {
+    if (!app->sc_data[i].sc_buffs) continue;
+    for (uint32_t j = 0; j < app->sc_data[i].sic; j++)
+      if (app->sc_data[i].sc_buffs[j].fb == entry->fb)
+        app->sc_data[i].sc_buffs[j].fb = VK_NULL_HANDLE;
+  }
+
+  free(entry->views);
+  *entry = app->fb_cache.entries[--app->fb_cache.count];
+}
+
+/* Destroy the pipeline at idx, then fill the hole with the last entry */
+static void pso_cache_remove(vkcomp *app, uint32_t idx) {
+  struct _pso_cache_entry *entry = &app->pso_cache.entries[idx];
+
+  /* Derivatives stay valid without their base, the base is only read at creation time */
+  vkDestroyPipeline(app->ld_data[entry->ldi].device, entry->pipeline, NULL);
+
+  /* Don't leave gp_data slots holding on to a dead handle */
+  for (uint32_t i = 0; i < app->gdc; i++) {
+    if (!app->gp_data[i].graphics_pipelines) continue;
+    for (uint32_t j = 0; j < app->gp_data[i].gpc; j++)
+      if (app->gp_data[i].graphics_pipelines[j] == entry->pipeline)
+        app->gp_data[i].graphics_pipelines[j] = VK_NULL_HANDLE;
+  }
+
+  free(entry->modules);
+  free(entry->key);
+  *entry = app->pso_cache.entries[--app->pso_cache.count];
+}
+
+/* Destroy the render pass at idx, then fill the hole with the last entry */
+static void rp_cache_remove(vkcomp *app, uint32_t idx) {
+  struct _rp_cache_entry *entry = &app->rp_cache.entries[idx];
+
+  for (uint32_t i = 0; i < app->pso_cache.count;) {
+    if (app->pso_cache.entries[i].render_pass == entry->render_pass) pso_cache_remove(app, i);
+    else i++;
+  }
+
+  /* A framebuffer is useless without the render pass it was created against */
+  for (uint32_t i = 0; i < app->fb_cache.count;) {
+    if (app->fb_cache.entries[i].render_pass == entry->render_pass) fb_cache_remove(app, i);
+    else i++;
+  }
+
+  vkDestroyRenderPass(app->ld_data[entry->ldi].device, entry->render_pass, NULL);
+
+  for (uint32_t i = 0; i < app->gdc; i++)
+    if (app->gp_data[i].render_pass == entry->render_pass)
+      app->gp_data[i].render_pass = VK_NULL_HANDLE;
+
+  free(entry->key);
+  *entry = app->rp_cache.entries[--app->rp_cache.count];
+}
+
+VkResult dlu_cache_render_pass(vkcomp *app, uint32_t cur_ld, const VkRenderPassCreateInfo *create_info, VkRenderPass *render_pass) {
+  VkResult res = VK_RESULT_MAX_ENUM;
+  struct _rp_cache_entry *entry = NULL;
+  unsigned char *key = NULL;
+  size_t key_size = 0;
+  uint64_t hash = 0;
+
+  key_size = rp_key(NULL, create_info);
+  key = calloc(1, key_size);
+  if (!key) { dlu_log_me(DLU_DANGER, "[x] calloc: %s", strerror(errno)); return res; }
+
+  rp_key(key, create_info);
+  hash = dlu_hash_bytes(DLU_HASH_SEED, key, key_size);
+
+  for (uint32_t i = 0; i < app->rp_cache.count; i++) {
+    entry = &app->rp_cache.entries[i];
+    if (entry->hash == hash && entry->ldi == cur_ld && entry->key_size == key_size && !memcmp(entry->key, key, key_size)) {
+      *render_pass = entry->render_pass;
+      free(key);
+      return VK_SUCCESS;
+    }
+  }
+
+  entry = realloc(app->rp_cache.entries, (app->rp_cache.count + 1) * sizeof(struct _rp_cache_entry));
+  if (!entry) { dlu_log_me(DLU_DANGER, "[x] realloc: %s", strerror(errno)); free(key); return res; }
+  app->rp_cache.entries = entry;
+
+  res = vkCreateRenderPass(app->ld_data[cur_ld].device, create_info, NULL, render_pass);
+  if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkCreateRenderPass"); free(key); return res; }
+
+  entry = &app->rp_cache.entries[app->rp_cache.count++];
+  entry->hash = hash;
+  entry->key_size = key_size;
+  entry->key = key;
+  entry->render_pass = *render_pass;
+  entry->ldi = cur_ld;
+
+  return res;
+}
+
+VkResult dlu_cache_framebuffer(vkcomp *app, uint32_t cur_ld, const VkFramebufferCreateInfo *create_info, VkFramebuffer *fb) {
+  VkResult res = VK_RESULT_MAX_ENUM;
+  struct _fb_cache_entry *entry = NULL;
+  VkImageView *views = NULL;
+  uint64_t hash = fb_hash(create_info);
+
+  for (uint32_t i = 0; i < app->fb_cache.count; i++) {
+    if (fb_match(&app->fb_cache.entries[i], hash, cur_ld, create_info)) {
+      *fb = app->fb_cache.entries[i].fb;
+      return VK_SUCCESS;
+    }
+  }
+
+  /* Keep our own copy of the views, needed for eviction */
+  if (create_info->attachmentCount) {
+    views = calloc(create_info->attachmentCount, sizeof(VkImageView));
+    if (!views) { dlu_log_me(DLU_DANGER, "[x] calloc: %s", strerror(errno)); return res; }
+    memcpy(views, create_info->pAttachments, create_info->attachmentCount * sizeof(VkImageView));
+  }
+
+  entry = realloc(app->fb_cache.entries, (app->fb_cache.count + 1) * sizeof(struct _fb_cache_entry));
+  if (!entry) { dlu_log_me(DLU_DANGER, "[x] realloc: %s", strerror(errno)); free(views); return res; }
+  app->fb_cache.entries = entry;
+
+  res = vkCreateFramebuffer(app->ld_data[cur_ld].device, create_info, NULL, fb);
+  if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkCreateFramebuffer"); free(views); return res; }
+
+  entry = &app->fb_cache.entries[app->fb_cache.count++];
+  entry->hash = hash;
+  entry->flags = create_info->flags;
+  entry->render_pass = create_info->renderPass;
+  entry->attc = create_info->attachmentCount;
+  entry->views = views;
+  entry->width = create_info->width;
+  entry->height = create_info->height;
+  entry->layers = create_info->layers;
+  entry->fb = *fb;
+  entry->ldi = cur_ld;
+
+  return res;
+}
+
+VkResult dlu_cache_graphics_pipeline(vkcomp *app, uint32_t cur_ld, const VkGraphicsPipelineCreateInfo *info, VkPipeline *pipeline) {
+  VkResult res = VK_RESULT_MAX_ENUM;
+  VkGraphicsPipelineCreateInfo pipeline_info = *info;
+  struct _pso_cache_entry *entry = NULL;
+  VkPipeline base = VK_NULL_HANDLE;
+  VkShaderModule *modules = NULL;
+  unsigned char *key = NULL;
+  size_t key_size = 0, family_size = 0;
+  uint64_t hash = 0, family = 0;
+
+  if (!app->ld_data[cur_ld].device) { PERR(DLU_VKCOMP_DEVICE, 0, NULL); return res; }
+
+  key_size = dlu_cache_pso_key(app, cur_ld, NULL, info, &family_size);
+  key = calloc(1, key_size);
+  if (!key) { dlu_log_me(DLU_DANGER, "[x] calloc: %s", strerror(errno)); return res; }
+
+  dlu_cache_pso_key(app, cur_ld, key, info, &family_size);
+  hash = dlu_hash_bytes(DLU_HASH_SEED, key, key_size);
+  family = dlu_hash_bytes(DLU_HASH_SEED, key, family_size);
+
+  for (uint32_t i = 0; i < app->pso_cache.count; i++) {
+    entry = &app->pso_cache.entries[i];
+    if (entry->ldi != cur_ld) continue;
+
+    if (entry->hash == hash && entry->key_size == key_size && !memcmp(entry->key, key, key_size)) {
+      *pipeline = entry->pipeline;
+      free(key);
+      return VK_SUCCESS;
+    }
+
+    if (entry->parent && entry->family == family && !base) base = entry->pipeline;
+  }
+
+  modules = calloc(info->stageCount, sizeof(VkShaderModule));
+  if (!modules) { dlu_log_me(DLU_DANGER, "[x] calloc: %s", strerror(errno)); free(key); return res; }
+
+  for (uint32_t i = 0; i < info->stageCount; i++)
+    modules[i] = (shader_find(app, cur_ld, info->pStages[i].module)) ? VK_NULL_HANDLE : info->pStages[i].module;
+
+  entry = realloc(app->pso_cache.entries, (app->pso_cache.count + 1) * sizeof(struct _pso_cache_entry));
+  if (!entry) { dlu_log_me(DLU_DANGER, "[x] realloc: %s", strerror(errno)); goto err_free; }
+  app->pso_cache.entries = entry;
+
+  /* Variants derive from the family's first pipeline, unless the caller picked a base */
+  if (!(pipeline_info.flags & VK_PIPELINE_CREATE_DERIVATIVE_BIT)) {
+    if (base) {
+      pipeline_info.flags |= VK_PIPELINE_CREATE_DERIVATIVE_BIT;
+      pipeline_info.basePipelineHandle = base;
+      pipeline_info.basePipelineIndex = -1;
+    } else {
+      pipeline_info.flags |= VK_PIPELINE_CREATE_ALLOW_DERIVATIVES_BIT;
+    }
+  }
+
+  res = dlu_create_pipeline_with_feedback(app, cur_ld, &pipeline_info, pipeline);
+  if (res) goto err_free;
+
+  entry = &app->pso_cache.entries[app->pso_cache.count++];
+  entry->hash = hash;
+  entry->family = family;
+  entry->key_size = key_size;
+  entry->key = key;
+  entry->pipeline = *pipeline;
+  entry->parent = !base && (pipeline_info.flags & VK_PIPELINE_CREATE_ALLOW_DERIVATIVES_BIT);
+  entry->layout = info->layout;
+  entry->render_pass = info->renderPass;
+  entry->stagec = info->stageCount;
+  entry->modules = modules;
+  entry->ldi = cur_ld;
+
+  return res;
+
+err_free:
+  free(modules);
+  free(key);
+  return res;
+}
+
+void dlu_cache_register_shader_module(vkcomp *app, uint32_t cur_ld, VkShaderModule module, const void *code, size_t code_size) {
+  struct _shader_cache_entry *entry = shader_find(app, cur_ld, module);
+
+  /* A recycled handle takes over the old entry */
+  if (!entry) {
+    entry = realloc(app->shader_cache.entries, (app->shader_cache.count + 1) * sizeof(struct _shader_cache_entry));
+    if (!entry) { dlu_log_me(DLU_DANGER, "[x] realloc: %s", strerror(errno)); return; }
+    app->shader_cache.entries = entry;
+    entry = &app->shader_cache.entries[app->shader_cache.count++];
+  }
+
+  entry->module = module;
+  entry->hash = dlu_hash_bytes(DLU_HASH_SEED, code, code_size);
+  entry->code_size = code_size;
+  entry->ldi = cur_ld;
+}
+
+void dlu_cache_evict_shader_module(vkcomp *app, VkShaderModule module) {
+
+  /* Pipelines keyed by SPIR-V don't depend on the module, only forget its hash */
+  for (uint32_t i = 0; i < app->shader_cache.count; i++) {
+    if (app->shader_cache.entries[i].module == module) {
+      app->shader_cache.entries[i] = app->shader_cache.entries[--app->shader_cache.count];
+      return;
+    }
+  }
+
+  /* Keyed by handle, which may be recycled for different code once destroyed */
+  for (uint32_t i = 0; i < app->pso_cache.count;) {
+    bool uses_module = false;
+
+    for (uint32_t j = 0; j < app->pso_cache.entries[i].stagec; j++)
+      if (app->pso_cache.entries[i].modules[j] == module)
+        uses_module = true;
+
+    if (uses_module) pso_cache_remove(app, i);
+    else i++;
+  }
+}
+
+void dlu_cache_evict_pipeline_layout(vkcomp *app, VkPipelineLayout layout) {
+  for (uint32_t i = 0; i < app->pso_cache.count;) {
+    if (app->pso_cache.entries[i].layout == layout) pso_cache_remove(app, i);
+    else i++;
+  }
+}
+
+bool dlu_cache_evict_pipeline(vkcomp *app, VkPipeline pipeline) {
+  for (uint32_t i = 0; i < app->pso_cache.count; i++) {
+    if (app->pso_cache.entries[i].pipeline == pipeline) {
+      pso_cache_remove(app, i);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void dlu_cache_evict_image_view(vkcomp *app, VkImageView view) {
+  for (uint32_t i = 0; i < app->fb_cache.count;) {
+    bool uses_view = false;
+
+    for (uint32_t j = 0; j < app->fb_cache.entries[i].attc; j++)
+      if (app->fb_cache.entries[i].views[j] == view)
+        uses_view = true;
+
+    if (uses_view) fb_cache_remove(app, i);
+    else i++;
+  }
+}
+
+bool dlu_cache_evict_render_pass(vkcomp *app, VkRenderPass render_pass) {
+  for (uint32_t i = 0; i < app->rp_cache.count; i++) {
+    if (app->rp_cache.entries[i].render_pass == render_pass) {
+      rp_cache_remove(app, i);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool dlu_cache_evict_framebuffer(vkcomp *app, VkFramebuffer fb) {
+  for (uint32_t i = 0; i < app->fb_cache.count; i++) {
+    if (app->fb_cache.entries[i].fb == fb) {
+      fb_cache_remove(app, i);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static size_t smp_key(unsigned char *key, const VkSamplerCreateInfo *info) {
+  return KEY_PUT_RANGE(key, 0, info, flags, unnormalizedCoordinates);
+}
+
+/**
+* Flatten a VkDescriptorSetLayoutCreateInfo. Binding flags from descriptor
+* indexing are part of the key, any other pNext struct makes the info uncacheable
+* (returns 0).
+*/
+static size_t dsl_key(unsigned char *key, const VkDescriptorSetLayoutCreateInfo *info) {
+  size_t off = 0;
+  uint32_t cnt = 0;
+
+  off = key_put(key, off, &info->flags, sizeof(info->flags));
+  off = key_put(key, off, &info->bindingCount, sizeof(uint32_t));
+  for (uint32_t i = 0; i < info->bindingCount; i++) {
+    const VkDescriptorSetLayoutBinding *b = &info->pBindings[i];
+    off = KEY_PUT_RANGE(key, off, b, binding, stageFlags);
+
+    cnt = (b->pImmutableSamplers && (b->descriptorType == VK_DESCRIPTOR_TYPE_SAMPLER ||
+           b->descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)) ? b->descriptorCount : 0;
+    off = key_put(key, off, &cnt, sizeof(uint32_t));
+    off = key_put(key, off, b->pImmutableSamplers, cnt * sizeof(VkSampler));
+  }
+
+  for (const VkBaseInStructure *ext = info->pNext; ext; ext = ext->pNext) {
+    if (ext->sType != VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT) return 0;
+
+    const VkDescriptorSetLayoutBindingFlagsCreateInfoEXT *flags = (const VkDescriptorSetLayoutBindingFlagsCreateInfoEXT *) ext;
+    off = key_put(key, off, &flags->bindingCount, sizeof(uint32_t));
+    off = key_put(key, off, flags->pBindingFlags, flags->bindingCount * sizeof(VkDescriptorBindingFlagsEXT));
+  }
+
+  return off;
+}
+
+static size_t pl_key(unsigned char *key, const VkPipelineLayoutCreateInfo *info) {
+  size_t off = 0;
+
+  off = key_put(key, off, &info->flags, sizeof(info->flags));
+  off = key_put(key, off, &info->setLayoutCount, sizeof(uint32_t));
+  off = key_put(key, off, info->pSetLayouts, info->setLayoutCount * sizeof(VkDescriptorSetLayout));
+  off = key_put(key, off, &info->pushConstantRangeCount, sizeof(uint32_t));
+  off = key_put(key, off, info->pPushConstantRanges, info->pushConstantRangeCount * sizeof(VkPushConstantRange));
+
+  return off;
+}
+
+/* Look for key in cache, on a hit take a reference and return the handle */
+static bool ref_cache_acquire(struct _ref_cache *cache, uint32_t cur_ld, const void *key, size_t key_size, uint64_t hash, uint64_t *handle) {
+  for (uint32_t i = 0; i < cache->count; i++) {
+    struct _ref_cache_entry *entry = &cache->entries[i];
+    if (entry->hash == hash && entry->ldi == cur_ld && entry->key_size == key_size && !memcmp(entry->key, key, key_size)) {
+      entry->refs++;
+      *handle = entry->handle;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/* Make room for one more entry, the new entry isn't counted until it's filled in */
+static bool ref_cache_grow(struct _ref_cache *cache) {
+  struct _ref_cache_entry *entries = realloc(cache->entries, (cache->count + 1) * sizeof(struct _ref_cache_entry));
+  if (!entries) { dlu_log_me(DLU_DANGER, "[x] realloc: %s", strerror(errno)); return false; }
+  cache->entries = entries;
+  return true;
+}
+
+static void ref_cache_insert(struct _ref_cache *cache, uint32_t cur_ld, void *key, size_t key_size, uint64_t hash, uint64_t handle) {
+  struct _ref_cache_entry *entry = &cache->entries[cache->count++];
+  memset(entry, 0, sizeof(struct _ref_cache_entry));
+  entry->hash = hash;
+  entry->key_size = key_size;
+  entry->key = key;
+  entry->handle = handle;
+  entry->refs = 1;
+  entry->ldi = cur_ld;
+}
+
+static uint32_t ref_cache_find(struct _ref_cache *cache, uint64_t handle) {
+  for (uint32_t i = 0; i < cache->count; i++)
+    if (cache->entries[i].handle == handle)
+      return i;
+  return UINT32_MAX;
+}
+
+/* Serialize with key_fn into a freshly allocated buffer. Returns NULL when uncacheable */
+#define REF_CACHE_KEY(key_fn, info, key, key_size) \
+  do { \
+    key_size = key_fn(NULL, info); \
+    key = (key_size) ? calloc(1, key_size) : NULL; \
+    if (key) key_fn(key, info); \
+  } while(0)
+
+VkResult dlu_cache_sampler(vkcomp *app, uint32_t cur_ld, const VkSamplerCreateInfo *create_info, VkSampler *sampler) {
+  VkResult res = VK_RESULT_MAX_ENUM;
+  unsigned char *key = NULL;
+  size_t key_size = 0;
+  uint64_t hash = 0, handle = 0;
+
+  /* Extension structs (YCbCr conversion, reduction mode, ...) aren't part of the key */
+  if (create_info->pNext) {
+    res = vkCreateSampler(app->ld_data[cur_ld].device, create_info, NULL, sampler);
+    if (res) PERR(DLU_VK_FUNC_ERR, res, "vkCreateSampler")
+    return res;
+  }
+
+  REF_CACHE_KEY(smp_key, create_info, key, key_size);
+  if (!key) { dlu_log_me(DLU_DANGER, "[x] calloc: %s", strerror(errno)); return res; }
+
+  hash = dlu_hash_bytes(DLU_HASH_SEED, key, key_size);
+  if (ref_cache_acquire(&app->smp_cache, cur_ld, key, key_size, hash, &handle)) {
+    *sampler = (VkSampler) handle;
+    free(key);
+    return VK_SUCCESS;
+  }
+
+  if (!ref_cache_grow(&app->smp_cache)) { free(key); return res; }
+
+  res = vkCreateSampler(app->ld_data[cur_ld].device, create_info, NULL, sampler);
+  if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkCreateSampler"); free(key); return res; }
+
+  ref_cache_insert(&app->smp_cache, cur_ld, key, key_size, hash, (uint64_t) *sampler);
+
+  return res;
+}
+
+VkResult dlu_cache_desc_set_layout(vkcomp *app, uint32_t cur_ld, const VkDescriptorSetLayoutCreateInfo *create_info, VkDescriptorSetLayout *layout) {
+  VkResult res = VK_RESULT_MAX_ENUM;
+  unsigned char *key = NULL;
+  size_t key_size = 0;
+  uint64_t hash = 0, handle = 0;
+
+  REF_CACHE_KEY(dsl_key, create_info, key, key_size);
+  if (!key) {
+    if (key_size) { dlu_log_me(DLU_DANGER, "[x] calloc: %s", strerror(errno)); return res; }
+    res = vkCreateDescriptorSetLayout(app->ld_data[cur_ld].device, create_info, NULL, layout);
+    if (res) PERR(DLU_VK_FUNC_ERR, res, "vkCreateDescriptorSetLayout")
+    return res;
+  }
+
+  hash = dlu_hash_bytes(DLU_HASH_SEED, key, key_size);
+  if (ref_cache_acquire(&app->dsl_cache, cur_ld, key, key_size, hash, &handle)) {
+    *layout = (VkDescriptorSetLayout) handle;
+    free(key);
+    return VK_SUCCESS;
+  }
+
+  if (!ref_cache_grow(&app->dsl_cache)) { free(key); return res; }
+
+  res = vkCreateDescriptorSetLayout(app->ld_data[cur_ld].device, create_info, NULL, layout);
+  if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkCreateDescriptorSetLayout"); free(key); return res; }
+
+  ref_cache_insert(&app->dsl_cache, cur_ld, key, key_size, hash, (uint64_t) *layout);
+
+  return res;
+}
+
+VkResult dlu_cache_pipeline_layout(vkcomp *app, uint32_t cur_ld, const VkPipelineLayoutCreateInfo *create_info, VkPipelineLayout *layout) {
+  VkResult res = VK_RESULT_MAX_ENUM;
+  VkDescriptorSetLayout *deps = NULL;
+  unsigned char *key = NULL;
+  size_t key_size = 0;
+  uint64_t hash = 0, handle = 0;
+  uint32_t depc = 0;
+
+  if (create_info->pNext) {
+    res = vkCreatePipelineLayout(app->ld_data[cur_ld].device, create_info, NULL, layout);
+    if (res) PERR(DLU_VK_FUNC_ERR, res, "vkCreatePipelineLayout")
+    return res;
+  }
+
+  REF_CACHE_KEY(pl_key, create_info, key, key_size);
+  if (!key) { dlu_log_me(DLU_DANGER, "[x] calloc: %s", strerror(errno)); return res; }
+
+  hash = dlu_hash_bytes(DLU_HASH_SEED, key, key_size);
+  if (ref_cache_acquire(&app->pl_cache, cur_ld, key, key_size, hash, &handle)) {
+    *layout = (VkPipelineLayout) handle;
+    free(key);
+    return VK_SUCCESS;
+  }
+
+  if (!ref_cache_grow(&app->pl_cache)) { free(key); return res; }
+
+  if (create_info->setLayoutCount) {
+    deps = calloc(create_info->setLayoutCount, sizeof(VkDescriptorSetLayout));
+    if (!deps) { dlu_log_me(DLU_DANGER, "[x] calloc: %s", strerror(errno)); free(key); return res; }
+  }
+
+  res = vkCreatePipelineLayout(app->ld_data[cur_ld].device, create_info, NULL, layout);
+  if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkCreatePipelineLayout"); free(deps); free(key); return res; }
+
+  /**
+  * Keep cached set layouts alive for as long as this layout is. Their handles
+  * are part of our key, a recycled handle would otherwise produce a false hit
+  */
+  for (uint32_t i = 0; i < create_info->setLayoutCount; i++) {
+    uint32_t idx = ref_cache_find(&app->dsl_cache, (uint64_t) create_info->pSetLayouts[i]);
+    if (idx == UINT32_MAX) continue;
+    app->dsl_cache.entries[idx].refs++;
+    deps[depc++] = create_info->pSetLayouts[i];
+  }
+
+  ref_cache_insert(&app->pl_cache, cur_ld, key, key_size, hash, (uint64_t) *layout);
+  app->pl_cache.entries[app->pl_cache.count - 1].depc = depc;
+  app->pl_cache.entries[app->pl_cache.count - 1].deps = deps;
+
+  return res;
+}
+
+/* Drop one reference to the entry at idx, destroying it once unused. Hole filled with last entry */
+static void ref_cache_put(struct _ref_cache *cache, uint32_t idx) {
+  struct _ref_cache_entry *entry = &cache->entries[idx];
+  if (--entry->refs) return;
+
+  free(entry->deps);
+  free(entry->key);
+  *entry = cache->entries[--cache->count];
+}
+
+bool dlu_cache_release_sampler(vkcomp *app, VkSampler sampler) {
+  uint32_t idx = ref_cache_find(&app->smp_cache, (uint64_t) sampler);
+  if (idx == UINT32_MAX) return false;
+
+  if (app->smp_cache.entries[idx].refs == 1)
+    vkDestroySampler(app->ld_data[app->smp_cache.entries[idx].ldi].device, sampler, NULL);
+
+  ref_cache_put(&app->smp_cache, idx);
+  return true;
+}
+
+bool dlu_cache_release_desc_set_layout(vkcomp *app, VkDescriptorSetLayout layout) {
+  uint32_t idx = ref_cache_find(&app->dsl_cache, (uint64_t) layout);
+  if (idx == UINT32_MAX) return false;
+
+  if (app->dsl_cache.entries[idx].refs == 1)
+    vkDestroyDescriptorSetLayout(app->ld_data[app->dsl_cache.entries[idx].ldi].device, layout, NULL);
+
+  ref_cache_put(&app->dsl_cache, idx);
+  return true;
+}
+
+bool dlu_cache_release_pipeline_layout(vkcomp *app, VkPipelineLayout layout) {
+  uint32_t idx = ref_cache_find(&app->pl_cache, (uint64_t) layout);
+  if (idx == UINT32_MAX) return false;
+
+  struct _ref_cache_entry *entry = &app->pl_cache.entries[idx];
+  if (entry->refs == 1) {
+    dlu_cache_evict_pipeline_layout(app, layout);
+    vkDestroyPipelineLayout(app->ld_data[entry->ldi].device, layout, NULL);
+    for (uint32_t i = 0; i < entry->depc; i++)
+      dlu_cache_release_desc_set_layout(app, entry->deps[i]);
+  }
+
+  ref_cache_put(&app->pl_cache, idx);
+  return true;
+}
+
+void dlu_cache_freeup(vkcomp *app) {
+  for (uint32_t i = 0; i < app->pso_cache.count; i++) {
+    vkDestroyPipeline(app->ld_data[app->pso_cache.entries[i].ldi].device, app->pso_cache.entries[i].pipeline, NULL);
+    free(app->pso_cache.entries[i].modules);
+    free(app->pso_cache.entries[i].key);
+  }
+
+  for (uint32_t i = 0; i < app->fb_cache.count; i++) {
+    vkDestroyFramebuffer(app->ld_data[app->fb_cache.entries[i].ldi].device, app->fb_cache.entries[i].fb, NULL);
+    free(app->fb_cache.entries[i].views);
+  }
+
+  for (uint32_t i = 0; i < app->rp_cache.count; i++) {
+    vkDestroyRenderPass(app->ld_data[app->rp_cache.entries[i].ldi].device, app->rp_cache.entries[i].render_pass, NULL);
+    free(app->rp_cache.entries[i].key);
+  }
+
+  for (uint32_t i = 0; i < app->pl_cache.count; i++) {
+    vkDestroyPipelineLayout(app->ld_data[app->pl_cache.entries[i].ldi].device, (VkPipelineLayout) app->pl_cache.entries[i].handle, NULL);
+    free(app->pl_cache.entries[i].deps);
+    free(app->pl_cache.entries[i].key);
+  }
+
+  for (uint32_t i = 0; i < app->dsl_cache.count; i++) {
+    vkDestroyDescriptorSetLayout(app->ld_data[app->dsl_cache.entries[i].ldi].device, (VkDescriptorSetLayout) app->dsl_cache.entries[i].handle, NULL);
+    free(app->dsl_cache.entries[i].key);
+  }
+
+  for (uint32_t i = 0; i < app->smp_cache.count; i++) {
+    vkDestroySampler(app->ld_data[app->smp_cache.entries[i].ldi].device, (VkSampler) app->smp_cache.entries[i].handle, NULL);
+    free(app->smp_cache.entries[i].key);
+  }
+
+  free(app->pl_cache.entries);
+  free(app->dsl_cache.entries);
+  free(app->smp_cache.entries);
+  memset(&app->pl_cache, 0, sizeof(app->pl_cache));
+  memset(&app->dsl_cache, 0, sizeof(app->dsl_cache));
+  memset(&app->smp_cache, 0, sizeof(app->smp_cache));
+
+  free(app->shader_cache.entries);
+  memset(&app->shader_cache, 0, sizeof(app->shader_cache));
+
+  free(app->pso_cache.entries);
+  free(app->fb_cache.entries);
+  free(app->rp_cache.entries);
+  memset(&app->pso_cache, 0, sizeof(app->pso_cache));
+  memset(&app->fb_cache, 0, sizeof(app->fb_cache));
+  memset(&app->rp_cache, 0, sizeof(app->rp_cache));
+}
@@ -0,0 +1,692 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright (c) 2019-2020 Vincent Davis Jr.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*/
+
+#define LUCUR_VKCOMP_API
+#include <lucom.h>
+
+/* Matches struct Surface in the shader (std430) */
+struct comp_surface {
+  float rect[4]; /* x0, y0, x1, y1 in pixels */
+  float opacity;
+  uint32_t tex; /* bindless slot */
+  uint32_t pad[2];
+};
+
+struct comp_push {
+  float clear[4];
+  uint32_t tiles_x;
+  uint32_t pad[3];
+};
+
+/* Each tile list is a count followed by DLU_COMP_TILE_SURFACES surface indices */
+#define TILE_STRIDE (DLU_COMP_TILE_SURFACES + 1)
+
+/* Count of a tile left to the raster path, the shader doesn't touch its pixels */
+#define TILE_RASTER UINT32_MAX
+
+static const char comp_shader_src[] =
+  "#version 450\n"
+  "#extension GL_EXT_nonuniform_qualifier : require\n"
+  "layout(local_size_x_id = 0, local_size_y_id = 0) in;\n"
+  "layout(constant_id = 1) const uint TILE_SURFACES = 31;\n"
+  "struct Surface { vec4 rect; float opacity; uint tex; uint pad0; uint pad1; };\n"
+  "layout(set = 0, binding = 0, rgba8) uniform writeonly image2D o_Image;\n"
+  "layout(std430, set = 0, binding = 1) readonly buffer Surfaces { Surface surfaces[]; };\n"
+  "layout(std430, set = 0, binding = 2) readonly buffer Tiles { uint tiles[]; };\n"
+  "layout(set = 1, binding = 0) uniform sampler2D textures[];\n"
+  "layout(push_constant) uniform Push { vec4 clear; uint tiles_x; } pc;\n"
+  "void main() {\n"
+  "  ivec2 px = ivec2(gl_GlobalInvocationID.xy);\n"
+  "  if (any(greaterThanEqual(px, imageSize(o_Image)))) return;\n"
+  "  uint base = (gl_WorkGroupID.y * pc.tiles_x + gl_WorkGroupID.x) * (TILE_SURFACES + 1);\n"
+  "  uint count = tiles[base];\n"
+  "  if (count > TILE_SURFACES) return;\n"
+  "  vec2 p = vec2(px) + 0.5;\n"
+  "  vec4 dst = pc.clear;\n"
+  "  for (uint i = 0; i < count; i++) {\n"
+  "    Surface s = surfaces[tiles[base + 1 + i]];\n"
+  "    if (any(lessThan(p, s.rect.xy)) || any(greaterThanEqual(p, s.rect.zw))) continue;\n"
+  "    vec2 uv = (p - s.rect.xy) / (s.rect.zw - s.rect.xy);\n"
+  "    vec4 src = textureLod(textures[nonuniformEXT(s.tex)], uv, 0.0);\n"
+  "    float a = src.a * s.opacity;\n"
+  "    dst.rgb = mix(dst.rgb, src.rgb, a);\n"
+  "    dst.a = a + dst.a * (1.0 - a);\n"
+  "  }\n"
+  "  imageStore(o_Image, px, dst);\n"
+  "}\n";
+
+const char *dlu_comp_shader_source(void) { return comp_shader_src; }
+
+static VkDeviceSize align_up(VkDeviceSize size, VkDeviceSize align) {
+  return (align) ? (size + align - 1) / align * align : size;
+}
+
+static VkResult comp_create_buffer(vkcomp *app, uint32_t cur_ld, VkDeviceSize size) {
+  VkResult res = VK_RESULT_MAX_ENUM;
+  struct _composite *comp = &app->composite;
+
+  VkBufferCreateInfo buff_info = {};
+  buff_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  buff_info.pNext = NULL;
+  buff_info.flags = 0;
+  buff_info.size = size;
+  buff_info.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+  buff_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  buff_info.queueFamilyIndexCount = 0;
+  buff_info.pQueueFamilyIndices = NULL;
+
+  res = vkCreateBuffer(app->ld_data[cur_ld].device, &buff_info, NULL, &comp->buff);
+  if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkCreateBuffer"); return res; }
+
+  VkMemoryRequirements mem_reqs;
+  vkGetBufferMemoryRequirements(app->ld_data[cur_ld].device, comp->buff, &mem_reqs);
+
+  VkMemoryAllocateInfo alloc_info = {};
+  alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  alloc_info.pNext = NULL;
+  alloc_info.allocationSize = mem_reqs.size;
+
+  /* Rewritten by the CPU every frame, read once by the GPU */
+  if (!memory_type_from_all_properties(app, app->ld_data[cur_ld].pdi, mem_reqs.memoryTypeBits,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &alloc_info.memoryTypeIndex)) {
+    PERR(DLU_MEM_TYPE_ERR, 0, NULL);
+    return VK_ERROR_FEATURE_NOT_PRESENT;
+  }
+
+  res = vkAllocateMemory(app->ld_data[cur_ld].device, &alloc_info, NULL, &comp->mem);
+  if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkAllocateMemory"); return res; }
+
+  res = vkBindBufferMemory(app->ld_data[cur_ld].device, comp->buff, comp->mem, 0);
+  if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkBindBufferMemory"); return res; }
+
+  res = vkMapMemory(app->ld_data[cur_ld].device, comp->mem, 0, VK_WHOLE_SIZE, 0, &comp->mapped);
+  if (res) PERR(DLU_VK_FUNC_ERR, res, "vkMapMemory")
+
+  return res;
+}
+
+/* Intermediate rgba8 storage image for targets whose format the shader can't write */
+static VkResult comp_create_image(vkcomp *app, uint32_t cur_ld, VkExtent2D extent) {
+  VkResult res = VK_RESULT_MAX_ENUM;
+  struct _composite *comp = &app->composite;
+  VkDevice device = app->ld_data[cur_ld].device;
+
+  VkImageCreateInfo img_info = {};
+  img_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+  img_info.pNext = NULL;
+  img_info.flags = 0;
+  img_info.imageType = VK_IMAGE_TYPE_2D;
+  img_info.format = VK_FORMAT_R8G8B8A8_UNORM;
+  img_info.extent.width = extent.width;
+  img_info.extent.height = extent.height;
+  img_info.extent.depth = 1;
+  img_info.mipLevels = 1;
+  img_info.arrayLayers = 1;
+  img_info.samples = VK_SAMPLE_COUNT_1_BIT;
+  img_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+  img_info.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+  img_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  img_info.queueFamilyIndexCount = 0;
+  img_info.pQueueFamilyIndices = NULL;
+  img_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+  res = vkCreateImage(device, &img_info, NULL, &comp->image);
+  if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkCreateImage"); return res; }
+
+  VkMemoryRequirements mem_reqs;
+  vkGetImageMemoryRequirements(device, comp->image, &mem_reqs);
+
+  VkMemoryAllocateInfo alloc_info = {};
+  alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  alloc_info.pNext = NULL;
+  alloc_info.allocationSize = mem_reqs.size;
+
+  if (!memory_type_from_all_properties(app, app->ld_data[cur_ld].pdi, mem_reqs.memoryTypeBits,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &alloc_info.memoryTypeIndex)) {
+    PERR(DLU_MEM_TYPE_ERR, 0, NULL);
+    return VK_ERROR_FEATURE_NOT_PRESENT;
+  }
+
+  res = vkAllocateMemory(device, &alloc_info, NULL, &comp->image_mem);
+  if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkAllocateMemory"); return res; }
+
+  res = vkBindImageMemory(device, comp->image, comp->image_mem, 0);
+  if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkBindImageMemory"); return res; }
+
+  VkImageViewCreateInfo view_info = {};
+  view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+  view_info.pNext = NULL;
+  view_info.flags = 0;
+  view_info.image = comp->image;
+  view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+  view_info.format = VK_FORMAT_R8G8B8A8_UNORM;
+  view_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+  view_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+  view_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+  view_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+  view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  view_info.subresourceRange.baseMipLevel = 0;
+  view_info.subresourceRange.levelCount = 1;
+  view_info.subresourceRange.baseArrayLayer = 0;
+  view_info.subresourceRange.layerCount = 1;
+
+  res = vkCreateImageView(device, &view_info, NULL, &comp->view);
+  if (res) PERR(DLU_VK_FUNC_ERR, res, "vkCreateImageView")
+
+  return res;
+}
+
+static VkResult comp_create_sets(vkcomp *app, uint32_t cur_ld) {
+  VkResult res = VK_RESULT_MAX_ENUM;
+  struct _composite *comp = &app->composite;
+
+  VkDescriptorSetLayoutBinding bindings[3] = {};
+  for (uint32_t i = 0; i < ARR_LEN(bindings); i++) {
+    bindings[i].binding = i;
+    bindings[i].descriptorType = (i) ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    bindings[i].descriptorCount = 1;
+    bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    bindings[i].pImmutableSamplers = NULL;
+  }
+
+  VkDescriptorSetLayoutCreateInfo layout_info = {};
+  layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  layout_info.pNext = NULL;
+  layout_info.flags = 0;
+  layout_info.bindingCount = ARR_LEN(bindings);
+  layout_info.pBindings = bindings;
+
+  res = vkCreateDescriptorSetLayout(app->ld_data[cur_ld].device, &layout_info, NULL, &comp->layout);
+  if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkCreateDescriptorSetLayout"); return res; }
+
+  VkDescriptorPoolSize pool_sizes[2] = {
+    { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, comp->fc },
+    { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2 * comp->fc }
+  };
+
+  VkDescriptorPoolCreateInfo pool_info = {};
+  pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  pool_info.pNext = NULL;
+  pool_info.flags = 0;
+  pool_info.maxSets = comp->fc;
+  pool_info.poolSizeCount = ARR_LEN(pool_sizes);
+  pool_info.pPoolSizes = pool_sizes;
+
+  res = vkCreateDescriptorPool(app->ld_data[cur_ld].device, &pool_info, NULL, &comp->pool);
+  if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkCreateDescriptorPool"); return res; }
+
+  VkDescriptorSetLayout *layouts = alloca(comp->fc * sizeof(VkDescriptorSetLayout));
+  for (uint32_t i = 0; i < comp->fc; i++) layouts[i] = comp->layout;
+
+  VkDescriptorSetAllocateInfo alloc_info = {};
+  alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  alloc_info.pNext = NULL;
+  alloc_info.descriptorPool = comp->pool;
+  alloc_info.descriptorSetCount = comp->fc;
+  alloc_info.pSetLayouts = layouts;
+
+  res = vkAllocateDescriptorSets(app->ld_data[cur_ld].device, &alloc_info, comp->sets);
+  if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkAllocateDescriptorSets"); return res; }
+
+  /**
+  * The buffer regions never move. Neither does the intermediate image,
+  * without it the target image is written per frame
+  */
+  for (uint32_t i = 0; i < comp->fc; i++) {
+    VkDescriptorBufferInfo buff_infos[2] = {
+      { comp->buff, i * comp->frame_bytes, comp->surf_bytes },
+      { comp->buff, i * comp->frame_bytes + (comp->frame_bytes - comp->tile_bytes), comp->tile_bytes }
+    };
+
+    VkDescriptorImageInfo image_info = { VK_NULL_HANDLE, comp->view, VK_IMAGE_LAYOUT_GENERAL };
+
+    VkWriteDescriptorSet writes[3] = {};
+    for (uint32_t j = 0; j < ARR_LEN(writes); j++) {
+      writes[j].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+      writes[j].pNext = NULL;
+      writes[j].dstSet = comp->sets[i];
+      writes[j].dstBinding = (j + 1) % ARR_LEN(writes);
+      writes[j].dstArrayElement = 0;
+      writes[j].descriptorCount = 1;
+      writes[j].descriptorType = (j < 2) ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+      writes[j].pBufferInfo = (j < 2) ? &buff_infos[j] : NULL;
+      writes[j].pImageInfo = (j < 2) ? NULL : &image_info;
+    }
+
+    vkUpdateDescriptorSets(app->ld_data[cur_ld].device, (comp->view) ? 3 : 2, writes, 0, NULL);
+  }
+
+  return res;
+}
+
+static VkResult comp_create_pipeline(vkcomp *app, uint32_t cur_ld, VkShaderModule module) {
+  VkResult res = VK_RESULT_MAX_ENUM;
+  struct _composite *comp = &app->composite;
+
+  VkDescriptorSetLayout layouts[2] = { comp->layout, app->bindless.layout };
+
+  VkPushConstantRange push_range = {};
+  push_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  push_range.offset = 0;
+  push_range.size = sizeof(struct comp_push);
+
+  VkPipelineLayoutCreateInfo layout_info = {};
+  layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  layout_info.pNext = NULL;
+  layout_info.flags = 0;
+  layout_info.setLayoutCount = ARR_LEN(layouts);
+  layout_info.pSetLayouts = layouts;
+  layout_info.pushConstantRangeCount = 1;
+  layout_info.pPushConstantRanges = &push_range;
+
+  res = vkCreatePipelineLayout(app->ld_data[cur_ld].device, &layout_info, NULL, &comp->pipeline_layout);
+  if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkCreatePipelineLayout"); return res; }
+
+  /* Workgroup size and tile list length are baked in as specialization constants */
+  uint32_t spec_data[2] = { comp->tile, DLU_COMP_TILE_SURFACES };
+  VkSpecializationMapEntry spec_entries[2] = {
+    { 0, 0, sizeof(uint32_t) },
+    { 1, sizeof(uint32_t), sizeof(uint32_t) }
+  };
+
+  VkSpecializationInfo spec_info = {};
+  spec_info.mapEntryCount = ARR_LEN(spec_entries);
+  spec_info.pMapEntries = spec_entries;
+  spec_info.dataSize = sizeof(spec_data);
+  spec_info.pData = spec_data;
+
+  VkComputePipelineCreateInfo pipeline_info = {};
+  pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+  pipeline_info.pNext = NULL;
+  pipeline_info.flags = 0;
+  pipeline_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  pipeline_info.stage.pNext = NULL;
+  pipeline_info.stage.flags = 0;
+  pipeline_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+  pipeline_info.stage.module = module;
+  pipeline_info.stage.pName = "main";
+  pipeline_info.stage.pSpecializationInfo = &spec_info;
+  pipeline_info.layout = comp->pipeline_layout;
+  pipeline_info.basePipelineHandle = VK_NULL_HANDLE;
+  pipeline_info.basePipelineIndex = -1;
+
+  res = vkCreateComputePipelines(app->ld_data[cur_ld].device, app->gp_cache.pipe_cache, 1, &pipeline_info, NULL, &comp->pipeline);
+  if (res) PERR(DLU_VK_FUNC_ERR, res, "vkCreateComputePipelines")
+
+  return res;
+}
+
+VkResult dlu_create_compositor(
+  vkcomp *app,
+  uint32_t cur_ld,
+  uint32_t frame_count,
+  uint32_t max_surfaces,
+  VkExtent2D max_extent,
+  VkFormat format,
+  uint32_t tile,
+  VkShaderModule module
+) {
+
+  VkResult res = VK_RESULT_MAX_ENUM;
+  struct _composite *comp = &app->composite;
+
+  if (!app->ld_data[cur_ld].device) { PERR(DLU_VKCOMP_DEVICE, 0, NULL); return res; }
+  if (!app->bindless.set) { PERR(DLU_VKCOMP_BINDLESS, 0, NULL); return res; }
+  if (comp->pipeline) { PERR(DLU_ALREADY_ALLOC, 0, NULL); return res; }
+  if (!frame_count || !max_surfaces || !tile) { PERR(DLU_OP_NOT_PERMITED, 0, NULL); return res; }
+
+  VkPhysicalDevice phys_dev = app->pd_data[app->ld_data[cur_ld].pdi].phys_dev;
+
+  VkPhysicalDeviceProperties props;
+  vkGetPhysicalDeviceProperties(phys_dev, &props);
+  if (tile * tile > props.limits.maxComputeWorkGroupInvocations || tile > props.limits.maxComputeWorkGroupSize[0]) {
+    dlu_log_me(DLU_DANGER, "[x] %ux%u tiles exceed the device's workgroup limits", tile, tile);
+    return res;
+  }
+
+  /**
+  * The shader's image is declared rgba8, only a target of that format with storage
+  * support is written directly. Anything else (i.e B8G8R8A8 swapchains) gets an
+  * intermediate rgba8 image blitted onto it, blits convert between formats
+  */
+  VkFormatProperties fmt_props;
+  vkGetPhysicalDeviceFormatProperties(phys_dev, format, &fmt_props);
+  bool direct = format == VK_FORMAT_R8G8B8A8_UNORM && (fmt_props.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT);
+  if (!direct && !(fmt_props.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_DST_BIT)) {
+    dlu_log_me(DLU_DANGER, "[x] Format %d can neither be a storage image nor a blit destination", format);
+    return res;
+  }
+
+  comp->fc = frame_count;
+  comp->tile = tile;
+  comp->max_surfaces = max_surfaces;
+  comp->max_tiles = ((max_extent.width + tile - 1) / tile) * ((max_extent.height + tile - 1) / tile);
+
+  VkDeviceSize align = props.limits.minStorageBufferOffsetAlignment;
+  comp->surf_bytes = max_surfaces * sizeof(struct comp_surface);
+  comp->tile_bytes = comp->max_tiles * TILE_STRIDE * sizeof(uint32_t);
+  comp->frame_bytes = align_up(align_up(comp->surf_bytes, align) + comp->tile_bytes, align);
+
+  comp->ldi = cur_ld;
+  comp->sets = calloc(frame_count, sizeof(VkDescriptorSet));
+  comp->bins = calloc(comp->max_tiles * TILE_STRIDE, sizeof(uint32_t));
+  comp->raster_tiles = calloc(comp->max_tiles, sizeof(VkRect2D));
+  if (!comp->sets || !comp->bins || !comp->raster_tiles) {
+    dlu_log_me(DLU_DANGER, "[x] calloc: %s", strerror(errno));
+    goto err_comp;
+  }
+
+  res = comp_create_buffer(app, cur_ld, comp->frame_bytes * frame_count);
+  if (res) goto err_comp;
+
+  if (!direct) {
+    res = comp_create_image(app, cur_ld, max_extent);
+    if (res) goto err_comp;
+  }
+
+  res = comp_create_sets(app, cur_ld);
+  if (res) goto err_comp;
+
+  res = comp_create_pipeline(app, cur_ld, module);
+  if (res) goto err_comp;
+
+  return res;
+
+err_comp:
+  dlu_freeup_compositor(app);
+  return (res) ? res : VK_RESULT_MAX_ENUM;
+}
+
+VkResult dlu_comp_begin_frame(vkcomp *app, uint32_t frame, VkExtent2D extent) {
+  VkResult res = VK_RESULT_MAX_ENUM;
+  struct _composite *comp = &app->composite;
+
+  if (!comp->pipeline) { PERR(DLU_VKCOMP_COMPOSITOR, 0, NULL); return res; }
+
+  uint32_t tiles_x = (extent.width + comp->tile - 1) / comp->tile;
+  uint32_t tiles_y = (extent.height + comp->tile - 1) / comp->tile;
+  if (frame >= comp->fc || tiles_x * tiles_y > comp->max_tiles) { PERR(DLU_OP_NOT_PERMITED, 0, NULL); return res; }
+
+  comp->cur_frame = frame;
+  comp->extent = extent;
+  comp->tiles_x = tiles_x;
+  comp->tiles_y = tiles_y;
+  comp->surfc = comp->overflow = 0;
+
+  /* Only the counts need clearing, indices past a count are never read */
+  for (uint32_t i = 0; i < tiles_x * tiles_y; i++)
+    comp->bins[i * TILE_STRIDE] = 0;
+
+  return VK_SUCCESS;
+}
+
+VkResult dlu_comp_add_surface(
+  vkcomp *app,
+  float x,
+  float y,
+  float width,
+  float height,
+  float opacity,
+  uint32_t cur_tex,
+  VkBool32 opaque
+) {
+
+  VkResult res = VK_RESULT_MAX_ENUM;
+  struct _composite *comp = &app->composite;
+
+  if (!comp->pipeline) { PERR(DLU_VKCOMP_COMPOSITOR, 0, NULL); return res; }
+  if (comp->surfc >= comp->max_surfaces) { PERR(DLU_OP_NOT_PERMITED, 0, NULL); return res; }
+  if (app->text_data[cur_tex].slot == UINT32_MAX) { PERR(DLU_VKCOMP_BINDLESS, 0, NULL); return res; }
+  if (width <= 0.0f || height <= 0.0f) return VK_SUCCESS;
+
+  float ext_w = (float) (comp->tiles_x * comp->tile), ext_h = (float) (comp->tiles_y * comp->tile);
+  if (x >= ext_w || y >= ext_h || x + width <= 0.0f || y + height <= 0.0f) return VK_SUCCESS;
+
+  uint32_t idx = comp->surfc++;
+  struct comp_surface *surfaces = (struct comp_surface *) ((char *) comp->mapped + comp->cur_frame * comp->frame_bytes);
+
+  /* Mapped memory is likely write combined, fill it in one go and never read it back */
+  struct comp_surface surface = {
+    { x, y, x + width, y + height }, opacity, app->text_data[cur_tex].slot, { 0, 0 }
+  };
+  surfaces[idx] = surface;
+
+  uint32_t tx0 = (x > 0.0f) ? (uint32_t) x / comp->tile : 0;
+  uint32_t ty0 = (y > 0.0f) ? (uint32_t) y / comp->tile : 0;
+  float x1 = (x + width < ext_w) ? x + width : ext_w, y1 = (y + height < ext_h) ? y + height : ext_h;
+  uint32_t px1 = (uint32_t) x1, py1 = (uint32_t) y1;
+  if ((float) px1 < x1) px1++; /* Partially covered pixels still count */
+  if ((float) py1 < y1) py1++;
+  uint32_t tx1 = (px1 - 1) / comp->tile;
+  uint32_t ty1 = (py1 - 1) / comp->tile;
+  bool covers_all = opaque && opacity >= 1.0f;
+
+  for (uint32_t ty = ty0; ty <= ty1; ty++) {
+    for (uint32_t tx = tx0; tx <= tx1; tx++) {
+      uint32_t *list = &comp->bins[(ty * comp->tiles_x + tx) * TILE_STRIDE];
+
+      /* The raster path draws every surface of the frame in it anyway */
+      if (list[0] == TILE_RASTER) continue;
+
+      /* Nothing beneath an opaque surface covering the whole tile can show through */
+      if (covers_all && x <= tx * comp->tile && y <= ty * comp->tile &&
+          x + width >= (tx + 1) * comp->tile && y + height >= (ty + 1) * comp->tile)
+        list[0] = 0;
+
+      /* Dropping a surface would show the wrong pixels, hand the whole tile over instead */
+      if (list[0] == DLU_COMP_TILE_SURFACES) {
+        uint32_t px = tx * comp->tile, py = ty * comp->tile;
+        VkRect2D rect = {
+          { (int32_t) px, (int32_t) py },
+          { (px + comp->tile < comp->extent.width) ? comp->tile : comp->extent.width - px,
+            (py + comp->tile < comp->extent.height) ? comp->tile : comp->extent.height - py }
+        };
+
+        comp->raster_tiles[comp->overflow++] = rect;
+        list[0] = TILE_RASTER;
+        continue;
+      }
+
+      list[++list[0]] = idx;
+    }
+  }
+
+  return VK_SUCCESS;
+}
+
+uint32_t dlu_comp_raster_tiles(vkcomp *app, const VkRect2D **rects) {
+  if (rects) *rects = app->composite.raster_tiles;
+  return app->composite.overflow;
+}
+
+/* Where the image is used after dlu_comp_record() leaves it in layout */
+static void layout_consumer(VkImageLayout layout, VkPipelineStageFlags *stage, VkAccessFlags *access) {
+  switch (layout) {
+    case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
+      *stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+      *access = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+      break;
+    case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+      *stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+      *access = VK_ACCESS_TRANSFER_READ_BIT;
+      break;
+    case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+      *stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+      *access = VK_ACCESS_SHADER_READ_BIT;
+      break;
+    default: /* VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, the presentation engine waits on semaphores */
+      *stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+      *access = 0;
+      break;
+  }
+}
+
+static VkImageMemoryBarrier comp_barrier(
+  VkImage image,
+  VkAccessFlags srcAccessMask,
+  VkAccessFlags dstAccessMask,
+  VkImageLayout oldLayout,
+  VkImageLayout newLayout
+) {
+
+  VkImageMemoryBarrier barrier = {};
+  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barrier.pNext = NULL;
+  barrier.srcAccessMask = srcAccessMask;
+  barrier.dstAccessMask = dstAccessMask;
+  barrier.oldLayout = oldLayout;
+  barrier.newLayout = newLayout;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image = image;
+  barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  barrier.subresourceRange.baseMipLevel = 0;
+  barrier.subresourceRange.levelCount = 1;
+  barrier.subresourceRange.baseArrayLayer = 0;
+  barrier.subresourceRange.layerCount = 1;
+
+  return barrier;
+}
+
+void dlu_comp_record(
+  vkcomp *app,
+  uint32_t cur_pool,
+  uint32_t cur_buff,
+  VkImage target,
+  VkImageView target_view,
+  VkImageLayout finalLayout,
+  VkClearColorValue clear
+) {
+
+  struct _composite *comp = &app->composite;
+  VkCommandBuffer cmd_buff = app->cmd_data[cur_pool].cmd_buffs[cur_buff];
+
+  if (!comp->pipeline) { PERR(DLU_VKCOMP_COMPOSITOR, 0, NULL); return; }
+
+  /* Hand the tile lists to the GPU */
+  memcpy((char *) comp->mapped + comp->cur_frame * comp->frame_bytes + (comp->frame_bytes - comp->tile_bytes),
+         comp->bins, comp->tiles_x * comp->tiles_y * TILE_STRIDE * sizeof(uint32_t));
+
+  /* With the intermediate image the set already points at it */
+  if (!comp->image) {
+    VkDescriptorImageInfo image_info = {};
+    image_info.sampler = VK_NULL_HANDLE;
+    image_info.imageView = target_view;
+    image_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+    VkWriteDescriptorSet write = {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.pNext = NULL;
+    write.dstSet = comp->sets[comp->cur_frame];
+    write.dstBinding = 0;
+    write.dstArrayElement = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    write.pImageInfo = &image_info;
+
+    DLU_VK(app, comp->ldi).UpdateDescriptorSets(app->ld_data[comp->ldi].device, 1, &write, 0, NULL);
+  }
+
+  struct comp_push push = {};
+  memcpy(push.clear, clear.float32, sizeof(push.clear));
+  push.tiles_x = comp->tiles_x;
+
+  VkDescriptorSet sets[2] = { comp->sets[comp->cur_frame], app->bindless.set };
+  VkImage written = (comp->image) ? comp->image : target;
+
+  VkPipelineStageFlags dst_stage = 0;
+  VkAccessFlags dst_access = 0;
+  layout_consumer(finalLayout, &dst_stage, &dst_access);
+
+  const float color[4] = { 0.2f, 0.6f, 1.0f, 1.0f };
+  if (app->gpu_prof.frames) dlu_gpu_prof_begin(app, cur_pool, cur_buff, "composite", color);
+
+  /**
+  * Every pixel of the frame is overwritten, so prior contents are discarded. The source
+  * stages are where a swapchain image's acquire semaphore is waited on: the intermediate
+  * image was last read by the previous frame's blit, a direct target is first touched here
+  */
+  VkImageMemoryBarrier pre = comp_barrier(written, 0, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+  DLU_CMD_VK(app, cur_pool).CmdPipelineBarrier(cmd_buff, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                               VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, NULL, 0, NULL, 1, &pre);
+
+  DLU_CMD_VK(app, cur_pool).CmdBindPipeline(cmd_buff, VK_PIPELINE_BIND_POINT_COMPUTE, comp->pipeline);
+  DLU_CMD_VK(app, cur_pool).CmdBindDescriptorSets(cmd_buff, VK_PIPELINE_BIND_POINT_COMPUTE, comp->pipeline_layout, 0, ARR_LEN(sets), sets, 0, NULL);
+  DLU_CMD_VK(app, cur_pool).CmdPushConstants(cmd_buff, comp->pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push), &push);
+  DLU_CMD_VK(app, cur_pool).CmdDispatch(cmd_buff, comp->tiles_x, comp->tiles_y, 1);
+
+  if (comp->image) {
+    VkImageMemoryBarrier mid[2] = {
+      comp_barrier(comp->image, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL),
+      comp_barrier(target, 0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
+    };
+    DLU_CMD_VK(app, cur_pool).CmdPipelineBarrier(cmd_buff, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                                 VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, ARR_LEN(mid), mid);
+
+    VkImageBlit blit = {};
+    blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    blit.srcSubresource.mipLevel = 0;
+    blit.srcSubresource.baseArrayLayer = 0;
+    blit.srcSubresource.layerCount = 1;
+    blit.srcOffsets[1].x = comp->extent.width;
+    blit.srcOffsets[1].y = comp->extent.height;
+    blit.srcOffsets[1].z = 1;
+    blit.dstSubresource = blit.srcSubresource;
+    blit.dstOffsets[1] = blit.srcOffsets[1];
+
+    DLU_CMD_VK(app, cur_pool).CmdBlitImage(cmd_buff, comp->image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                           target, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_NEAREST);
+
+    VkImageMemoryBarrier post = comp_barrier(target, VK_ACCESS_TRANSFER_WRITE_BIT, dst_access, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, finalLayout);
+    DLU_CMD_VK(app, cur_pool).CmdPipelineBarrier(cmd_buff, VK_PIPELINE_STAGE_TRANSFER_BIT, dst_stage, 0, 0, NULL, 0, NULL, 1, &post);
+  } else {
+    VkImageMemoryBarrier post = comp_barrier(target, VK_ACCESS_SHADER_WRITE_BIT, dst_access, VK_IMAGE_LAYOUT_GENERAL, finalLayout);
+    DLU_CMD_VK(app, cur_pool).CmdPipelineBarrier(cmd_buff, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, dst_stage, 0, 0, NULL, 0, NULL, 1, &post);
+  }
+
+  if (app->gpu_prof.frames) dlu_gpu_prof_end(app, cur_pool, cur_buff);
+}
+
+void dlu_freeup_compositor(vkcomp *app) {
+  struct _composite *comp = &app->composite;
+
+  if (comp->sets) {
+    VkDevice device = app->ld_data[comp->ldi].device;
+    if (comp->pipeline) vkDestroyPipeline(device, comp->pipeline, NULL);
+    if (comp->pipeline_layout) vkDestroyPipelineLayout(device, comp->pipeline_layout, NULL);
+    if (comp->pool) vkDestroyDescriptorPool(device, comp->pool, NULL);
+    if (comp->layout) vkDestroyDescriptorSetLayout(device, comp->layout, NULL);
+    if (comp->mapped) vkUnmapMemory(device, comp->mem);
+    if (comp->buff) vkDestroyBuffer(device, comp->buff, NULL);
+    if (comp->mem) vkFreeMemory(device, comp->mem, NULL);
+    if (comp->view) vkDestroyImageView(device, comp->view, NULL);
+    if (comp->image) vkDestroyImage(device, comp->image, NULL);
+    if (comp->image_mem) vkFreeMemory(device, comp->image_mem, NULL);
+  }
+
+  free(comp->sets);
+  free(comp->bins);
+  free(comp->raster_tiles);
+  memset(comp, 0, sizeof(struct _composite));
+}
@@ -99,17 +99,123 @@ VkResult dlu_create_vkwayland_surfaceKHR(vkcomp *app, void *wl_display, void *wl
   return res;
 }
 
-VkResult dlu_create_physical_device(
+/* Points per criterion, each outweighs everything below it */
+#define DLU_PD_SCORE_USER 1000000
+#define DLU_PD_SCORE_DRM 100000
+#define DLU_PD_SCORE_TYPE 10000
+#define DLU_PD_SCORE_QUEUE 1000
+
+/* Returns -1 for devices that can't be used at all */
+static int64_t score_device(vkcomp *app, VkPhysicalDevice dev, const dlu_pd_criteria *crit, const char *name) {
+  VkPhysicalDeviceProperties props;
+  VkPhysicalDeviceMemoryProperties mem_props;
+  VkExtensionProperties *ext_props = NULL;
+  VkQueueFamilyProperties *queue_families = NULL;
+  uint32_t extc = 0, qfc = 0;
+  VkBool32 found = VK_FALSE, has_drm = VK_FALSE, present = (app->surface) ? VK_FALSE : VK_TRUE;
+  int64_t score = 0;
+
+  vkGetPhysicalDeviceProperties(dev, &props);
+  if (crit->require_type && props.deviceType != crit->type) return -1;
+
+  if (vkEnumerateDeviceExtensionProperties(dev, NULL, &extc, NULL)) return -1;
+  ext_props = (VkExtensionProperties *) alloca(extc * sizeof(VkExtensionProperties));
+  if (vkEnumerateDeviceExtensionProperties(dev, NULL, &extc, ext_props)) return -1;
+
+  for (uint32_t i = 0; i < crit->extc; i++) {
+    found = VK_FALSE;
+    for (uint32_t j = 0; j < extc && !found; j++)
+      found = !strcmp(crit->exts[i], ext_props[j].extensionName);
+    if (!found) {
+      dlu_log_me(DLU_INFO, "%s lacks %s", props.deviceName, crit->exts[i]);
+      return -1;
+    }
+  }
+
+  for (uint32_t j = 0; j < extc; j++)
+    if (!strcmp(ext_props[j].extensionName, VK_EXT_PHYSICAL_DEVICE_DRM_EXTENSION_NAME)) has_drm = VK_TRUE;
+
+  /* Queue topology, a graphics family able to present is a must with a surface */
+  vkGetPhysicalDeviceQueueFamilyProperties(dev, &qfc, NULL);
+  queue_families = (VkQueueFamilyProperties *) alloca(qfc * sizeof(VkQueueFamilyProperties));
+  vkGetPhysicalDeviceQueueFamilyProperties(dev, &qfc, queue_families);
+
+  VkBool32 dedicated_compute = VK_FALSE, dedicated_transfer = VK_FALSE;
+  for (uint32_t i = 0; i < qfc; i++) {
+    VkQueueFlags flags = queue_families[i].queueFlags;
+    if (!present && flags & VK_QUEUE_GRAPHICS_BIT)
+      vkGetPhysicalDeviceSurfaceSupportKHR(dev, i, app->surface, &present);
+    if (flags & VK_QUEUE_COMPUTE_BIT && !(flags & VK_QUEUE_GRAPHICS_BIT))
+      dedicated_compute = VK_TRUE;
+    if (flags & VK_QUEUE_TRANSFER_BIT && !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
+      dedicated_transfer = VK_TRUE;
+  }
+
+  if (!present) {
+    dlu_log_me(DLU_INFO, "%s can't present to the given surface", props.deviceName);
+    return -1;
+  }
+
+  score += (dedicated_compute + dedicated_transfer) * DLU_PD_SCORE_QUEUE;
+
+  if (name && strstr(props.deviceName, name)) score += DLU_PD_SCORE_USER;
+
+  if (crit->type != VK_PHYSICAL_DEVICE_TYPE_MAX_ENUM) {
+    if (props.deviceType == crit->type) score += DLU_PD_SCORE_TYPE;
+  } else {
+    switch (props.deviceType) {
+      case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: score += DLU_PD_SCORE_TYPE; break;
+      case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: score += DLU_PD_SCORE_TYPE * 2 / 3; break;
+      case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: score += DLU_PD_SCORE_TYPE / 3; break;
+      default: break;
+    }
+  }
+
+  if (crit->match_drm && has_drm) {
+    PFN_vkGetPhysicalDeviceProperties2KHR get_props2 = (PFN_vkGetPhysicalDeviceProperties2KHR)
+      vkGetInstanceProcAddr(app->instance, "vkGetPhysicalDeviceProperties2KHR");
+
+    if (get_props2) {
+      VkPhysicalDeviceDrmPropertiesEXT drm_props = {};
+      drm_props.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DRM_PROPERTIES_EXT;
+      drm_props.pNext = NULL;
+
+      VkPhysicalDeviceProperties2 props2 = {};
+      props2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+      props2.pNext = &drm_props;
+
+      get_props2(dev, &props2);
+
+      if ((drm_props.hasPrimary && drm_props.primaryMajor == crit->drm_major && drm_props.primaryMinor == crit->drm_minor) ||
+          (drm_props.hasRender && drm_props.renderMajor == crit->drm_major && drm_props.renderMinor == crit->drm_minor))
+        score += DLU_PD_SCORE_DRM;
+    }
+  }
+
+  /* Device local memory in 256MiB units, tie breaker between similar devices */
+  vkGetPhysicalDeviceMemoryProperties(dev, &mem_props);
+  for (uint32_t i = 0; i < mem_props.memoryHeapCount; i++)
+    if (mem_props.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+      score += (int64_t) (mem_props.memoryHeaps[i].size >> 28);
+
+  dlu_log_me(DLU_INFO, "%s scored %ld", props.deviceName, (long) score);
+
+  return score;
+}
+
+VkResult dlu_select_physical_device(
   vkcomp *app,
   uint32_t cur_pd,
-  VkPhysicalDeviceType vkpdtype,
+  const dlu_pd_criteria *criteria,
   VkPhysicalDeviceProperties *device_props,
   VkPhysicalDeviceFeatures *device_feats
 ) {
 
   VkResult res = VK_RESULT_MAX_ENUM;
   VkPhysicalDevice *devices = VK_NULL_HANDLE;
-  uint32_t device_count = 0;
+  uint32_t device_count = 0, best = UINT32_MAX;
+  int64_t score = 0, best_score = -1;
+  const char *name = NULL;
 
   if (!app->pd_data) { PERR(DLU_BUFF_NOT_ALLOC, 0, "DLU_PD_DATA"); return res; }
   if (!app->instance) { PERR(DLU_VKCOMP_INSTANCE, 0, NULL); return res; }
@@ -127,28 +233,43 @@ VkResult dlu_create_physical_device(
   res = vkEnumeratePhysicalDevices(app->instance, &device_count, devices);
   if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkEnumeratePhysicalDevices"); return res; }
 
-  /**
-  * get a physical device that is suitable
-  * to do the graphics related task that we need
-  */
+  name = getenv("DLU_DEVICE_NAME");
+  if (!name || !*name) name = criteria->name;
+
+  /* Ties go to the device enumerated first */
   for (uint32_t i = 0; i < device_count; i++) {
-    vkGetPhysicalDeviceProperties(devices[i], device_props); /* Query device properties */
-    vkGetPhysicalDeviceFeatures(devices[i], device_feats); /* Query device features */
-    if (device_props->deviceType == vkpdtype) {
-      memmove(&app->pd_data[cur_pd].phys_dev, &devices[i], sizeof(devices[i]));
-      dlu_log_me(DLU_SUCCESS, "Suitable GPU Found: %s", device_props->deviceName);
-      break;
-    }
+    score = score_device(app, devices[i], criteria, name);
+    if (score > best_score) { best_score = score; best = i; }
   }
 
-  if (app->pd_data[cur_pd].phys_dev == VK_NULL_HANDLE) {
+  if (best == UINT32_MAX) {
     dlu_log_me(DLU_DANGER, "[x] failed to find a suitable GPU!!!");
     return VK_RESULT_MAX_ENUM;
   }
 
+  app->pd_data[cur_pd].phys_dev = devices[best];
+  vkGetPhysicalDeviceProperties(devices[best], device_props); /* Query device properties */
+  vkGetPhysicalDeviceFeatures(devices[best], device_feats); /* Query device features */
+  dlu_log_me(DLU_SUCCESS, "Suitable GPU Found: %s", device_props->deviceName);
+
   return res;
 }
 
+VkResult dlu_create_physical_device(
+  vkcomp *app,
+  uint32_t cur_pd,
+  VkPhysicalDeviceType vkpdtype,
+  VkPhysicalDeviceProperties *device_props,
+  VkPhysicalDeviceFeatures *device_feats
+) {
+
+  dlu_pd_criteria criteria = {};
+  criteria.type = vkpdtype;
+  criteria.require_type = VK_TRUE;
+
+  return dlu_select_physical_device(app, cur_pd, &criteria, device_props, device_feats);
+}
+
 VkBool32 dlu_create_queue_families(vkcomp *app, uint32_t cur_pd, VkQueueFlagBits vkqfbits) {
   VkBool32 ret = VK_TRUE;
   VkBool32 present_support = VK_FALSE;
@@ -180,6 +301,13 @@ VkBool32 dlu_create_queue_families(vkcomp *app, uint32_t cur_pd, VkQueueFlagBits
         present_support = VK_FALSE;
       }
 
+      /* Headless rendering, no surface to present to */
+      if (!app->surface && vkqfbits & VK_QUEUE_GRAPHICS_BIT && app->pd_data[cur_pd].gfam_idx == UINT32_MAX &&
+          queue_families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+        app->pd_data[cur_pd].gfam_idx = i; ret = VK_FALSE;
+        dlu_log_me(DLU_SUCCESS, "Physical Device Queue Family Index %d supports graphics operations", i);
+      }
+
       if (vkqfbits & VK_QUEUE_COMPUTE_BIT && app->pd_data[cur_pd].cfam_idx == UINT32_MAX) {
         /* Retrieve Compute Family Queue index */
         app->pd_data[cur_pd].cfam_idx = i; ret = VK_FALSE;
@@ -194,9 +322,61 @@ VkBool32 dlu_create_queue_families(vkcomp *app, uint32_t cur_pd, VkQueueFlagBits
     }
   }
 
+  /* A family without graphics runs compute work asynchronously to rendering */
+  if (vkqfbits & VK_QUEUE_COMPUTE_BIT) {
+    for (uint32_t i = 0; i < qfc; i++) {
+      if ((queue_families[i].queueFlags & VK_QUEUE_COMPUTE_BIT) && !(queue_families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+        app->pd_data[cur_pd].cfam_idx = i; ret = VK_FALSE;
+        dlu_log_me(DLU_SUCCESS, "Physical Device Queue Family Index %d is a dedicated compute family", i);
+        break;
+      }
+    }
+  }
+
+  /* A transfer only family is usually backed by DMA engines, uploads then overlap rendering */
+  if (vkqfbits & VK_QUEUE_TRANSFER_BIT) {
+    for (uint32_t i = 0; i < qfc; i++) {
+      if ((queue_families[i].queueFlags & VK_QUEUE_TRANSFER_BIT) &&
+          !(queue_families[i].queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+        app->pd_data[cur_pd].tfam_idx = i; ret = VK_FALSE;
+        dlu_log_me(DLU_SUCCESS, "Physical Device Queue Family Index %d is a dedicated transfer family", i);
+        break;
+      }
+    }
+  }
+
   return ret;
 }
 
+static bool device_has_ext(VkPhysicalDevice dev, const char *name) {
+  VkExtensionProperties *ext_props = NULL;
+  uint32_t extc = 0;
+
+  if (vkEnumerateDeviceExtensionProperties(dev, NULL, &extc, NULL)) return false;
+  ext_props = (VkExtensionProperties *) alloca(extc * sizeof(VkExtensionProperties));
+  if (vkEnumerateDeviceExtensionProperties(dev, NULL, &extc, ext_props)) return false;
+
+  for (uint32_t i = 0; i < extc; i++)
+    if (!strcmp(name, ext_props[i].extensionName)) return true;
+
+  return false;
+}
+
+/* Fills a VkPhysicalDeviceFeatures2 pNext chain, false if the device can't be queried */
+static bool query_features2(vkcomp *app, uint32_t cur_pd, void *pNext) {
+  PFN_vkGetPhysicalDeviceFeatures2KHR get_features2 = (PFN_vkGetPhysicalDeviceFeatures2KHR)
+    vkGetInstanceProcAddr(app->instance, "vkGetPhysicalDeviceFeatures2KHR");
+  if (!get_features2) return false;
+
+  VkPhysicalDeviceFeatures2 features2 = {};
+  features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  features2.pNext = pNext;
+
+  get_features2(app->pd_data[cur_pd].phys_dev, &features2);
+
+  return true;
+}
+
 VkResult dlu_create_logical_device(
   vkcomp *app,
   uint32_t cur_pd,
@@ -226,6 +406,85 @@ VkResult dlu_create_logical_device(
   create_info.ppEnabledExtensionNames = ppEnabledExtensionNames;
   create_info.pEnabledFeatures = pEnabledFeatures;
 
+  /* The present extensions are optional, leave out the ones the device lacks instead of failing vkCreateDevice */
+  const char **ext_names = alloca((enabledExtensionCount + 1) * sizeof(const char *));
+  uint32_t extc = 0;
+  for (uint32_t i = 0; i < enabledExtensionCount; i++) {
+    if ((!strcmp(ppEnabledExtensionNames[i], VK_KHR_PRESENT_ID_EXTENSION_NAME) ||
+         !strcmp(ppEnabledExtensionNames[i], VK_KHR_PRESENT_WAIT_EXTENSION_NAME)) &&
+        !device_has_ext(app->pd_data[cur_pd].phys_dev, ppEnabledExtensionNames[i])) {
+      dlu_log_me(DLU_WARNING, "%s not supported by this device, skipped", ppEnabledExtensionNames[i]);
+      continue;
+    }
+    ext_names[extc++] = ppEnabledExtensionNames[i];
+  }
+
+  create_info.enabledExtensionCount = extc;
+  create_info.ppEnabledExtensionNames = ext_names;
+
+  /* Both extensions only do something with their features turned on */
+  bool present_id = false, present_wait = false;
+  for (uint32_t i = 0; i < extc; i++) {
+    if (!strcmp(ext_names[i], VK_KHR_PRESENT_ID_EXTENSION_NAME))
+      present_id = true;
+    if (!strcmp(ext_names[i], VK_KHR_PRESENT_WAIT_EXTENSION_NAME))
+      present_wait = true;
+  }
+
+  VkPhysicalDevicePresentWaitFeaturesKHR wait_features = {};
+  wait_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+  wait_features.pNext = NULL;
+
+  VkPhysicalDevicePresentIdFeaturesKHR id_features = {};
+  id_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+  id_features.pNext = &wait_features;
+
+  /* Drivers may expose the extensions without the features, fall back to fence tracking then */
+  if (present_id && present_wait) {
+    if (!query_features2(app, cur_pd, &id_features) || !id_features.presentId || !wait_features.presentWait) {
+      dlu_log_me(DLU_WARNING, "presentId/presentWait unsupported, present latency falls back to fences");
+      present_id = present_wait = false;
+    }
+  }
+
+  if (present_id && present_wait) {
+    id_features.presentId = wait_features.presentWait = VK_TRUE;
+    create_info.pNext = &id_features;
+  }
+
+  /* Descriptor indexing features are off unless asked for, only request what the device has */
+  bool desc_indexing = false;
+  for (uint32_t i = 0; i < enabledExtensionCount; i++)
+    if (!strcmp(ppEnabledExtensionNames[i], VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME))
+      desc_indexing = true;
+
+  VkPhysicalDeviceDescriptorIndexingFeaturesEXT idx_features = {};
+  idx_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+  idx_features.pNext = NULL;
+
+  if (desc_indexing) {
+    VkPhysicalDeviceDescriptorIndexingFeaturesEXT supported = idx_features;
+    if (!query_features2(app, cur_pd, &supported)) desc_indexing = false;
+
+    idx_features.runtimeDescriptorArray = supported.runtimeDescriptorArray;
+    idx_features.descriptorBindingPartiallyBound = supported.descriptorBindingPartiallyBound;
+    idx_features.descriptorBindingSampledImageUpdateAfterBind = supported.descriptorBindingSampledImageUpdateAfterBind;
+    idx_features.descriptorBindingUpdateUnusedWhilePending = supported.descriptorBindingUpdateUnusedWhilePending;
+    idx_features.shaderSampledImageArrayNonUniformIndexing = supported.shaderSampledImageArrayNonUniformIndexing;
+
+    /* What the bindless texture table can't do without */
+    if (!idx_features.runtimeDescriptorArray || !idx_features.descriptorBindingPartiallyBound ||
+        !idx_features.descriptorBindingSampledImageUpdateAfterBind || !idx_features.shaderSampledImageArrayNonUniformIndexing) {
+      dlu_log_me(DLU_WARNING, "%s lacks the features needed for bindless textures", VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+      desc_indexing = false;
+    }
+  }
+
+  if (desc_indexing) {
+    idx_features.pNext = (void *) create_info.pNext;
+    create_info.pNext = &idx_features;
+  }
+
   /* Create logic device */
   res = vkCreateDevice(app->pd_data[cur_pd].phys_dev, &create_info, NULL, &app->ld_data[cur_ld].device);
   if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkCreateDevice"); return res; }
@@ -233,6 +492,53 @@ VkResult dlu_create_logical_device(
   /* Associate a logical device with a given physical */
   app->ld_data[cur_ld].pdi = cur_pd;
 
+  /**
+  * Per frame entry points straight from the driver. Anything the device doesn't
+  * expose (swapchain functions without VK_KHR_swapchain) keeps the loader's
+  * trampoline, so table entries are never NULL.
+  */
+#define DLU_VK_DISPATCH_LOAD(func) \
+  app->ld_data[cur_ld].vk.func = (PFN_vk##func) vkGetDeviceProcAddr(app->ld_data[cur_ld].device, "vk" #func); \
+  if (!app->ld_data[cur_ld].vk.func) app->ld_data[cur_ld].vk.func = vk##func;
+
+  DLU_VK_DEVICE_FUNCS(DLU_VK_DISPATCH_LOAD)
+#undef DLU_VK_DISPATCH_LOAD
+
+  /* Pipeline creation will report pipeline cache hits/misses if available */
+  for (uint32_t i = 0; i < enabledExtensionCount; i++)
+    if (!strcmp(ppEnabledExtensionNames[i], VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME))
+      app->ld_data[cur_ld].pipe_feedback = VK_TRUE;
+
+  /* Needed for the bindless texture table */
+  app->ld_data[cur_ld].desc_indexing = (desc_indexing) ? VK_TRUE : VK_FALSE;
+  app->ld_data[cur_ld].desc_unused_pending = (desc_indexing) ? idx_features.descriptorBindingUpdateUnusedWhilePending : VK_FALSE;
+
+  /* Descriptor update templates and push descriptors are device extensions under Vulkan 1.0 */
+  bool desc_template = false, push_desc = false;
+  for (uint32_t i = 0; i < enabledExtensionCount; i++) {
+    if (!strcmp(ppEnabledExtensionNames[i], VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME))
+      desc_template = true;
+    if (!strcmp(ppEnabledExtensionNames[i], VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME))
+      push_desc = true;
+  }
+
+  if (desc_template) {
+    DLU_DR_DEVICE_PROC_ADDR(app->ld_data[cur_ld].device, app->ld_data[cur_ld].create_desc_template, CreateDescriptorUpdateTemplateKHR);
+    DLU_DR_DEVICE_PROC_ADDR(app->ld_data[cur_ld].device, app->ld_data[cur_ld].destroy_desc_template, DestroyDescriptorUpdateTemplateKHR);
+    DLU_DR_DEVICE_PROC_ADDR(app->ld_data[cur_ld].device, app->ld_data[cur_ld].update_desc_template, UpdateDescriptorSetWithTemplateKHR);
+  }
+
+  if (push_desc)
+    DLU_DR_DEVICE_PROC_ADDR(app->ld_data[cur_ld].device, app->ld_data[cur_ld].push_desc_set, CmdPushDescriptorSetKHR);
+
+  if (desc_template && push_desc)
+    DLU_DR_DEVICE_PROC_ADDR(app->ld_data[cur_ld].device, app->ld_data[cur_ld].push_desc_template, CmdPushDescriptorSetWithTemplateKHR);
+
+  if (present_id && present_wait) {
+    DLU_DR_DEVICE_PROC_ADDR(app->ld_data[cur_ld].device, app->ld_data[cur_ld].wait_for_present, WaitForPresentKHR);
+    app->ld_data[cur_ld].present_wait = (app->ld_data[cur_ld].wait_for_present) ? VK_TRUE : VK_FALSE;
+  }
+
   return res;
 }
 
@@ -299,7 +605,16 @@ VkResult dlu_create_swap_chain(
   }
 
   res = vkCreateSwapchainKHR(app->ld_data[cur_ld].device, create_info, NULL, &app->sc_data[cur_scd].swap_chain);
-  if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkCreateSwapchainKHR"); }
+  if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkCreateSwapchainKHR"); return res; }
+
+  app->sc_data[cur_scd].format = create_info->imageFormat;
+  app->sc_data[cur_scd].extent = create_info->imageExtent;
+  app->sc_data[cur_scd].stale = VK_FALSE;
+
+  /* Present ids are per swapchain and queued[] refers to frames of the one being replaced */
+  app->sc_data[cur_scd].present_id = 0;
+  app->sc_data[cur_scd].submitted = 0;
+  memset(app->sc_data[cur_scd].queued, 0, sizeof(app->sc_data[cur_scd].queued));
 
   VkImage *imgs = VK_NULL_HANDLE;
 
@@ -310,6 +625,12 @@ VkResult dlu_create_swap_chain(
   res = vkGetSwapchainImagesKHR(app->ld_data[cur_ld].device, app->sc_data[cur_scd].swap_chain, &app->sc_data[cur_scd].sic, NULL);
   if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkGetSwapchainImagesKHR"); return res; }
 
+  /* sc_buffs and syncs were sized by dlu_otba(), the driver may hand back more images than asked for */
+  if (app->sc_data[cur_scd].sbc && app->sc_data[cur_scd].sic > app->sc_data[cur_scd].sbc) {
+    dlu_log_me(DLU_DANGER, "[x] Swapchain has %u images, only room for %u", app->sc_data[cur_scd].sic, app->sc_data[cur_scd].sbc);
+    return VK_RESULT_MAX_ENUM;
+  }
+
   imgs = (VkImage *) alloca(app->sc_data[cur_scd].sic * sizeof(VkImage));
 
   res = vkGetSwapchainImagesKHR(app->ld_data[cur_ld].device, app->sc_data[cur_scd].swap_chain, &app->sc_data[cur_scd].sic, imgs);
@@ -360,8 +681,14 @@ VkResult dlu_create_depth_buff(
   mem_alloc.allocationSize = mem_reqs.size;
   mem_alloc.memoryTypeIndex = 0;
 
-  VkBool32 pass; /* find a suitable memory type for depth bufffer */
-  pass = memory_type_from_properties(app, app->ld_data[app->sc_data[cur_scd].ldi].pdi, mem_reqs.memoryTypeBits, requirements_mask, &mem_alloc.memoryTypeIndex);
+  VkBool32 pass = VK_FALSE; /* find a suitable memory type for depth bufffer */
+
+  /* A transient depth buffer never needs to leave tile memory, so prefer lazily allocated memory */
+  if (img_info->usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT)
+    pass = memory_type_from_all_properties(app, app->ld_data[app->sc_data[cur_scd].ldi].pdi, mem_reqs.memoryTypeBits,
+                                           VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT | VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &mem_alloc.memoryTypeIndex);
+  if (!pass)
+    pass = memory_type_from_properties(app, app->ld_data[app->sc_data[cur_scd].ldi].pdi, mem_reqs.memoryTypeBits, requirements_mask, &mem_alloc.memoryTypeIndex);
   if (!pass) {
     dlu_log_me(DLU_DANGER, "[x] memory_type_from_properties failed");
     return pass;
@@ -386,10 +713,129 @@ VkResult dlu_create_depth_buff(
   ivi->image = app->sc_data[cur_scd].depth.image;
   res = vkCreateImageView(app->ld_data[app->sc_data[cur_scd].ldi].device, ivi, NULL, &app->sc_data[cur_scd].depth.view);
   if (res) PERR(DLU_VK_FUNC_ERR, res, "vkCreateImageView")
+
+  /* Extension chains aren't kept, they may not outlive this call */
+  app->sc_data[cur_scd].depth.img_info = *img_info;
+  app->sc_data[cur_scd].depth.img_info.pNext = NULL;
+  app->sc_data[cur_scd].depth.view_info = *ivi;
+  app->sc_data[cur_scd].depth.view_info.pNext = NULL;
+  app->sc_data[cur_scd].depth.mem_flags = requirements_mask;
  
   return res;
 }
 
+VkResult dlu_create_transient_attachments(
+  vkcomp *app,
+  uint32_t cur_scd,
+  uint32_t count,
+  VkImageCreateInfo *img_infos,
+  VkImageViewCreateInfo *ivis,
+  const uint32_t *alias_groups
+) {
+
+  VkResult res = VK_RESULT_MAX_ENUM;
+  VkDevice device = VK_NULL_HANDLE;
+  VkMemoryRequirements *mem_reqs = NULL;
+  VkDeviceSize *group_sizes = NULL, *group_aligns = NULL, *group_offsets = NULL;
+  VkDeviceSize total_size = 0;
+  uint32_t type_bits = UINT32_MAX;
+  VkBool32 lazy = VK_TRUE;
+
+  /* Only these usages are allowed to be combined with VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT */
+  const VkImageUsageFlags att_usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
+                                      VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+
+  if (!app->sc_data) { PERR(DLU_BUFF_NOT_ALLOC, 0, "DLU_SC_DATA"); return res; }
+  if (app->sc_data[cur_scd].ldi == UINT32_MAX) { PERR(DLU_VKCOMP_DEVICE_NOT_ASSOC, 0, "dlu_create_swap_chain()"); return res; }
+  if (app->sc_data[cur_scd].trans) { PERR(DLU_ALREADY_ALLOC, 0, NULL); return res; }
+
+  device = app->ld_data[app->sc_data[cur_scd].ldi].device;
+
+  app->sc_data[cur_scd].trans = calloc(count, sizeof(struct _transient_attachment));
+  if (!app->sc_data[cur_scd].trans) {
+    dlu_log_me(DLU_DANGER, "[x] calloc: %s", strerror(errno));
+    return res;
+  }
+
+  app->sc_data[cur_scd].tac = count;
+
+  mem_reqs = (VkMemoryRequirements *) alloca(count * sizeof(VkMemoryRequirements));
+  group_sizes = (VkDeviceSize *) alloca(count * sizeof(VkDeviceSize));
+  group_aligns = (VkDeviceSize *) alloca(count * sizeof(VkDeviceSize));
+  group_offsets = (VkDeviceSize *) alloca(count * sizeof(VkDeviceSize));
+  memset(group_sizes, 0, count * sizeof(VkDeviceSize));
+  memset(group_aligns, 0, count * sizeof(VkDeviceSize));
+
+  for (uint32_t i = 0; i < count; i++) {
+    struct _transient_attachment *trans = &app->sc_data[cur_scd].trans[i];
+
+    trans->alias = (alias_groups) ? alias_groups[i] : i;
+    if (trans->alias >= count) { PERR(DLU_OP_NOT_PERMITED, 0, NULL); return res; }
+
+    /* Attachment only images never need to be read back outside of the render pass */
+    if (img_infos[i].usage & ~att_usage) lazy = VK_FALSE;
+    else img_infos[i].usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+
+    res = vkCreateImage(device, &img_infos[i], NULL, &trans->image);
+    if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkCreateImage"); return res; }
+
+    vkGetImageMemoryRequirements(device, trans->image, &mem_reqs[i]);
+
+    /* Every attachment in a group is bound to the same offset, so a group is as large as its largest member */
+    if (mem_reqs[i].size > group_sizes[trans->alias]) group_sizes[trans->alias] = mem_reqs[i].size;
+    if (mem_reqs[i].alignment > group_aligns[trans->alias]) group_aligns[trans->alias] = mem_reqs[i].alignment;
+    type_bits &= mem_reqs[i].memoryTypeBits;
+  }
+
+  /* Lay alias groups out back to back */
+  for (uint32_t i = 0; i < count; i++) {
+    if (!group_sizes[i]) continue;
+    group_offsets[i] = (total_size + group_aligns[i] - 1) & ~(group_aligns[i] - 1);
+    total_size = group_offsets[i] + group_sizes[i];
+  }
+
+  VkMemoryAllocateInfo alloc_info = {};
+  alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  alloc_info.pNext = NULL;
+  alloc_info.allocationSize = total_size;
+  alloc_info.memoryTypeIndex = 0;
+
+  /* Not every device offers a lazily allocated memory type, fallback to plain device local memory */
+  if (lazy)
+    lazy = memory_type_from_all_properties(app, app->ld_data[app->sc_data[cur_scd].ldi].pdi, type_bits,
+                                           VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT | VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &alloc_info.memoryTypeIndex);
+  if (!lazy && !memory_type_from_properties(app, app->ld_data[app->sc_data[cur_scd].ldi].pdi, type_bits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &alloc_info.memoryTypeIndex)) {
+    PERR(DLU_MEM_TYPE_ERR, 0, NULL); return VK_RESULT_MAX_ENUM;
+  }
+
+  res = vkAllocateMemory(device, &alloc_info, NULL, &app->sc_data[cur_scd].trans_mem);
+  if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkAllocateMemory"); return res; }
+
+  app->sc_data[cur_scd].trans_lazy = lazy;
+
+  for (uint32_t i = 0; i < count; i++) {
+    struct _transient_attachment *trans = &app->sc_data[cur_scd].trans[i];
+    trans->offset = group_offsets[trans->alias];
+
+    res = vkBindImageMemory(device, trans->image, app->sc_data[cur_scd].trans_mem, trans->offset);
+    if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkBindImageMemory"); return res; }
+
+    ivis[i].image = trans->image;
+    res = vkCreateImageView(device, &ivis[i], NULL, &trans->view);
+    if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkCreateImageView"); return res; }
+
+    /* Kept so dlu_recreate_swap_chain() can rebuild attachments at a new size */
+    trans->img_info = img_infos[i];
+    trans->img_info.pNext = NULL;
+    trans->view_info = ivis[i];
+    trans->view_info.pNext = NULL;
+  }
+
+  dlu_log_me(DLU_SUCCESS, "%u transient attachments share %lu bytes of %s memory", count, total_size, (lazy) ? "lazily allocated" : "device local");
+
+  return res;
+}
+
 VkResult dlu_create_vk_buffer(
   vkcomp *app,
   uint32_t cur_ld,
@@ -478,8 +924,9 @@ VkResult dlu_create_framebuffers(
     pAttachments[0] = app->sc_data[cur_scd].sc_buffs[i].view;
     create_info.pAttachments = pAttachments;
 
-    res = vkCreateFramebuffer(app->ld_data[app->sc_data[cur_scd].ldi].device, &create_info, NULL, &app->sc_data[cur_scd].sc_buffs[i].fb);
-    if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkCreateFramebuffer"); return res; }
+    /* Reuse a framebuffer if one already exists for these views, render pass and extent */
+    res = dlu_cache_framebuffer(app, app->sc_data[cur_scd].ldi, &create_info, &app->sc_data[cur_scd].sc_buffs[i].fb);
+    if (res) return res;
   }
 
   return res;
@@ -568,6 +1015,10 @@ VkResult dlu_create_syncs(vkcomp *app, uint32_t cur_scd) {
     res = vkCreateSemaphore(app->ld_data[app->sc_data[cur_scd].ldi].device, &sem_info, NULL, &app->sc_data[cur_scd].syncs[i].sem.render);
     if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkCreateSemaphore"); return res; }
 
+    /* Only needed once async compute work gets submitted, but semaphores are cheap */
+    res = vkCreateSemaphore(app->ld_data[app->sc_data[cur_scd].ldi].device, &sem_info, NULL, &app->sc_data[cur_scd].syncs[i].sem.compute);
+    if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkCreateSemaphore"); return res; }
+
     res = vkCreateFence(app->ld_data[app->sc_data[cur_scd].ldi].device, &fence_info, NULL, &app->sc_data[cur_scd].syncs[i].fence.render);
     if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkCreateFence"); return res; }
   }
@@ -592,7 +1043,10 @@ VkShaderModule dlu_create_shader_module(vkcomp *app, uint32_t cur_ld, char *code
   err = vkCreateShaderModule(app->ld_data[cur_ld].device, &create_info, NULL, &shader_module);
   if (err) PERR(DLU_VK_FUNC_ERR, err, "vkCreateShaderModule");
 
-  if (err == VK_SUCCESS) dlu_log_me(DLU_SUCCESS, "Shader module successfully created");
+  if (err == VK_SUCCESS) {
+    dlu_cache_register_shader_module(app, cur_ld, shader_module, code, code_size);
+    dlu_log_me(DLU_SUCCESS, "Shader module successfully created");
+  }
 
   return shader_module;
 }
@@ -626,8 +1080,8 @@ VkResult dlu_create_render_pass(
   render_pass_info.dependencyCount = dependencyCount;
   render_pass_info.pDependencies = pDependencies;
 
-  res = vkCreateRenderPass(app->ld_data[app->gp_data[cur_gpd].ldi].device, &render_pass_info, NULL, &app->gp_data[cur_gpd].render_pass);
-  if (res) PERR(DLU_VK_FUNC_ERR, res, "vkCreateRenderPass");
+  /* Identical attachment/subpass descriptions resolve to the same VkRenderPass */
+  res = dlu_cache_render_pass(app, app->gp_data[cur_gpd].ldi, &render_pass_info, &app->gp_data[cur_gpd].render_pass);
 
   return res;
 }
@@ -677,8 +1131,8 @@ VkResult dlu_create_graphics_pipelines(
   pipeline_info.basePipelineHandle = basePipelineHandle;
   pipeline_info.basePipelineIndex = basePipelineIndex;
 
-  res = vkCreateGraphicsPipelines(app->ld_data[app->gp_data[cur_gpd].ldi].device, app->gp_cache.pipe_cache, 1, &pipeline_info, NULL, app->gp_data[cur_gpd].graphics_pipelines);
-  if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkCreateGraphicsPipelines"); }
+  /* Identical state already built for another slot is a cache lookup */
+  res = dlu_cache_graphics_pipeline(app, app->gp_data[cur_gpd].ldi, &pipeline_info, app->gp_data[cur_gpd].graphics_pipelines);
 
   return res;
 }
@@ -718,10 +1172,12 @@ VkResult dlu_create_pipeline_layout(
 
   if (!app->gp_data) { PERR(DLU_BUFF_NOT_ALLOC, 0, "DLU_GP_DATA"); return res; }
 
+  /* Set layouts come from the layout cache, so equal descriptions across pipelines share a handle */
   VkDescriptorSetLayout  *pSetLayouts  = (layout_infos) ? alloca(layout_count * sizeof(VkDescriptorSetLayout)) :  NULL;
+  if (pSetLayouts) memset(pSetLayouts, 0, layout_count * sizeof(VkDescriptorSetLayout));
   for (uint32_t i = 0; i < layout_count; i++) {
-    res = vkCreateDescriptorSetLayout(app->ld_data[cur_ld].device, &layout_infos[i], NULL, &pSetLayouts[i]);
-    if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkCreateDescriptorSetLayout"); goto end_func; }
+    res = dlu_cache_desc_set_layout(app, cur_ld, &layout_infos[i], &pSetLayouts[i]);
+    if (res) goto end_func;
   }
 
   VkPipelineLayoutCreateInfo create_info = {};
@@ -733,15 +1189,16 @@ VkResult dlu_create_pipeline_layout(
   create_info.pushConstantRangeCount = pushConstantRangeCount;
   create_info.pPushConstantRanges = pPushConstantRanges;
 
-  res = vkCreatePipelineLayout(app->ld_data[cur_ld].device, &create_info, NULL, &app->gp_data[cur_gpd].pipeline_layout);
-  if (res) PERR(DLU_VK_FUNC_ERR, res, "vkCreatePipelineLayout")
+  res = dlu_cache_pipeline_layout(app, cur_ld, &create_info, &app->gp_data[cur_gpd].pipeline_layout);
+  if (res) goto end_func;
 
   /* Associate a logical device with a graphics pipeline */
   app->gp_data[cur_gpd].ldi = cur_ld;
 
 end_func:
+  /* The pipeline layout holds its own references on the set layouts */
   for (uint32_t i = 0; i < layout_count; i++)
-    if (pSetLayouts[i])
+    if (pSetLayouts[i] && !dlu_cache_release_desc_set_layout(app, pSetLayouts[i]))
       vkDestroyDescriptorSetLayout(app->ld_data[cur_ld].device, pSetLayouts[i], NULL);
 
   return res;
@@ -758,8 +1215,69 @@ VkResult dlu_create_desc_set_layout(
   if (!app->desc_data[cur_dd].layouts) { PERR(DLU_BUFF_NOT_ALLOC, 0, "DLU_DESC_DATA_MEMS"); return res; }
   if (app->desc_data[cur_dd].ldi == UINT32_MAX) { PERR(DLU_VKCOMP_DEVICE_NOT_ASSOC, 0, "dlu_create_desc_pool(3)"); return res; }
 
-  res = vkCreateDescriptorSetLayout(app->ld_data[app->desc_data[cur_dd].ldi].device, desc_set_info, NULL, &app->desc_data[cur_dd].layouts[cur_dl]);
-  if (res) PERR(DLU_VK_FUNC_ERR, res, "vkCreateDescriptorSetLayout")
+  res = dlu_cache_desc_set_layout(app, app->desc_data[cur_dd].ldi, desc_set_info, &app->desc_data[cur_dd].layouts[cur_dl]);
+
+  return res;
+}
+
+VkResult dlu_create_desc_template(
+  vkcomp *app,
+  uint32_t cur_dd,
+  uint32_t cur_dl,
+  uint32_t descriptorUpdateEntryCount,
+  const VkDescriptorUpdateTemplateEntryKHR *pDescriptorUpdateEntries,
+  VkDescriptorUpdateTemplateTypeKHR templateType,
+  VkPipelineBindPoint pipelineBindPoint,
+  uint32_t cur_gpd,
+  uint32_t set
+) {
+  VkResult res = VK_RESULT_MAX_ENUM;
+
+  if (!app->desc_data[cur_dd].templates) { PERR(DLU_BUFF_NOT_ALLOC, 0, "DLU_DESC_DATA_MEMS"); return res; }
+  if (app->desc_data[cur_dd].ldi == UINT32_MAX) { PERR(DLU_VKCOMP_DEVICE_NOT_ASSOC, 0, "dlu_create_desc_pool(3)"); return res; }
+  if (!app->desc_data[cur_dd].layouts[cur_dl]) { dlu_log_me(DLU_DANGER, "[x] Descriptor set layout must be created first"); return res; }
+
+  struct _ld_data *ld = &app->ld_data[app->desc_data[cur_dd].ldi];
+  if (!ld->create_desc_template) {
+    if (templateType == VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR) {
+      dlu_log_me(DLU_DANGER, "[x] %s not enabled on this device", VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME);
+      return res;
+    }
+
+    /* Keep the entries so dlu_update_desc_template() can expand them into vkUpdateDescriptorSets */
+    struct _desc_tmpl *tmpl = &app->desc_data[cur_dd].tmpl_entries[cur_dl];
+    VkDescriptorUpdateTemplateEntryKHR *entries = calloc(descriptorUpdateEntryCount, sizeof(VkDescriptorUpdateTemplateEntryKHR));
+    if (!entries) { dlu_log_me(DLU_DANGER, "[x] calloc: %s", strerror(errno)); return res; }
+    memcpy(entries, pDescriptorUpdateEntries, descriptorUpdateEntryCount * sizeof(VkDescriptorUpdateTemplateEntryKHR));
+
+    free(tmpl->entries);
+    tmpl->entries = entries;
+    tmpl->cnt = descriptorUpdateEntryCount;
+
+    dlu_log_once(DLU_WARNING, "[!] %s not enabled, templates fall back to vkUpdateDescriptorSets", VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME);
+    return VK_SUCCESS;
+  }
+
+  /* Push descriptor templates are resolved against a pipeline layout rather than a set */
+  if (templateType == VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR && !app->gp_data[cur_gpd].pipeline_layout) {
+    dlu_log_me(DLU_DANGER, "[x] Push descriptor templates need a pipeline layout, call dlu_create_pipeline_layout() first");
+    return res;
+  }
+
+  VkDescriptorUpdateTemplateCreateInfoKHR create_info = {};
+  create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO_KHR;
+  create_info.pNext = NULL;
+  create_info.flags = 0;
+  create_info.descriptorUpdateEntryCount = descriptorUpdateEntryCount;
+  create_info.pDescriptorUpdateEntries = pDescriptorUpdateEntries;
+  create_info.templateType = templateType;
+  create_info.descriptorSetLayout = app->desc_data[cur_dd].layouts[cur_dl];
+  create_info.pipelineBindPoint = pipelineBindPoint;
+  create_info.pipelineLayout = (templateType == VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR) ? app->gp_data[cur_gpd].pipeline_layout : VK_NULL_HANDLE;
+  create_info.set = set;
+
+  res = ld->create_desc_template(ld->device, &create_info, NULL, &app->desc_data[cur_dd].templates[cur_dl]);
+  if (res) PERR(DLU_VK_FUNC_ERR, res, "vkCreateDescriptorUpdateTemplateKHR")
 
   return res;
 }
@@ -889,8 +1407,8 @@ VkResult dlu_create_texture_sampler(vkcomp *app, uint32_t cur_tex, VkSamplerCrea
 
   if (!app->text_data) { PERR(DLU_BUFF_NOT_ALLOC, 0, "DLU_TEXT_DATA"); return res; }
 
-  res = vkCreateSampler(app->ld_data[app->text_data[cur_tex].ldi].device, sample_info, NULL, &app->text_data[cur_tex].sampler);
-  if (res) PERR(DLU_VK_FUNC_ERR, res, "vkCreateSampler")
+  /* Most textures share a handful of sampler states */
+  res = dlu_cache_sampler(app, app->text_data[cur_tex].ldi, sample_info, &app->text_data[cur_tex].sampler);
 
   return res;
 }
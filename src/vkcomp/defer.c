@@ -0,0 +1,148 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright (c) 2019-2020 Vincent Davis Jr.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*/
+
+#define LUCUR_VKCOMP_API
+#include <lucom.h>
+
+/* Frames are retired in order, a newer frame being done means older ones are too */
+static void retire_frame(struct _deferred *def, uint64_t frame) {
+  if (frame + 1 > def->completed) def->completed = frame + 1;
+}
+
+VkResult dlu_defer_destroy(dlu_destroy_type type, vkcomp *app, uint32_t cur_ld, void *data) {
+  VkResult res = VK_RESULT_MAX_ENUM;
+  struct _deferred *def = NULL;
+
+  if (!app->ld_data) { PERR(DLU_BUFF_NOT_ALLOC, 0, "DLU_LD_DATA"); return res; }
+  if (!app->ld_data[cur_ld].device) { PERR(DLU_VKCOMP_DEVICE, 0, NULL); return res; }
+  if (type == DLU_DESTROY_VK_LOGIC_DEVICE) { PERR(DLU_OP_NOT_PERMITED, 0, NULL); return res; }
+  if (!data) return VK_SUCCESS;
+
+  def = &app->ld_data[cur_ld].deferred;
+
+  if (def->objc == def->cap) {
+    uint32_t cap = (def->cap) ? def->cap * 2 : 64;
+    struct _deferred_obj *objs = realloc(def->objs, cap * sizeof(struct _deferred_obj));
+    if (!objs) { dlu_log_me(DLU_DANGER, "[x] realloc: %s", strerror(errno)); return res; }
+    def->objs = objs;
+    def->cap = cap;
+  }
+
+  def->objs[def->objc].type = type;
+  def->objs[def->objc].data = data;
+  def->objs[def->objc].frame = def->frame;
+  def->objc++;
+
+  return VK_SUCCESS;
+}
+
+uint64_t dlu_defer_frame(vkcomp *app, uint32_t cur_ld) {
+  return app->ld_data[cur_ld].deferred.frame;
+}
+
+void dlu_defer_end_frame(vkcomp *app, uint32_t cur_ld, VkFence fence) {
+  struct _deferred *def = &app->ld_data[cur_ld].deferred;
+  uint32_t j = 0;
+
+  if (fence) {
+    /**
+    * A fence seen again was waited on before being reset, what it covered is done.
+    * The frame's compute work may still be running, then a later frame retires it
+    */
+    for (uint32_t i = 0; i < def->fc; i++) {
+      if (def->inflight[i].fence != fence) { def->inflight[j++] = def->inflight[i]; continue; }
+      if (!def->inflight[i].compute || DLU_VK(app, cur_ld).GetFenceStatus(app->ld_data[cur_ld].device, def->inflight[i].compute) == VK_SUCCESS)
+        retire_frame(def, def->inflight[i].frame);
+    }
+    def->fc = j;
+
+    /* Out of slots, forget the oldest. A later frame retiring covers it anyway */
+    if (def->fc == DLU_DEFER_FRAMES) {
+      memmove(def->inflight, def->inflight + 1, (DLU_DEFER_FRAMES - 1) * sizeof(struct _deferred_frame));
+      def->fc--;
+    }
+
+    def->inflight[def->fc].fence = fence;
+    def->inflight[def->fc].compute = def->compute;
+    def->inflight[def->fc].frame = def->frame;
+    def->fc++;
+  }
+
+  def->compute = VK_NULL_HANDLE;
+
+  def->frame++;
+  dlu_defer_collect(app, cur_ld);
+}
+
+void dlu_defer_compute_fence(vkcomp *app, uint32_t cur_ld, VkFence fence) {
+  /* Fences signal in submission order on a queue, the last one covers the rest */
+  if (fence) app->ld_data[cur_ld].deferred.compute = fence;
+}
+
+void dlu_defer_complete(vkcomp *app, uint32_t cur_ld, uint64_t frame) {
+  struct _deferred *def = &app->ld_data[cur_ld].deferred;
+
+  if (frame == UINT64_MAX) def->completed = UINT64_MAX;
+  else retire_frame(def, frame);
+
+  dlu_defer_collect(app, cur_ld);
+}
+
+void dlu_defer_collect(vkcomp *app, uint32_t cur_ld) {
+  struct _deferred *def = &app->ld_data[cur_ld].deferred;
+  VkDevice device = app->ld_data[cur_ld].device;
+  uint32_t j = 0;
+
+  /* inflight[] is oldest first, stop at the first frame still running */
+  for (j = 0; j < def->fc; j++) {
+    if (def->inflight[j].frame < def->completed) continue;
+    if (DLU_VK(app, cur_ld).GetFenceStatus(device, def->inflight[j].fence) != VK_SUCCESS) break;
+    if (def->inflight[j].compute && DLU_VK(app, cur_ld).GetFenceStatus(device, def->inflight[j].compute) != VK_SUCCESS) break;
+    retire_frame(def, def->inflight[j].frame);
+  }
+
+  if (j) {
+    memmove(def->inflight, def->inflight + j, (def->fc - j) * sizeof(struct _deferred_frame));
+    def->fc -= j;
+  }
+
+  /* Destroy in request order, keep the rest packed */
+  j = 0;
+  for (uint32_t i = 0; i < def->objc; i++) {
+    if (def->objs[i].frame < def->completed) dlu_vk_destroy(def->objs[i].type, app, cur_ld, def->objs[i].data);
+    else def->objs[j++] = def->objs[i];
+  }
+  def->objc = j;
+}
+
+void dlu_freeup_deferred(vkcomp *app, uint32_t cur_ld) {
+  struct _deferred *def = &app->ld_data[cur_ld].deferred;
+
+  for (uint32_t i = 0; i < def->objc; i++)
+    dlu_vk_destroy(def->objs[i].type, app, cur_ld, def->objs[i].data);
+
+  free(def->objs);
+  def->objs = NULL;
+  def->objc = def->cap = def->fc = 0;
+}
@@ -0,0 +1,247 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright (c) 2019-2020 Vincent Davis Jr.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*/
+
+#define LUCUR_VKCOMP_API
+#include <lucom.h>
+
+VkResult dlu_create_desc_allocator(vkcomp *app, uint32_t cur_ld, uint32_t frame_count, uint32_t sets_per_pool) {
+  VkResult res = VK_RESULT_MAX_ENUM;
+
+  if (!app->ld_data[cur_ld].device) { PERR(DLU_VKCOMP_DEVICE, 0, NULL); return res; }
+
+  if (app->desc_alloc.fc) {
+    dlu_log_me(DLU_WARNING, "Descriptor allocator already created");
+    return VK_SUCCESS;
+  }
+
+  if (!frame_count || !sets_per_pool) {
+    dlu_log_me(DLU_DANGER, "[x] frame_count and sets_per_pool must be greater than 0");
+    return res;
+  }
+
+  app->desc_alloc.fc = frame_count;
+  app->desc_alloc.sets_per_pool = sets_per_pool;
+  app->desc_alloc.bc = 0;
+  app->desc_alloc.ldi = cur_ld;
+
+  return VK_SUCCESS;
+}
+
+VkResult dlu_create_desc_bucket(
+  vkcomp *app,
+  VkDescriptorSetLayout layout,
+  const VkDescriptorSetLayoutCreateInfo *layout_info,
+  uint32_t *bucket
+) {
+
+  VkResult res = VK_RESULT_MAX_ENUM;
+  struct _desc_bucket *buckets = NULL, *b = NULL;
+
+  if (!app->desc_alloc.fc) { PERR(DLU_VKCOMP_DESC_ALLOC, 0, NULL); return res; }
+
+  if (layout_info->flags & VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR) {
+    dlu_log_me(DLU_DANGER, "[x] Push descriptor set layouts can't be allocated from a pool");
+    return res;
+  }
+
+  for (uint32_t i = 0; i < app->desc_alloc.bc; i++) {
+    if (app->desc_alloc.buckets[i].layout == layout) {
+      *bucket = i;
+      return VK_SUCCESS;
+    }
+  }
+
+  buckets = realloc(app->desc_alloc.buckets, (app->desc_alloc.bc + 1) * sizeof(struct _desc_bucket));
+  if (!buckets) {
+    dlu_log_me(DLU_DANGER, "[x] realloc: %s", strerror(errno));
+    return res;
+  }
+
+  app->desc_alloc.buckets = buckets;
+  b = &app->desc_alloc.buckets[app->desc_alloc.bc];
+  memset(b, 0, sizeof(struct _desc_bucket));
+
+  /* Size each pool after the layout, one entry per descriptor type used */
+  b->pool_sizes = calloc(layout_info->bindingCount + 1, sizeof(VkDescriptorPoolSize));
+  b->chains = calloc(app->desc_alloc.fc, sizeof(struct _desc_chain));
+  if (!b->pool_sizes || !b->chains) {
+    dlu_log_me(DLU_DANGER, "[x] calloc: %s", strerror(errno));
+    free(b->pool_sizes); free(b->chains);
+    return res;
+  }
+
+  for (uint32_t i = 0; i < layout_info->bindingCount; i++) {
+    const VkDescriptorSetLayoutBinding *binding = &layout_info->pBindings[i];
+    uint32_t j = 0;
+
+    if (!binding->descriptorCount) continue;
+
+    for (; j < b->psize; j++)
+      if (b->pool_sizes[j].type == binding->descriptorType) break;
+
+    if (j == b->psize) {
+      b->pool_sizes[j].type = binding->descriptorType;
+      b->psize++;
+    }
+
+    b->pool_sizes[j].descriptorCount += binding->descriptorCount * app->desc_alloc.sets_per_pool;
+  }
+
+  /* Vulkan requires at least one pool size, layouts with no bindings still allocate sets */
+  if (!b->psize) {
+    b->pool_sizes[0].type = VK_DESCRIPTOR_TYPE_SAMPLER;
+    b->pool_sizes[0].descriptorCount = 1;
+    b->psize = 1;
+  }
+
+  if (layout_info->flags & VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT)
+    b->flags |= VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+
+  b->layout = layout;
+  *bucket = app->desc_alloc.bc++;
+
+  return VK_SUCCESS;
+}
+
+/* Chain a new pool onto the end of chain */
+static VkResult desc_chain_grow(vkcomp *app, struct _desc_bucket *b, struct _desc_chain *chain) {
+  VkResult res = VK_RESULT_MAX_ENUM;
+  VkDescriptorPool pool = VK_NULL_HANDLE, *pools = NULL;
+
+  VkDescriptorPoolCreateInfo create_info = {};
+  create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  create_info.pNext = NULL;
+  create_info.flags = b->flags;
+  create_info.maxSets = app->desc_alloc.sets_per_pool;
+  create_info.poolSizeCount = b->psize;
+  create_info.pPoolSizes = b->pool_sizes;
+
+  res = vkCreateDescriptorPool(app->ld_data[app->desc_alloc.ldi].device, &create_info, NULL, &pool);
+  if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkCreateDescriptorPool"); return res; }
+
+  pools = realloc(chain->pools, (chain->pc + 1) * sizeof(VkDescriptorPool));
+  if (!pools) {
+    dlu_log_me(DLU_DANGER, "[x] realloc: %s", strerror(errno));
+    vkDestroyDescriptorPool(app->ld_data[app->desc_alloc.ldi].device, pool, NULL);
+    return VK_RESULT_MAX_ENUM;
+  }
+
+  chain->pools = pools;
+  chain->pools[chain->pc++] = pool;
+
+  return res;
+}
+
+VkResult dlu_alloc_desc_set(vkcomp *app, uint32_t bucket, uint32_t frame, VkDescriptorSet *set) {
+  VkResult res = VK_RESULT_MAX_ENUM;
+  struct _desc_bucket *b = NULL;
+  struct _desc_chain *chain = NULL;
+
+  if (!app->desc_alloc.fc) { PERR(DLU_VKCOMP_DESC_ALLOC, 0, NULL); return res; }
+
+  if (bucket >= app->desc_alloc.bc || frame >= app->desc_alloc.fc) {
+    dlu_log_me(DLU_DANGER, "[x] Descriptor bucket %u or frame %u out of range", bucket, frame);
+    return res;
+  }
+
+  b = &app->desc_alloc.buckets[bucket];
+  chain = &b->chains[frame];
+
+  VkDescriptorSetAllocateInfo alloc_info = {};
+  alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  alloc_info.pNext = NULL;
+  alloc_info.descriptorSetCount = 1;
+  alloc_info.pSetLayouts = &b->layout;
+
+  /**
+  * Walk forward through the chain, pools before cur_pool are known to be full.
+  * Only grow once every pool already created for this frame is exhausted
+  */
+  for (;;) {
+    bool grown = false;
+    if (chain->cur_pool == chain->pc) {
+      res = desc_chain_grow(app, b, chain);
+      if (res) return res;
+      grown = true;
+    }
+
+    alloc_info.descriptorPool = chain->pools[chain->cur_pool];
+    res = DLU_VK(app, app->desc_alloc.ldi).AllocateDescriptorSets(app->ld_data[app->desc_alloc.ldi].device, &alloc_info, set);
+    if (res != VK_ERROR_OUT_OF_POOL_MEMORY && res != VK_ERROR_FRAGMENTED_POOL) break;
+
+    /* A fresh pool that can't fit a single set will never succeed */
+    if (grown) break;
+
+    chain->cur_pool++;
+  }
+
+  if (res) PERR(DLU_VK_FUNC_ERR, res, "vkAllocateDescriptorSets")
+
+  return res;
+}
+
+VkResult dlu_reset_desc_frame(vkcomp *app, uint32_t frame) {
+  VkResult res = VK_RESULT_MAX_ENUM;
+
+  if (!app->desc_alloc.fc) { PERR(DLU_VKCOMP_DESC_ALLOC, 0, NULL); return res; }
+
+  if (frame >= app->desc_alloc.fc) {
+    dlu_log_me(DLU_DANGER, "[x] Descriptor frame %u out of range", frame);
+    return res;
+  }
+
+  res = VK_SUCCESS;
+  for (uint32_t i = 0; i < app->desc_alloc.bc; i++) {
+    struct _desc_chain *chain = &app->desc_alloc.buckets[i].chains[frame];
+
+    /* Only pools up to cur_pool were handed sets */
+    for (uint32_t j = 0; j < chain->pc && j <= chain->cur_pool; j++) {
+      res = DLU_VK(app, app->desc_alloc.ldi).ResetDescriptorPool(app->ld_data[app->desc_alloc.ldi].device, chain->pools[j], 0);
+      if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkResetDescriptorPool"); return res; }
+    }
+
+    chain->cur_pool = 0;
+  }
+
+  return res;
+}
+
+void dlu_freeup_desc_allocator(vkcomp *app) {
+  for (uint32_t i = 0; i < app->desc_alloc.bc; i++) {
+    struct _desc_bucket *b = &app->desc_alloc.buckets[i];
+
+    for (uint32_t j = 0; j < app->desc_alloc.fc; j++) {
+      for (uint32_t k = 0; k < b->chains[j].pc; k++)
+        vkDestroyDescriptorPool(app->ld_data[app->desc_alloc.ldi].device, b->chains[j].pools[k], NULL);
+      free(b->chains[j].pools);
+    }
+
+    free(b->chains);
+    free(b->pool_sizes);
+  }
+
+  free(app->desc_alloc.buckets);
+  /* fc included, otherwise recreating the allocator reports it as already created */
+  memset(&app->desc_alloc, 0, sizeof(app->desc_alloc));
+}
@@ -91,7 +91,8 @@ VkSurfaceFormatKHR dlu_choose_swap_surface_format(vkcomp *app, uint32_t cur_pd,
   return ret_fmt;
 }
 
-VkPresentModeKHR dlu_choose_swap_present_mode(vkcomp *app, uint32_t cur_pd) {
+/* Returns the first mode of prefs the surface supports, FIFO being the only one guaranteed */
+static VkPresentModeKHR pick_present_mode(vkcomp *app, uint32_t cur_pd, uint32_t prefc, const VkPresentModeKHR *prefs) {
   VkResult err;
   VkPresentModeKHR best_mode = VK_PRESENT_MODE_MAX_ENUM_KHR;
   VkPresentModeKHR *present_modes = VK_NULL_HANDLE;
@@ -117,19 +118,89 @@ VkPresentModeKHR dlu_choose_swap_present_mode(vkcomp *app, uint32_t cur_pd) {
   /* Only mode that is guaranteed */
   best_mode = VK_PRESENT_MODE_FIFO_KHR;
 
-  for (uint32_t i = 0; i < pres_mode_count; i++) {
-    if (present_modes[i] == VK_PRESENT_MODE_MAILBOX_KHR) { /* For triple buffering */
-      best_mode = present_modes[i];
-      break;
-    }
-    else if (present_modes[i] == VK_PRESENT_MODE_IMMEDIATE_KHR) {
-      best_mode = present_modes[i];
-    }
-  }
+  for (uint32_t i = 0; i < prefc; i++)
+    for (uint32_t j = 0; j < pres_mode_count; j++)
+      if (present_modes[j] == prefs[i])
+        return prefs[i];
 
   return best_mode;
 }
 
+VkPresentModeKHR dlu_choose_swap_present_mode(vkcomp *app, uint32_t cur_pd) {
+  /* MAILBOX for triple buffering */
+  const VkPresentModeKHR prefs[] = { VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR };
+  return pick_present_mode(app, cur_pd, ARR_LEN(prefs), prefs);
+}
+
+VkPresentModeKHR dlu_choose_present_mode(vkcomp *app, uint32_t cur_pd, dlu_present_policy policy) {
+  const VkPresentModeKHR lowest[] = {
+    VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR
+  };
+  const VkPresentModeKHR no_tear[] = { VK_PRESENT_MODE_MAILBOX_KHR };
+
+  switch (policy) {
+    case DLU_PRESENT_LOWEST_LATENCY: return pick_present_mode(app, cur_pd, ARR_LEN(lowest), lowest);
+    case DLU_PRESENT_LOW_LATENCY_NO_TEAR: return pick_present_mode(app, cur_pd, ARR_LEN(no_tear), no_tear);
+    default: return pick_present_mode(app, cur_pd, 0, NULL);
+  }
+}
+
+uint32_t dlu_present_policy_image_count(dlu_present_policy policy, VkPresentModeKHR mode, VkSurfaceCapabilitiesKHR cap) {
+  uint32_t count = cap.minImageCount;
+
+  /**
+  * MAILBOX needs a spare image to replace the queued one without blocking.
+  * Everything else gets by with the minimum, extra images only add queueing.
+  * Power saving trades a frame of latency for never stalling on acquire.
+  */
+  if (mode == VK_PRESENT_MODE_MAILBOX_KHR && count < 3) count = 3;
+  if (policy == DLU_PRESENT_POWER_SAVING) count++;
+  if (count < 2) count = 2;
+
+  if (cap.maxImageCount && count > cap.maxImageCount) count = cap.maxImageCount;
+
+  return count;
+}
+
+void dlu_set_present_policy(vkcomp *app, uint32_t cur_scd, dlu_present_policy policy, uint32_t max_queued) {
+  if (!app->sc_data) { PERR(DLU_BUFF_NOT_ALLOC, 0, "DLU_SC_DATA"); return; }
+
+  if (!max_queued && policy != DLU_PRESENT_POWER_SAVING) max_queued = 1;
+  if (max_queued > DLU_PRESENT_MAX_QUEUED) max_queued = DLU_PRESENT_MAX_QUEUED;
+
+  app->sc_data[cur_scd].max_queued = max_queued;
+}
+
+VkResult dlu_wait_present_latency(vkcomp *app, uint32_t cur_scd, uint64_t timeout) {
+  VkResult res = VK_SUCCESS;
+  struct _sc_data *sc = &app->sc_data[cur_scd];
+  struct _ld_data *ld = &app->ld_data[sc->ldi];
+
+  if (!sc->max_queued) return res;
+
+  DLU_PROF_ZONE(DLU_PROF_PRESENT, "dlu_wait_present_latency");
+
+  /* Wait until the present max_queued frames back is on screen */
+  if (ld->present_wait) {
+    if (sc->present_id < sc->max_queued) return res;
+    res = ld->wait_for_present(ld->device, sc->swap_chain, sc->present_id - sc->max_queued + 1, timeout);
+    if (res == VK_ERROR_OUT_OF_DATE_KHR || res == VK_SUBOPTIMAL_KHR) sc->stale = VK_TRUE;
+    else if (res && res != VK_TIMEOUT) PERR(DLU_VK_FUNC_ERR, res, "vkWaitForPresentKHR")
+    return res;
+  }
+
+  /* No way to see the display, the best bound is the GPU having finished that frame */
+  if (sc->submitted < sc->max_queued) return res;
+
+  VkFence fence = sc->syncs[sc->queued[(sc->submitted - sc->max_queued) % DLU_PRESENT_MAX_QUEUED]].fence.render;
+  if (ld->vk.GetFenceStatus(ld->device, fence) == VK_SUCCESS) return res;
+
+  res = ld->vk.WaitForFences(ld->device, 1, &fence, VK_TRUE, timeout);
+  if (res && res != VK_TIMEOUT) PERR(DLU_VK_FUNC_ERR, res, "vkWaitForFences")
+
+  return res;
+}
+
 /**
 * If the width retrieved from making a call to dlu_get_physical_device_surface_capabilities()
 * doesn't equal -1 then leave VkExtent2D struct in VkSurfaceCapabilitiesKHR struct the same
@@ -153,10 +224,15 @@ VkResult dlu_acquire_sc_image_index(vkcomp *app, uint32_t cur_scd, uint32_t cur_
 
   if (!app->sc_data[cur_scd].syncs) { PERR(DLU_VKCOMP_SC_SYNCS, 0, NULL); return res; }
 
+  DLU_PROF_ZONE(DLU_PROF_ACQUIRE, "vkAcquireNextImageKHR");
+
   /* Signal image semaphore */
-  res = vkAcquireNextImageKHR(app->ld_data[app->sc_data[cur_scd].ldi].device, app->sc_data[cur_scd].swap_chain,
-                              GENERAL_TIMEOUT, app->sc_data[cur_scd].syncs[cur_sync].sem.image, VK_NULL_HANDLE, cur_img);
-  if (res) PERR(DLU_VK_FUNC_ERR, res, "vkAcquireNextImageKHR")
+  res = DLU_SC_VK(app, cur_scd).AcquireNextImageKHR(app->ld_data[app->sc_data[cur_scd].ldi].device, app->sc_data[cur_scd].swap_chain,
+                                                   GENERAL_TIMEOUT, app->sc_data[cur_scd].syncs[cur_sync].sem.image, VK_NULL_HANDLE, cur_img);
+
+  /* Not errors, the surface changed. Caller should dlu_recreate_swap_chain() */
+  if (res == VK_ERROR_OUT_OF_DATE_KHR || res == VK_SUBOPTIMAL_KHR) app->sc_data[cur_scd].stale = VK_TRUE;
+  else if (res) PERR(DLU_VK_FUNC_ERR, res, "vkAcquireNextImageKHR")
 
   return res;
 }
@@ -176,6 +252,8 @@ VkResult dlu_queue_graphics_queue(
 
   VkResult res = VK_RESULT_MAX_ENUM;
 
+  DLU_PROF_ZONE(DLU_PROF_SUBMIT, "vkQueueSubmit");
+
   VkSubmitInfo submit_info = {};
   submit_info.pNext = NULL;
   submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -191,8 +269,53 @@ VkResult dlu_queue_graphics_queue(
   * Fence will be in signaled state when the command buffers finish execution
   * VkFence render: Used to signal that a frame has finished rendering
   */
-  res = vkQueueSubmit(app->ld_data[app->sc_data[cur_scd].ldi].graphics, 1, &submit_info, app->sc_data[cur_scd].syncs[synci].fence.render);
-  if (res) PERR(DLU_VK_FUNC_ERR, res, "vkQueueSubmit")
+  res = DLU_SC_VK(app, cur_scd).QueueSubmit(app->ld_data[app->sc_data[cur_scd].ldi].graphics, 1, &submit_info, app->sc_data[cur_scd].syncs[synci].fence.render);
+  if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkQueueSubmit"); return res; }
+
+  /* Remembered for dlu_wait_present_latency() */
+  app->sc_data[cur_scd].queued[app->sc_data[cur_scd].submitted++ % DLU_PRESENT_MAX_QUEUED] = synci;
+
+  /* Objects handed to dlu_defer_destroy() so far go once this fence signals */
+  dlu_defer_end_frame(app, app->sc_data[cur_scd].ldi, app->sc_data[cur_scd].syncs[synci].fence.render);
+
+  return res;
+}
+
+VkResult dlu_queue_compute_queue(
+  vkcomp *app,
+  uint32_t cur_scd,
+  uint32_t synci,
+  uint32_t commandBufferCount,
+  VkCommandBuffer *pCommandBuffers,
+  uint32_t waitSemaphoreCount,
+  const VkSemaphore *pWaitSemaphores,
+  const VkPipelineStageFlags *pWaitDstStageMask,
+  VkFence fence
+) {
+
+  VkResult res = VK_RESULT_MAX_ENUM;
+
+  if (!app->ld_data[app->sc_data[cur_scd].ldi].compute) { PERR(DLU_OP_NOT_PERMITED, 0, NULL); return res; }
+  if (!app->sc_data[cur_scd].syncs) { PERR(DLU_VKCOMP_SC_SYNCS, 0, NULL); return res; }
+
+  DLU_PROF_ZONE(DLU_PROF_SUBMIT, "vkQueueSubmit(compute)");
+
+  VkSubmitInfo submit_info = {};
+  submit_info.pNext = NULL;
+  submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submit_info.waitSemaphoreCount = waitSemaphoreCount;
+  submit_info.pWaitSemaphores = pWaitSemaphores;
+  submit_info.pWaitDstStageMask = pWaitDstStageMask;
+  submit_info.commandBufferCount = commandBufferCount;
+  submit_info.pCommandBuffers = pCommandBuffers;
+  submit_info.signalSemaphoreCount = 1;
+  submit_info.pSignalSemaphores = &app->sc_data[cur_scd].syncs[synci].sem.compute;
+
+  res = DLU_SC_VK(app, cur_scd).QueueSubmit(app->ld_data[app->sc_data[cur_scd].ldi].compute, 1, &submit_info, fence);
+  if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkQueueSubmit"); return res; }
+
+  /* Objects deferred this frame must outlive the compute work too, the next graphics submit ends the frame */
+  dlu_defer_compute_fence(app, app->sc_data[cur_scd].ldi, fence);
 
   return res;
 }
@@ -210,6 +333,8 @@ VkResult dlu_queue_present_queue(
 
   VkResult res = VK_RESULT_MAX_ENUM;
 
+  DLU_PROF_ZONE(DLU_PROF_PRESENT, "vkQueuePresentKHR");
+
   VkPresentInfoKHR present;
   present.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
   present.pNext = NULL;
@@ -220,8 +345,36 @@ VkResult dlu_queue_present_queue(
   present.pImageIndices = pImageIndices;
   present.pResults = pResults;
 
-  res = vkQueuePresentKHR(app->ld_data[cur_ld].graphics, &present);
-  if (res) PERR(DLU_VK_FUNC_ERR, res, "vkQueuePresentKHR")
+  /* Tag every present so dlu_wait_present_latency() can wait for it to reach the display */
+  VkPresentIdKHR present_ids;
+  uint64_t *ids = NULL;
+  if (app->ld_data[cur_ld].present_wait) {
+    ids = alloca(swapchainCount * sizeof(uint64_t));
+    for (uint32_t j = 0; j < swapchainCount; j++) {
+      ids[j] = 0;
+      for (uint32_t i = 0; i < app->sdc; i++)
+        if (app->sc_data[i].swap_chain == pSwapchains[j])
+          ids[j] = ++app->sc_data[i].present_id;
+    }
+
+    present_ids.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+    present_ids.pNext = NULL;
+    present_ids.swapchainCount = swapchainCount;
+    present_ids.pPresentIds = ids;
+    present.pNext = &present_ids;
+  }
+
+  res = DLU_VK(app, cur_ld).QueuePresentKHR(app->ld_data[cur_ld].graphics, &present);
+
+  /* Flag the swapchains involved, so the caller knows which ones to dlu_recreate_swap_chain() */
+  if (res == VK_ERROR_OUT_OF_DATE_KHR || res == VK_SUBOPTIMAL_KHR) {
+    for (uint32_t i = 0; i < app->sdc; i++)
+      for (uint32_t j = 0; j < swapchainCount; j++)
+        if (app->sc_data[i].swap_chain == pSwapchains[j])
+          app->sc_data[i].stale = VK_TRUE;
+  } else if (res) {
+    PERR(DLU_VK_FUNC_ERR, res, "vkQueuePresentKHR")
+  }
 
   return res;
 }
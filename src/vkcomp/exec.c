@@ -68,10 +68,10 @@ VkResult dlu_exec_end_single_time_cmd_buff(vkcomp *app, uint32_t cur_pool, VkCom
   submit_info.commandBufferCount = 1;
   submit_info.pCommandBuffers = cmd_buff;
 
-  res = vkQueueSubmit(app->ld_data[app->cmd_data[cur_pool].ldi].graphics, 1, &submit_info, VK_NULL_HANDLE);
+  res = DLU_CMD_VK(app, cur_pool).QueueSubmit(app->ld_data[app->cmd_data[cur_pool].ldi].graphics, 1, &submit_info, VK_NULL_HANDLE);
   if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkQueueSubmit"); goto finish_estcb; }
 
-  res = vkQueueWaitIdle(app->ld_data[app->cmd_data[cur_pool].ldi].graphics);
+  res = DLU_CMD_VK(app, cur_pool).QueueWaitIdle(app->ld_data[app->cmd_data[cur_pool].ldi].graphics);
   if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkQueueWaitIdle"); goto finish_estcb; }
 
 finish_estcb:
@@ -95,7 +95,7 @@ void dlu_exec_copy_buffer(
   copy_region.dstOffset = dstOffset;
   copy_region.size = size;
 
-  vkCmdCopyBuffer(cmd_buff, app->buff_data[src_bd].buff, app->buff_data[dst_bd].buff, 1, &copy_region);
+  DLU_VK(app, app->buff_data[src_bd].ldi).CmdCopyBuffer(cmd_buff, app->buff_data[src_bd].buff, app->buff_data[dst_bd].buff, 1, &copy_region);
 }
 
 void dlu_exec_copy_buff_to_image(
@@ -108,8 +108,8 @@ void dlu_exec_copy_buff_to_image(
   VkCommandBuffer cmd_buff
 ) {
 
-  vkCmdCopyBufferToImage(cmd_buff, app->buff_data[cur_bd].buff, app->text_data[cur_tex].image,
-                        dstImageLayout, regionCount, pRegions);
+  DLU_VK(app, app->buff_data[cur_bd].ldi).CmdCopyBufferToImage(cmd_buff, app->buff_data[cur_bd].buff, app->text_data[cur_tex].image,
+                                                              dstImageLayout, regionCount, pRegions);
 }
 
 void dlu_exec_pipeline_barrier(
@@ -129,6 +129,51 @@ void dlu_exec_pipeline_barrier(
                        bufferMemoryBarrierCount, pBufferMemoryBarriers, imageMemoryBarrierCount, pImageMemoryBarriers);
 }
 
+void dlu_exec_cmd_pipeline_barrier(
+  vkcomp *app,
+  uint32_t cur_pool,
+  VkPipelineStageFlags srcStageMask,
+  VkPipelineStageFlags dstStageMask,
+  VkDependencyFlags dependencyFlags,
+  uint32_t memoryBarrierCount,
+  const VkMemoryBarrier *pMemoryBarriers,
+  uint32_t bufferMemoryBarrierCount,
+  const VkBufferMemoryBarrier *pBufferMemoryBarriers,
+  uint32_t imageMemoryBarrierCount,
+  const VkImageMemoryBarrier *pImageMemoryBarriers,
+  VkCommandBuffer cmd_buff
+) {
+
+  DLU_CMD_VK(app, cur_pool).CmdPipelineBarrier(cmd_buff, srcStageMask, dstStageMask, dependencyFlags, memoryBarrierCount, pMemoryBarriers,
+                                               bufferMemoryBarrierCount, pBufferMemoryBarriers, imageMemoryBarrierCount, pImageMemoryBarriers);
+}
+
+void dlu_exec_buffer_ownership_barrier(
+  vkcomp *app,
+  uint32_t cur_bd,
+  uint32_t srcQueueFamilyIndex,
+  uint32_t dstQueueFamilyIndex,
+  VkPipelineStageFlags srcStageMask,
+  VkPipelineStageFlags dstStageMask,
+  VkAccessFlags srcAccessMask,
+  VkAccessFlags dstAccessMask,
+  VkCommandBuffer cmd_buff
+) {
+
+  VkBufferMemoryBarrier barrier = {};
+  barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+  barrier.pNext = NULL;
+  barrier.srcAccessMask = srcAccessMask;
+  barrier.dstAccessMask = dstAccessMask;
+  barrier.srcQueueFamilyIndex = srcQueueFamilyIndex;
+  barrier.dstQueueFamilyIndex = dstQueueFamilyIndex;
+  barrier.buffer = app->buff_data[cur_bd].buff;
+  barrier.offset = 0;
+  barrier.size = VK_WHOLE_SIZE;
+
+  DLU_VK(app, app->buff_data[cur_bd].ldi).CmdPipelineBarrier(cmd_buff, srcStageMask, dstStageMask, 0, 0, NULL, 1, &barrier, 0, NULL);
+}
+
 void dlu_exec_begin_render_pass(
   vkcomp *app,
   uint32_t cur_pool,
@@ -159,13 +204,13 @@ void dlu_exec_begin_render_pass(
   for (uint32_t i = 0; i < app->sc_data[cur_scd].sic; i++) {
     render_pass_info.framebuffer = app->sc_data[cur_scd].sc_buffs[i].fb;
     /* Instert render pass into command buffer */
-    vkCmdBeginRenderPass(app->cmd_data[cur_pool].cmd_buffs[i], &render_pass_info, contents);
+    DLU_CMD_VK(app, cur_pool).CmdBeginRenderPass(app->cmd_data[cur_pool].cmd_buffs[i], &render_pass_info, contents);
   }
 }
 
 void dlu_exec_stop_render_pass(vkcomp *app, uint32_t cur_pool, uint32_t cur_scd) {
   for (uint32_t i = 0; i < app->sc_data[cur_scd].sic; i++)
-    vkCmdEndRenderPass(app->cmd_data[cur_pool].cmd_buffs[i]);
+    DLU_CMD_VK(app, cur_pool).CmdEndRenderPass(app->cmd_data[cur_pool].cmd_buffs[i]);
 }
 
 VkResult dlu_exec_begin_cmd_buffs(
@@ -180,6 +225,9 @@ VkResult dlu_exec_begin_cmd_buffs(
 
   if (!app->cmd_data[cur_pool].cmd_buffs) { PERR(DLU_VKCOMP_CMD_BUFFS, 0, NULL); return res; }
 
+  /* Recording phase lasts until dlu_exec_stop_cmd_buffs() */
+  dlu_prof_mark_begin(DLU_PROF_RECORD);
+
   VkCommandBufferBeginInfo begin_info = {};
   begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
   begin_info.pNext = NULL;
@@ -187,7 +235,7 @@ VkResult dlu_exec_begin_cmd_buffs(
   begin_info.pInheritanceInfo = pInheritanceInfo;
 
   for (uint32_t i = 0; i < app->sc_data[cur_scd].sic; i++) {
-    res = vkBeginCommandBuffer(app->cmd_data[cur_pool].cmd_buffs[i], &begin_info);
+    res = DLU_CMD_VK(app, cur_pool).BeginCommandBuffer(app->cmd_data[cur_pool].cmd_buffs[i], &begin_info);
     if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkBeginCommandBuffer"); return res; }
   }
 
@@ -200,13 +248,38 @@ VkResult dlu_exec_stop_cmd_buffs(vkcomp *app, uint32_t cur_pool, uint32_t cur_sc
   if (!app->cmd_data[cur_pool].cmd_buffs) { PERR(DLU_VKCOMP_CMD_BUFFS, 0, NULL); return res; }
 
   for (uint32_t i = 0; i < app->sc_data[cur_scd].sic; i++) {
-    res = vkEndCommandBuffer(app->cmd_data[cur_pool].cmd_buffs[i]);
+    res = DLU_CMD_VK(app, cur_pool).EndCommandBuffer(app->cmd_data[cur_pool].cmd_buffs[i]);
     if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkEndCommandBuffer"); return res; }
   }
 
+  dlu_prof_mark_end(DLU_PROF_RECORD, "record");
+
   return res;
 }
 
+void dlu_exec_cmd_dispatch(
+  vkcomp *app,
+  uint32_t cur_pool,
+  uint32_t cur_buff,
+  uint32_t groupCountX,
+  uint32_t groupCountY,
+  uint32_t groupCountZ
+) {
+
+  DLU_CMD_VK(app, cur_pool).CmdDispatch(app->cmd_data[cur_pool].cmd_buffs[cur_buff], groupCountX, groupCountY, groupCountZ);
+}
+
+void dlu_exec_cmd_dispatch_indirect(
+  vkcomp *app,
+  uint32_t cur_pool,
+  uint32_t cur_buff,
+  uint32_t cur_bd,
+  VkDeviceSize offset
+) {
+
+  DLU_CMD_VK(app, cur_pool).CmdDispatchIndirect(app->cmd_data[cur_pool].cmd_buffs[cur_buff], app->buff_data[cur_bd].buff, offset);
+}
+
 void dlu_exec_cmd_draw(
   vkcomp *app,
   uint32_t cur_pool,
@@ -217,7 +290,7 @@ void dlu_exec_cmd_draw(
   uint32_t firstInstance
 ) {
 
-  vkCmdDraw(app->cmd_data[cur_pool].cmd_buffs[cur_buff], vertexCount, instanceCount, firstVertex, firstInstance);
+  DLU_CMD_VK(app, cur_pool).CmdDraw(app->cmd_data[cur_pool].cmd_buffs[cur_buff], vertexCount, instanceCount, firstVertex, firstInstance);
 }
 
 void dlu_exec_cmd_draw_indexed(
@@ -231,7 +304,7 @@ void dlu_exec_cmd_draw_indexed(
   uint32_t firstInstance
 ) {
 
-  vkCmdDrawIndexed(app->cmd_data[cur_pool].cmd_buffs[cur_buff], indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+  DLU_CMD_VK(app, cur_pool).CmdDrawIndexed(app->cmd_data[cur_pool].cmd_buffs[cur_buff], indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
 }
 
 void dlu_exec_cmd_set_viewport(
@@ -243,7 +316,7 @@ void dlu_exec_cmd_set_viewport(
   uint32_t viewportCount
 ) {
 
-  vkCmdSetViewport(app->cmd_data[cur_pool].cmd_buffs[cur_buff], firstViewport, viewportCount, viewport);
+  DLU_CMD_VK(app, cur_pool).CmdSetViewport(app->cmd_data[cur_pool].cmd_buffs[cur_buff], firstViewport, viewportCount, viewport);
 }
 
 void dlu_exec_cmd_set_scissor(
@@ -255,5 +328,5 @@ void dlu_exec_cmd_set_scissor(
   uint32_t scissorCount
 ) {
 
-  vkCmdSetScissor(app->cmd_data[cur_pool].cmd_buffs[cur_buff], firstScissor, scissorCount, scissor);
+  DLU_CMD_VK(app, cur_pool).CmdSetScissor(app->cmd_data[cur_pool].cmd_buffs[cur_buff], firstScissor, scissorCount, scissor);
 }
@@ -0,0 +1,180 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright (c) 2019-2020 Vincent Davis Jr.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*/
+
+#define LUCUR_VKCOMP_API
+#include <lucom.h>
+
+VkResult dlu_frame_ctx_init(vkcomp *app, dlu_frame_ctx *ctx, uint32_t cur_scd, uint32_t cur_pool) {
+  VkResult res = VK_RESULT_MAX_ENUM;
+
+  if (!app->sc_data[cur_scd].swap_chain) { PERR(DLU_VKCOMP_SC, 0, NULL); return res; }
+  if (!app->sc_data[cur_scd].syncs) { PERR(DLU_VKCOMP_SC_SYNCS, 0, NULL); return res; }
+  if (!app->cmd_data[cur_pool].cmd_buffs) { PERR(DLU_VKCOMP_CMD_BUFFS, 0, NULL); return res; }
+  if (app->sc_data[cur_scd].ldi != app->cmd_data[cur_pool].ldi) {
+    PERR(DLU_VKCOMP_DEVICE_NOT_ASSOC, 0, "dlu_create_cmd_pool()"); return res;
+  }
+
+  struct _ld_data *ld = &app->ld_data[app->sc_data[cur_scd].ldi];
+
+  memset(ctx, 0, sizeof(dlu_frame_ctx));
+  ctx->device = ld->device;
+  ctx->graphics = ld->graphics;
+  ctx->swap_chain = app->sc_data[cur_scd].swap_chain;
+  ctx->AcquireNextImageKHR = ld->vk.AcquireNextImageKHR;
+  ctx->QueueSubmit = ld->vk.QueueSubmit;
+  ctx->QueuePresentKHR = ld->vk.QueuePresentKHR;
+  ctx->WaitForFences = ld->vk.WaitForFences;
+  ctx->ResetFences = ld->vk.ResetFences;
+  ctx->syncs = app->sc_data[cur_scd].syncs;
+  ctx->cmd_buffs = app->cmd_data[cur_pool].cmd_buffs;
+  ctx->sc = &app->sc_data[cur_scd];
+  ctx->present_wait = ld->present_wait;
+  ctx->max_queued = app->sc_data[cur_scd].max_queued;
+  ctx->ldi = app->sc_data[cur_scd].ldi;
+  ctx->GetFenceStatus = ld->vk.GetFenceStatus;
+  ctx->WaitForPresentKHR = ld->wait_for_present;
+  ctx->app = app;
+
+  dlu_frame_next(ctx, 0, 0);
+
+  return VK_SUCCESS;
+}
+
+void dlu_frame_next(dlu_frame_ctx *ctx, uint32_t cur_buff, uint32_t synci) {
+  ctx->cmd_buff = ctx->cmd_buffs[cur_buff];
+  ctx->image = ctx->syncs[synci].sem.image;
+  ctx->render = ctx->syncs[synci].sem.render;
+  ctx->fence = ctx->syncs[synci].fence.render;
+  ctx->synci = synci;
+}
+
+VkResult dlu_frame_wait(dlu_frame_ctx *ctx, uint64_t timeout) {
+  VkResult res = ctx->WaitForFences(ctx->device, 1, &ctx->fence, VK_TRUE, timeout);
+  if (res && res != VK_TIMEOUT) PERR(DLU_VK_FUNC_ERR, res, "vkWaitForFences")
+  return res;
+}
+
+VkResult dlu_frame_pace(dlu_frame_ctx *ctx, uint64_t timeout) {
+  VkResult res = VK_SUCCESS;
+
+  if (!ctx->max_queued) return res;
+
+  DLU_PROF_ZONE(DLU_PROF_PRESENT, "dlu_frame_pace");
+
+  /* Same bounds as dlu_wait_present_latency() */
+  if (ctx->present_wait) {
+    if (ctx->sc->present_id < ctx->max_queued) return res;
+    res = ctx->WaitForPresentKHR(ctx->device, ctx->swap_chain, ctx->sc->present_id - ctx->max_queued + 1, timeout);
+    if (res == VK_ERROR_OUT_OF_DATE_KHR || res == VK_SUBOPTIMAL_KHR) ctx->stale = VK_TRUE;
+    else if (res && res != VK_TIMEOUT) PERR(DLU_VK_FUNC_ERR, res, "vkWaitForPresentKHR")
+    return res;
+  }
+
+  if (ctx->sc->submitted < ctx->max_queued) return res;
+
+  VkFence fence = ctx->syncs[ctx->sc->queued[(ctx->sc->submitted - ctx->max_queued) % DLU_PRESENT_MAX_QUEUED]].fence.render;
+  if (ctx->GetFenceStatus(ctx->device, fence) == VK_SUCCESS) return res;
+
+  res = ctx->WaitForFences(ctx->device, 1, &fence, VK_TRUE, timeout);
+  if (res && res != VK_TIMEOUT) PERR(DLU_VK_FUNC_ERR, res, "vkWaitForFences")
+
+  return res;
+}
+
+VkResult dlu_frame_acquire(dlu_frame_ctx *ctx) {
+  VkResult res = VK_RESULT_MAX_ENUM;
+
+  DLU_PROF_ZONE(DLU_PROF_ACQUIRE, "vkAcquireNextImageKHR");
+
+  res = ctx->AcquireNextImageKHR(ctx->device, ctx->swap_chain, GENERAL_TIMEOUT, ctx->image, VK_NULL_HANDLE, &ctx->cur_img);
+
+  /* Not errors, the surface changed. Caller should dlu_recreate_swap_chain() */
+  if (res == VK_ERROR_OUT_OF_DATE_KHR || res == VK_SUBOPTIMAL_KHR) ctx->stale = VK_TRUE;
+  else if (res) PERR(DLU_VK_FUNC_ERR, res, "vkAcquireNextImageKHR")
+
+  return res;
+}
+
+VkResult dlu_frame_submit(dlu_frame_ctx *ctx, VkPipelineStageFlags wait_stage) {
+  VkResult res = VK_RESULT_MAX_ENUM;
+
+  DLU_PROF_ZONE(DLU_PROF_SUBMIT, "vkQueueSubmit");
+
+  res = ctx->ResetFences(ctx->device, 1, &ctx->fence);
+  if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkResetFences"); return res; }
+
+  VkSubmitInfo submit_info = {};
+  submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submit_info.pNext = NULL;
+  submit_info.waitSemaphoreCount = 1;
+  submit_info.pWaitSemaphores = &ctx->image;
+  submit_info.pWaitDstStageMask = &wait_stage;
+  submit_info.commandBufferCount = 1;
+  submit_info.pCommandBuffers = &ctx->cmd_buff;
+  submit_info.signalSemaphoreCount = 1;
+  submit_info.pSignalSemaphores = &ctx->render;
+
+  res = ctx->QueueSubmit(ctx->graphics, 1, &submit_info, ctx->fence);
+  if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkQueueSubmit"); return res; }
+
+  ctx->sc->queued[ctx->sc->submitted++ % DLU_PRESENT_MAX_QUEUED] = ctx->synci;
+  dlu_defer_end_frame(ctx->app, ctx->ldi, ctx->fence);
+
+  return res;
+}
+
+VkResult dlu_frame_present(dlu_frame_ctx *ctx) {
+  VkResult res = VK_RESULT_MAX_ENUM;
+
+  DLU_PROF_ZONE(DLU_PROF_PRESENT, "vkQueuePresentKHR");
+
+  VkPresentInfoKHR present;
+  present.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+  present.pNext = NULL;
+  present.waitSemaphoreCount = 1;
+  present.pWaitSemaphores = &ctx->render;
+  present.swapchainCount = 1;
+  present.pSwapchains = &ctx->swap_chain;
+  present.pImageIndices = &ctx->cur_img;
+  present.pResults = NULL;
+
+  /* Tag the present so dlu_frame_pace() can wait for it to reach the display */
+  VkPresentIdKHR present_id;
+  if (ctx->present_wait) {
+    ctx->sc->present_id++;
+    present_id.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+    present_id.pNext = NULL;
+    present_id.swapchainCount = 1;
+    present_id.pPresentIds = &ctx->sc->present_id;
+    present.pNext = &present_id;
+  }
+
+  res = ctx->QueuePresentKHR(ctx->graphics, &present);
+
+  /* Not errors, the surface changed. Caller should dlu_recreate_swap_chain() */
+  if (res == VK_ERROR_OUT_OF_DATE_KHR || res == VK_SUBOPTIMAL_KHR) ctx->stale = VK_TRUE;
+  else if (res) PERR(DLU_VK_FUNC_ERR, res, "vkQueuePresentKHR")
+
+  return res;
+}
@@ -0,0 +1,252 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright (c) 2019-2020 Vincent Davis Jr.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*/
+
+#define LUCUR_VKCOMP_API
+#include <lucom.h>
+
+VkResult dlu_create_gpu_profiler(
+  vkcomp *app,
+  uint32_t cur_ld,
+  uint32_t frame_count,
+  uint32_t max_zones,
+  VkQueryPipelineStatisticFlags stat_flags
+) {
+
+  VkResult res = VK_RESULT_MAX_ENUM;
+  struct _gpu_prof *prof = &app->gpu_prof;
+  VkQueueFamilyProperties *fam_props = NULL;
+  VkPhysicalDeviceProperties props;
+  uint32_t famc = 0, valid_bits = 0;
+
+  if (!app->ld_data[cur_ld].device) { PERR(DLU_VKCOMP_DEVICE, 0, NULL); return res; }
+  if (prof->frames) { dlu_log_me(DLU_WARNING, "GPU profiler already created"); return VK_SUCCESS; }
+  if (!frame_count || !max_zones) { dlu_log_me(DLU_DANGER, "[x] frame_count and max_zones must be greater than 0"); return res; }
+
+  VkPhysicalDevice phys_dev = app->pd_data[app->ld_data[cur_ld].pdi].phys_dev;
+  vkGetPhysicalDeviceProperties(phys_dev, &props);
+
+  /* Timestamps are written on the graphics queue, its family decides how many bits are meaningful */
+  vkGetPhysicalDeviceQueueFamilyProperties(phys_dev, &famc, NULL);
+  fam_props = alloca(famc * sizeof(VkQueueFamilyProperties));
+  vkGetPhysicalDeviceQueueFamilyProperties(phys_dev, &famc, fam_props);
+  if (app->pd_data[app->ld_data[cur_ld].pdi].gfam_idx < famc)
+    valid_bits = fam_props[app->pd_data[app->ld_data[cur_ld].pdi].gfam_idx].timestampValidBits;
+
+  if (!valid_bits || props.limits.timestampPeriod == 0.0f) {
+    dlu_log_me(DLU_DANGER, "[x] Graphics queue doesn't support timestamps");
+    return res;
+  }
+
+  prof->frames = calloc(frame_count, sizeof(struct _gpu_prof_frame));
+  if (!prof->frames) { dlu_log_me(DLU_DANGER, "[x] calloc: %s", strerror(errno)); return res; }
+
+  prof->fc = frame_count;
+  prof->max_zones = max_zones;
+  prof->period = props.limits.timestampPeriod;
+  prof->ts_mask = (valid_bits >= 64) ? UINT64_MAX : ((1ULL << valid_bits) - 1);
+  prof->stat_flags = stat_flags;
+  prof->statc = __builtin_popcount(stat_flags);
+  prof->ldi = cur_ld;
+
+  prof->results = calloc(max_zones, sizeof(struct _gpu_prof_zone));
+  if (!prof->results) { dlu_log_me(DLU_DANGER, "[x] calloc: %s", strerror(errno)); goto err_free; }
+
+  if (prof->statc > DLU_GPU_PROF_STATS) {
+    dlu_log_me(DLU_DANGER, "[x] Unknown pipeline statistic flags 0x%x", stat_flags);
+    goto err_free;
+  }
+
+  VkQueryPoolCreateInfo create_info = {};
+  create_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  create_info.pNext = NULL;
+  create_info.flags = 0;
+
+  for (uint32_t i = 0; i < frame_count; i++) {
+    struct _gpu_prof_frame *frame = &prof->frames[i];
+
+    frame->zones = calloc(max_zones, sizeof(struct _gpu_prof_zone));
+    if (!frame->zones) { dlu_log_me(DLU_DANGER, "[x] calloc: %s", strerror(errno)); goto err_free; }
+
+    create_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    create_info.queryCount = max_zones * 2;
+    create_info.pipelineStatistics = 0;
+
+    res = vkCreateQueryPool(app->ld_data[cur_ld].device, &create_info, NULL, &frame->ts_pool);
+    if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkCreateQueryPool"); goto err_free; }
+
+    if (!stat_flags) continue;
+
+    create_info.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+    create_info.queryCount = max_zones;
+    create_info.pipelineStatistics = stat_flags;
+
+    res = vkCreateQueryPool(app->ld_data[cur_ld].device, &create_info, NULL, &frame->stat_pool);
+    if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkCreateQueryPool"); goto err_free; }
+  }
+
+  return res;
+
+err_free:
+  dlu_freeup_gpu_profiler(app);
+  return (res) ? res : VK_RESULT_MAX_ENUM;
+}
+
+/* Read back a slot's queries without waiting. Returns false if the GPU isn't done with them yet */
+static bool gpu_prof_resolve(vkcomp *app, struct _gpu_prof_frame *frame) {
+  struct _gpu_prof *prof = &app->gpu_prof;
+  VkDevice device = app->ld_data[prof->ldi].device;
+  VkResult res = VK_RESULT_MAX_ENUM;
+
+  if (!frame->zonec) return true;
+
+  uint64_t *ts = alloca(frame->zonec * 2 * sizeof(uint64_t));
+  res = DLU_VK(app, prof->ldi).GetQueryPoolResults(device, frame->ts_pool, 0, frame->zonec * 2, frame->zonec * 2 * sizeof(uint64_t),
+                                                   ts, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+  if (res == VK_NOT_READY) return false;
+  if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkGetQueryPoolResults"); return false; }
+
+  for (uint32_t i = 0; i < frame->zonec; i++) {
+    uint64_t ticks = ((ts[i * 2 + 1] & prof->ts_mask) - (ts[i * 2] & prof->ts_mask)) & prof->ts_mask;
+    frame->zones[i].ms = (double) ticks * prof->period / 1000000.0;
+  }
+
+  if (!prof->statc) return true;
+
+  /* Statistic queries are only issued around top level zones, read them one at a time */
+  for (uint32_t i = 0; i < frame->zonec; i++) {
+    if (!frame->zones[i].has_stats) continue;
+
+    res = DLU_VK(app, prof->ldi).GetQueryPoolResults(device, frame->stat_pool, i, 1, sizeof(frame->zones[i].stats), frame->zones[i].stats,
+                                                     prof->statc * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if (res == VK_NOT_READY) return false;
+    if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkGetQueryPoolResults"); return false; }
+  }
+
+  return true;
+}
+
+void dlu_gpu_prof_begin_frame(vkcomp *app, uint32_t cur_pool, uint32_t cur_buff, uint32_t frame) {
+  struct _gpu_prof *prof = &app->gpu_prof;
+  VkCommandBuffer cmd = app->cmd_data[cur_pool].cmd_buffs[cur_buff];
+
+  if (!prof->frames) { PERR(DLU_VKCOMP_GPU_PROF, 0, NULL); return; }
+  if (frame >= prof->fc) { dlu_log_me(DLU_DANGER, "[x] GPU profiler frame %u out of range", frame); return; }
+
+  struct _gpu_prof_frame *slot = &prof->frames[frame];
+
+  /* The slot is about to be reused, keep a copy of what it measured */
+  if (slot->pending) {
+    if (gpu_prof_resolve(app, slot)) {
+      memcpy(prof->results, slot->zones, slot->zonec * sizeof(struct _gpu_prof_zone));
+      prof->resc = slot->zonec;
+    } else {
+      prof->dropped++;
+    }
+    slot->pending = VK_FALSE;
+  }
+
+  DLU_CMD_VK(app, cur_pool).CmdResetQueryPool(cmd, slot->ts_pool, 0, prof->max_zones * 2);
+  if (slot->stat_pool) DLU_CMD_VK(app, cur_pool).CmdResetQueryPool(cmd, slot->stat_pool, 0, prof->max_zones);
+
+  slot->zonec = slot->depth = slot->skipped = 0;
+  slot->pending = VK_TRUE;
+  prof->cur_frame = frame;
+}
+
+void dlu_gpu_prof_begin(vkcomp *app, uint32_t cur_pool, uint32_t cur_buff, const char *name, const float color[4]) {
+  struct _gpu_prof *prof = &app->gpu_prof;
+  VkCommandBuffer cmd = app->cmd_data[cur_pool].cmd_buffs[cur_buff];
+
+  if (!prof->frames) { PERR(DLU_VKCOMP_GPU_PROF, 0, NULL); return; }
+
+  struct _gpu_prof_frame *slot = &prof->frames[prof->cur_frame];
+  /* Zones nested inside a skipped one are skipped too, so end() pops the right zone */
+  if (slot->skipped || slot->zonec == prof->max_zones || slot->depth == DLU_GPU_PROF_DEPTH) {
+    dlu_log_me(DLU_WARNING, "GPU profiler zone limit reached, '%s' not timed", name);
+    slot->skipped++;
+    return;
+  }
+
+  if (app->dbg_utils_cmd_begin) {
+    VkDebugUtilsLabelEXT label = {};
+    label.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT;
+    label.pNext = NULL;
+    label.pLabelName = name;
+    if (color) memcpy(label.color, color, sizeof(label.color));
+    app->dbg_utils_cmd_begin(cmd, &label);
+  }
+
+  uint32_t zone = slot->zonec++;
+  struct _gpu_prof_zone *z = &slot->zones[zone];
+  snprintf(z->name, sizeof(z->name), "%s", name);
+  z->depth = slot->depth;
+  z->ms = 0.0;
+
+  /* Only one pipeline statistics query can be active at a time, so nested zones go without */
+  z->has_stats = (slot->stat_pool && !slot->depth);
+  if (z->has_stats) DLU_CMD_VK(app, cur_pool).CmdBeginQuery(cmd, slot->stat_pool, zone, 0);
+
+  DLU_CMD_VK(app, cur_pool).CmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, slot->ts_pool, zone * 2);
+  slot->stack[slot->depth++] = zone;
+}
+
+void dlu_gpu_prof_end(vkcomp *app, uint32_t cur_pool, uint32_t cur_buff) {
+  struct _gpu_prof *prof = &app->gpu_prof;
+  VkCommandBuffer cmd = app->cmd_data[cur_pool].cmd_buffs[cur_buff];
+
+  if (!prof->frames) { PERR(DLU_VKCOMP_GPU_PROF, 0, NULL); return; }
+
+  struct _gpu_prof_frame *slot = &prof->frames[prof->cur_frame];
+  if (slot->skipped) { slot->skipped--; return; } /* Matches a begin that wasn't timed */
+  if (!slot->depth) { dlu_log_me(DLU_WARNING, "dlu_gpu_prof_end() without a matching dlu_gpu_prof_begin()"); return; }
+
+  uint32_t zone = slot->stack[--slot->depth];
+  DLU_CMD_VK(app, cur_pool).CmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, slot->ts_pool, zone * 2 + 1);
+  if (slot->zones[zone].has_stats) DLU_CMD_VK(app, cur_pool).CmdEndQuery(cmd, slot->stat_pool, zone);
+
+  if (app->dbg_utils_cmd_end) app->dbg_utils_cmd_end(cmd);
+}
+
+const struct _gpu_prof_zone *dlu_gpu_prof_results(vkcomp *app, uint32_t *count) {
+  *count = app->gpu_prof.resc;
+  return (app->gpu_prof.resc) ? app->gpu_prof.results : NULL;
+}
+
+void dlu_freeup_gpu_profiler(vkcomp *app) {
+  struct _gpu_prof *prof = &app->gpu_prof;
+
+  if (prof->frames) {
+    for (uint32_t i = 0; i < prof->fc; i++) {
+      if (prof->frames[i].ts_pool)
+        vkDestroyQueryPool(app->ld_data[prof->ldi].device, prof->frames[i].ts_pool, NULL);
+      if (prof->frames[i].stat_pool)
+        vkDestroyQueryPool(app->ld_data[prof->ldi].device, prof->frames[i].stat_pool, NULL);
+      free(prof->frames[i].zones);
+    }
+  }
+
+  free(prof->frames);
+  free(prof->results);
+  memset(prof, 0, sizeof(struct _gpu_prof));
+}
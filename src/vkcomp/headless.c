@@ -0,0 +1,426 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright (c) 2019-2020 Vincent Davis Jr.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*/
+
+#define LUCUR_VKCOMP_API
+#include <lucom.h>
+
+/* Bytes per texel of the color formats a readback can be tightly packed for */
+static uint32_t format_size(VkFormat format) {
+  switch (format) {
+    case VK_FORMAT_R8_UNORM: return 1;
+    case VK_FORMAT_R8G8_UNORM: return 2;
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+    case VK_FORMAT_B8G8R8A8_UNORM:
+    case VK_FORMAT_B8G8R8A8_SRGB:
+    case VK_FORMAT_A2B10G10R10_UNORM_PACK32:
+    case VK_FORMAT_R32_SFLOAT: return 4;
+    case VK_FORMAT_R16G16B16A16_SFLOAT:
+    case VK_FORMAT_R16G16B16A16_UNORM: return 8;
+    case VK_FORMAT_R32G32B32A32_SFLOAT: return 16;
+    default: return 0;
+  }
+}
+
+static VkResult create_images(vkcomp *app, uint32_t cur_ld, uint32_t cur_scd, VkImageUsageFlags usage) {
+  VkResult res = VK_RESULT_MAX_ENUM;
+  struct _sc_data *sc = &app->sc_data[cur_scd];
+  VkDevice device = app->ld_data[cur_ld].device;
+
+  VkImageCreateInfo img_info = {};
+  img_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+  img_info.pNext = NULL;
+  img_info.flags = 0;
+  img_info.imageType = VK_IMAGE_TYPE_2D;
+  img_info.format = sc->format;
+  img_info.extent.width = sc->extent.width;
+  img_info.extent.height = sc->extent.height;
+  img_info.extent.depth = 1;
+  img_info.mipLevels = 1;
+  img_info.arrayLayers = 1;
+  img_info.samples = VK_SAMPLE_COUNT_1_BIT;
+  img_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+  img_info.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | usage;
+  img_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  img_info.queueFamilyIndexCount = 0;
+  img_info.pQueueFamilyIndices = NULL;
+  img_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+  VkMemoryRequirements mem_reqs;
+  VkDeviceSize *offsets = alloca(sc->sic * sizeof(VkDeviceSize));
+  VkDeviceSize size = 0;
+  uint32_t type_bits = UINT32_MAX;
+
+  for (uint32_t i = 0; i < sc->sic; i++) {
+    res = vkCreateImage(device, &img_info, NULL, &sc->sc_buffs[i].image);
+    if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkCreateImage"); return res; }
+
+    vkGetImageMemoryRequirements(device, sc->sc_buffs[i].image, &mem_reqs);
+    offsets[i] = (size + mem_reqs.alignment - 1) / mem_reqs.alignment * mem_reqs.alignment;
+    size = offsets[i] + mem_reqs.size;
+    type_bits &= mem_reqs.memoryTypeBits;
+  }
+
+  /* Every image shares one allocation */
+  VkMemoryAllocateInfo alloc_info = {};
+  alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  alloc_info.pNext = NULL;
+  alloc_info.allocationSize = size;
+
+  if (!memory_type_from_properties(app, app->ld_data[cur_ld].pdi, type_bits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &alloc_info.memoryTypeIndex)) {
+    PERR(DLU_MEM_TYPE_ERR, 0, NULL);
+    return VK_RESULT_MAX_ENUM;
+  }
+
+  res = vkAllocateMemory(device, &alloc_info, NULL, &sc->img_mem);
+  if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkAllocateMemory"); return res; }
+
+  VkImageViewCreateInfo view_info = {};
+  view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+  view_info.pNext = NULL;
+  view_info.flags = 0;
+  view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+  view_info.format = sc->format;
+  view_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+  view_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+  view_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+  view_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+  view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  view_info.subresourceRange.baseMipLevel = 0;
+  view_info.subresourceRange.levelCount = 1;
+  view_info.subresourceRange.baseArrayLayer = 0;
+  view_info.subresourceRange.layerCount = 1;
+
+  for (uint32_t i = 0; i < sc->sic; i++) {
+    res = vkBindImageMemory(device, sc->sc_buffs[i].image, sc->img_mem, offsets[i]);
+    if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkBindImageMemory"); return res; }
+
+    view_info.image = sc->sc_buffs[i].image;
+    res = vkCreateImageView(device, &view_info, NULL, &sc->sc_buffs[i].view);
+    if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkCreateImageView"); return res; }
+  }
+
+  return res;
+}
+
+static VkResult create_readbacks(vkcomp *app, uint32_t cur_ld, uint32_t cur_scd) {
+  VkResult res = VK_RESULT_MAX_ENUM;
+  struct _sc_data *sc = &app->sc_data[cur_scd];
+  VkDevice device = app->ld_data[cur_ld].device;
+
+  VkPhysicalDeviceMemoryProperties mem_props;
+  vkGetPhysicalDeviceMemoryProperties(app->pd_data[app->ld_data[cur_ld].pdi].phys_dev, &mem_props);
+
+  VkBufferCreateInfo buff_info = {};
+  buff_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  buff_info.pNext = NULL;
+  buff_info.flags = 0;
+  buff_info.size = sc->row_pitch * sc->extent.height;
+  buff_info.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+  buff_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  buff_info.queueFamilyIndexCount = 0;
+  buff_info.pQueueFamilyIndices = NULL;
+
+  VkFenceCreateInfo fence_info = {};
+  fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+  fence_info.pNext = NULL;
+  fence_info.flags = 0;
+
+  for (uint32_t i = 0; i < sc->sic; i++) {
+    struct _readback *rb = &sc->readback[i];
+
+    res = vkCreateBuffer(device, &buff_info, NULL, &rb->buff);
+    if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkCreateBuffer"); return res; }
+
+    VkMemoryRequirements mem_reqs;
+    vkGetBufferMemoryRequirements(device, rb->buff, &mem_reqs);
+
+    VkMemoryAllocateInfo alloc_info = {};
+    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    alloc_info.pNext = NULL;
+    alloc_info.allocationSize = mem_reqs.size;
+
+    /* The CPU reads every byte, uncached memory would make that crawl */
+    if (!memory_type_from_all_properties(app, app->ld_data[cur_ld].pdi, mem_reqs.memoryTypeBits,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT, &alloc_info.memoryTypeIndex) &&
+        !memory_type_from_all_properties(app, app->ld_data[cur_ld].pdi, mem_reqs.memoryTypeBits,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &alloc_info.memoryTypeIndex)) {
+      PERR(DLU_MEM_TYPE_ERR, 0, NULL);
+      return VK_RESULT_MAX_ENUM;
+    }
+
+    rb->coherent = (mem_props.memoryTypes[alloc_info.memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) ? VK_TRUE : VK_FALSE;
+
+    res = vkAllocateMemory(device, &alloc_info, NULL, &rb->mem);
+    if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkAllocateMemory"); return res; }
+
+    res = vkBindBufferMemory(device, rb->buff, rb->mem, 0);
+    if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkBindBufferMemory"); return res; }
+
+    /* Persistently mapped */
+    res = vkMapMemory(device, rb->mem, 0, VK_WHOLE_SIZE, 0, &rb->mapped);
+    if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkMapMemory"); return res; }
+
+    /* Each readback has its own fence, frame sync fences get reset and reused before anyone reads the pixels */
+    res = vkCreateFence(device, &fence_info, NULL, &rb->fence);
+    if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkCreateFence"); return res; }
+  }
+
+  return res;
+}
+
+VkResult dlu_create_headless_target(
+  vkcomp *app,
+  uint32_t cur_ld,
+  uint32_t cur_scd,
+  VkFormat format,
+  VkExtent2D extent,
+  uint32_t image_count,
+  VkImageUsageFlags usage
+) {
+
+  VkResult res = VK_RESULT_MAX_ENUM;
+  struct _sc_data *sc = NULL;
+
+  if (!app->sc_data) { PERR(DLU_BUFF_NOT_ALLOC, 0, "DLU_SC_DATA"); return res; }
+  if (!app->ld_data[cur_ld].device) { PERR(DLU_VKCOMP_DEVICE, 0, NULL); return res; }
+
+  sc = &app->sc_data[cur_scd];
+  if (!sc->sc_buffs) { PERR(DLU_BUFF_NOT_ALLOC, 0, "DLU_SC_DATA_MEMS"); return res; }
+  if (sc->swap_chain || sc->headless) { PERR(DLU_ALREADY_ALLOC, 0, NULL); return res; }
+  if (!image_count || image_count > sc->sbc) { PERR(DLU_VKCOMP_SC_IC, 0, NULL); return res; }
+
+  uint32_t texel = format_size(format);
+  if (!texel) { PERR(DLU_OP_NOT_PERMITED, 0, NULL); return res; }
+
+  sc->readback = calloc(image_count, sizeof(struct _readback));
+  if (!sc->readback) { dlu_log_me(DLU_DANGER, "[x] calloc: %s", strerror(errno)); return res; }
+
+  sc->headless = VK_TRUE;
+  sc->ldi = cur_ld;
+  sc->sic = image_count;
+  sc->next_img = 0;
+  sc->format = format;
+  sc->extent = extent;
+  sc->stale = VK_FALSE;
+  sc->row_pitch = (VkDeviceSize) extent.width * texel;
+
+  res = create_images(app, cur_ld, cur_scd, usage);
+  if (res) goto err_headless;
+
+  res = create_readbacks(app, cur_ld, cur_scd);
+  if (res) goto err_headless;
+
+  dlu_log_me(DLU_SUCCESS, "Headless target %u: %u %ux%u images", cur_scd, image_count, extent.width, extent.height);
+
+  return res;
+
+err_headless:
+  dlu_freeup_headless_target(app, cur_scd);
+  return res;
+}
+
+uint32_t dlu_headless_acquire(vkcomp *app, uint32_t cur_scd) {
+  struct _sc_data *sc = &app->sc_data[cur_scd];
+  uint32_t cur_img = sc->next_img;
+
+  DLU_PROF_ZONE(DLU_PROF_ACQUIRE, "dlu_headless_acquire");
+
+  sc->next_img = (sc->next_img + 1) % sc->sic;
+  return cur_img;
+}
+
+void dlu_headless_record_readback(
+  vkcomp *app,
+  uint32_t cur_pool,
+  uint32_t cur_buff,
+  uint32_t cur_scd,
+  uint32_t cur_img,
+  VkImageLayout oldLayout
+) {
+
+  struct _sc_data *sc = &app->sc_data[cur_scd];
+  VkCommandBuffer cmd_buff = app->cmd_data[cur_pool].cmd_buffs[cur_buff];
+
+  if (!sc->headless) { PERR(DLU_OP_NOT_PERMITED, 0, NULL); return; }
+
+  VkImageMemoryBarrier img_barrier = {};
+  img_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  img_barrier.pNext = NULL;
+  img_barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+  img_barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+  img_barrier.oldLayout = oldLayout;
+  img_barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+  img_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  img_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  img_barrier.image = sc->sc_buffs[cur_img].image;
+  img_barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  img_barrier.subresourceRange.baseMipLevel = 0;
+  img_barrier.subresourceRange.levelCount = 1;
+  img_barrier.subresourceRange.baseArrayLayer = 0;
+  img_barrier.subresourceRange.layerCount = 1;
+
+  DLU_CMD_VK(app, cur_pool).CmdPipelineBarrier(cmd_buff, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                               VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1, &img_barrier);
+
+  VkBufferImageCopy region = {};
+  region.bufferOffset = 0;
+  region.bufferRowLength = 0; /* tightly packed */
+  region.bufferImageHeight = 0;
+  region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  region.imageSubresource.mipLevel = 0;
+  region.imageSubresource.baseArrayLayer = 0;
+  region.imageSubresource.layerCount = 1;
+  region.imageOffset.x = region.imageOffset.y = region.imageOffset.z = 0;
+  region.imageExtent.width = sc->extent.width;
+  region.imageExtent.height = sc->extent.height;
+  region.imageExtent.depth = 1;
+
+  DLU_CMD_VK(app, cur_pool).CmdCopyImageToBuffer(cmd_buff, sc->sc_buffs[cur_img].image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, sc->readback[cur_img].buff, 1, &region);
+
+  /* Make the copy visible to host reads once the fence signals */
+  VkBufferMemoryBarrier buff_barrier = {};
+  buff_barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+  buff_barrier.pNext = NULL;
+  buff_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  buff_barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+  buff_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  buff_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  buff_barrier.buffer = sc->readback[cur_img].buff;
+  buff_barrier.offset = 0;
+  buff_barrier.size = VK_WHOLE_SIZE;
+
+  DLU_CMD_VK(app, cur_pool).CmdPipelineBarrier(cmd_buff, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, NULL, 1, &buff_barrier, 0, NULL);
+
+}
+
+/* Waits out a readback's copy, GENERAL_TIMEOUT at most so a lost device can't hang the caller */
+static VkResult wait_readback(vkcomp *app, struct _sc_data *sc, struct _readback *rb, VkBool32 wait) {
+  VkDevice device = app->ld_data[sc->ldi].device;
+
+  VkResult res = DLU_VK(app, sc->ldi).GetFenceStatus(device, rb->fence);
+  if (res == VK_NOT_READY && wait)
+    res = DLU_VK(app, sc->ldi).WaitForFences(device, 1, &rb->fence, VK_TRUE, GENERAL_TIMEOUT);
+
+  return res;
+}
+
+VkResult dlu_headless_queue_readback(vkcomp *app, uint32_t cur_scd, uint32_t cur_img) {
+  VkResult res = VK_RESULT_MAX_ENUM;
+  struct _sc_data *sc = &app->sc_data[cur_scd];
+
+  if (!sc->headless) { PERR(DLU_OP_NOT_PERMITED, 0, NULL); return res; }
+
+  struct _readback *rb = &sc->readback[cur_img];
+  VkDevice device = app->ld_data[sc->ldi].device;
+
+  /* A fence can't be reset while a submission still holds it */
+  if (rb->pending) {
+    res = wait_readback(app, sc, rb, VK_TRUE);
+    if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkWaitForFences"); return res; }
+    rb->pending = VK_FALSE;
+  }
+
+  res = DLU_VK(app, sc->ldi).ResetFences(device, 1, &rb->fence);
+  if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkResetFences"); return res; }
+
+  /* An empty batch signals its fence once everything queued before it has completed */
+  res = DLU_VK(app, sc->ldi).QueueSubmit(app->ld_data[sc->ldi].graphics, 0, NULL, rb->fence);
+  if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkQueueSubmit"); return res; }
+
+  rb->pending = VK_TRUE;
+
+  return res;
+}
+
+const void *dlu_headless_get_frame(vkcomp *app, uint32_t cur_scd, uint32_t cur_img, VkBool32 wait, VkDeviceSize *row_pitch) {
+  VkResult res = VK_RESULT_MAX_ENUM;
+  struct _sc_data *sc = &app->sc_data[cur_scd];
+  struct _readback *rb = NULL;
+  VkDevice device = VK_NULL_HANDLE;
+
+  if (!sc->headless) { PERR(DLU_OP_NOT_PERMITED, 0, NULL); return NULL; }
+
+  rb = &sc->readback[cur_img];
+  device = app->ld_data[sc->ldi].device;
+
+  if (rb->pending) {
+    res = wait_readback(app, sc, rb, wait);
+    if (res == VK_NOT_READY) return NULL;
+    if (res == VK_TIMEOUT) { dlu_log_me(DLU_WARNING, "Readback of image %u not done after %d ns", cur_img, GENERAL_TIMEOUT); return NULL; }
+    if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkWaitForFences"); return NULL; }
+
+    if (!rb->coherent) {
+      VkMappedMemoryRange range = {};
+      range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+      range.pNext = NULL;
+      range.memory = rb->mem;
+      range.offset = 0;
+      range.size = VK_WHOLE_SIZE;
+
+      res = vkInvalidateMappedMemoryRanges(device, 1, &range);
+      if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkInvalidateMappedMemoryRanges"); return NULL; }
+    }
+
+    rb->pending = VK_FALSE;
+  }
+
+  if (row_pitch) *row_pitch = sc->row_pitch;
+  return rb->mapped;
+}
+
+void dlu_freeup_headless_target(vkcomp *app, uint32_t cur_scd) {
+  struct _sc_data *sc = &app->sc_data[cur_scd];
+
+  if (!sc->headless) return;
+
+  VkDevice device = app->ld_data[sc->ldi].device;
+
+  for (uint32_t i = 0; i < sc->sic; i++) {
+    if (sc->readback) {
+      if (sc->readback[i].mapped) vkUnmapMemory(device, sc->readback[i].mem);
+      if (sc->readback[i].buff) vkDestroyBuffer(device, sc->readback[i].buff, NULL);
+      if (sc->readback[i].mem) vkFreeMemory(device, sc->readback[i].mem, NULL);
+      if (sc->readback[i].fence) vkDestroyFence(device, sc->readback[i].fence, NULL);
+    }
+
+    if (sc->sc_buffs[i].view) {
+      dlu_cache_evict_image_view(app, sc->sc_buffs[i].view);
+      vkDestroyImageView(device, sc->sc_buffs[i].view, NULL);
+      sc->sc_buffs[i].view = VK_NULL_HANDLE;
+    }
+
+    if (sc->sc_buffs[i].image) {
+      vkDestroyImage(device, sc->sc_buffs[i].image, NULL);
+      sc->sc_buffs[i].image = VK_NULL_HANDLE;
+    }
+  }
+
+  if (sc->img_mem) vkFreeMemory(device, sc->img_mem, NULL);
+
+  free(sc->readback);
+  sc->readback = NULL;
+  sc->img_mem = VK_NULL_HANDLE;
+  sc->headless = VK_FALSE;
+}
@@ -0,0 +1,141 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright (c) 2019-2020 Vincent Davis Jr.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*/
+
+#define LUCUR_VKCOMP_API
+#include <lucom.h>
+
+static VkImageAspectFlags depth_aspect(VkFormat format) {
+  switch (format) {
+    case VK_FORMAT_D16_UNORM_S8_UINT:
+    case VK_FORMAT_D24_UNORM_S8_UINT:
+    case VK_FORMAT_D32_SFLOAT_S8_UINT:
+      return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+    default:
+      return VK_IMAGE_ASPECT_DEPTH_BIT;
+  }
+}
+
+VkSampleCountFlagBits dlu_msaa_sample_count(vkcomp *app, uint32_t cur_pd, VkSampleCountFlagBits wanted, VkBool32 depth) {
+  VkPhysicalDeviceProperties props;
+  VkSampleCountFlags counts = 0;
+
+  if (!app->pd_data[cur_pd].phys_dev) { PERR(DLU_VKCOMP_PHYS_DEV, 0, NULL); return VK_SAMPLE_COUNT_1_BIT; }
+
+  vkGetPhysicalDeviceProperties(app->pd_data[cur_pd].phys_dev, &props);
+
+  counts = props.limits.framebufferColorSampleCounts;
+  if (depth) counts &= props.limits.framebufferDepthSampleCounts;
+
+  /* Sample counts are single bits, walk down from wanted */
+  for (VkSampleCountFlags bit = wanted; bit > VK_SAMPLE_COUNT_1_BIT; bit >>= 1)
+    if (counts & bit) return (VkSampleCountFlagBits) bit;
+
+  return VK_SAMPLE_COUNT_1_BIT;
+}
+
+VkResult dlu_create_msaa_attachments(vkcomp *app, uint32_t cur_scd, VkSampleCountFlagBits samples, VkFormat depth_format) {
+  VkResult res = VK_RESULT_MAX_ENUM;
+  uint32_t count = (depth_format == VK_FORMAT_UNDEFINED) ? 1 : 2;
+
+  if (!app->sc_data) { PERR(DLU_BUFF_NOT_ALLOC, 0, "DLU_SC_DATA"); return res; }
+  if (samples == VK_SAMPLE_COUNT_1_BIT) { PERR(DLU_OP_NOT_PERMITED, 0, NULL); return res; }
+
+  struct _sc_data *sc = &app->sc_data[cur_scd];
+  VkExtent3D extent = dlu_set_extent3D(sc->extent.width, sc->extent.height, 1);
+  VkComponentMapping comps = dlu_set_component_mapping(VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY,
+                                                       VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY);
+
+  VkImageCreateInfo img_infos[2];
+  VkImageViewCreateInfo ivis[2];
+  VkImageSubresourceRange range = {};
+  range.baseMipLevel = 0;
+  range.levelCount = 1;
+  range.baseArrayLayer = 0;
+  range.layerCount = 1;
+
+  /* Only ever attachments, so dlu_create_transient_attachments() may hand out lazily allocated memory */
+  range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  img_infos[0] = dlu_set_image_info(0, VK_IMAGE_TYPE_2D, sc->format, extent, 1, 1, samples, VK_IMAGE_TILING_OPTIMAL,
+                                    VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, VK_SHARING_MODE_EXCLUSIVE, 0, NULL, VK_IMAGE_LAYOUT_UNDEFINED);
+  ivis[0] = dlu_set_image_view_info(0, VK_NULL_HANDLE, VK_IMAGE_VIEW_TYPE_2D, sc->format, comps, range);
+
+  if (count == 2) {
+    range.aspectMask = depth_aspect(depth_format);
+    img_infos[1] = dlu_set_image_info(0, VK_IMAGE_TYPE_2D, depth_format, extent, 1, 1, samples, VK_IMAGE_TILING_OPTIMAL,
+                                      VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_SHARING_MODE_EXCLUSIVE, 0, NULL, VK_IMAGE_LAYOUT_UNDEFINED);
+    ivis[1] = dlu_set_image_view_info(0, VK_NULL_HANDLE, VK_IMAGE_VIEW_TYPE_2D, depth_format, comps, range);
+  }
+
+  /* Color and depth are alive at the same time, no aliasing */
+  res = dlu_create_transient_attachments(app, cur_scd, count, img_infos, ivis, NULL);
+  if (res) return res;
+
+  if (!sc->trans_lazy)
+    dlu_log_me(DLU_WARNING, "No lazily allocated memory, %ux MSAA attachments are backed by device memory", (uint32_t) samples);
+
+  return res;
+}
+
+VkResult dlu_create_msaa_render_pass(
+  vkcomp *app,
+  uint32_t cur_gpd,
+  uint32_t cur_scd,
+  VkSampleCountFlagBits samples,
+  VkFormat depth_format,
+  VkImageLayout finalLayout
+) {
+
+  VkBool32 depth = (depth_format != VK_FORMAT_UNDEFINED);
+  VkFormat format = app->sc_data[cur_scd].format;
+
+  /**
+  * Multisampled attachments are cleared on load and discarded on store, only
+  * the resolved single sample image is written out to memory
+  */
+  VkAttachmentDescription attachments[3];
+  attachments[0] = dlu_set_attachment_desc(format, samples, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_DONT_CARE,
+                                           VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_DONT_CARE,
+                                           VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+  attachments[1] = dlu_set_attachment_desc(format, VK_SAMPLE_COUNT_1_BIT, VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_STORE,
+                                           VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_DONT_CARE,
+                                           VK_IMAGE_LAYOUT_UNDEFINED, finalLayout);
+  attachments[2] = dlu_set_attachment_desc(depth_format, samples, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_DONT_CARE,
+                                           VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_DONT_CARE,
+                                           VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+
+  VkAttachmentReference color_ref = dlu_set_attachment_ref(0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+  VkAttachmentReference resolve_ref = dlu_set_attachment_ref(1, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+  VkAttachmentReference depth_ref = dlu_set_attachment_ref(2, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+
+  VkSubpassDescription subpass = dlu_set_subpass_desc(0, VK_PIPELINE_BIND_POINT_GRAPHICS, 0, NULL, 1, &color_ref,
+                                                      &resolve_ref, (depth) ? &depth_ref : NULL, 0, NULL);
+
+  /* The resolve writes the swapchain image, wait for the acquire like a plain color pass does */
+  VkSubpassDependency dep = dlu_set_subpass_dep(VK_SUBPASS_EXTERNAL, 0,
+                                                VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+                                                VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+                                                0, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, 0);
+
+  return dlu_create_render_pass(app, cur_gpd, (depth) ? 3 : 2, attachments, 1, &subpass, 1, &dep, 0);
+}
@@ -0,0 +1,247 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright (c) 2019-2020 Vincent Davis Jr.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*/
+
+#define LUCUR_VKCOMP_API
+#include <lucom.h>
+
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/stat.h>
+
+#define PCACHE_MAGIC 0x50554c44 /* "DLUP" */
+#define PCACHE_VERSION 1
+
+/**
+* Written in front of the vkGetPipelineCacheData() blob. Vulkan's own cache
+* header doesn't carry the driver version, so keep everything needed to
+* decide whether the blob is still usable on this device.
+*/
+struct pcache_header {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t vendorID;
+  uint32_t deviceID;
+  uint32_t driverVersion;
+  uint8_t uuid[VK_UUID_SIZE];
+  uint64_t data_size;
+  uint64_t data_hash;
+};
+
+/* Build $XDG_CACHE_HOME/lucurious/<name>.pcache, creating directories along the way */
+static bool pcache_path(char *path, size_t size, const char *name) {
+  const char *base = getenv("XDG_CACHE_HOME");
+  const char *home = getenv("HOME");
+  char dir[PATH_MAX];
+
+  if (base && *base) {
+    snprintf(dir, sizeof(dir), "%s", base);
+  } else if (home && *home) {
+    snprintf(dir, sizeof(dir), "%s/.cache", home);
+  } else {
+    dlu_log_me(DLU_WARNING, "Neither XDG_CACHE_HOME nor HOME is set, pipeline cache disabled");
+    return false;
+  }
+
+  if (mkdir(dir, 0755) == NEG_ONE && errno != EEXIST) {
+    dlu_log_me(DLU_DANGER, "[x] mkdir: %s", strerror(errno));
+    return false;
+  }
+
+  strncat(dir, "/lucurious", sizeof(dir) - strlen(dir) - 1);
+  if (mkdir(dir, 0755) == NEG_ONE && errno != EEXIST) {
+    dlu_log_me(DLU_DANGER, "[x] mkdir: %s", strerror(errno));
+    return false;
+  }
+
+  if (snprintf(path, size, "%s/%s.pcache", dir, name) >= (int) size) {
+    dlu_log_me(DLU_DANGER, "[x] pipeline cache path too long");
+    return false;
+  }
+
+  return true;
+}
+
+void *dlu_pcache_read(const char *path, const VkPhysicalDeviceProperties *props, size_t *size) {
+  struct pcache_header header;
+  struct stat st;
+  void *data = NULL;
+  FILE *stream = NULL;
+
+  *size = 0;
+
+  stream = fopen(path, "rb");
+  if (!stream) return NULL; /* First run, nothing cached yet */
+
+  if (fstat(fileno(stream), &st) == NEG_ONE) { dlu_log_me(DLU_DANGER, "[x] fstat: %s", strerror(errno)); goto finish_pcache_read; }
+  if (fread(&header, sizeof(header), 1, stream) != 1) goto finish_pcache_read;
+
+  if (header.magic != PCACHE_MAGIC || header.version != PCACHE_VERSION ||
+      header.vendorID != props->vendorID || header.deviceID != props->deviceID ||
+      header.driverVersion != props->driverVersion ||
+      memcmp(header.uuid, props->pipelineCacheUUID, VK_UUID_SIZE)) {
+    dlu_log_me(DLU_WARNING, "Pipeline cache %s was written by a different device or driver, ignoring", path);
+    goto finish_pcache_read;
+  }
+
+  /* The header isn't trusted, its size has to account for exactly the rest of the file */
+  if ((uint64_t) st.st_size < sizeof(header) || header.data_size != (uint64_t) st.st_size - sizeof(header) || !header.data_size) {
+    dlu_log_me(DLU_WARNING, "Pipeline cache %s is corrupt, ignoring", path);
+    goto finish_pcache_read;
+  }
+
+  data = calloc(1, header.data_size);
+  if (!data) { dlu_log_me(DLU_DANGER, "[x] calloc: %s", strerror(errno)); goto finish_pcache_read; }
+
+  if (fread(data, header.data_size, 1, stream) != 1 || dlu_hash_bytes(DLU_HASH_SEED, data, header.data_size) != header.data_hash) {
+    dlu_log_me(DLU_WARNING, "Pipeline cache %s is corrupt, ignoring", path);
+    free(data); data = NULL;
+    goto finish_pcache_read;
+  }
+
+  *size = header.data_size;
+
+finish_pcache_read:
+  fclose(stream);
+  return data;
+}
+
+bool dlu_pcache_write(const char *path, const VkPhysicalDeviceProperties *props, const void *data, size_t size) {
+  struct pcache_header header;
+  char tmp[PATH_MAX];
+  bool ret = false;
+  int fd = NEG_ONE;
+
+  memset(&header, 0, sizeof(header));
+  header.magic = PCACHE_MAGIC;
+  header.version = PCACHE_VERSION;
+  header.vendorID = props->vendorID;
+  header.deviceID = props->deviceID;
+  header.driverVersion = props->driverVersion;
+  memcpy(header.uuid, props->pipelineCacheUUID, VK_UUID_SIZE);
+  header.data_size = size;
+  header.data_hash = dlu_hash_bytes(DLU_HASH_SEED, data, size);
+
+  /* Write next to the real file so rename(2) stays on one filesystem and is atomic */
+  if (snprintf(tmp, sizeof(tmp), "%s.XXXXXX", path) >= (int) sizeof(tmp)) {
+    dlu_log_me(DLU_DANGER, "[x] pipeline cache path too long");
+    return ret;
+  }
+
+  fd = mkstemp(tmp);
+  if (fd == NEG_ONE) { dlu_log_me(DLU_DANGER, "[x] mkstemp: %s", strerror(errno)); return ret; }
+
+  if (write(fd, &header, sizeof(header)) != (ssize_t) sizeof(header) || write(fd, data, size) != (ssize_t) size) {
+    dlu_log_me(DLU_DANGER, "[x] write: %s", strerror(errno));
+    goto finish_pcache_write;
+  }
+
+  if (fsync(fd) == NEG_ONE) { dlu_log_me(DLU_DANGER, "[x] fsync: %s", strerror(errno)); goto finish_pcache_write; }
+
+  if (rename(tmp, path) == NEG_ONE) {
+    dlu_log_me(DLU_DANGER, "[x] rename: %s", strerror(errno));
+    goto finish_pcache_write;
+  }
+
+  ret = true;
+
+finish_pcache_write:
+  close(fd);
+  if (!ret) unlink(tmp);
+  return ret;
+}
+
+VkResult dlu_load_pipeline_cache(vkcomp *app, uint32_t cur_ld, const char *name) {
+  VkResult res = VK_RESULT_MAX_ENUM;
+  VkPhysicalDeviceProperties props;
+  char path[PATH_MAX];
+  void *data = NULL;
+  size_t size = 0;
+
+  if (!app->ld_data[cur_ld].device) { PERR(DLU_VKCOMP_DEVICE, 0, NULL); return res; }
+  if (app->ld_data[cur_ld].pdi == UINT32_MAX) { PERR(DLU_VKCOMP_DEVICE_NOT_ASSOC, 0, "dlu_create_logical_device()"); return res; }
+
+  vkGetPhysicalDeviceProperties(app->pd_data[app->ld_data[cur_ld].pdi].phys_dev, &props);
+
+  free(app->gp_cache.path);
+  app->gp_cache.path = NULL;
+
+  if (pcache_path(path, sizeof(path), name)) {
+    app->gp_cache.path = strdup(path);
+    data = dlu_pcache_read(path, &props, &size);
+  }
+
+  res = dlu_create_pipeline_cache(app, cur_ld, size, data);
+  if (res && data) /* Some drivers reject stale data outright instead of ignoring it */
+    res = dlu_create_pipeline_cache(app, cur_ld, 0, NULL);
+
+  if (!res && data) dlu_log_me(DLU_SUCCESS, "Loaded %zu byte pipeline cache from %s", size, path);
+
+  free(data);
+  return res;
+}
+
+VkResult dlu_save_pipeline_cache(vkcomp *app) {
+  VkResult res = VK_RESULT_MAX_ENUM;
+  VkPhysicalDeviceProperties props;
+  VkDevice device = VK_NULL_HANDLE;
+  void *data = NULL;
+  size_t size = 0;
+
+  if (!app->gp_cache.pipe_cache) { PERR(DLU_VKCOMP_PIPE_CACHE, 0, NULL); return res; }
+  if (!app->gp_cache.path) return VK_SUCCESS; /* cache wasn't created by dlu_load_pipeline_cache() */
+
+  device = app->ld_data[app->gp_cache.ldi].device;
+  vkGetPhysicalDeviceProperties(app->pd_data[app->ld_data[app->gp_cache.ldi].pdi].phys_dev, &props);
+
+  res = vkGetPipelineCacheData(device, app->gp_cache.pipe_cache, &size, NULL);
+  if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkGetPipelineCacheData"); return res; }
+
+  data = calloc(1, size);
+  if (!data) { dlu_log_me(DLU_DANGER, "[x] calloc: %s", strerror(errno)); return VK_RESULT_MAX_ENUM; }
+
+  res = vkGetPipelineCacheData(device, app->gp_cache.pipe_cache, &size, data);
+  if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkGetPipelineCacheData"); goto finish_save; }
+
+  res = VK_RESULT_MAX_ENUM;
+  if (!dlu_pcache_write(app->gp_cache.path, &props, data, size)) goto finish_save;
+
+  res = VK_SUCCESS;
+  dlu_log_me(DLU_SUCCESS, "Saved %zu byte pipeline cache to %s (%u hits, %u misses)", size, app->gp_cache.path, app->gp_cache.hits, app->gp_cache.misses);
+
+finish_save:
+  free(data);
+  return res;
+}
+
+void dlu_pipeline_cache_feedback(vkcomp *app, const VkPipelineCreationFeedbackEXT *feedback) {
+  if (!(feedback->flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT_EXT)) return;
+
+  /* Pipelines may be created from worker threads, see pipeline.c */
+  if (feedback->flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT_EXT)
+    __atomic_fetch_add(&app->gp_cache.hits, 1, __ATOMIC_RELAXED);
+  else
+    __atomic_fetch_add(&app->gp_cache.misses, 1, __ATOMIC_RELAXED);
+
+  __atomic_fetch_add(&app->gp_cache.duration, feedback->duration, __ATOMIC_RELAXED);
+}
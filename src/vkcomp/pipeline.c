@@ -0,0 +1,314 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright (c) 2019-2020 Vincent Davis Jr.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*/
+
+#define LUCUR_VKCOMP_API
+#include <lucom.h>
+
+#include <pthread.h>
+
+/**
+* Workers pull the next pipeline index off of job->next until all
+* count pipelines have been handed out. One pipeline per vkCreateGraphicsPipelines
+* call keeps the load balanced when some variants are far more expensive than others.
+*/
+struct _dlu_pipe_job {
+  vkcomp *app;
+  uint32_t cur_gpd;
+  uint32_t count;
+  const VkGraphicsPipelineCreateInfo *infos;
+  uint32_t next;
+  VkResult res; /* first failure */
+  dlu_pipeline_ready_cb cb;
+  void *data;
+  uint32_t thread_count;
+  pthread_t *threads;
+};
+
+VkResult dlu_create_pipeline_with_feedback(vkcomp *app, uint32_t cur_ld, const VkGraphicsPipelineCreateInfo *info, VkPipeline *pipeline) {
+  VkResult res = VK_RESULT_MAX_ENUM;
+  VkGraphicsPipelineCreateInfo pipeline_info = *info;
+
+  VkPipelineCreationFeedbackEXT feedback = {};
+  VkPipelineCreationFeedbackEXT *stage_feedback = (VkPipelineCreationFeedbackEXT *) alloca(info->stageCount * sizeof(VkPipelineCreationFeedbackEXT));
+
+  VkPipelineCreationFeedbackCreateInfoEXT feedback_info = {};
+  feedback_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO_EXT;
+  feedback_info.pNext = NULL;
+  feedback_info.pPipelineCreationFeedback = &feedback;
+  feedback_info.pipelineStageCreationFeedbackCount = info->stageCount;
+  feedback_info.pPipelineStageCreationFeedbacks = stage_feedback;
+
+  if (app->ld_data[cur_ld].pipe_feedback && !pipeline_info.pNext)
+    pipeline_info.pNext = &feedback_info;
+
+  res = vkCreateGraphicsPipelines(app->ld_data[cur_ld].device, app->gp_cache.pipe_cache, 1, &pipeline_info, NULL, pipeline);
+  if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkCreateGraphicsPipelines"); return res; }
+
+  if (pipeline_info.pNext == &feedback_info) dlu_pipeline_cache_feedback(app, &feedback);
+
+  return res;
+}
+
+VkResult dlu_create_compute_pipelines(
+  vkcomp *app,
+  uint32_t cur_gpd,
+  uint32_t count,
+  const VkPipelineShaderStageCreateInfo *pStages,
+  VkPipelineCreateFlags flags
+) {
+
+  VkResult res = VK_RESULT_MAX_ENUM;
+
+  if (!app->gp_data) { PERR(DLU_BUFF_NOT_ALLOC, 0, "DLU_GP_DATA"); return res; }
+  if (!app->gp_data[cur_gpd].pipeline_layout) { PERR(DLU_VKCOMP_PIPELINE_LAYOUT, 0, NULL); return res; }
+  if (app->gp_data[cur_gpd].compute_pipelines) { PERR(DLU_ALREADY_ALLOC, 0, NULL); return res; }
+
+  app->gp_data[cur_gpd].compute_pipelines = calloc(count, sizeof(VkPipeline));
+  if (!app->gp_data[cur_gpd].compute_pipelines) {
+    dlu_log_me(DLU_DANGER, "[x] calloc: %s", strerror(errno));
+    return res;
+  }
+
+  app->gp_data[cur_gpd].cpc = count;
+
+  VkPipelineCreationFeedbackEXT feedback = {};
+  VkPipelineCreationFeedbackEXT stage_feedback = {};
+
+  VkPipelineCreationFeedbackCreateInfoEXT feedback_info = {};
+  feedback_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO_EXT;
+  feedback_info.pNext = NULL;
+  feedback_info.pPipelineCreationFeedback = &feedback;
+  feedback_info.pipelineStageCreationFeedbackCount = 1;
+  feedback_info.pPipelineStageCreationFeedbacks = &stage_feedback;
+
+  VkComputePipelineCreateInfo pipeline_info = {};
+  pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+  pipeline_info.pNext = (app->ld_data[app->gp_data[cur_gpd].ldi].pipe_feedback) ? &feedback_info : NULL;
+  pipeline_info.flags = flags;
+  pipeline_info.layout = app->gp_data[cur_gpd].pipeline_layout;
+  pipeline_info.basePipelineHandle = VK_NULL_HANDLE;
+  pipeline_info.basePipelineIndex = -1;
+
+  /* One at a time so each pipeline gets its own cache hit/miss feedback */
+  for (uint32_t i = 0; i < count; i++) {
+    pipeline_info.stage = pStages[i];
+
+    res = vkCreateComputePipelines(app->ld_data[app->gp_data[cur_gpd].ldi].device, app->gp_cache.pipe_cache, 1,
+                                   &pipeline_info, NULL, &app->gp_data[cur_gpd].compute_pipelines[i]);
+    if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkCreateComputePipelines"); return res; }
+
+    if (pipeline_info.pNext) dlu_pipeline_cache_feedback(app, &feedback);
+  }
+
+  return res;
+}
+
+/* Fill in defaults from the gp_data slot and make sure there's room for count pipelines */
+static VkResult prep_infos(vkcomp *app, uint32_t cur_gpd, uint32_t count, VkGraphicsPipelineCreateInfo *infos) {
+  VkResult res = VK_RESULT_MAX_ENUM;
+
+  if (!app->gp_data) { PERR(DLU_BUFF_NOT_ALLOC, 0, "DLU_GP_DATA"); return res; }
+  if (!app->gp_data[cur_gpd].graphics_pipelines) { PERR(DLU_BUFF_NOT_ALLOC, 0, "DLU_GP_DATA_MEMS"); return res; }
+  if (app->gp_data[cur_gpd].ldi == UINT32_MAX) { PERR(DLU_VKCOMP_DEVICE_NOT_ASSOC, 0, "dlu_create_pipeline_layout()"); return res; }
+  if (app->gp_data[cur_gpd].job) { PERR(DLU_OP_NOT_PERMITED, 0, NULL); return res; }
+  if (count > app->gp_data[cur_gpd].gpc) { PERR(DLU_OP_NOT_PERMITED, 0, NULL); return res; }
+
+  for (uint32_t i = 0; i < count; i++) {
+    if (!infos[i].layout) infos[i].layout = app->gp_data[cur_gpd].pipeline_layout;
+    if (!infos[i].renderPass) infos[i].renderPass = app->gp_data[cur_gpd].render_pass;
+    if (!infos[i].layout) { PERR(DLU_VKCOMP_PIPELINE_LAYOUT, 0, NULL); return res; }
+    if (!infos[i].renderPass) { PERR(DLU_VKCOMP_RENDER_PASS, 0, NULL); return res; }
+  }
+
+  return VK_SUCCESS;
+}
+
+VkResult dlu_create_graphics_pipelines_batch(
+  vkcomp *app,
+  uint32_t cur_gpd,
+  uint32_t count,
+  VkGraphicsPipelineCreateInfo *infos
+) {
+
+  VkResult res = prep_infos(app, cur_gpd, count, infos);
+  if (res) return res;
+
+  if (!app->ld_data[app->gp_data[cur_gpd].ldi].pipe_feedback) {
+    res = vkCreateGraphicsPipelines(app->ld_data[app->gp_data[cur_gpd].ldi].device, app->gp_cache.pipe_cache, count, infos, NULL, app->gp_data[cur_gpd].graphics_pipelines);
+    if (res) PERR(DLU_VK_FUNC_ERR, res, "vkCreateGraphicsPipelines")
+    return res;
+  }
+
+  /**
+  * Still one call, every create info gets its own feedback chained in.
+  * Infos that already carry a pNext chain are left alone, same as dlu_create_pipeline_with_feedback()
+  */
+  uint32_t stagec = 0;
+  for (uint32_t i = 0; i < count; i++) stagec += infos[i].stageCount;
+
+  size_t bytes = count * (sizeof(VkGraphicsPipelineCreateInfo) + sizeof(VkPipelineCreationFeedbackCreateInfoEXT) +
+                          sizeof(VkPipelineCreationFeedbackEXT)) + stagec * sizeof(VkPipelineCreationFeedbackEXT);
+  VkGraphicsPipelineCreateInfo *batch = calloc(1, bytes);
+  if (!batch) { dlu_log_me(DLU_DANGER, "[x] calloc: %s", strerror(errno)); return VK_RESULT_MAX_ENUM; }
+
+  VkPipelineCreationFeedbackCreateInfoEXT *feedback_info = (VkPipelineCreationFeedbackCreateInfoEXT *) (batch + count);
+  VkPipelineCreationFeedbackEXT *feedback = (VkPipelineCreationFeedbackEXT *) (feedback_info + count);
+  VkPipelineCreationFeedbackEXT *stage_feedback = feedback + count;
+
+  for (uint32_t i = 0; i < count; i++) {
+    batch[i] = infos[i];
+    feedback_info[i].sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO_EXT;
+    feedback_info[i].pNext = NULL;
+    feedback_info[i].pPipelineCreationFeedback = &feedback[i];
+    feedback_info[i].pipelineStageCreationFeedbackCount = infos[i].stageCount;
+    feedback_info[i].pPipelineStageCreationFeedbacks = stage_feedback;
+    stage_feedback += infos[i].stageCount;
+    if (!batch[i].pNext) batch[i].pNext = &feedback_info[i];
+  }
+
+  res = vkCreateGraphicsPipelines(app->ld_data[app->gp_data[cur_gpd].ldi].device, app->gp_cache.pipe_cache, count, batch, NULL, app->gp_data[cur_gpd].graphics_pipelines);
+  if (res) { PERR(DLU_VK_FUNC_ERR, res, "vkCreateGraphicsPipelines"); free(batch); return res; }
+
+  for (uint32_t i = 0; i < count; i++)
+    if (batch[i].pNext == &feedback_info[i]) dlu_pipeline_cache_feedback(app, &feedback[i]);
+
+  free(batch);
+  return res;
+}
+
+static void *pipe_worker(void *arg) {
+  struct _dlu_pipe_job *job = arg;
+  struct _gp_data *gp_data = &job->app->gp_data[job->cur_gpd];
+  uint32_t idx = 0;
+
+  while ((idx = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED)) < job->count) {
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkResult expected = VK_SUCCESS;
+    VkResult res = dlu_create_pipeline_with_feedback(job->app, gp_data->ldi, &job->infos[idx], &pipeline);
+
+    if (res) __atomic_compare_exchange_n(&job->res, &expected, res, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+
+    /* Pairs with the acquire in dlu_get_graphics_pipeline() */
+    __atomic_store_n(&gp_data->graphics_pipelines[idx], pipeline, __ATOMIC_RELEASE);
+
+    if (job->cb) job->cb(job->app, job->cur_gpd, idx, res, job->data);
+  }
+
+  return NULL;
+}
+
+VkResult dlu_create_graphics_pipelines_async(
+  vkcomp *app,
+  uint32_t cur_gpd,
+  uint32_t count,
+  VkGraphicsPipelineCreateInfo *infos,
+  uint32_t thread_count,
+  dlu_pipeline_ready_cb cb,
+  void *data
+) {
+
+  VkResult res = prep_infos(app, cur_gpd, count, infos);
+  struct _dlu_pipe_job *job = NULL;
+  int err = 0;
+
+  if (res || !count) return res;
+
+  if (!thread_count) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    thread_count = (cpus > 0) ? (uint32_t) cpus : 1;
+  }
+
+  /* No point in spawning threads that won't have any work */
+  if (thread_count > count) thread_count = count;
+
+  job = calloc(1, sizeof(struct _dlu_pipe_job));
+  if (!job) { dlu_log_me(DLU_DANGER, "[x] calloc: %s", strerror(errno)); return VK_RESULT_MAX_ENUM; }
+
+  job->threads = calloc(thread_count, sizeof(pthread_t));
+  if (!job->threads) { dlu_log_me(DLU_DANGER, "[x] calloc: %s", strerror(errno)); free(job); return VK_RESULT_MAX_ENUM; }
+
+  job->app = app;
+  job->cur_gpd = cur_gpd;
+  job->count = count;
+  job->infos = infos;
+  job->res = VK_SUCCESS;
+  job->cb = cb;
+  job->data = data;
+
+  for (uint32_t i = 0; i < count; i++)
+    app->gp_data[cur_gpd].graphics_pipelines[i] = VK_NULL_HANDLE;
+
+  for (uint32_t i = 0; i < thread_count; i++) {
+    err = pthread_create(&job->threads[i], NULL, pipe_worker, job);
+    if (err) { dlu_log_me(DLU_DANGER, "[x] pthread_create: %s", strerror(err)); break; }
+    job->thread_count++;
+  }
+
+  app->gp_data[cur_gpd].job = job;
+
+  /* Remaining workers still drain the queue, only fail if none could be started */
+  if (!job->thread_count) {
+    dlu_wait_graphics_pipelines(app, cur_gpd);
+    return VK_RESULT_MAX_ENUM;
+  }
+
+  return VK_SUCCESS;
+}
+
+VkResult dlu_create_graphics_pipelines_parallel(
+  vkcomp *app,
+  uint32_t cur_gpd,
+  uint32_t count,
+  VkGraphicsPipelineCreateInfo *infos,
+  uint32_t thread_count
+) {
+
+  VkResult res = dlu_create_graphics_pipelines_async(app, cur_gpd, count, infos, thread_count, NULL, NULL);
+  if (res) return res;
+
+  return dlu_wait_graphics_pipelines(app, cur_gpd);
+}
+
+VkResult dlu_wait_graphics_pipelines(vkcomp *app, uint32_t cur_gpd) {
+  struct _dlu_pipe_job *job = app->gp_data[cur_gpd].job;
+  VkResult res = VK_SUCCESS;
+
+  if (!job) return res;
+
+  for (uint32_t i = 0; i < job->thread_count; i++)
+    pthread_join(job->threads[i], NULL);
+
+  res = job->res;
+  app->gp_data[cur_gpd].job = NULL;
+
+  free(job->threads);
+  free(job);
+
+  return res;
+}
+
+VkPipeline dlu_get_graphics_pipeline(vkcomp *app, uint32_t cur_gpd, uint32_t index, VkPipeline fallback) {
+  VkPipeline pipeline = __atomic_load_n(&app->gp_data[cur_gpd].graphics_pipelines[index], __ATOMIC_ACQUIRE);
+  return (pipeline) ? pipeline : fallback;
+}
@@ -31,8 +31,21 @@ vkcomp *dlu_init_vk() {
   return app;
 }
 
+/* Graphics, compute and transfer queues may all still be running work that uses what's about to be destroyed */
+static void wait_devices_idle(vkcomp *app) {
+  if (!app->ld_data) return;
+
+  for (uint32_t i = 0; i < app->ldc; i++) {
+    if (!app->ld_data[i].device) continue;
+    VkResult res = vkDeviceWaitIdle(app->ld_data[i].device);
+    if (res) PERR(DLU_VK_FUNC_ERR, res, "vkDeviceWaitIdle")
+  }
+}
+
 void dlu_freeup_sc(vkcomp *app) {
 
+  wait_devices_idle(app);
+
   /* destory all uniform buffers */
   if (app->buff_data) {
     for (uint32_t i = 0; i < app->bdc; i++) {
@@ -63,39 +76,43 @@ void dlu_freeup_sc(vkcomp *app) {
     }
   }
 
-  if (app->gp_cache.pipe_cache) {
-    vkDestroyPipelineCache(app->ld_data[app->gp_cache.ldi].device, app->gp_cache.pipe_cache, NULL);
-    app->gp_cache.pipe_cache = VK_NULL_HANDLE;
-  }
+  /* The pipeline cache outlives swap chains, dlu_freeup_vk() saves and destroys it */
 
   if (app->gp_data) {
     for (uint32_t i = 0; i < app->gdc; i++) {
+      dlu_wait_graphics_pipelines(app, i);
       if (app->gp_data[i].pipeline_layout) {
-        vkDestroyPipelineLayout(app->ld_data[app->gp_data[i].ldi].device, app->gp_data[i].pipeline_layout, NULL);
+        if (!dlu_cache_release_pipeline_layout(app, app->gp_data[i].pipeline_layout)) {
+          dlu_cache_evict_pipeline_layout(app, app->gp_data[i].pipeline_layout);
+          vkDestroyPipelineLayout(app->ld_data[app->gp_data[i].ldi].device, app->gp_data[i].pipeline_layout, NULL);
+        }
         app->gp_data[i].pipeline_layout = VK_NULL_HANDLE;
       }
-      if (app->gp_data[i].render_pass) {
-        vkDestroyRenderPass(app->ld_data[app->gp_data[i].ldi].device, app->gp_data[i].render_pass, NULL);
-        app->gp_data[i].render_pass = VK_NULL_HANDLE;
-      }
+      /* Render passes are owned by the render pass cache, recreating one with the same description is a lookup */
+      app->gp_data[i].render_pass = VK_NULL_HANDLE;
       for (uint32_t j = 0; j < app->gp_data[i].gpc; j++) {
         if (app->gp_data[i].graphics_pipelines[j]) {
-          vkDestroyPipeline(app->ld_data[app->gp_data[i].ldi].device, app->gp_data[i].graphics_pipelines[j], NULL);
+          if (!dlu_cache_evict_pipeline(app, app->gp_data[i].graphics_pipelines[j]))
+            vkDestroyPipeline(app->ld_data[app->gp_data[i].ldi].device, app->gp_data[i].graphics_pipelines[j], NULL);
           app->gp_data[i].graphics_pipelines[j] = VK_NULL_HANDLE;
         }
       }
+      for (uint32_t j = 0; j < app->gp_data[i].cpc; j++)
+        vkDestroyPipeline(app->ld_data[app->gp_data[i].ldi].device, app->gp_data[i].compute_pipelines[j], NULL);
+      free(app->gp_data[i].compute_pipelines);
+      app->gp_data[i].compute_pipelines = NULL;
+      app->gp_data[i].cpc = 0;
     }
   }
 
   if (app->sc_data) {
     for (uint32_t i = 0; i < app->sdc; i++) {
+      dlu_freeup_headless_target(app, i);
       if (app->sc_data[i].sc_buffs) {
         for (uint32_t j = 0; j < app->sc_data[i].sic; j++) {
-          if (app->sc_data[i].sc_buffs[j].fb) {
-            vkDestroyFramebuffer(app->ld_data[app->sc_data[i].ldi].device, app->sc_data[i].sc_buffs[j].fb, NULL);
-            app->sc_data[i].sc_buffs[j].fb = VK_NULL_HANDLE;
-          }
           if (app->sc_data[i].sc_buffs[j].view) {
+            /* Framebuffers are owned by the framebuffer cache, drop those referencing this view */
+            dlu_cache_evict_image_view(app, app->sc_data[i].sc_buffs[j].view);
             vkDestroyImageView(app->ld_data[app->sc_data[i].ldi].device, app->sc_data[i].sc_buffs[j].view, NULL);
             app->sc_data[i].sc_buffs[j].view = VK_NULL_HANDLE;
           }
@@ -106,6 +123,8 @@ void dlu_freeup_sc(vkcomp *app) {
         }
       }
 
+      dlu_retire_swap_chains(app, i, VK_TRUE);
+
       if (app->sc_data[i].swap_chain) {
         vkDestroySwapchainKHR(app->ld_data[app->sc_data[i].ldi].device, app->sc_data[i].swap_chain, NULL);
         app->sc_data[i].swap_chain = VK_NULL_HANDLE;
@@ -116,14 +135,34 @@ void dlu_freeup_sc(vkcomp *app) {
 
 void dlu_freeup_vk(vkcomp *app) {
 
-  /* Synchronous wait for present queue to empty. So that all objects can be properly destroyed */
-  for (uint32_t i = 0; i < app->ldc; i++)
-    if (app->ld_data[i].graphics)
-      vkQueueWaitIdle(app->ld_data[i].graphics);
+  /* Async compile workers use the pipeline cache, join them before it's saved and destroyed */
+  if (app->gp_data)
+    for (uint32_t i = 0; i < app->gdc; i++)
+      dlu_wait_graphics_pipelines(app, i);
+
+  /* Synchronous wait for every queue to empty. So that all objects can be properly destroyed */
+  wait_devices_idle(app);
 
   if (app->debug_utils_msg)
     app->dbg_destroy_utils_msg(app->instance, app->debug_utils_msg, NULL);
 
+  /* Destroys every pool chained by the descriptor allocator */
+  dlu_freeup_desc_allocator(app);
+
+  /* Destroys the bindless texture table, textures themselves are destroyed below */
+  dlu_freeup_bindless_table(app);
+
+  /* Destroys the GPU profiler's query pools */
+  dlu_freeup_gpu_profiler(app);
+
+  /* Destroys the compute compositor's pipeline and buffers */
+  dlu_freeup_compositor(app);
+
+  /* Queues are idle, everything waiting in the deferred destruction queues can go */
+  for (uint32_t i = 0; i < app->ldc; i++)
+    if (app->ld_data[i].device)
+      dlu_freeup_deferred(app, i);
+
   if (app->cmd_data) {
     for (uint32_t i = 0; i < app->cdc; i++) {
       if (app->cmd_data[i].cmd_pool)
@@ -131,12 +170,16 @@ void dlu_freeup_vk(vkcomp *app) {
     }
   }
 
-  if (app->gp_cache.pipe_cache)
+  if (app->gp_cache.pipe_cache) {
+    dlu_save_pipeline_cache(app);
     vkDestroyPipelineCache(app->ld_data[app->gp_cache.ldi].device, app->gp_cache.pipe_cache, NULL);
+  }
+
+  free(app->gp_cache.path);
  
   if (app->text_data) {
     for (uint32_t i = 0; i < app->tdc; i++) {
-      if (app->text_data[i].sampler)
+      if (app->text_data[i].sampler && !dlu_cache_release_sampler(app, app->text_data[i].sampler))
         vkDestroySampler(app->ld_data[app->text_data[i].ldi].device, app->text_data[i].sampler, NULL);
       if (app->text_data[i].view)
         vkDestroyImageView(app->ld_data[app->text_data[i].ldi].device, app->text_data[i].view, NULL);
@@ -149,12 +192,14 @@ void dlu_freeup_vk(vkcomp *app) {
 
   if (app->gp_data) {
     for (uint32_t i = 0; i < app->gdc; i++) {
-      if (app->gp_data[i].pipeline_layout)
+      if (app->gp_data[i].pipeline_layout && !dlu_cache_release_pipeline_layout(app, app->gp_data[i].pipeline_layout))
         vkDestroyPipelineLayout(app->ld_data[app->gp_data[i].ldi].device, app->gp_data[i].pipeline_layout, NULL);
-      if (app->gp_data[i].render_pass)
-        vkDestroyRenderPass(app->ld_data[app->gp_data[i].ldi].device, app->gp_data[i].render_pass, NULL);
       for (uint32_t j = 0; j < app->gp_data[i].gpc; j++)
-        vkDestroyPipeline(app->ld_data[app->gp_data[i].ldi].device, app->gp_data[i].graphics_pipelines[j], NULL);
+        if (app->gp_data[i].graphics_pipelines[j] && !dlu_cache_evict_pipeline(app, app->gp_data[i].graphics_pipelines[j]))
+          vkDestroyPipeline(app->ld_data[app->gp_data[i].ldi].device, app->gp_data[i].graphics_pipelines[j], NULL);
+      for (uint32_t j = 0; j < app->gp_data[i].cpc; j++)
+        vkDestroyPipeline(app->ld_data[app->gp_data[i].ldi].device, app->gp_data[i].compute_pipelines[j], NULL);
+      free(app->gp_data[i].compute_pipelines);
     }
   }
 
@@ -162,7 +207,10 @@ void dlu_freeup_vk(vkcomp *app) {
     for (uint32_t i = 0; i < app->ddc; i++) {
       if (app->desc_data[i].layouts) {
         for (uint32_t j = 0; j < app->desc_data[i].dlsc; j++) {
-          if (app->desc_data[i].layouts[j])
+          if (app->desc_data[i].tmpl_entries) free(app->desc_data[i].tmpl_entries[j].entries);
+          if (app->desc_data[i].templates && app->desc_data[i].templates[j] && app->ld_data[app->desc_data[i].ldi].destroy_desc_template)
+            app->ld_data[app->desc_data[i].ldi].destroy_desc_template(app->ld_data[app->desc_data[i].ldi].device, app->desc_data[i].templates[j], NULL);
+          if (app->desc_data[i].layouts[j] && !dlu_cache_release_desc_set_layout(app, app->desc_data[i].layouts[j]))
             vkDestroyDescriptorSetLayout(app->ld_data[app->desc_data[i].ldi].device, app->desc_data[i].layouts[j], NULL);
         }
       }
@@ -171,6 +219,9 @@ void dlu_freeup_vk(vkcomp *app) {
     }
   }
 
+  /* Destroys all cached objects, including those still referenced */
+  dlu_cache_freeup(app);
+
   if (app->buff_data) {
     for (uint32_t i = 0; i < app->bdc; i++) {
       if (app->buff_data[i].buff)
@@ -182,22 +233,35 @@ void dlu_freeup_vk(vkcomp *app) {
 
   if (app->sc_data) { /* Annihilate All Swap Chain Objects */
     for (uint32_t i = 0; i < app->sdc; i++) {
+      dlu_freeup_headless_target(app, i);
+      dlu_retire_swap_chains(app, i, VK_TRUE);
       if (app->sc_data[i].depth.view)
         vkDestroyImageView(app->ld_data[app->sc_data[i].ldi].device, app->sc_data[i].depth.view, NULL);
       if (app->sc_data[i].depth.image)
         vkDestroyImage(app->ld_data[app->sc_data[i].ldi].device, app->sc_data[i].depth.image, NULL);
       if (app->sc_data[i].depth.mem)
         vkFreeMemory(app->ld_data[app->sc_data[i].ldi].device, app->sc_data[i].depth.mem, NULL);
+      if (app->sc_data[i].trans) {
+        for (uint32_t j = 0; j < app->sc_data[i].tac; j++) {
+          if (app->sc_data[i].trans[j].view)
+            vkDestroyImageView(app->ld_data[app->sc_data[i].ldi].device, app->sc_data[i].trans[j].view, NULL);
+          if (app->sc_data[i].trans[j].image)
+            vkDestroyImage(app->ld_data[app->sc_data[i].ldi].device, app->sc_data[i].trans[j].image, NULL);
+        }
+        free(app->sc_data[i].trans);
+      }
+      if (app->sc_data[i].trans_mem)
+        vkFreeMemory(app->ld_data[app->sc_data[i].ldi].device, app->sc_data[i].trans_mem, NULL);
       if (app->sc_data[i].sc_buffs && app->sc_data[i].syncs) {
         for (uint32_t j = 0; j < app->sc_data[i].sic; j++) {
           if (app->sc_data[i].syncs[j].sem.image)
             vkDestroySemaphore(app->ld_data[app->sc_data[i].ldi].device, app->sc_data[i].syncs[j].sem.image, NULL);
           if (app->sc_data[i].syncs[j].sem.render)
             vkDestroySemaphore(app->ld_data[app->sc_data[i].ldi].device, app->sc_data[i].syncs[j].sem.render, NULL);
+          if (app->sc_data[i].syncs[j].sem.compute)
+            vkDestroySemaphore(app->ld_data[app->sc_data[i].ldi].device, app->sc_data[i].syncs[j].sem.compute, NULL);
           if (app->sc_data[i].syncs[j].fence.render)
             vkDestroyFence(app->ld_data[app->sc_data[i].ldi].device, app->sc_data[i].syncs[j].fence.render, NULL);
-          if (app->sc_data[i].sc_buffs[j].fb)
-            vkDestroyFramebuffer(app->ld_data[app->sc_data[i].ldi].device, app->sc_data[i].sc_buffs[j].fb, NULL);
           if (app->sc_data[i].sc_buffs[j].view)
             vkDestroyImageView(app->ld_data[app->sc_data[i].ldi].device, app->sc_data[i].sc_buffs[j].view, NULL);
         }
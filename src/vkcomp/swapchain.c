@@ -0,0 +1,301 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright (c) 2019-2020 Vincent Davis Jr.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*/
+
+#define LUCUR_VKCOMP_API
+#include <lucom.h>
+
+/* Everything of one sc_data that depends on the swapchain, moved aside before rebuilding */
+struct sc_snapshot {
+  VkFormat format;
+  uint32_t sic;
+  VkImageView *views;
+  VkFramebuffer *fbs;
+  VkImageView depth;
+  uint32_t tac;
+  VkImageView *trans;
+};
+
+static bool retired_push(vkcomp *app, uint32_t cur_scd, struct sc_snapshot *snap) {
+  struct _sc_data *sc = &app->sc_data[cur_scd];
+  struct _retired_sc *retired = NULL;
+
+  retired = realloc(sc->retired, (sc->rsc + 1) * sizeof(struct _retired_sc));
+  if (!retired) { dlu_log_me(DLU_DANGER, "[x] realloc: %s", strerror(errno)); return false; }
+  sc->retired = retired;
+
+  retired = &sc->retired[sc->rsc];
+  memset(retired, 0, sizeof(struct _retired_sc));
+
+  retired->views = calloc(snap->sic + 1 + snap->tac, sizeof(VkImageView));
+  retired->images = calloc(1 + snap->tac, sizeof(VkImage));
+  if (!retired->views || !retired->images) {
+    dlu_log_me(DLU_DANGER, "[x] calloc: %s", strerror(errno));
+    free(retired->views); free(retired->images);
+    return false;
+  }
+
+  retired->swap_chain = sc->swap_chain;
+
+  /* Swapchain images belong to the swapchain, only their views need destroying */
+  for (uint32_t i = 0; i < snap->sic; i++)
+    if (snap->views[i]) retired->views[retired->viewc++] = snap->views[i];
+
+  /* Creation infos stay behind so the attachments can be rebuilt at the new size */
+  if (sc->depth.image) {
+    retired->views[retired->viewc++] = sc->depth.view;
+    retired->images[retired->imgc++] = sc->depth.image;
+    retired->mems[0] = sc->depth.mem;
+    sc->depth.image = VK_NULL_HANDLE;
+    sc->depth.view = VK_NULL_HANDLE;
+    sc->depth.mem = VK_NULL_HANDLE;
+  }
+
+  for (uint32_t i = 0; i < snap->tac; i++) {
+    retired->views[retired->viewc++] = sc->trans[i].view;
+    retired->images[retired->imgc++] = sc->trans[i].image;
+    sc->trans[i].view = VK_NULL_HANDLE;
+    sc->trans[i].image = VK_NULL_HANDLE;
+  }
+  retired->mems[1] = sc->trans_mem;
+  sc->trans_mem = VK_NULL_HANDLE;
+
+  sc->rsc++;
+  return true;
+}
+
+static void retired_destroy(vkcomp *app, uint32_t cur_scd, uint32_t idx) {
+  struct _sc_data *sc = &app->sc_data[cur_scd];
+  struct _retired_sc *retired = &sc->retired[idx];
+  VkDevice device = app->ld_data[sc->ldi].device;
+
+  for (uint32_t i = 0; i < retired->viewc; i++) {
+    dlu_cache_evict_image_view(app, retired->views[i]);
+    vkDestroyImageView(device, retired->views[i], NULL);
+  }
+
+  for (uint32_t i = 0; i < retired->imgc; i++)
+    vkDestroyImage(device, retired->images[i], NULL);
+
+  for (uint32_t i = 0; i < ARR_LEN(retired->mems); i++)
+    if (retired->mems[i]) vkFreeMemory(device, retired->mems[i], NULL);
+
+  vkDestroySwapchainKHR(device, retired->swap_chain, NULL);
+
+  free(retired->views);
+  free(retired->images);
+  *retired = sc->retired[--sc->rsc];
+}
+
+uint32_t dlu_retire_swap_chains(vkcomp *app, uint32_t cur_scd, VkBool32 force) {
+  struct _sc_data *sc = &app->sc_data[cur_scd];
+
+  if (!sc->rsc) return 0;
+
+  /**
+  * Render fences signal in submission order, once all of them are signaled
+  * nothing recorded against a retired swapchain can still be executing
+  */
+  if (!force && sc->syncs) {
+    for (uint32_t i = 0; i < sc->sbc; i++) {
+      if (!sc->syncs[i].fence.render) continue;
+      if (vkGetFenceStatus(app->ld_data[sc->ldi].device, sc->syncs[i].fence.render) != VK_SUCCESS)
+        return sc->rsc;
+    }
+  }
+
+  while (sc->rsc)
+    retired_destroy(app, cur_scd, sc->rsc - 1);
+
+  free(sc->retired);
+  sc->retired = NULL;
+
+  return 0;
+}
+
+/* Rebuild the depth buffer and transient attachments at the new extent */
+static VkResult rebuild_attachments(vkcomp *app, uint32_t cur_scd, VkExtent2D extent) {
+  VkResult res = VK_SUCCESS;
+  struct _sc_data *sc = &app->sc_data[cur_scd];
+
+  if (sc->depth.img_info.sType) {
+    VkImageCreateInfo img_info = sc->depth.img_info;
+    VkImageViewCreateInfo view_info = sc->depth.view_info;
+    VkMemoryPropertyFlags mem_flags = sc->depth.mem_flags;
+
+    img_info.extent.width = extent.width;
+    img_info.extent.height = extent.height;
+
+    res = dlu_create_depth_buff(app, cur_scd, &img_info, &view_info, mem_flags);
+    if (res) return res;
+  }
+
+  if (sc->trans) {
+    uint32_t count = sc->tac;
+    VkImageCreateInfo *img_infos = alloca(count * sizeof(VkImageCreateInfo));
+    VkImageViewCreateInfo *ivis = alloca(count * sizeof(VkImageViewCreateInfo));
+    uint32_t *alias_groups = alloca(count * sizeof(uint32_t));
+
+    for (uint32_t i = 0; i < count; i++) {
+      img_infos[i] = sc->trans[i].img_info;
+      img_infos[i].extent.width = extent.width;
+      img_infos[i].extent.height = extent.height;
+      ivis[i] = sc->trans[i].view_info;
+      alias_groups[i] = sc->trans[i].alias;
+    }
+
+    free(sc->trans);
+    sc->trans = NULL;
+    sc->tac = 0;
+
+    res = dlu_create_transient_attachments(app, cur_scd, count, img_infos, ivis, alias_groups);
+  }
+
+  return res;
+}
+
+/* Swap a view of the old swapchain generation for its replacement */
+static VkImageView remap_view(vkcomp *app, uint32_t cur_scd, struct sc_snapshot *snap, uint32_t img, VkImageView view) {
+  struct _sc_data *sc = &app->sc_data[cur_scd];
+
+  for (uint32_t i = 0; i < snap->sic; i++)
+    if (view == snap->views[i]) return sc->sc_buffs[img].view;
+
+  if (view && view == snap->depth) return sc->depth.view;
+
+  for (uint32_t i = 0; i < snap->tac && i < sc->tac; i++)
+    if (view == snap->trans[i]) return sc->trans[i].view;
+
+  return view;
+}
+
+/* Recreate the swapchain framebuffers with the same render pass and attachments, against the new views */
+static VkResult rebuild_framebuffers(vkcomp *app, uint32_t cur_scd, struct sc_snapshot *snap) {
+  VkResult res = VK_SUCCESS;
+  struct _sc_data *sc = &app->sc_data[cur_scd];
+  struct _fb_cache_entry *tmpl = NULL;
+
+  /* Any old framebuffer describes the layout, they only differ by the swapchain view */
+  for (uint32_t i = 0; i < snap->sic && !tmpl; i++) {
+    if (!snap->fbs[i]) continue;
+    for (uint32_t j = 0; j < app->fb_cache.count; j++)
+      if (app->fb_cache.entries[j].fb == snap->fbs[i]) { tmpl = &app->fb_cache.entries[j]; break; }
+  }
+
+  if (!tmpl) return res;
+
+  uint32_t attc = tmpl->attc;
+  VkImageView *old_views = alloca(attc * sizeof(VkImageView));
+  VkImageView *views = alloca(attc * sizeof(VkImageView));
+  memcpy(old_views, tmpl->views, attc * sizeof(VkImageView));
+
+  VkFramebufferCreateInfo create_info = {};
+  create_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+  create_info.pNext = NULL;
+  create_info.flags = tmpl->flags;
+  create_info.renderPass = tmpl->render_pass;
+  create_info.attachmentCount = attc;
+  create_info.pAttachments = views;
+  create_info.width = sc->extent.width;
+  create_info.height = sc->extent.height;
+  create_info.layers = tmpl->layers;
+
+  /* tmpl points into fb_cache.entries, which dlu_cache_framebuffer() may realloc */
+  tmpl = NULL;
+
+  for (uint32_t i = 0; i < sc->sic; i++) {
+    for (uint32_t j = 0; j < attc; j++)
+      views[j] = remap_view(app, cur_scd, snap, i, old_views[j]);
+
+    res = dlu_cache_framebuffer(app, sc->ldi, &create_info, &sc->sc_buffs[i].fb);
+    if (res) return res;
+  }
+
+  return res;
+}
+
+VkResult dlu_recreate_swap_chain(
+  vkcomp *app,
+  uint32_t cur_scd,
+  VkSwapchainCreateInfoKHR *create_info,
+  VkImageViewCreateInfo *ivi,
+  VkBool32 *format_changed
+) {
+
+  VkResult res = VK_RESULT_MAX_ENUM;
+  struct _sc_data *sc = NULL;
+  struct sc_snapshot snap = {};
+
+  if (!app->sc_data) { PERR(DLU_BUFF_NOT_ALLOC, 0, "DLU_SC_DATA"); return res; }
+
+  sc = &app->sc_data[cur_scd];
+  if (!sc->swap_chain) { PERR(DLU_VKCOMP_SC, 0, NULL); return res; }
+
+  /* Opportunistically drop generations from earlier resizes */
+  dlu_retire_swap_chains(app, cur_scd, VK_FALSE);
+
+  snap.format = sc->format;
+  snap.sic = sc->sic;
+  snap.views = alloca(sc->sic * sizeof(VkImageView));
+  snap.fbs = alloca(sc->sic * sizeof(VkFramebuffer));
+  snap.depth = sc->depth.view;
+  snap.tac = sc->tac;
+  snap.trans = alloca((sc->tac + 1) * sizeof(VkImageView));
+
+  for (uint32_t i = 0; i < sc->sic; i++) {
+    snap.views[i] = sc->sc_buffs[i].view;
+    snap.fbs[i] = sc->sc_buffs[i].fb;
+  }
+
+  for (uint32_t i = 0; i < sc->tac; i++)
+    snap.trans[i] = sc->trans[i].view;
+
+  if (!retired_push(app, cur_scd, &snap)) return res;
+
+  /* Lets the driver hand over resources and keep presenting the old images until the new ones are ready */
+  create_info->oldSwapchain = sc->swap_chain;
+
+  for (uint32_t i = 0; i < sc->sbc; i++) {
+    sc->sc_buffs[i].view = VK_NULL_HANDLE;
+    sc->sc_buffs[i].fb = VK_NULL_HANDLE;
+  }
+
+  /* On failure the retired swapchain is still destroyed later, the slot is left without one */
+  sc->swap_chain = VK_NULL_HANDLE;
+  res = dlu_create_swap_chain(app, sc->ldi, cur_scd, create_info, ivi);
+  create_info->oldSwapchain = VK_NULL_HANDLE;
+  if (res) return res;
+
+  res = rebuild_attachments(app, cur_scd, sc->extent);
+  if (res) return res;
+
+  if (format_changed) *format_changed = (sc->format != snap.format);
+
+  /* Render passes built for another format aren't compatible, caller rebuilds those first */
+  if (sc->format == snap.format)
+    res = rebuild_framebuffers(app, cur_scd, &snap);
+
+  dlu_log_me(DLU_SUCCESS, "Swapchain %u recreated at %ux%u", cur_scd, sc->extent.width, sc->extent.height);
+
+  return res;
+}
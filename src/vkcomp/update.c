@@ -61,3 +61,134 @@ void dlu_update_desc_sets(
 
   vkUpdateDescriptorSets(device, descriptorWriteCount, pDescriptorWrites, descriptorCopyCount, pDescriptorCopies);
 }
+
+void dlu_update_desc_sets_ld(
+  vkcomp *app,
+  uint32_t cur_ld,
+  uint32_t descriptorWriteCount,
+  const VkWriteDescriptorSet *pDescriptorWrites,
+  uint32_t descriptorCopyCount,
+  const VkCopyDescriptorSet *pDescriptorCopies
+) {
+
+  DLU_VK(app, cur_ld).UpdateDescriptorSets(app->ld_data[cur_ld].device, descriptorWriteCount, pDescriptorWrites, descriptorCopyCount, pDescriptorCopies);
+}
+
+VkDescriptorUpdateTemplateEntryKHR dlu_write_desc_template_entry(
+  uint32_t dstBinding,
+  uint32_t dstArrayElement,
+  uint32_t descriptorCount,
+  VkDescriptorType descriptorType,
+  size_t offset,
+  size_t stride
+) {
+
+  VkDescriptorUpdateTemplateEntryKHR entry = {};
+  entry.dstBinding = dstBinding;
+  entry.dstArrayElement = dstArrayElement;
+  entry.descriptorCount = descriptorCount;
+  entry.descriptorType = descriptorType;
+  entry.offset = offset;
+  entry.stride = stride;
+
+  return entry;
+}
+
+/* Expands template entries into one write per array element, stride can't be expressed otherwise */
+static void update_desc_entries(struct _ld_data *ld, VkDescriptorSet set, const struct _desc_tmpl *tmpl, const void *data) {
+  uint32_t wcnt = 0;
+  for (uint32_t i = 0; i < tmpl->cnt; i++)
+    wcnt += tmpl->entries[i].descriptorCount;
+
+  /* Called per frame, keep the writes on the stack like the rest of vkcomp */
+  VkWriteDescriptorSet *writes = (VkWriteDescriptorSet *) alloca(wcnt * sizeof(VkWriteDescriptorSet));
+
+  uint32_t w = 0;
+  for (uint32_t i = 0; i < tmpl->cnt; i++) {
+    const VkDescriptorUpdateTemplateEntryKHR *entry = &tmpl->entries[i];
+    for (uint32_t j = 0; j < entry->descriptorCount; j++) {
+      const void *info = (const char *) data + entry->offset + (j * entry->stride);
+      writes[w] = dlu_write_desc_set(set, entry->dstBinding, entry->dstArrayElement + j, 1, entry->descriptorType, NULL, NULL, NULL);
+
+      switch (entry->descriptorType) {
+        case VK_DESCRIPTOR_TYPE_SAMPLER:
+        case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+        case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+        case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+        case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+          writes[w].pImageInfo = info; break;
+        case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+        case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+          writes[w].pTexelBufferView = info; break;
+        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+          writes[w].pBufferInfo = info; break;
+        default:
+          dlu_log_me(DLU_DANGER, "[x] Descriptor type %d has no vkUpdateDescriptorSets fallback", entry->descriptorType);
+          continue;
+      }
+      w++;
+    }
+  }
+
+  ld->vk.UpdateDescriptorSets(ld->device, w, writes, 0, NULL);
+}
+
+void dlu_update_desc_template(vkcomp *app, uint32_t cur_dd, uint32_t cur_dl, VkDescriptorSet set, const void *data) {
+  struct _ld_data *ld = &app->ld_data[app->desc_data[cur_dd].ldi];
+  if (!set) set = app->desc_data[cur_dd].desc_set[cur_dl];
+
+  if (ld->update_desc_template && app->desc_data[cur_dd].templates[cur_dl]) {
+    ld->update_desc_template(ld->device, set, app->desc_data[cur_dd].templates[cur_dl], data);
+    return;
+  }
+
+  if (!app->desc_data[cur_dd].tmpl_entries[cur_dl].entries) {
+    dlu_log_me(DLU_DANGER, "[x] No template for layout %d, call dlu_create_desc_template() first", cur_dl);
+    return;
+  }
+
+  update_desc_entries(ld, set, &app->desc_data[cur_dd].tmpl_entries[cur_dl], data);
+}
+
+void dlu_push_desc_set(
+  vkcomp *app,
+  uint32_t cur_pool,
+  uint32_t cur_buff,
+  uint32_t cur_gpd,
+  VkPipelineBindPoint pipelineBindPoint,
+  uint32_t set,
+  uint32_t descriptorWriteCount,
+  const VkWriteDescriptorSet *pDescriptorWrites
+) {
+
+  if (!app->ld_data[app->cmd_data[cur_pool].ldi].push_desc_set) {
+    dlu_log_me(DLU_DANGER, "[x] %s not enabled on this device", VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+    return;
+  }
+
+  app->ld_data[app->cmd_data[cur_pool].ldi].push_desc_set(app->cmd_data[cur_pool].cmd_buffs[cur_buff], pipelineBindPoint,
+                                                          app->gp_data[cur_gpd].pipeline_layout, set, descriptorWriteCount, pDescriptorWrites);
+}
+
+void dlu_push_desc_template(
+  vkcomp *app,
+  uint32_t cur_pool,
+  uint32_t cur_buff,
+  uint32_t cur_gpd,
+  uint32_t cur_dd,
+  uint32_t cur_dl,
+  uint32_t set,
+  const void *data
+) {
+
+  if (!app->ld_data[app->cmd_data[cur_pool].ldi].push_desc_template || !app->desc_data[cur_dd].templates[cur_dl]) {
+    dlu_log_me(DLU_DANGER, "[x] Push descriptor templates need %s and %s", VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME, VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME);
+    return;
+  }
+
+  app->ld_data[app->cmd_data[cur_pool].ldi].push_desc_template(app->cmd_data[cur_pool].cmd_buffs[cur_buff], app->desc_data[cur_dd].templates[cur_dl],
+                                                               app->gp_data[cur_gpd].pipeline_layout, set, data);
+}
@@ -45,3 +45,26 @@ bool memory_type_from_properties(vkcomp *app, uint32_t pdi, uint32_t typeBits, V
   /* No memory types matched, return failure */
   return false;
 }
+
+/**
+* Unlike memory_type_from_properties() every bit in requirements_mask
+* must be present. Needed when asking for VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT
+* alongside VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT.
+*/
+bool memory_type_from_all_properties(vkcomp *app, uint32_t pdi, uint32_t typeBits, VkFlags requirements_mask, uint32_t *typeIndex) {
+
+  VkPhysicalDeviceMemoryProperties memory_properties;
+  vkGetPhysicalDeviceMemoryProperties(app->pd_data[pdi].phys_dev, &memory_properties);
+
+  for (uint32_t i = 0; i < memory_properties.memoryTypeCount; i++) {
+    if ((typeBits & 1) == 1) {
+      if ((memory_properties.memoryTypes[i].propertyFlags & requirements_mask) == requirements_mask) {
+        *typeIndex = i;
+        return true;
+      }
+    }
+    typeBits >>= 1;
+  }
+
+  return false;
+}
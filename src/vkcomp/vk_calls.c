@@ -30,23 +30,23 @@ VkResult dlu_vk_sync(dlu_sync_type type, vkcomp *app, uint32_t cur_scd, uint32_t
 
   switch (type) {
     case DLU_VK_WAIT_IMAGE_FENCE: /* set render fence to signal state */
-      res = vkWaitForFences(app->ld_data[app->sc_data[cur_scd].ldi].device, 1, &app->sc_data[cur_scd].syncs[synci].fence.image, VK_TRUE, GENERAL_TIMEOUT);
+      res = DLU_SC_VK(app, cur_scd).WaitForFences(app->ld_data[app->sc_data[cur_scd].ldi].device, 1, &app->sc_data[cur_scd].syncs[synci].fence.image, VK_TRUE, GENERAL_TIMEOUT);
       if (res) PERR(DLU_VK_FUNC_ERR, res, "vkWaitForFences")
       break;
     case DLU_VK_WAIT_RENDER_FENCE: /* set image fence to signal state */
-      res = vkWaitForFences(app->ld_data[app->sc_data[cur_scd].ldi].device, 1, &app->sc_data[cur_scd].syncs[synci].fence.render, VK_TRUE, GENERAL_TIMEOUT);
+      res = DLU_SC_VK(app, cur_scd).WaitForFences(app->ld_data[app->sc_data[cur_scd].ldi].device, 1, &app->sc_data[cur_scd].syncs[synci].fence.render, VK_TRUE, GENERAL_TIMEOUT);
       if (res) PERR(DLU_VK_FUNC_ERR, res, "vkWaitForFences")
       break;
     case DLU_VK_WAIT_GRAPHICS_QUEUE:
-      res = vkQueueWaitIdle(app->ld_data[app->sc_data[cur_scd].ldi].graphics);
+      res = DLU_SC_VK(app, cur_scd).QueueWaitIdle(app->ld_data[app->sc_data[cur_scd].ldi].graphics);
       if (res) PERR(DLU_VK_FUNC_ERR, res, "vkQueueWaitIdle") 
       break;
     case DLU_VK_RESET_RENDER_FENCE: /* set fence to unsignaled state */
-      res = vkResetFences(app->ld_data[app->sc_data[cur_scd].ldi].device, 1, &app->sc_data[cur_scd].syncs[synci].fence.render);
+      res = DLU_SC_VK(app, cur_scd).ResetFences(app->ld_data[app->sc_data[cur_scd].ldi].device, 1, &app->sc_data[cur_scd].syncs[synci].fence.render);
       if (res) PERR(DLU_VK_FUNC_ERR, res, "vkResetFences")
       break;
     case DLU_VK_GET_RENDER_FENCE:
-      res = vkGetFenceStatus(app->ld_data[app->sc_data[cur_scd].ldi].device, app->sc_data[cur_scd].syncs[synci].fence.render);
+      res = DLU_SC_VK(app, cur_scd).GetFenceStatus(app->ld_data[app->sc_data[cur_scd].ldi].device, app->sc_data[cur_scd].syncs[synci].fence.render);
       switch(res) {
         case VK_SUCCESS:
           dlu_log_me(DLU_WARNING, "The fence specified app->sc_data[%d].syncs[%d].fence.render is signaled.", cur_scd, synci);
@@ -70,6 +70,7 @@ void dlu_vk_destroy(dlu_destroy_type type, vkcomp *app, uint32_t cur_ld, void *d
   switch (type) {
       case DLU_DESTROY_VK_SHADER:
         {VkShaderModule shader_module = (VkShaderModule) data;
+         if (shader_module) dlu_cache_evict_shader_module(app, shader_module);
          if (shader_module) vkDestroyShaderModule(app->ld_data[cur_ld].device, shader_module, NULL);}
         break;
       case DLU_DESTROY_VK_BUFFER:
@@ -90,7 +91,7 @@ void dlu_vk_destroy(dlu_destroy_type type, vkcomp *app, uint32_t cur_ld, void *d
         break;
       case DLU_DESTROY_VK_DESC_SET_LAYOUT:
         {VkDescriptorSetLayout layout = (VkDescriptorSetLayout) data;
-         if (layout) vkDestroyDescriptorSetLayout(app->ld_data[cur_ld].device, layout, NULL);}
+         if (layout && !dlu_cache_release_desc_set_layout(app, layout)) vkDestroyDescriptorSetLayout(app->ld_data[cur_ld].device, layout, NULL);}
         break;
       case DLU_DESTROY_PIPELINE_CACHE:
         {VkPipelineCache cache = (VkPipelineCache) data;
@@ -98,23 +99,26 @@ void dlu_vk_destroy(dlu_destroy_type type, vkcomp *app, uint32_t cur_ld, void *d
         break;
       case DLU_DESTROY_VK_FRAME_BUFFER:
         {VkFramebuffer frame = (VkFramebuffer) data;
-         if (frame) vkDestroyFramebuffer(app->ld_data[cur_ld].device, frame, NULL);}
+         if (frame && !dlu_cache_evict_framebuffer(app, frame)) vkDestroyFramebuffer(app->ld_data[cur_ld].device, frame, NULL);}
         break;
       case DLU_DESTROY_VK_RENDER_PASS:
         {VkRenderPass rp = (VkRenderPass) data;
-         if (rp) vkDestroyRenderPass(app->ld_data[cur_ld].device, rp, NULL);}
+         if (rp && !dlu_cache_evict_render_pass(app, rp)) vkDestroyRenderPass(app->ld_data[cur_ld].device, rp, NULL);}
         break;
       case DLU_DESTROY_VK_PIPE_LAYOUT:
         {VkPipelineLayout pipe_layout = (VkPipelineLayout) data;
-         if (pipe_layout) vkDestroyPipelineLayout(app->ld_data[cur_ld].device, pipe_layout, NULL);}
+         if (pipe_layout && !dlu_cache_release_pipeline_layout(app, pipe_layout)) {
+           dlu_cache_evict_pipeline_layout(app, pipe_layout);
+           vkDestroyPipelineLayout(app->ld_data[cur_ld].device, pipe_layout, NULL);
+         }}
         break;
       case DLU_DESTROY_PIPELINE:
         {VkPipeline pipeline = (VkPipeline) data;
-         if (pipeline) vkDestroyPipeline(app->ld_data[cur_ld].device, pipeline, NULL);}
+         if (pipeline && !dlu_cache_evict_pipeline(app, pipeline)) vkDestroyPipeline(app->ld_data[cur_ld].device, pipeline, NULL);}
         break;
       case DLU_DESTROY_VK_SAMPLER:
         {VkSampler sampler = (VkSampler) data;
-         if (sampler) vkDestroySampler(app->ld_data[cur_ld].device, sampler, NULL);}
+         if (sampler && !dlu_cache_release_sampler(app, sampler)) vkDestroySampler(app->ld_data[cur_ld].device, sampler, NULL);}
         break;
       case DLU_DESTROY_VK_IMAGE:
         {VkImage image = (VkImage) data;
@@ -122,6 +126,7 @@ void dlu_vk_destroy(dlu_destroy_type type, vkcomp *app, uint32_t cur_ld, void *d
         break;
       case DLU_DESTROY_VK_IMAGE_VIEW:
         {VkImageView view = (VkImageView) data;
+         if (view) dlu_cache_evict_image_view(app, view);
          if (view) vkDestroyImageView(app->ld_data[cur_ld].device, view, NULL);}
         break;
       case DLU_DESTROY_VK_SWAPCHAIN:
@@ -83,80 +83,73 @@ static VKAPI_ATTR VkBool32 VKAPI_CALL debug_utils_callbackFN(
 ) {
 
   dlu_log_type type = DLU_NONE;
+  const char *prefix = "";
+  char *message = NULL;
+  size_t size = 0;
 
-  char prefix[64];
-  uint32_t str_sze = strlen(pCallbackData->pMessage) + 1000;
-  char *message = (char *) alloca(str_sze);
+  /* The whole report goes out as one message, built in a growing buffer */
+  FILE *stream = open_memstream(&message, &size);
+  if (!stream) { dlu_log_me(DLU_DANGER, "[x] open_memstream: %s", strerror(errno)); return VK_FALSE; }
 
   switch (messageSeverity) {
     case VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT:
-      strcpy(prefix, "\n\nValidation Verbose "); type = DLU_INFO;
+      prefix = "Validation Verbose"; type = DLU_INFO;
       break;
     case VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT:
-      strcpy(prefix, "\n\nValidation Info "); type = DLU_INFO;
+      prefix = "Validation Info"; type = DLU_INFO;
       break;
     case VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT:
-      strcpy(prefix, "\n\nValidation Warning "); type = DLU_WARNING;
+      prefix = "Validation Warning"; type = DLU_WARNING;
       break;
     case VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT:
-       strcpy(prefix, "\n\nValidation Error "); type = DLU_DANGER;
-       break;
+      prefix = "Validation Error"; type = DLU_DANGER;
+      break;
     default: break;
   }
 
   switch (messageType) {
     case VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT:
-      strcat(prefix, "General: ");
-      sprintf(message, "%s MessageID = 0x%x" PRIu32 ", MessageID Name = [ %s ]\n\t  %s\n\n",
+      fprintf(stream, "\n\n%s General:  MessageID = 0x%x, MessageID Name = [ %s ]\n\t  %s\n\n",
               prefix, pCallbackData->messageIdNumber, pCallbackData->pMessageIdName, pCallbackData->pMessage);
       break; /* Leave bellow for now */
     case VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT:
     case VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT:
-      sprintf(message, "\n\n%s\n\n", pCallbackData->pMessage);
+      fprintf(stream, "\n\n%s\n\n", pCallbackData->pMessage);
       break;
     default: break;
   }
 
-  char tmp_msg[1000];
   if (pCallbackData->objectCount > 0) {
-    snprintf(tmp_msg, sizeof(tmp_msg), "\t  Objects - %d\n", pCallbackData->objectCount);
-    strncat(message, tmp_msg, str_sze);
-
+    fprintf(stream, "\t  Objects - %d\n", pCallbackData->objectCount);
     for (unsigned object = 0; object < pCallbackData->objectCount; object++) {
-      snprintf(tmp_msg, sizeof(tmp_msg), "\t\tObject[%d] : Type = %s, Handle = %p, Name = \"%s\"\n", object, obj_to_str(pCallbackData->pObjects[object].objectType),
+      fprintf(stream, "\t\tObject[%d] : Type = %s, Handle = %p, Name = \"%s\"\n", object, obj_to_str(pCallbackData->pObjects[object].objectType),
               (void *) (pCallbackData->pObjects[object].objectHandle), pCallbackData->pObjects[object].pObjectName);
-      strncat(message, tmp_msg, str_sze);
     }
-    memset(tmp_msg, 0, sizeof(tmp_msg));
   }
 
   if (pCallbackData->cmdBufLabelCount > 0) {
-    snprintf(tmp_msg, sizeof(tmp_msg), "VkCommandBuffer Labels - %d\n", pCallbackData->cmdBufLabelCount);
-    strncat(message, tmp_msg, str_sze);
+    fprintf(stream, "VkCommandBuffer Labels - %d\n", pCallbackData->cmdBufLabelCount);
     for (uint32_t label = 0; label < pCallbackData->cmdBufLabelCount; label++) {
-      snprintf(tmp_msg, sizeof(tmp_msg), "\tLabel[%d] : %s { %f, %f, %f, %f }\n",
-               label, pCallbackData->pCmdBufLabels[label].pLabelName,
-               pCallbackData->pCmdBufLabels[label].color[0], pCallbackData->pCmdBufLabels[label].color[1],
-               pCallbackData->pCmdBufLabels[label].color[2], pCallbackData->pCmdBufLabels[label].color[3]);
-      strncat(message, tmp_msg, str_sze);
+      fprintf(stream, "\tLabel[%d] : %s { %f, %f, %f, %f }\n",
+              label, pCallbackData->pCmdBufLabels[label].pLabelName,
+              pCallbackData->pCmdBufLabels[label].color[0], pCallbackData->pCmdBufLabels[label].color[1],
+              pCallbackData->pCmdBufLabels[label].color[2], pCallbackData->pCmdBufLabels[label].color[3]);
     }
-    memset(tmp_msg, 0, sizeof(tmp_msg));
   }
 
   if (pCallbackData->queueLabelCount > 0) {
-    snprintf(tmp_msg, sizeof(tmp_msg), "VkQueue Labels - %d\n", pCallbackData->queueLabelCount);
-    strncat(message, tmp_msg, str_sze);
+    fprintf(stream, "VkQueue Labels - %d\n", pCallbackData->queueLabelCount);
     for (uint32_t label = 0; label < pCallbackData->queueLabelCount; label++) {
-      snprintf(tmp_msg, sizeof(tmp_msg), "\tLabel[%d] : %s { %f, %f, %f, %f }\n",
-               label, pCallbackData->pQueueLabels[label].pLabelName,
-               pCallbackData->pQueueLabels[label].color[0], pCallbackData->pQueueLabels[label].color[1],
-               pCallbackData->pQueueLabels[label].color[2], pCallbackData->pQueueLabels[label].color[3]);
-      strncat(message, tmp_msg, str_sze);
+      fprintf(stream, "\tLabel[%d] : %s { %f, %f, %f, %f }\n",
+              label, pCallbackData->pQueueLabels[label].pLabelName,
+              pCallbackData->pQueueLabels[label].color[0], pCallbackData->pQueueLabels[label].color[1],
+              pCallbackData->pQueueLabels[label].color[2], pCallbackData->pQueueLabels[label].color[3]);
     }
-    memset(tmp_msg, 0, sizeof(tmp_msg));
   }
 
+  fclose(stream);
   dlu_log_me(type, "%s", message);
+  free(message);
 
   return VK_FALSE;
 }
@@ -0,0 +1,194 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright (c) 2019-2020 Vincent Davis Jr.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*/
+
+#define LUCUR_VKCOMP_API
+#include <lucom.h>
+#include <check.h>
+
+/* Never handed to vulkan, the key only looks at the handle values */
+#define FAKE_HANDLE(type, val) ((type) (uintptr_t) (val))
+
+static const uint32_t spirv_a[] = { 0x07230203, 0x00010000, 0x00080001, 0x0000000d, 0x00000000 };
+static const uint32_t spirv_b[] = { 0x07230203, 0x00010000, 0x00080001, 0x0000000e, 0x00000000 };
+
+/* Serialize info, caller frees the key */
+static unsigned char *pso_key(vkcomp *app, const VkGraphicsPipelineCreateInfo *info, size_t *size, size_t *family_size) {
+  *size = dlu_cache_pso_key(app, 0, NULL, info, family_size);
+  unsigned char *key = calloc(1, *size);
+  ck_assert_ptr_nonnull(key);
+  ck_assert_uint_eq(dlu_cache_pso_key(app, 0, key, info, family_size), *size);
+  return key;
+}
+
+static bool pso_key_eq(vkcomp *app, const VkGraphicsPipelineCreateInfo *a, const VkGraphicsPipelineCreateInfo *b) {
+  size_t asize, bsize, afam, bfam;
+  unsigned char *akey = pso_key(app, a, &asize, &afam);
+  unsigned char *bkey = pso_key(app, b, &bsize, &bfam);
+  bool eq = asize == bsize && afam == bfam && !memcmp(akey, bkey, asize);
+  free(akey); free(bkey);
+  return eq;
+}
+
+START_TEST(hash_bytes_fnv1a) {
+  /* Published FNV-1a 64-bit test vectors */
+  ck_assert_uint_eq(dlu_hash_bytes(DLU_HASH_SEED, "", 0), DLU_HASH_SEED);
+  ck_assert_uint_eq(dlu_hash_bytes(DLU_HASH_SEED, "a", 1), 0xaf63dc4c8601ec8cULL);
+  ck_assert_uint_eq(dlu_hash_bytes(DLU_HASH_SEED, "foobar", 6), 0x85944171f73967e8ULL);
+
+  /* Hashing in pieces is the same as hashing it all at once */
+  ck_assert_uint_eq(dlu_hash_bytes(dlu_hash_bytes(DLU_HASH_SEED, "foo", 3), "bar", 3), 0x85944171f73967e8ULL);
+} END_TEST;
+
+START_TEST(pso_key_shader_modules) {
+  dlu_otma_mems ma = { .vkcomp_cnt = 1 };
+  if (!dlu_otma(DLU_LARGE_BLOCK_PRIV, ma)) ck_abort_msg(NULL);
+
+  vkcomp *app = dlu_init_vk();
+  ck_assert_ptr_nonnull(app);
+
+  VkShaderModule mod_a = FAKE_HANDLE(VkShaderModule, 0x10);
+  VkShaderModule mod_a2 = FAKE_HANDLE(VkShaderModule, 0x20);
+  VkShaderModule mod_b = FAKE_HANDLE(VkShaderModule, 0x30);
+  VkShaderModule mod_raw = FAKE_HANDLE(VkShaderModule, 0x40);
+  VkShaderModule mod_raw2 = FAKE_HANDLE(VkShaderModule, 0x50);
+
+  /* Same SPIR-V in two modules, what dlu_create_shader_module() does */
+  dlu_cache_register_shader_module(app, 0, mod_a, spirv_a, sizeof(spirv_a));
+  dlu_cache_register_shader_module(app, 0, mod_a2, spirv_a, sizeof(spirv_a));
+  dlu_cache_register_shader_module(app, 0, mod_b, spirv_b, sizeof(spirv_b));
+
+  VkPipelineShaderStageCreateInfo stage = dlu_set_shader_stage_info(mod_a, "main", VK_SHADER_STAGE_VERTEX_BIT, NULL, 0);
+  VkPipelineRasterizationStateCreateInfo raster = dlu_set_rasterization_state_info(
+    VK_FALSE, VK_FALSE, VK_POLYGON_MODE_FILL, VK_CULL_MODE_BACK_BIT,
+    VK_FRONT_FACE_CLOCKWISE, VK_FALSE, 0.0f, 0.0f, 0.0f, 1.0f
+  );
+
+  VkGraphicsPipelineCreateInfo info = {};
+  info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+  info.stageCount = 1;
+  info.pStages = &stage;
+  info.pRasterizationState = &raster;
+  info.layout = FAKE_HANDLE(VkPipelineLayout, 0x100);
+  info.renderPass = FAKE_HANDLE(VkRenderPass, 0x200);
+
+  VkPipelineShaderStageCreateInfo stage2 = stage;
+  VkPipelineRasterizationStateCreateInfo raster2 = raster;
+  VkGraphicsPipelineCreateInfo info2 = info;
+  info2.pStages = &stage2;
+  info2.pRasterizationState = &raster2;
+
+  ck_assert(pso_key_eq(app, &info, &info2));
+
+  /* Registered modules are keyed by their SPIR-V, not their handle */
+  stage2.module = mod_a2;
+  ck_assert(pso_key_eq(app, &info, &info2));
+  stage2.module = mod_b;
+  ck_assert(!pso_key_eq(app, &info, &info2));
+
+  /* Anything else falls back to the handle */
+  stage.module = mod_raw; stage2.module = mod_raw2;
+  ck_assert(!pso_key_eq(app, &info, &info2));
+  stage2.module = mod_raw;
+  ck_assert(pso_key_eq(app, &info, &info2));
+
+  /* Entry point and a NULL vs empty specialization are part of the key */
+  stage2.pName = "main2";
+  ck_assert(!pso_key_eq(app, &info, &info2));
+  stage2.pName = "main";
+
+  VkSpecializationInfo spec = {};
+  stage2.pSpecializationInfo = &spec;
+  ck_assert(!pso_key_eq(app, &info, &info2));
+  stage2.pSpecializationInfo = NULL;
+
+  /* Fixed function state changes the key but not the family */
+  size_t size, size2, family, family2;
+  raster2.lineWidth = 2.0f;
+  unsigned char *key = pso_key(app, &info, &size, &family);
+  unsigned char *key2 = pso_key(app, &info2, &size2, &family2);
+  ck_assert_uint_eq(size, size2);
+  ck_assert_uint_eq(family, family2);
+  ck_assert_uint_lt(family, size);
+  ck_assert(!memcmp(key, key2, family));
+  ck_assert(memcmp(key, key2, size));
+  free(key); free(key2);
+  raster2.lineWidth = 1.0f;
+
+  /* So does a state being left out */
+  info2.pRasterizationState = NULL;
+  ck_assert(!pso_key_eq(app, &info, &info2));
+  info2.pRasterizationState = &raster2;
+
+  /* Render pass and subpass are family members */
+  info2.subpass = 1;
+  key = pso_key(app, &info, &size, &family);
+  key2 = pso_key(app, &info2, &size2, &family2);
+  ck_assert(memcmp(key, key2, family));
+  free(key); free(key2);
+  info2.subpass = 0;
+
+  /* Evicting a module forgets its hash, the other module with the same code stays keyed by it */
+  stage.module = mod_a; stage2.module = mod_a2;
+  dlu_cache_evict_shader_module(app, mod_a);
+  ck_assert(!pso_key_eq(app, &info, &info2));
+
+  /* A recycled handle takes over the entry */
+  dlu_cache_register_shader_module(app, 0, mod_a, spirv_a, sizeof(spirv_a));
+  ck_assert(pso_key_eq(app, &info, &info2));
+  dlu_cache_register_shader_module(app, 0, mod_a, spirv_b, sizeof(spirv_b));
+  ck_assert(!pso_key_eq(app, &info, &info2));
+  stage2.module = mod_b;
+  ck_assert(pso_key_eq(app, &info, &info2));
+
+  dlu_cache_freeup(app);
+  dlu_release_blocks();
+} END_TEST;
+
+Suite *cache_suite(void) {
+  Suite *s = NULL;
+  TCase *tc_core = NULL;
+
+  s = suite_create("Cache");
+
+  /* Core test case */
+  tc_core = tcase_create("Core");
+
+  tcase_add_test(tc_core, hash_bytes_fnv1a);
+  tcase_add_test(tc_core, pso_key_shader_modules);
+  suite_add_tcase(s, tc_core);
+
+  return s;
+}
+
+int main(void) {
+  int number_failed;
+
+  Suite *s = cache_suite();
+  SRunner *sr = srunner_create(s);
+
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,562 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright (c) 2019-2020 Vincent Davis Jr.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*/
+#include <check.h>
+
+#define LUCUR_VKCOMP_API
+#define LUCUR_SPIRV_API
+#include <lucom.h>
+
+#include "wayland/client.h"
+#include "test-extras.h"
+
+/**
+* Benchmarks the compute compositor against the raster path (one blended quad
+* per surface) on the same scene, then checks both produced the same image.
+* The scene stacks more surfaces than a tile list holds, so the compositor
+* hands those tiles to the raster path as well.
+*/
+
+#define WIDTH 256
+#define HEIGHT 256
+#define TILE 16
+#define SURFACES 40
+#define TEXTURES 4
+#define ITERATIONS 64
+#define STR(x) #x
+#define XSTR(x) STR(x)
+
+/* Per instance data of the raster path, one quad per surface */
+struct surface {
+  float rect[4]; /* x0, y0, x1, y1 in pixels */
+  float opacity;
+  uint32_t tex; /* bindless slot, UINT32_MAX draws the clear color */
+};
+
+static dlu_otma_mems ma = {
+  .vkcomp_cnt = 1, .scd_cnt = 2, .gpd_cnt = 2, .gp_cnt = 1, .cmdd_cnt = 2,
+  .bd_cnt = 2, .td_cnt = TEXTURES, .ld_cnt = 1, .pd_cnt = 1
+};
+
+static const char raster_vert_src[] =
+  "#version 450\n"
+  "layout(location = 0) in vec4 i_Rect;\n"
+  "layout(location = 1) in float i_Opacity;\n"
+  "layout(location = 2) in uint i_Tex;\n"
+  "layout(location = 0) out vec2 v_TexCoord;\n"
+  "layout(location = 1) flat out float v_Opacity;\n"
+  "layout(location = 2) flat out uint v_Tex;\n"
+  "const vec2 corners[6] = vec2[](vec2(0, 0), vec2(1, 0), vec2(1, 1), vec2(0, 0), vec2(1, 1), vec2(0, 1));\n"
+  "const vec2 extent = vec2(" XSTR(WIDTH) ".0, " XSTR(HEIGHT) ".0);\n"
+  "void main() {\n"
+  "  vec2 corner = corners[gl_VertexIndex];\n"
+  "  v_TexCoord = corner;\n"
+  "  v_Opacity = i_Opacity;\n"
+  "  v_Tex = i_Tex;\n"
+  "  gl_Position = vec4(mix(i_Rect.xy, i_Rect.zw, corner) / extent * 2.0 - 1.0, 0.0, 1.0);\n"
+  "}\n";
+
+/* Blends like the compositor: rgb = mix(dst, src, a), alpha = a + dst.a * (1 - a) */
+static const char raster_frag_src[] =
+  "#version 450\n"
+  "#extension GL_EXT_nonuniform_qualifier : require\n"
+  "layout(location = 0) in vec2 v_TexCoord;\n"
+  "layout(location = 1) flat in float v_Opacity;\n"
+  "layout(location = 2) flat in uint v_Tex;\n"
+  "layout(location = 0) out vec4 o_Color;\n"
+  "layout(set = 0, binding = 0) uniform sampler2D textures[];\n"
+  "void main() {\n"
+  "  if (v_Tex == 0xFFFFFFFFu) { o_Color = vec4(0.0, 0.0, 0.0, 1.0); return; }\n"
+  "  vec4 src = textureLod(textures[nonuniformEXT(v_Tex)], v_TexCoord, 0.0);\n"
+  "  o_Color = vec4(src.rgb, src.a * v_Opacity);\n"
+  "}\n";
+
+static bool init_buffs(vkcomp *app) {
+  bool err;
+
+  err = dlu_otba(DLU_PD_DATA, app, INDEX_IGNORE, ma.pd_cnt);
+  if (!err) return err;
+
+  err = dlu_otba(DLU_LD_DATA, app, INDEX_IGNORE, ma.ld_cnt);
+  if (!err) return err;
+
+  err = dlu_otba(DLU_SC_DATA, app, INDEX_IGNORE, ma.scd_cnt);
+  if (!err) return err;
+
+  err = dlu_otba(DLU_GP_DATA, app, INDEX_IGNORE, ma.gpd_cnt);
+  if (!err) return err;
+
+  err = dlu_otba(DLU_CMD_DATA, app, INDEX_IGNORE, ma.cmdd_cnt);
+  if (!err) return err;
+
+  err = dlu_otba(DLU_BUFF_DATA, app, INDEX_IGNORE, ma.bd_cnt);
+  if (!err) return err;
+
+  err = dlu_otba(DLU_TEXT_DATA, app, INDEX_IGNORE, ma.td_cnt);
+  if (!err) return err;
+
+  return err;
+}
+
+/* Overlapping translucent surfaces, the middle of the stack is deeper than a tile list */
+static void build_scene(vkcomp *app, struct surface *surfaces) {
+  surfaces[0] = (struct surface) { { 0.0f, 0.0f, WIDTH, HEIGHT }, 1.0f, UINT32_MAX };
+
+  for (uint32_t i = 1; i <= SURFACES; i++) {
+    float x = 4.0f + 3.0f * (i - 1), y = 4.0f + 2.0f * (i - 1);
+    surfaces[i] = (struct surface) { { x, y, x + 128.0f, y + 128.0f }, 0.5f, app->text_data[i % TEXTURES].slot };
+  }
+}
+
+/* Solid color textures, uploaded through the staging buffer cur_bd */
+static VkResult create_textures(vkcomp *app, uint32_t cur_ld, uint32_t cur_pool, uint32_t cur_bd) {
+  VkResult err;
+
+  const uint8_t colors[TEXTURES][4] = { {255, 0, 0, 255}, {0, 255, 0, 255}, {0, 0, 255, 255}, {255, 255, 255, 255} };
+  uint8_t texels[TEXTURES][16][4];
+  for (uint32_t i = 0; i < TEXTURES; i++)
+    for (uint32_t j = 0; j < 16; j++)
+      memcpy(texels[i][j], colors[i], 4);
+
+  err = dlu_create_vk_buffer(app, cur_ld, cur_bd, sizeof(texels), 0, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_SHARING_MODE_EXCLUSIVE,
+    0, NULL, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+  );
+  if (err) return err;
+
+  err = dlu_vk_map_mem(DLU_VK_BUFFER, app, cur_bd, sizeof(texels), texels, 0, 0);
+  if (err) return err;
+
+  VkExtent3D tex_extent = {4, 4, 1};
+  VkImageSubresourceRange img_sub_rr = dlu_set_image_sub_resource_range(VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1);
+  VkComponentMapping comp_map = dlu_set_component_mapping(VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY);
+  VkImageViewCreateInfo img_view_info = dlu_set_image_view_info(0, VK_NULL_HANDLE, VK_IMAGE_VIEW_TYPE_2D, VK_FORMAT_R8G8B8A8_UNORM, comp_map, img_sub_rr);
+  VkImageCreateInfo img_info = dlu_set_image_info(0, VK_IMAGE_TYPE_2D, VK_FORMAT_R8G8B8A8_UNORM, tex_extent, 1, 1,
+    VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+    VK_SHARING_MODE_EXCLUSIVE, 0, NULL, VK_IMAGE_LAYOUT_UNDEFINED
+  );
+
+  VkSamplerCreateInfo sampler = dlu_set_sampler_info(0, VK_FILTER_NEAREST, VK_FILTER_NEAREST, 0.0f, VK_SAMPLER_MIPMAP_MODE_NEAREST,
+    VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, 1.0f, VK_FALSE, VK_FALSE,
+    VK_COMPARE_OP_ALWAYS, 0.0f, 0.0f, VK_BORDER_COLOR_INT_OPAQUE_BLACK, VK_FALSE
+  );
+
+  VkCommandBuffer cmd_buff = dlu_exec_begin_single_time_cmd_buff(app, cur_pool);
+  if (!cmd_buff) return VK_RESULT_MAX_ENUM;
+
+  for (uint32_t i = 0; i < TEXTURES; i++) {
+    err = dlu_create_texture_image(app, cur_ld, i, &img_info, &img_view_info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (err) return err;
+
+    err = dlu_create_texture_sampler(app, i, &sampler);
+    if (err) return err;
+
+    VkImageMemoryBarrier barrier = dlu_set_image_mem_barrier(0, VK_ACCESS_TRANSFER_WRITE_BIT,
+      VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_QUEUE_FAMILY_IGNORED,
+      VK_QUEUE_FAMILY_IGNORED, app->text_data[i].image, img_sub_rr
+    );
+    dlu_exec_cmd_pipeline_barrier(app, cur_pool, VK_PIPELINE_STAGE_HOST_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1, &barrier, cmd_buff);
+
+    VkOffset3D offset3D = {0, 0, 0};
+    VkImageSubresourceLayers img_sub_rl = dlu_set_image_sub_resource_layers(VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1);
+    VkBufferImageCopy region = dlu_set_buff_image_copy(sizeof(texels[0]) * i, 0, 0, img_sub_rl, offset3D, tex_extent);
+    dlu_exec_copy_buff_to_image(app, cur_bd, i, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region, cmd_buff);
+
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT; barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL; barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    dlu_exec_cmd_pipeline_barrier(app, cur_pool, VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, NULL, 0, NULL, 1, &barrier, cmd_buff);
+  }
+
+  err = dlu_exec_end_single_time_cmd_buff(app, cur_pool, &cmd_buff);
+  if (err) return err;
+
+  for (uint32_t i = 0; i < TEXTURES; i++) {
+    err = dlu_bindless_register_texture(app, i, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    if (err) return err;
+  }
+
+  return err;
+}
+
+static VkShaderModule create_shader(vkcomp *app, uint32_t cur_ld, unsigned int kind, const char *src, const char *name) {
+  dlu_shader_info shi = dlu_compile_to_spirv(kind, src, name, "main");
+  if (!shi.bytes) return VK_NULL_HANDLE;
+
+  VkShaderModule module = dlu_create_shader_module(app, cur_ld, shi.bytes, shi.byte_size);
+  dlu_freeup_spriv_bytes(DLU_LIB_SHADERC_SPRIV, shi.result);
+  return module;
+}
+
+/**
+* cur_gpd: Raster render pass (DONT_CARE, every pixel is drawn) holding the pipeline
+* cur_gpd + 1: Same attachment, loaded, for drawing tiles on top of the compositor's output
+*/
+static VkResult create_raster_path(vkcomp *app, uint32_t cur_ld, uint32_t cur_gpd) {
+  VkResult err;
+  VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+
+  VkAttachmentReference color_attachment_ref = dlu_set_attachment_ref(0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+  VkSubpassDescription subpass = dlu_set_subpass_desc(0, VK_PIPELINE_BIND_POINT_GRAPHICS, 0, NULL, 1, &color_attachment_ref, NULL, NULL, 0, NULL);
+
+  VkSubpassDependency subdep = dlu_set_subpass_dep(VK_SUBPASS_EXTERNAL, 0,
+    VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+    0, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, 0
+  );
+
+  VkAttachmentDescription color_attachments[2] = {
+    dlu_set_attachment_desc(format, VK_SAMPLE_COUNT_1_BIT, VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_STORE,
+      VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_DONT_CARE, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL),
+    dlu_set_attachment_desc(format, VK_SAMPLE_COUNT_1_BIT, VK_ATTACHMENT_LOAD_OP_LOAD, VK_ATTACHMENT_STORE_OP_STORE,
+      VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_DONT_CARE, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)
+  };
+
+  for (uint32_t i = 0; i < ARR_LEN(color_attachments); i++) {
+    err = dlu_create_render_pass(app, cur_gpd + i, 1, &color_attachments[i], 1, &subpass, 1, &subdep, 0);
+    if (err) return err;
+  }
+
+  VkDescriptorSetLayoutCreateInfo layout_info = *dlu_get_bindless_layout_info(app);
+  err = dlu_create_pipeline_layout(app, cur_ld, cur_gpd, 1, &layout_info, 0, NULL, 0);
+  if (err) return err;
+
+  VkShaderModule vert_shader_module = create_shader(app, cur_ld, VK_SHADER_STAGE_VERTEX_BIT, raster_vert_src, "vert.spv");
+  if (!vert_shader_module) return VK_RESULT_MAX_ENUM;
+
+  VkShaderModule frag_shader_module = create_shader(app, cur_ld, VK_SHADER_STAGE_FRAGMENT_BIT, raster_frag_src, "frag.spv");
+  if (!frag_shader_module) {
+    dlu_vk_destroy(DLU_DESTROY_VK_SHADER, app, cur_ld, vert_shader_module);
+    return VK_RESULT_MAX_ENUM;
+  }
+
+  VkPipelineShaderStageCreateInfo shader_stages[2] = {
+    dlu_set_shader_stage_info(vert_shader_module, "main", VK_SHADER_STAGE_VERTEX_BIT, NULL, 0),
+    dlu_set_shader_stage_info(frag_shader_module, "main", VK_SHADER_STAGE_FRAGMENT_BIT, NULL, 0)
+  };
+
+  VkVertexInputBindingDescription vi_binding = dlu_set_vertex_input_binding_desc(0, sizeof(struct surface), VK_VERTEX_INPUT_RATE_INSTANCE);
+
+  VkVertexInputAttributeDescription vi_attribs[3];
+  vi_attribs[0] = dlu_set_vertex_input_attrib_desc(0, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(struct surface, rect));
+  vi_attribs[1] = dlu_set_vertex_input_attrib_desc(1, 0, VK_FORMAT_R32_SFLOAT, offsetof(struct surface, opacity));
+  vi_attribs[2] = dlu_set_vertex_input_attrib_desc(2, 0, VK_FORMAT_R32_UINT, offsetof(struct surface, tex));
+
+  VkPipelineVertexInputStateCreateInfo vertex_input_info = dlu_set_vertex_input_state_info(1, &vi_binding, ARR_LEN(vi_attribs), vi_attribs);
+  VkPipelineInputAssemblyStateCreateInfo input_assembly = dlu_set_input_assembly_state_info(0, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, VK_FALSE);
+
+  VkViewport viewport = dlu_set_view_port(0.0f, 0.0f, (float) WIDTH, (float) HEIGHT, 0.0f, 1.0f);
+  VkRect2D scissor = dlu_set_rect2D(0, 0, WIDTH, HEIGHT);
+  VkPipelineViewportStateCreateInfo view_port_info = dlu_set_view_port_state_info(1, &viewport, 1, &scissor);
+
+  VkPipelineRasterizationStateCreateInfo rasterizer = dlu_set_rasterization_state_info(
+    VK_FALSE, VK_FALSE, VK_POLYGON_MODE_FILL, VK_CULL_MODE_NONE,
+    VK_FRONT_FACE_CLOCKWISE, VK_FALSE, 0.0f, 0.0f, 0.0f, 1.0f
+  );
+
+  VkPipelineMultisampleStateCreateInfo multisampling = dlu_set_multisample_state_info(
+    VK_SAMPLE_COUNT_1_BIT, VK_FALSE, 1.0f, NULL, VK_FALSE, VK_FALSE
+  );
+
+  VkPipelineColorBlendAttachmentState color_blend_attachment = dlu_set_color_blend_attachment_state(
+    VK_TRUE, VK_BLEND_FACTOR_SRC_ALPHA, VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA, VK_BLEND_OP_ADD,
+    VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA, VK_BLEND_OP_ADD,
+    VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT
+  );
+
+  float blend_const[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+  VkPipelineColorBlendStateCreateInfo color_blending = dlu_set_color_blend_attachment_state_info(
+    VK_FALSE, VK_LOGIC_OP_COPY, 1, &color_blend_attachment, blend_const
+  );
+
+  /* Raster tiles are drawn scissored */
+  VkDynamicState dynamic_states[1] = { VK_DYNAMIC_STATE_SCISSOR };
+  VkPipelineDynamicStateCreateInfo dynamic_info = dlu_set_dynamic_state_info(ARR_LEN(dynamic_states), dynamic_states);
+
+  err = dlu_otba(DLU_GP_DATA_MEMS, app, cur_gpd, 1) ? VK_SUCCESS : VK_RESULT_MAX_ENUM;
+  if (!err)
+    err = dlu_create_graphics_pipelines(app, cur_gpd, ARR_LEN(shader_stages), shader_stages,
+      &vertex_input_info, &input_assembly, VK_NULL_HANDLE, &view_port_info,
+      &rasterizer, &multisampling, VK_NULL_HANDLE, &color_blending,
+      &dynamic_info, 0, VK_NULL_HANDLE, UINT32_MAX
+    );
+
+  dlu_vk_destroy(DLU_DESTROY_VK_SHADER, app, cur_ld, frag_shader_module);
+  dlu_vk_destroy(DLU_DESTROY_VK_SHADER, app, cur_ld, vert_shader_module);
+
+  return err;
+}
+
+/* Every surface of the scene, clipped to each of rects */
+static void record_raster(vkcomp *app, uint32_t cur_pool, uint32_t cur_gpd, uint32_t cur_bd, uint32_t rectc, const VkRect2D *rects) {
+  const VkDeviceSize offsets[1] = {0};
+
+  dlu_bind_pipeline(app, cur_pool, 0, cur_gpd, 0, VK_PIPELINE_BIND_POINT_GRAPHICS);
+  dlu_bind_bindless_table(app, cur_pool, 0, cur_gpd, VK_PIPELINE_BIND_POINT_GRAPHICS, 0);
+  dlu_bind_vertex_buff_to_cmd_buff(app, cur_pool, 0, cur_bd, 0, offsets);
+
+  for (uint32_t i = 0; i < rectc; i++) {
+    VkRect2D scissor = rects[i];
+    dlu_exec_cmd_set_scissor(app, &scissor, cur_pool, 0, 0, 1);
+    dlu_exec_cmd_draw(app, cur_pool, 0, 6, SURFACES + 1, 0, 0);
+  }
+}
+
+static int cmp_u64(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+  return (x > y) - (x < y);
+}
+
+/* Median wall time (ns) of submitting cur_pool's command buffer and waiting for it */
+static VkResult time_path(vkcomp *app, uint32_t cur_scd, uint32_t cur_pool, uint64_t *median) {
+  VkResult err;
+  uint64_t times[ITERATIONS];
+  VkCommandBuffer cmd_buffs[1] = {app->cmd_data[cur_pool].cmd_buffs[0]};
+
+  for (uint32_t i = 0; i < ITERATIONS; i++) {
+    err = dlu_vk_sync(DLU_VK_WAIT_RENDER_FENCE, app, cur_scd, 0);
+    if (err) return err;
+
+    err = dlu_vk_sync(DLU_VK_RESET_RENDER_FENCE, app, cur_scd, 0);
+    if (err) return err;
+
+    uint64_t start = dlu_hrnst();
+
+    err = dlu_queue_graphics_queue(app, cur_scd, 0, 1, cmd_buffs, 0, NULL, NULL, 0, NULL);
+    if (err) return err;
+
+    err = dlu_vk_sync(DLU_VK_WAIT_RENDER_FENCE, app, cur_scd, 0);
+    if (err) return err;
+
+    times[i] = dlu_hrnst() - start;
+  }
+
+  qsort(times, ITERATIONS, sizeof(uint64_t), cmp_u64);
+  *median = times[ITERATIONS / 2];
+
+  /* The last submission also copied the image out */
+  return dlu_headless_queue_readback(app, cur_scd, 0);
+}
+
+/* Rounding differs (the compositor blends in registers, the raster path in the attachment) */
+static bool same_pixels(const uint8_t *a, const uint8_t *b, VkDeviceSize row_pitch) {
+  for (uint32_t y = 0; y < HEIGHT; y++)
+    for (uint32_t x = 0; x < WIDTH * 4; x++)
+      if (abs(a[y * row_pitch + x] - b[y * row_pitch + x]) > 3)
+        return false;
+
+  return true;
+}
+
+START_TEST(test_composite_vs_raster) {
+  VkResult err;
+
+  if (!dlu_otma(DLU_LARGE_BLOCK_PRIV, ma)) ck_abort_msg(NULL);
+
+  vkcomp *app = dlu_init_vk();
+  check_err(!app, NULL, NULL, NULL)
+
+  err = init_buffs(app);
+  check_err(!err, app, NULL, NULL)
+
+  err = dlu_create_instance(app, "Composite", "No Engine", 0, NULL, 0, NULL);
+  check_err(err, app, NULL, NULL)
+
+  VkPhysicalDeviceProperties device_props;
+  VkPhysicalDeviceFeatures device_feats;
+  uint32_t cur_pd = 0, cur_ld = 0;
+
+  dlu_pd_criteria criteria = {};
+  criteria.type = VK_PHYSICAL_DEVICE_TYPE_MAX_ENUM;
+  err = dlu_select_physical_device(app, cur_pd, &criteria, &device_props, &device_feats);
+  check_err(err, app, NULL, NULL)
+
+  err = dlu_create_queue_families(app, cur_pd, VK_QUEUE_GRAPHICS_BIT);
+  check_err(err, app, NULL, NULL)
+
+  float queue_priorities[1] = {1.0};
+  VkDeviceQueueCreateInfo dqueue_create_info[1];
+  dqueue_create_info[0] = dlu_set_device_queue_info(0, app->pd_data[cur_pd].gfam_idx, 1, queue_priorities);
+
+  err = dlu_create_logical_device(app, cur_pd, cur_ld, 0, ARR_LEN(dqueue_create_info), dqueue_create_info, &device_feats, 0, NULL);
+  check_err(err, app, NULL, NULL)
+
+  /* Both paths sample through the bindless table */
+  if (!app->ld_data[cur_ld].desc_indexing) {
+    dlu_log_me(DLU_WARNING, "Device lacks descriptor indexing, skipping the compositor benchmark");
+    FREEME(app, NULL)
+    return;
+  }
+
+  err = dlu_create_device_queue(app, cur_ld, 0, VK_QUEUE_GRAPHICS_BIT);
+  check_err(err, app, NULL, NULL)
+
+  /* scd/pool 0: compositor, scd/pool 1: raster path. One image each */
+  uint32_t comp_scd = 0, raster_scd = 1, cur_gpd = 0, inst_bd = 1;
+  VkExtent2D extent2D = {WIDTH, HEIGHT};
+  VkImageView vkimg_attach[1];
+
+  for (uint32_t i = 0; i < ma.scd_cnt; i++) {
+    err = dlu_otba(DLU_SC_DATA_MEMS, app, i, 1);
+    check_err(!err, app, NULL, NULL)
+
+    err = dlu_create_headless_target(app, cur_ld, i, VK_FORMAT_R8G8B8A8_UNORM, extent2D, 1, VK_IMAGE_USAGE_STORAGE_BIT);
+    check_err(err, app, NULL, NULL)
+
+    err = dlu_create_cmd_pool(app, cur_ld, i, i, app->pd_data[cur_pd].gfam_idx, 0);
+    check_err(err, app, NULL, NULL)
+
+    err = dlu_create_cmd_buffs(app, i, i, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+    check_err(err, app, NULL, NULL)
+
+    err = dlu_create_syncs(app, i);
+    check_err(err, app, NULL, NULL)
+  }
+
+  err = dlu_create_bindless_table(app, cur_ld, 16, VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
+  check_err(err, app, NULL, NULL)
+
+  err = create_textures(app, cur_ld, comp_scd, 0);
+  check_err(err, app, NULL, NULL)
+
+  err = create_raster_path(app, cur_ld, cur_gpd);
+  check_err(err, app, NULL, NULL)
+
+  /* The compositor's target gets the loading pass, raster tiles are drawn over its output */
+  err = dlu_create_framebuffers(app, comp_scd, cur_gpd + 1, 1, vkimg_attach, extent2D.width, extent2D.height, 1);
+  check_err(err, app, NULL, NULL)
+
+  err = dlu_create_framebuffers(app, raster_scd, cur_gpd, 1, vkimg_attach, extent2D.width, extent2D.height, 1);
+  check_err(err, app, NULL, NULL)
+
+  struct surface surfaces[SURFACES + 1];
+  build_scene(app, surfaces);
+
+  err = dlu_create_vk_buffer(app, cur_ld, inst_bd, sizeof(surfaces), 0, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+    VK_SHARING_MODE_EXCLUSIVE, 0, NULL, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+  );
+  check_err(err, app, NULL, NULL)
+
+  err = dlu_vk_map_mem(DLU_VK_BUFFER, app, inst_bd, sizeof(surfaces), surfaces, 0, 0);
+  check_err(err, app, NULL, NULL)
+
+  VkShaderModule comp_shader_module = create_shader(app, cur_ld, VK_SHADER_STAGE_COMPUTE_BIT, dlu_comp_shader_source(), "comp.spv");
+  check_err(!comp_shader_module, app, NULL, NULL)
+
+  err = dlu_create_compositor(app, cur_ld, 1, SURFACES, extent2D, VK_FORMAT_R8G8B8A8_UNORM, TILE, comp_shader_module);
+  dlu_vk_destroy(DLU_DESTROY_VK_SHADER, app, cur_ld, comp_shader_module);
+  check_err(err, app, NULL, NULL)
+
+  /* Compositor, then the raster path for tiles too deep for it */
+  err = dlu_comp_begin_frame(app, 0, extent2D);
+  check_err(err, app, NULL, NULL)
+
+  for (uint32_t i = 1; i <= SURFACES; i++) {
+    struct surface *s = &surfaces[i];
+    err = dlu_comp_add_surface(app, s->rect[0], s->rect[1], s->rect[2] - s->rect[0], s->rect[3] - s->rect[1],
+                               s->opacity, i % TEXTURES, VK_FALSE);
+    check_err(err, app, NULL, NULL)
+  }
+
+  const VkRect2D *raster_tiles = NULL;
+  uint32_t raster_tilec = dlu_comp_raster_tiles(app, &raster_tiles);
+  check_err(!raster_tilec, app, NULL, NULL)
+
+  VkClearColorValue clear = { .float32 = {0.0f, 0.0f, 0.0f, 1.0f} };
+
+  err = dlu_exec_begin_cmd_buffs(app, comp_scd, comp_scd, 0, NULL);
+  check_err(err, app, NULL, NULL)
+
+  dlu_comp_record(app, comp_scd, 0, app->sc_data[comp_scd].sc_buffs[0].image, app->sc_data[comp_scd].sc_buffs[0].view,
+                  VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, clear);
+
+  dlu_exec_begin_render_pass(app, comp_scd, comp_scd, cur_gpd + 1, 0, 0, extent2D.width, extent2D.height, 0, NULL, VK_SUBPASS_CONTENTS_INLINE);
+  record_raster(app, comp_scd, cur_gpd, inst_bd, raster_tilec, raster_tiles);
+  dlu_exec_stop_render_pass(app, comp_scd, comp_scd);
+
+  dlu_headless_record_readback(app, comp_scd, 0, comp_scd, 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+
+  err = dlu_exec_stop_cmd_buffs(app, comp_scd, comp_scd);
+  check_err(err, app, NULL, NULL)
+
+  /* Raster path alone, one quad per surface over the whole output */
+  VkRect2D full = dlu_set_rect2D(0, 0, WIDTH, HEIGHT);
+
+  err = dlu_exec_begin_cmd_buffs(app, raster_scd, raster_scd, 0, NULL);
+  check_err(err, app, NULL, NULL)
+
+  dlu_exec_begin_render_pass(app, raster_scd, raster_scd, cur_gpd, 0, 0, extent2D.width, extent2D.height, 0, NULL, VK_SUBPASS_CONTENTS_INLINE);
+  record_raster(app, raster_scd, cur_gpd, inst_bd, 1, &full);
+  dlu_exec_stop_render_pass(app, raster_scd, raster_scd);
+
+  dlu_headless_record_readback(app, raster_scd, 0, raster_scd, 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+
+  err = dlu_exec_stop_cmd_buffs(app, raster_scd, raster_scd);
+  check_err(err, app, NULL, NULL)
+
+  uint64_t comp_ns = 0, raster_ns = 0;
+
+  err = time_path(app, comp_scd, comp_scd, &comp_ns);
+  check_err(err, app, NULL, NULL)
+
+  err = time_path(app, raster_scd, raster_scd, &raster_ns);
+  check_err(err, app, NULL, NULL)
+
+  dlu_log_me(DLU_INFO, "%u surfaces at %ux%u, median of %u frames (readback included)", SURFACES, WIDTH, HEIGHT, ITERATIONS);
+  dlu_log_me(DLU_INFO, "compositor: %.3f ms (%u tiles through the raster path)", comp_ns / 1000000.0, raster_tilec);
+  dlu_log_me(DLU_INFO, "raster: %.3f ms", raster_ns / 1000000.0);
+
+  VkDeviceSize comp_pitch = 0, raster_pitch = 0;
+  const uint8_t *comp_pixels = dlu_headless_get_frame(app, comp_scd, 0, VK_TRUE, &comp_pitch);
+  const uint8_t *raster_pixels = dlu_headless_get_frame(app, raster_scd, 0, VK_TRUE, &raster_pitch);
+  check_err(!comp_pixels || !raster_pixels || comp_pitch != raster_pitch, app, NULL, NULL)
+  check_err(!same_pixels(comp_pixels, raster_pixels, comp_pitch), app, NULL, NULL)
+
+  FREEME(app, NULL)
+} END_TEST;
+
+Suite *main_suite(void) {
+  Suite *s = NULL;
+  TCase *tc_core = NULL;
+
+  s = suite_create("TestComposite");
+
+  /* Core test case */
+  tc_core = tcase_create("Core");
+
+  tcase_add_test(tc_core, test_composite_vs_raster);
+  suite_add_tcase(s, tc_core);
+
+  return s;
+}
+
+int main (void) {
+  int number_failed;
+  SRunner *sr = NULL;
+
+  sr = srunner_create(main_suite());
+
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  sr = NULL;
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,202 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright (c) 2019-2020 Vincent Davis Jr.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*/
+
+#define LUCUR_DRM_API
+#include <lucom.h>
+#include <check.h>
+
+/**
+* Exercises the atomic commit builder's delta state without a KMS device.
+* Requests are only built in memory, kmsfd stays invalid so commits fail.
+*/
+
+#define PLANE_PROPS 10 /* CRTC_ID, FB_ID, SRC_*, CRTC_* */
+#define FULL_PROPS (PLANE_PROPS + 2 + 1) /* + MODE_ID, ACTIVE, connector CRTC_ID */
+
+static dlu_drm_core *fake_core(void) {
+  dlu_otma_mems ma = { .drmc_cnt = 1, .dod_cnt = 1, .dob_cnt = 2 };
+  if (!dlu_otma(DLU_LARGE_BLOCK_PRIV, ma)) ck_abort_msg(NULL);
+
+  dlu_drm_core *core = dlu_drm_init_core();
+  ck_assert_ptr_nonnull(core);
+  ck_assert(dlu_otba(DLU_DEVICE_OUTPUT_DATA, core, INDEX_IGNORE, 1));
+  ck_assert(dlu_otba(DLU_DEVICE_OUTPUT_BUFF_DATA, core, INDEX_IGNORE, 2));
+
+  struct _output_data *od = &core->output_data[0];
+  snprintf(od->name, sizeof(od->name), "FAKE-1");
+  od->pp_id = 31; od->crtc_id = 41; od->conn_id = 51;
+  od->mode.hdisplay = 1920; od->mode.vdisplay = 1080;
+  od->mode_blob_id = 61;
+
+  for (uint32_t i = 0; i < DLU_DRM_PLANE__CNT; i++) od->props.plane[i].prop_id = 100 + i;
+  for (uint32_t i = 0; i < DLU_DRM_CRTC__CNT; i++) od->props.crtc[i].prop_id = 200 + i;
+  for (uint32_t i = 0; i < DLU_DRM_CONNECTOR__CNT; i++) od->props.conn[i].prop_id = 300 + i;
+
+  for (uint32_t i = 0; i < 2; i++) {
+    core->buff_data[i].odid = 0;
+    core->buff_data[i].fb_id = 71 + i;
+  }
+
+  return core;
+}
+
+static void free_core(dlu_drm_core *core) {
+  /* None of these exist on a device */
+  core->output_data[0].mode_blob_id = 0;
+  for (uint32_t i = 0; i < core->odbc; i++) core->buff_data[i].fb_id = 0;
+
+  dlu_drm_freeup_core(core);
+  dlu_release_blocks();
+}
+
+/* What a successful dlu_drm_atomic_commit() records, the kernel isn't there to take it */
+static void fake_commit(dlu_drm_core *core) {
+  for (uint32_t i = 0; i < core->odc; i++) {
+    if (!core->output_data[i].queued) continue;
+    core->output_data[i].committed = core->output_data[i].pending;
+    core->output_data[i].valid = true;
+    core->output_data[i].queued = false;
+  }
+}
+
+START_TEST(atomic_delta_state) {
+  dlu_drm_core *core = fake_core();
+  struct _output_data *od = &core->output_data[0];
+
+  /* Nothing committed yet, every property goes in */
+  ck_assert(dlu_drm_atomic_begin(core));
+  ck_assert(dlu_drm_atomic_add_output(core, 0));
+  ck_assert_int_eq(drmModeAtomicGetCursor(core->atomic.req), FULL_PROPS);
+  ck_assert(core->atomic.modeset);
+  ck_assert(od->queued);
+  ck_assert_uint_eq(od->queued_bi, 0);
+  ck_assert_uint_eq(od->pending.plane[DLU_DRM_PLANE_FB_ID], 71);
+  ck_assert_uint_eq(od->pending.plane[DLU_DRM_PLANE_SRC_W], 1920 << 16);
+  ck_assert_uint_eq(od->pending.crtc[DLU_DRM_CRTC_MODE_ID], 61);
+
+  /* A failed commit records nothing, the next frame sends it all again */
+  ck_assert_int_ne(dlu_drm_atomic_commit(core), 0);
+  ck_assert(!od->valid);
+  ck_assert_uint_eq(od->flip_bi, UINT32_MAX);
+
+  ck_assert(dlu_drm_atomic_begin(core));
+  ck_assert_int_eq(drmModeAtomicGetCursor(core->atomic.req), 0);
+  ck_assert(!core->atomic.modeset);
+  ck_assert(!od->queued);
+  ck_assert(dlu_drm_atomic_add_output(core, 0));
+  ck_assert_int_eq(drmModeAtomicGetCursor(core->atomic.req), FULL_PROPS);
+  fake_commit(core);
+
+  /* Same buffer again, only FB_ID */
+  ck_assert(dlu_drm_atomic_begin(core));
+  ck_assert(dlu_drm_atomic_add_output(core, 0));
+  ck_assert_int_eq(drmModeAtomicGetCursor(core->atomic.req), 1);
+  ck_assert(!core->atomic.modeset);
+  fake_commit(core);
+
+  /* Flip to the other buffer, still only FB_ID */
+  ck_assert(dlu_drm_atomic_begin(core));
+  ck_assert(dlu_drm_atomic_add_output(core, 1));
+  ck_assert_int_eq(drmModeAtomicGetCursor(core->atomic.req), 1);
+  ck_assert(!core->atomic.modeset);
+  ck_assert_uint_eq(od->queued_bi, 1);
+  ck_assert_uint_eq(od->pending.plane[DLU_DRM_PLANE_FB_ID], 72);
+  fake_commit(core);
+
+  /* New mode, FB_ID + SRC_W/H + CRTC_W/H + MODE_ID and a modeset */
+  od->mode.hdisplay = 1280; od->mode.vdisplay = 720;
+  od->mode_blob_id = 62;
+  ck_assert(dlu_drm_atomic_begin(core));
+  ck_assert(dlu_drm_atomic_add_output(core, 1));
+  ck_assert_int_eq(drmModeAtomicGetCursor(core->atomic.req), 6);
+  ck_assert(core->atomic.modeset);
+  fake_commit(core);
+
+  /* Someone else touched KMS, back to everything */
+  dlu_drm_atomic_invalidate(core, 0);
+  ck_assert(dlu_drm_atomic_begin(core));
+  ck_assert(dlu_drm_atomic_add_output(core, 1));
+  ck_assert_int_eq(drmModeAtomicGetCursor(core->atomic.req), FULL_PROPS);
+
+  free_core(core);
+} END_TEST;
+
+START_TEST(atomic_add_output_rollback) {
+  dlu_drm_core *core = fake_core();
+  struct _output_data *od = &core->output_data[0];
+
+  /* The connector property is the last one added, everything before it has to come back out */
+  od->props.conn[DLU_DRM_CONNECTOR_CRTC_ID].prop_id = 0;
+
+  ck_assert(dlu_drm_atomic_begin(core));
+  ck_assert(!dlu_drm_atomic_add_output(core, 0));
+  ck_assert_int_eq(drmModeAtomicGetCursor(core->atomic.req), 0);
+  ck_assert(!core->atomic.modeset);
+  ck_assert(!od->queued);
+
+  /* Properties kept in the base survive, and so does the modeset they need */
+  od->props.conn[DLU_DRM_CONNECTOR_CRTC_ID].prop_id = 300 + DLU_DRM_CONNECTOR_CRTC_ID;
+  ck_assert(dlu_drm_atomic_add_output(core, 0));
+  dlu_drm_atomic_set_base(core);
+  ck_assert(core->atomic.base_modeset);
+
+  ck_assert(dlu_drm_atomic_begin(core));
+  ck_assert_int_eq(drmModeAtomicGetCursor(core->atomic.req), FULL_PROPS);
+  ck_assert(core->atomic.modeset);
+
+  od->props.conn[DLU_DRM_CONNECTOR_CRTC_ID].prop_id = 0;
+  ck_assert(!dlu_drm_atomic_add_output(core, 0));
+  ck_assert_int_eq(drmModeAtomicGetCursor(core->atomic.req), FULL_PROPS);
+  ck_assert(core->atomic.modeset);
+
+  free_core(core);
+} END_TEST;
+
+Suite *drm_atomic_suite(void) {
+  Suite *s = NULL;
+  TCase *tc_core = NULL;
+
+  s = suite_create("DrmAtomic");
+
+  /* Core test case */
+  tc_core = tcase_create("Core");
+
+  tcase_add_test(tc_core, atomic_delta_state);
+  tcase_add_test(tc_core, atomic_add_output_rollback);
+  suite_add_tcase(s, tc_core);
+
+  return s;
+}
+
+int main(void) {
+  int number_failed;
+
+  Suite *s = drm_atomic_suite();
+  SRunner *sr = srunner_create(s);
+
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
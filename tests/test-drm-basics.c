@@ -29,6 +29,8 @@
 /* For Libinput input event codes */
 #include <linux/input-event-codes.h>
 
+#include <poll.h>
+
 static void free_core(dlu_drm_core *core) {
   dlu_drm_freeup_core(core);
   dlu_release_blocks();
@@ -121,6 +123,105 @@ exit_create_kms_node:
   free_core(core);
 } END_TEST;
 
+START_TEST(kms_atomic_input_to_photon) {
+  dlu_otma_mems ma = { .drmc_cnt = 1, .dod_cnt = 1, .dob_cnt = 1 };
+
+  if (!dlu_otma(DLU_LARGE_BLOCK_PRIV, ma))
+    ck_abort_msg(NULL);
+
+  dlu_drm_core *core = dlu_drm_init_core();
+
+  if (!dlu_otba(DLU_DEVICE_OUTPUT_DATA, core, INDEX_IGNORE, 1))
+    ck_abort_msg(NULL);
+
+  if (!dlu_otba(DLU_DEVICE_OUTPUT_BUFF_DATA, core, INDEX_IGNORE, 1))
+    ck_abort_msg(NULL);
+
+  /**
+  * RUN IN TTY:
+  * First creates a logind session. This allows for access to
+  * privileged devices without being root.
+  * Then find a suitable kms node = drm device = gpu
+  */
+  if (!dlu_drm_create_session(core))
+    goto exit_atomic_commit; // Exit if not in a tty
+
+  if (!dlu_drm_create_kms_node(core, NULL)) {
+    free_core(core);
+    ck_abort_msg(NULL);
+  }
+
+  dlu_drm_device_info dinfo[1];
+  if (!dlu_drm_q_output_dev_info(core, dinfo) ) {
+    free_core(core);
+    ck_abort_msg(NULL);
+  }
+
+  uint32_t cur_odb = 0, cur_bi = 0;
+  /* indexes for my particular system kms node */
+  if (!dlu_drm_kms_node_enum_ouput_dev(core, cur_odb, dinfo->conn_idx, dinfo->enc_idx, dinfo->crtc_idx, dinfo->plane_idx, dinfo->refresh, dinfo->conn_name)) {
+    free_core(core);
+    ck_abort_msg(NULL);
+  }
+
+  if (!dlu_drm_create_gbm_device(core)) {
+    free_core(core);
+    ck_abort_msg(NULL);
+  }
+
+  uint32_t bo_flags = GBM_BO_USE_RENDERING | GBM_BO_USE_SCANOUT;
+  if (!dlu_drm_create_fb(DLU_DRM_GBM_BO, core, cur_bi, cur_odb, GBM_BO_FORMAT_ARGB8888, 24, 32, bo_flags, 0)) {
+    free_core(core);
+    ck_abort_msg(NULL);
+  }
+
+  /* Input-to-photon: tag the buffer as if a key was just pressed, its flip event reports the latency */
+  dlu_prof_enable(true);
+  core->input.pending_ns = dlu_hrnst();
+  dlu_drm_input_tag_frame(core, cur_bi);
+
+  struct pollfd pfd = { .fd = core->device.kmsfd, .events = POLLIN };
+  drmEventContext ev = { .version = DRM_EVENT_CONTEXT_VERSION };
+
+  /**
+  * The first commit is the modeset, nothing was committed on the output yet.
+  * The second shows the same buffer again, only FB_ID changes hands.
+  */
+  for (uint32_t i = 0; i < 2; i++) {
+    if (!dlu_drm_atomic_begin(core) || !dlu_drm_atomic_add_output(core, cur_bi)) {
+      free_core(core);
+      ck_abort_msg(NULL);
+    }
+
+    ck_assert(core->atomic.modeset == !i);
+
+    if (dlu_drm_atomic_commit(core)) {
+      free_core(core);
+      ck_abort_msg(NULL);
+    }
+
+    while (core->output_data[cur_odb].flip_bi != UINT32_MAX) {
+      if (poll(&pfd, 1, 1000) <= 0 || dlu_drm_do_handle_event_core(core, &ev)) {
+        free_core(core);
+        ck_abort_msg(NULL);
+      }
+    }
+  }
+
+  ck_assert_uint_eq(core->buff_data[cur_bi].input_ns, 0);
+
+  dlu_prof_stats stats;
+  if (core->device.ts_monotonic && (!dlu_prof_get_stats(DLU_PROF_INPUT_TO_PHOTON, &stats) || stats.count != 1)) {
+    free_core(core);
+    ck_abort_msg(NULL);
+  }
+
+  dlu_prof_freeup();
+
+exit_atomic_commit:
+  free_core(core);
+} END_TEST;
+
 START_TEST(test_libinput_esc) {
   dlu_otma_mems ma = { .drmc_cnt = 1 };
 
@@ -165,6 +266,7 @@ Suite *alloc_suite(void) {
 
   tcase_add_test(tc_core, init_create_kms_node);
   tcase_add_test(tc_core, kms_node_enumeration_gbm_bo_creation);
+  tcase_add_test(tc_core, kms_atomic_input_to_photon);
   tcase_add_test(tc_core, test_libinput_esc);
   suite_add_tcase(s, tc_core);
 
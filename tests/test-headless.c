@@ -0,0 +1,230 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright (c) 2019-2020 Vincent Davis Jr.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*/
+
+
+#include <check.h>
+
+#define LUCUR_VKCOMP_API
+#include <lucom.h>
+
+#include "wayland/client.h"
+#include "test-extras.h"
+
+#define WIDTH 64
+#define HEIGHT 64
+#define FRAMES 4
+
+static dlu_otma_mems ma = {
+  .vkcomp_cnt = 1, .scd_cnt = 1, .gpd_cnt = 1,
+  .cmdd_cnt = 1, .ld_cnt = 1, .pd_cnt = 1
+};
+
+static bool init_buffs(vkcomp *app) {
+  bool err;
+
+  err = dlu_otba(DLU_PD_DATA, app, INDEX_IGNORE, ma.pd_cnt);
+  if (!err) return err;
+
+  err = dlu_otba(DLU_LD_DATA, app, INDEX_IGNORE, ma.ld_cnt);
+  if (!err) return err;
+
+  err = dlu_otba(DLU_SC_DATA, app, INDEX_IGNORE, ma.scd_cnt);
+  if (!err) return err;
+
+  err = dlu_otba(DLU_GP_DATA, app, INDEX_IGNORE, ma.gpd_cnt);
+  if (!err) return err;
+
+  err = dlu_otba(DLU_CMD_DATA, app, INDEX_IGNORE, ma.cmdd_cnt);
+  if (!err) return err;
+
+  return err;
+}
+
+/* Every texel must hold the clear color, R8G8B8A8_UNORM red */
+static bool check_pixels(const uint8_t *pixels, VkDeviceSize row_pitch) {
+  for (uint32_t y = 0; y < HEIGHT; y++) {
+    const uint8_t *row = pixels + (y * row_pitch);
+    for (uint32_t x = 0; x < WIDTH; x++)
+      if (row[x * 4] != 255 || row[x * 4 + 1] != 0 || row[x * 4 + 2] != 0 || row[x * 4 + 3] != 255)
+        return false;
+  }
+
+  return true;
+}
+
+START_TEST(test_vulkan_headless_readback) {
+  VkResult err;
+
+  if (!dlu_otma(DLU_LARGE_BLOCK_PRIV, ma)) ck_abort_msg(NULL);
+
+  vkcomp *app = dlu_init_vk();
+  check_err(!app, NULL, NULL, NULL)
+
+  err = init_buffs(app);
+  check_err(!err, app, NULL, NULL)
+
+  /* No surface, so no WSI extensions either */
+  err = dlu_create_instance(app, "Headless", "No Engine", 0, NULL, 0, NULL);
+  check_err(err, app, NULL, NULL)
+
+  VkPhysicalDeviceProperties device_props;
+  VkPhysicalDeviceFeatures device_feats;
+  uint32_t cur_pd = 0, cur_ld = 0;
+
+  dlu_pd_criteria criteria = {};
+  criteria.type = VK_PHYSICAL_DEVICE_TYPE_MAX_ENUM;
+  err = dlu_select_physical_device(app, cur_pd, &criteria, &device_props, &device_feats);
+  check_err(err, app, NULL, NULL)
+
+  err = dlu_create_queue_families(app, cur_pd, VK_QUEUE_GRAPHICS_BIT);
+  check_err(err, app, NULL, NULL)
+
+  float queue_priorities[1] = {1.0};
+  VkDeviceQueueCreateInfo dqueue_create_info[1];
+  dqueue_create_info[0] = dlu_set_device_queue_info(0, app->pd_data[cur_pd].gfam_idx, 1, queue_priorities);
+
+  err = dlu_create_logical_device(app, cur_pd, cur_ld, 0, ARR_LEN(dqueue_create_info), dqueue_create_info, &device_feats, 0, NULL);
+  check_err(err, app, NULL, NULL)
+
+  err = dlu_create_device_queue(app, cur_ld, 0, VK_QUEUE_GRAPHICS_BIT);
+  check_err(err, app, NULL, NULL)
+
+  uint32_t cur_scd = 0, cur_pool = 0, cur_gpd = 0;
+  VkExtent2D extent2D = {WIDTH, HEIGHT};
+  VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+
+  err = dlu_otba(DLU_SC_DATA_MEMS, app, cur_scd, 2);
+  check_err(!err, app, NULL, NULL)
+
+  err = dlu_create_headless_target(app, cur_ld, cur_scd, format, extent2D, 2, 0);
+  check_err(err, app, NULL, NULL)
+
+  err = dlu_create_cmd_pool(app, cur_ld, cur_scd, cur_pool, app->pd_data[cur_pd].gfam_idx, 0);
+  check_err(err, app, NULL, NULL)
+
+  err = dlu_create_cmd_buffs(app, cur_pool, cur_scd, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+  check_err(err, app, NULL, NULL)
+
+  err = dlu_create_syncs(app, cur_scd);
+  check_err(err, app, NULL, NULL)
+
+  /* The readback copies out of COLOR_ATTACHMENT_OPTIMAL, no present layout needed */
+  VkAttachmentDescription color_attachment = dlu_set_attachment_desc(format,
+    VK_SAMPLE_COUNT_1_BIT, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE,
+    VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_DONT_CARE, VK_IMAGE_LAYOUT_UNDEFINED,
+    VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+  );
+
+  VkAttachmentReference color_attachment_ref = dlu_set_attachment_ref(0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+  VkSubpassDescription subpass = dlu_set_subpass_desc(0, VK_PIPELINE_BIND_POINT_GRAPHICS, 0, NULL, 1, &color_attachment_ref, NULL, NULL, 0, NULL);
+
+  VkSubpassDependency subdep = dlu_set_subpass_dep(VK_SUBPASS_EXTERNAL, 0,
+    VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+    0, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, 0
+  );
+
+  err = dlu_create_render_pass(app, cur_gpd, 1, &color_attachment, 1, &subpass, 1, &subdep, 0);
+  check_err(err, app, NULL, NULL)
+
+  VkImageView vkimg_attach[1];
+  err = dlu_create_framebuffers(app, cur_scd, cur_gpd, 1, vkimg_attach, extent2D.width, extent2D.height, 1);
+  check_err(err, app, NULL, NULL)
+
+  float float32[4] = {1.0f, 0.0f, 0.0f, 1.0f};
+  int32_t int32[4] = {1, 0, 0, 1};
+  uint32_t uint32[4] = {1, 0, 0, 1};
+  VkClearValue clear_value = dlu_set_clear_value(float32, int32, uint32, 0.0f, 0);
+
+  err = dlu_exec_begin_cmd_buffs(app, cur_pool, cur_scd, 0, NULL);
+  check_err(err, app, NULL, NULL)
+
+  dlu_exec_begin_render_pass(app, cur_pool, cur_scd, cur_gpd, 0, 0, extent2D.width, extent2D.height, 1, &clear_value, VK_SUBPASS_CONTENTS_INLINE);
+  dlu_exec_stop_render_pass(app, cur_pool, cur_scd);
+
+  /* Command buffer i renders into image i */
+  for (uint32_t i = 0; i < app->sc_data[cur_scd].sic; i++)
+    dlu_headless_record_readback(app, cur_pool, i, cur_scd, i, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+
+  err = dlu_exec_stop_cmd_buffs(app, cur_pool, cur_scd);
+  check_err(err, app, NULL, NULL)
+
+  /**
+  * Every frame goes through sync 0, so its render fence is reset and reused
+  * while earlier readbacks are still unread. Each readback waits on its own fence.
+  */
+  for (uint32_t frame = 0; frame < FRAMES; frame++) {
+    uint32_t cur_img = dlu_headless_acquire(app, cur_scd);
+    VkCommandBuffer cmd_buffs[1] = {app->cmd_data[cur_pool].cmd_buffs[cur_img]};
+
+    err = dlu_vk_sync(DLU_VK_WAIT_RENDER_FENCE, app, cur_scd, 0);
+    check_err(err, app, NULL, NULL)
+
+    err = dlu_vk_sync(DLU_VK_RESET_RENDER_FENCE, app, cur_scd, 0);
+    check_err(err, app, NULL, NULL)
+
+    err = dlu_queue_graphics_queue(app, cur_scd, 0, 1, cmd_buffs, 0, NULL, NULL, 0, NULL);
+    check_err(err, app, NULL, NULL)
+
+    err = dlu_headless_queue_readback(app, cur_scd, cur_img);
+    check_err(err, app, NULL, NULL)
+  }
+
+  for (uint32_t i = 0; i < app->sc_data[cur_scd].sic; i++) {
+    VkDeviceSize row_pitch = 0;
+    const uint8_t *pixels = dlu_headless_get_frame(app, cur_scd, i, VK_TRUE, &row_pitch);
+    check_err(!pixels, app, NULL, NULL)
+    check_err(row_pitch != WIDTH * 4, app, NULL, NULL)
+    check_err(!check_pixels(pixels, row_pitch), app, NULL, NULL)
+  }
+
+  FREEME(app, NULL)
+} END_TEST;
+
+Suite *main_suite(void) {
+  Suite *s = NULL;
+  TCase *tc_core = NULL;
+
+  s = suite_create("TestHeadless");
+
+  /* Core test case */
+  tc_core = tcase_create("Core");
+
+  tcase_add_test(tc_core, test_vulkan_headless_readback);
+  suite_add_tcase(s, tc_core);
+
+  return s;
+}
+
+int main (void) {
+  int number_failed;
+  SRunner *sr = NULL;
+
+  sr = srunner_create(main_suite());
+
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  sr = NULL;
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
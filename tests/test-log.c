@@ -0,0 +1,265 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright (c) 2019-2020 Vincent Davis Jr.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*/
+
+#include <lucom.h>
+#include <check.h>
+
+#define RESET "\x1b[0m"
+
+/* Everything written to stream so far, caller frees */
+static char *read_stream(FILE *stream) {
+  fflush(stream);
+  long size = ftell(stream);
+  rewind(stream);
+
+  char *str = calloc(1, size + 1);
+  ck_assert_ptr_nonnull(str);
+  ck_assert_uint_eq(fread(str, 1, size, stream), size);
+  fseek(stream, 0, SEEK_END);
+
+  return str;
+}
+
+/* Log through the ring and check the writer formatted it like printf would */
+#define CHECK_LOG(stream, fmt, ...) \
+  do { \
+    char _expect[512]; \
+    snprintf(_expect, sizeof(_expect), "- " fmt RESET "\n", ##__VA_ARGS__); \
+    _dlu_log_me(DLU_NONE, stream, fmt, ##__VA_ARGS__); \
+    dlu_log_flush(); \
+    char *_out = read_stream(stream); \
+    ck_assert_msg(strstr(_out, _expect), "expected \"%s\" in \"%s\"", _expect, _out); \
+    free(_out); \
+  } while (0)
+
+/* Point stdout at a temporary file for the dlu_log_me() family, returns the saved fd */
+static int capture_stdout(FILE **stream) {
+  fflush(stdout);
+  *stream = tmpfile();
+  ck_assert_ptr_nonnull(*stream);
+
+  int saved = dup(STDOUT_FILENO);
+  ck_assert_int_ne(saved, NEG_ONE);
+  ck_assert_int_ne(dup2(fileno(*stream), STDOUT_FILENO), NEG_ONE);
+  return saved;
+}
+
+static char *release_stdout(FILE *stream, int saved) {
+  dlu_log_flush();
+  fflush(stdout);
+  dup2(saved, STDOUT_FILENO);
+  close(saved);
+
+  fseek(stream, 0, SEEK_END);
+  char *str = read_stream(stream);
+  fclose(stream);
+  return str;
+}
+
+static uint32_t count_str(const char *str, const char *needle) {
+  uint32_t count = 0;
+  for (const char *p = strstr(str, needle); p; p = strstr(p + 1, needle)) count++;
+  return count;
+}
+
+START_TEST(log_ring_encoder) {
+  FILE *stream = tmpfile();
+  ck_assert_ptr_nonnull(stream);
+
+  const char *str = "lucurious";
+  int value = -42;
+  size_t size = 123456789;
+  intmax_t imax = -9876543210;
+  void *ptr = &value;
+
+  CHECK_LOG(stream, "plain message");
+  CHECK_LOG(stream, "%d %i %u %x %X %o", value, 7, 4000000000u, 0xbeef, 0xbeef, 8);
+  CHECK_LOG(stream, "%ld %lu %lld %llu", -5L, 5UL, -1234567890123LL, 1234567890123ULL);
+  CHECK_LOG(stream, "%zu %zd %jd", size, (ssize_t) -3, imax);
+  CHECK_LOG(stream, "%hhu %hd %c", (unsigned char) 250, (short) -300, 'z');
+  CHECK_LOG(stream, "%s|%-12s|%.3s|%12s", str, str, str, "");
+  CHECK_LOG(stream, "%*d|%-*d|%.*f|%*.*e", 6, 42, 6, 42, 2, 3.14159, 12, 3, 2.5e-7);
+  CHECK_LOG(stream, "%f %e %g %G %a", 1.5, -2.25e10, 0.0001, 1e20, 1.0);
+  CHECK_LOG(stream, "%Lf", (long double) 2.75);
+  CHECK_LOG(stream, "%p %p", ptr, NULL);
+  CHECK_LOG(stream, "100%% %s%%", "done");
+  CHECK_LOG(stream, "%08.3f|%+d|% d|%#x|%-5u|", 3.14159, 5, 5, 255, 7u);
+
+  /* Writing synchronously gives the same text */
+  dlu_log_async(false);
+  CHECK_LOG(stream, "%s %d %.2f %zu", str, value, 1.005, size);
+  dlu_log_async(true);
+
+  fclose(stream);
+} END_TEST;
+
+START_TEST(log_ring_order) {
+  FILE *stream = tmpfile();
+  ck_assert_ptr_nonnull(stream);
+
+  /* Too big for a ring slot, written on this thread once what's queued went out */
+  char big[2048];
+  memset(big, 'b', sizeof(big) - 1);
+  big[sizeof(big) - 1] = '\0';
+
+  for (int i = 0; i < 2000; i++) {
+    if (i == 1000) _dlu_log_me(DLU_NONE, stream, "big %s", big);
+    _dlu_log_me(DLU_NONE, stream, "msg %d", i);
+  }
+  dlu_log_flush();
+
+  char *out = read_stream(stream);
+  const char *p = out;
+  char expect[32];
+  for (int i = 0; i < 2000; i++) {
+    if (i == 1000) {
+      p = strstr(p, "big bbbb");
+      ck_assert_ptr_nonnull(p);
+    }
+    snprintf(expect, sizeof(expect), "msg %d" RESET "\n", i);
+    p = strstr(p, expect);
+    ck_assert_msg(p, "\"msg %d\" missing or out of order", i);
+  }
+
+  free(out);
+  fclose(stream);
+} END_TEST;
+
+START_TEST(log_ratelimit) {
+  uint64_t last = 0;
+
+  /* First call always logs, then nothing until the interval passed */
+  ck_assert(_dlu_log_ratelimit(&last, 60000000000ULL));
+  ck_assert_uint_ne(last, 0);
+  ck_assert(!_dlu_log_ratelimit(&last, 60000000000ULL));
+  ck_assert(!_dlu_log_ratelimit(&last, 60000000000ULL));
+
+  usleep(2000);
+  ck_assert(_dlu_log_ratelimit(&last, 1000000));
+  ck_assert(!_dlu_log_ratelimit(&last, 60000000000ULL));
+
+  /* Built with -Dlog_level above info, the macros have nothing to limit */
+  if (!dlu_log_enabled(DLU_INFO)) return;
+
+  FILE *stream = NULL;
+  int saved = capture_stdout(&stream);
+
+  for (int i = 0; i < 100; i++) {
+    dlu_log_every(60000, DLU_INFO, "every %d", i);
+    dlu_log_once(DLU_INFO, "once %d", i);
+  }
+
+  char *out = release_stdout(stream, saved);
+  ck_assert_uint_eq(count_str(out, "every "), 1);
+  ck_assert_ptr_nonnull(strstr(out, "every 0"));
+  ck_assert_uint_eq(count_str(out, "once "), 1);
+  ck_assert_ptr_nonnull(strstr(out, "once 0"));
+  free(out);
+} END_TEST;
+
+START_TEST(log_levels) {
+  dlu_log_set_level(DLU_LOG_APP, DLU_LOG_LEVEL_WARNING);
+  ck_assert(!dlu_log_enabled(DLU_INFO));
+  ck_assert(!dlu_log_enabled(DLU_SUCCESS));
+  ck_assert(dlu_log_enabled(DLU_WARNING) == (DLU_LOG_MIN_LEVEL <= DLU_LOG_LEVEL_WARNING));
+  ck_assert(dlu_log_enabled(DLU_DANGER) == (DLU_LOG_MIN_LEVEL <= DLU_LOG_LEVEL_DANGER));
+
+  /* Debug is off unless asked for */
+  dlu_log_set_level(DLU_LOG_APP, DLU_LOG_LEVEL_INFO);
+  ck_assert(!dlu_log_enabled(DLU_DEBUG));
+  dlu_log_set_level(DLU_LOG_APP, DLU_LOG_LEVEL_DEBUG);
+  ck_assert(dlu_log_enabled(DLU_DEBUG) == (DLU_LOG_MIN_LEVEL <= DLU_LOG_LEVEL_DEBUG));
+
+  /* Every module starts at info */
+  for (uint32_t i = DLU_LOG_UTILS; i < DLU_LOG_MODULE_MAX; i++)
+    ck_assert_uint_eq(_dlu_log_levels[i], DLU_LOG_LEVEL_INFO);
+
+  dlu_log_set_level(DLU_LOG_MODULE_MAX, DLU_LOG_LEVEL_OFF);
+  for (uint32_t i = 0; i < DLU_LOG_MODULE_MAX; i++)
+    ck_assert_uint_eq(_dlu_log_levels[i], DLU_LOG_LEVEL_OFF);
+  ck_assert(!dlu_log_enabled(DLU_DANGER));
+
+  FILE *stream = NULL;
+  int saved = capture_stdout(&stream);
+  dlu_log_me(DLU_DANGER, "muted");
+  char *out = release_stdout(stream, saved);
+  ck_assert_ptr_null(strstr(out, "muted"));
+  free(out);
+} END_TEST;
+
+START_TEST(log_perr_module) {
+  FILE *stream = NULL;
+  int saved = 0;
+  char *out = NULL;
+
+  /* PERR() is filtered as the module it's called from, this file is DLU_LOG_APP */
+  dlu_log_set_level(DLU_LOG_MODULE_MAX, DLU_LOG_LEVEL_INFO);
+  dlu_log_set_level(DLU_LOG_APP, DLU_LOG_LEVEL_OFF);
+
+  saved = capture_stdout(&stream);
+  PERR(DLU_MEM_TYPE_ERR, 0, NULL)
+  out = release_stdout(stream, saved);
+  ck_assert_ptr_null(strstr(out, "memory_type_from_properties"));
+  free(out);
+
+  dlu_log_set_level(DLU_LOG_APP, DLU_LOG_LEVEL_INFO);
+  dlu_log_set_level(DLU_LOG_UTILS, DLU_LOG_LEVEL_OFF);
+
+  saved = capture_stdout(&stream);
+  PERR(DLU_MEM_TYPE_ERR, 0, NULL)
+  out = release_stdout(stream, saved);
+  ck_assert(strstr(out, "memory_type_from_properties") != NULL || DLU_LOG_MIN_LEVEL > DLU_LOG_LEVEL_DANGER);
+  free(out);
+} END_TEST;
+
+Suite *log_suite(void) {
+  Suite *s = NULL;
+  TCase *tc_core = NULL;
+
+  s = suite_create("Log");
+
+  /* Core test case */
+  tc_core = tcase_create("Core");
+
+  tcase_add_test(tc_core, log_ring_encoder);
+  tcase_add_test(tc_core, log_ring_order);
+  tcase_add_test(tc_core, log_ratelimit);
+  tcase_add_test(tc_core, log_levels);
+  tcase_add_test(tc_core, log_perr_module);
+  suite_add_tcase(s, tc_core);
+
+  return s;
+}
+
+int main(void) {
+  int number_failed;
+
+  Suite *s = log_suite();
+  SRunner *sr = srunner_create(s);
+
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,136 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright (c) 2019-2020 Vincent Davis Jr.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*/
+
+#define LUCUR_VKCOMP_API
+#include <lucom.h>
+#include <check.h>
+
+#include <sys/stat.h>
+
+START_TEST(pcache_header_validation) {
+  char path[] = "/tmp/lucur-pcache-XXXXXX";
+  int fd = mkstemp(path);
+  ck_assert_int_ne(fd, NEG_ONE);
+  close(fd);
+
+  VkPhysicalDeviceProperties props = {};
+  props.vendorID = 0x1002;
+  props.deviceID = 0x67df;
+  props.driverVersion = 0x800000;
+  memset(props.pipelineCacheUUID, 0xab, VK_UUID_SIZE);
+
+  unsigned char blob[256];
+  for (uint32_t i = 0; i < sizeof(blob); i++) blob[i] = (unsigned char) (i * 7);
+
+  size_t size = 0;
+  void *data = NULL;
+
+  /* Empty file, nothing cached */
+  data = dlu_pcache_read(path, &props, &size);
+  ck_assert_ptr_null(data);
+  ck_assert_uint_eq(size, 0);
+
+  ck_assert(dlu_pcache_write(path, &props, blob, sizeof(blob)));
+
+  data = dlu_pcache_read(path, &props, &size);
+  ck_assert_ptr_nonnull(data);
+  ck_assert_uint_eq(size, sizeof(blob));
+  ck_assert(!memcmp(data, blob, sizeof(blob)));
+  free(data);
+
+  /* Written by another device or driver */
+  VkPhysicalDeviceProperties other = props;
+  other.driverVersion++;
+  ck_assert_ptr_null(dlu_pcache_read(path, &other, &size));
+  other = props;
+  other.deviceID++;
+  ck_assert_ptr_null(dlu_pcache_read(path, &other, &size));
+  other = props;
+  other.pipelineCacheUUID[VK_UUID_SIZE - 1] = 0;
+  ck_assert_ptr_null(dlu_pcache_read(path, &other, &size));
+  ck_assert_uint_eq(size, 0);
+
+  struct stat st;
+  ck_assert_int_eq(stat(path, &st), 0);
+
+  /* Flipped byte in the blob, the hash no longer matches */
+  FILE *stream = fopen(path, "r+b");
+  ck_assert_ptr_nonnull(stream);
+  ck_assert_int_eq(fseek(stream, -1, SEEK_END), 0);
+  int c = fgetc(stream);
+  ck_assert_int_eq(fseek(stream, -1, SEEK_END), 0);
+  fputc(c ^ 0xff, stream);
+  fclose(stream);
+  ck_assert_ptr_null(dlu_pcache_read(path, &props, &size));
+
+  /* Truncated and padded files disagree with the header's size */
+  ck_assert(dlu_pcache_write(path, &props, blob, sizeof(blob)));
+  ck_assert_int_eq(truncate(path, st.st_size - 1), 0);
+  ck_assert_ptr_null(dlu_pcache_read(path, &props, &size));
+
+  ck_assert(dlu_pcache_write(path, &props, blob, sizeof(blob)));
+  ck_assert_int_eq(truncate(path, st.st_size + 1), 0);
+  ck_assert_ptr_null(dlu_pcache_read(path, &props, &size));
+
+  /* Shorter than a header */
+  ck_assert_int_eq(truncate(path, 4), 0);
+  ck_assert_ptr_null(dlu_pcache_read(path, &props, &size));
+
+  /* Rewriting replaces the file as a whole */
+  ck_assert(dlu_pcache_write(path, &props, blob, sizeof(blob) / 2));
+  data = dlu_pcache_read(path, &props, &size);
+  ck_assert_ptr_nonnull(data);
+  ck_assert_uint_eq(size, sizeof(blob) / 2);
+  ck_assert(!memcmp(data, blob, sizeof(blob) / 2));
+  free(data);
+
+  unlink(path);
+} END_TEST;
+
+Suite *pcache_suite(void) {
+  Suite *s = NULL;
+  TCase *tc_core = NULL;
+
+  s = suite_create("Pipeline Cache");
+
+  /* Core test case */
+  tc_core = tcase_create("Core");
+
+  tcase_add_test(tc_core, pcache_header_validation);
+  suite_add_tcase(s, tc_core);
+
+  return s;
+}
+
+int main(void) {
+  int number_failed;
+
+  Suite *s = pcache_suite();
+  SRunner *sr = srunner_create(s);
+
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,181 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright (c) 2019-2020 Vincent Davis Jr.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*/
+
+#include <lucom.h>
+#include <check.h>
+
+/* Whole file as a string, caller frees */
+static char *read_file(const char *path) {
+  FILE *stream = fopen(path, "rb");
+  ck_assert_ptr_nonnull(stream);
+
+  fseek(stream, 0, SEEK_END);
+  long size = ftell(stream);
+  rewind(stream);
+
+  char *str = calloc(1, size + 1);
+  ck_assert_ptr_nonnull(str);
+  ck_assert_uint_eq(fread(str, 1, size, stream), size);
+  fclose(stream);
+
+  return str;
+}
+
+START_TEST(prof_disabled) {
+  dlu_prof_stats stats;
+
+  dlu_prof_enable(false);
+  dlu_prof_record(DLU_PROF_USER, "off", 1000, 2000);
+  dlu_prof_mark_begin(DLU_PROF_RECORD);
+  dlu_prof_mark_end(DLU_PROF_RECORD, "off");
+  { DLU_PROF_ZONE(DLU_PROF_SUBMIT, "off"); }
+
+  ck_assert(dlu_prof_get_stats(DLU_PROF_USER, &stats));
+  ck_assert_uint_eq(stats.count, 0);
+  ck_assert(dlu_prof_get_stats(DLU_PROF_RECORD, &stats));
+  ck_assert_uint_eq(stats.count, 0);
+  ck_assert(dlu_prof_get_stats(DLU_PROF_SUBMIT, &stats));
+  ck_assert_uint_eq(stats.count, 0);
+
+  ck_assert(!dlu_prof_get_stats(DLU_PROF_PHASE_MAX, &stats));
+} END_TEST;
+
+START_TEST(prof_stats_percentiles) {
+  dlu_prof_stats stats;
+
+  dlu_prof_enable(true);
+
+  /* 1..100 us recorded out of order, 37 and 100 are coprime so every value shows up once */
+  for (uint64_t i = 0; i < 100; i++)
+    dlu_prof_record(DLU_PROF_USER, "user", 1000, 1000 + ((i * 37) % 100 + 1) * 1000);
+
+  ck_assert(dlu_prof_get_stats(DLU_PROF_USER, &stats));
+  ck_assert_uint_eq(stats.count, 100);
+  ck_assert_uint_eq(stats.p50, 50000);
+  ck_assert_uint_eq(stats.p99, 99000);
+  ck_assert_uint_eq(stats.max, 100000);
+
+  /* Other phases keep their own window */
+  ck_assert(dlu_prof_get_stats(DLU_PROF_ACQUIRE, &stats));
+  ck_assert_uint_eq(stats.count, 0);
+
+  dlu_prof_freeup();
+} END_TEST;
+
+START_TEST(prof_stats_window) {
+  dlu_prof_stats stats;
+
+  dlu_prof_enable(true);
+
+  /* Only the most recent 1024 samples count, 1977..3000 */
+  for (uint64_t i = 1; i <= 3000; i++)
+    dlu_prof_record(DLU_PROF_PRESENT, NULL, 1, 1 + i);
+
+  ck_assert(dlu_prof_get_stats(DLU_PROF_PRESENT, &stats));
+  ck_assert_uint_eq(stats.count, 1024);
+  ck_assert_uint_eq(stats.p50, 1977 + 1023 * 50 / 100);
+  ck_assert_uint_eq(stats.p99, 1977 + 1023 * 99 / 100);
+  ck_assert_uint_eq(stats.max, 3000);
+
+  dlu_prof_freeup();
+} END_TEST;
+
+START_TEST(prof_zones_export_chrome) {
+  char path[] = "/tmp/lucur-prof-XXXXXX";
+  int fd = mkstemp(path);
+  ck_assert_int_ne(fd, NEG_ONE);
+  close(fd);
+
+  dlu_prof_stats stats;
+  dlu_prof_enable(true);
+
+  { DLU_PROF_ZONE(DLU_PROF_SUBMIT, "zone \"quoted\""); usleep(1000); }
+
+  dlu_prof_mark_begin(DLU_PROF_RECORD);
+  usleep(1000);
+  dlu_prof_mark_end(DLU_PROF_RECORD, "mark");
+
+  /* An end without a begin is dropped */
+  dlu_prof_mark_end(DLU_PROF_RECORD, "mark");
+
+  dlu_prof_record(DLU_PROF_USER, NULL, 2000, 5000);
+
+  ck_assert(dlu_prof_get_stats(DLU_PROF_SUBMIT, &stats));
+  ck_assert_uint_eq(stats.count, 1);
+  ck_assert_uint_ge(stats.max, 1000000);
+  ck_assert(dlu_prof_get_stats(DLU_PROF_RECORD, &stats));
+  ck_assert_uint_eq(stats.count, 1);
+  ck_assert_uint_ge(stats.max, 1000000);
+
+  ck_assert(dlu_prof_export_chrome(path));
+  char *json = read_file(path);
+  ck_assert_ptr_nonnull(strstr(json, "{\"traceEvents\":["));
+  ck_assert_ptr_nonnull(strstr(json, "\"name\":\"zone \\\"quoted\\\"\",\"cat\":\"submit\""));
+  ck_assert_ptr_nonnull(strstr(json, "\"name\":\"mark\",\"cat\":\"record\""));
+  ck_assert_ptr_nonnull(strstr(json, "\"name\":\"user\",\"cat\":\"user\",\"ph\":\"X\",\"ts\":2.000,\"dur\":3.000"));
+  free(json);
+
+  /* Freed rings are gone from the export, the next zone starts a fresh one */
+  dlu_prof_freeup();
+  dlu_prof_record(DLU_PROF_USER, "after", 2000, 3000);
+
+  ck_assert(dlu_prof_export_chrome(path));
+  json = read_file(path);
+  ck_assert_ptr_null(strstr(json, "\"name\":\"mark\""));
+  ck_assert_ptr_nonnull(strstr(json, "\"name\":\"after\""));
+  free(json);
+
+  dlu_prof_freeup();
+  unlink(path);
+} END_TEST;
+
+Suite *prof_suite(void) {
+  Suite *s = NULL;
+  TCase *tc_core = NULL;
+
+  s = suite_create("Prof");
+
+  /* Core test case */
+  tc_core = tcase_create("Core");
+
+  tcase_add_test(tc_core, prof_disabled);
+  tcase_add_test(tc_core, prof_stats_percentiles);
+  tcase_add_test(tc_core, prof_stats_window);
+  tcase_add_test(tc_core, prof_zones_export_chrome);
+  suite_add_tcase(s, tc_core);
+
+  return s;
+}
+
+int main(void) {
+  int number_failed;
+
+  Suite *s = prof_suite();
+  SRunner *sr = srunner_create(s);
+
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
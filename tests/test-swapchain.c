@@ -0,0 +1,288 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright (c) 2019-2020 Vincent Davis Jr.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*/
+
+#include <check.h>
+
+#define LUCUR_VKCOMP_API
+#include <lucom.h>
+
+#include "wayland/client.h"
+#include "test-extras.h"
+
+#define WIDTH 800
+#define HEIGHT 600
+#define FRAMES 8
+
+static dlu_otma_mems ma = {
+  .vkcomp_cnt = 1, .scd_cnt = 1, .gpd_cnt = 1,
+  .cmdd_cnt = 1, .ld_cnt = 1, .pd_cnt = 1
+};
+
+/* Skipped by dlu_create_logical_device() when missing, pacing then falls back to fences */
+static const char *pace_extensions[] = {
+  VK_KHR_SWAPCHAIN_EXTENSION_NAME,
+  VK_KHR_PRESENT_ID_EXTENSION_NAME,
+  VK_KHR_PRESENT_WAIT_EXTENSION_NAME
+};
+
+static bool init_buffs(vkcomp *app) {
+  bool err;
+
+  err = dlu_otba(DLU_PD_DATA, app, INDEX_IGNORE, ma.pd_cnt);
+  if (!err) return err;
+
+  err = dlu_otba(DLU_LD_DATA, app, INDEX_IGNORE, ma.ld_cnt);
+  if (!err) return err;
+
+  err = dlu_otba(DLU_SC_DATA, app, INDEX_IGNORE, ma.scd_cnt);
+  if (!err) return err;
+
+  err = dlu_otba(DLU_GP_DATA, app, INDEX_IGNORE, ma.gpd_cnt);
+  if (!err) return err;
+
+  err = dlu_otba(DLU_CMD_DATA, app, INDEX_IGNORE, ma.cmdd_cnt);
+  if (!err) return err;
+
+  return err;
+}
+
+/* Command buffers reference the framebuffers, so they're recorded again after every recreation */
+static VkResult record_clear(vkcomp *app, uint32_t cur_pool, uint32_t cur_scd, uint32_t cur_gpd) {
+  VkResult err;
+
+  float float32[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+  int32_t int32[4] = {0, 0, 0, 1};
+  uint32_t uint32[4] = {0, 0, 0, 1};
+  VkClearValue clear_value = dlu_set_clear_value(float32, int32, uint32, 0.0f, 0);
+  VkExtent2D extent2D = app->sc_data[cur_scd].extent;
+
+  err = dlu_exec_begin_cmd_buffs(app, cur_pool, cur_scd, 0, NULL);
+  if (err) return err;
+
+  dlu_exec_begin_render_pass(app, cur_pool, cur_scd, cur_gpd, 0, 0, extent2D.width, extent2D.height, 1, &clear_value, VK_SUBPASS_CONTENTS_INLINE);
+  dlu_exec_stop_render_pass(app, cur_pool, cur_scd);
+
+  return dlu_exec_stop_cmd_buffs(app, cur_pool, cur_scd);
+}
+
+/* One paced frame, any VK_TIMEOUT from dlu_wait_present_latency() is a failure */
+static VkResult draw_frame(vkcomp *app, uint32_t cur_ld, uint32_t cur_pool, uint32_t cur_scd) {
+  VkResult err;
+  uint32_t cur_img;
+
+  err = dlu_vk_sync(DLU_VK_WAIT_RENDER_FENCE, app, cur_scd, 0);
+  if (err) return err;
+
+  err = dlu_wait_present_latency(app, cur_scd, GENERAL_TIMEOUT);
+  if (err) return err;
+
+  err = dlu_acquire_sc_image_index(app, cur_scd, 0, &cur_img);
+  if (err) return err;
+
+  err = dlu_vk_sync(DLU_VK_RESET_RENDER_FENCE, app, cur_scd, 0);
+  if (err) return err;
+
+  VkPipelineStageFlags pipe_stage_flags[1] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+  VkSemaphore acquire_sems[1] = {app->sc_data[cur_scd].syncs[0].sem.image};
+  VkSemaphore render_sems[1] = {app->sc_data[cur_scd].syncs[0].sem.render};
+  VkCommandBuffer cmd_buffs[1] = {app->cmd_data[cur_pool].cmd_buffs[cur_img]};
+
+  err = dlu_queue_graphics_queue(app, cur_scd, 0, 1, cmd_buffs, 1, acquire_sems, pipe_stage_flags, 1, render_sems);
+  if (err) return err;
+
+  err = dlu_queue_present_queue(app, cur_ld, 1, render_sems, 1, &app->sc_data[cur_scd].swap_chain, &cur_img, NULL);
+  if (err) return err;
+
+  dlu_retire_swap_chains(app, cur_scd, VK_FALSE);
+
+  return err;
+}
+
+START_TEST(test_vulkan_recreate_then_pace) {
+  VkResult err;
+
+  if (!dlu_otma(DLU_LARGE_BLOCK_PRIV, ma)) ck_abort_msg(NULL);
+
+  wclient *wc = dlu_init_wc();
+  check_err(!wc, NULL, NULL, NULL)
+
+  vkcomp *app = dlu_init_vk();
+  check_err(!app, NULL, wc, NULL)
+
+  err = init_buffs(app);
+  check_err(!err, app, wc, NULL)
+
+  err = dlu_create_instance(app, "Recreate Swapchain", "No Engine", ARR_LEN(enabled_validation_layers), enabled_validation_layers, ARR_LEN(instance_extensions), instance_extensions);
+  check_err(err, app, wc, NULL)
+
+  check_err(!dlu_create_client(wc), app, wc, NULL)
+
+  err = dlu_create_vkwayland_surfaceKHR(app, wc->display, wc->surface);
+  check_err(err, app, wc, NULL)
+
+  VkPhysicalDeviceProperties device_props;
+  VkPhysicalDeviceFeatures device_feats;
+  uint32_t cur_ld = 0, cur_pd = 0;
+  err = dlu_create_physical_device(app, cur_pd, VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU, &device_props, &device_feats);
+  check_err(err, app, wc, NULL)
+
+  err = dlu_create_queue_families(app, cur_pd, VK_QUEUE_GRAPHICS_BIT);
+  check_err(err, app, wc, NULL)
+
+  float queue_priorities[1] = {1.0};
+  VkDeviceQueueCreateInfo dqueue_create_info[1];
+  dqueue_create_info[0] = dlu_set_device_queue_info(0, app->pd_data[cur_pd].gfam_idx, 1, queue_priorities);
+
+  err = dlu_create_logical_device(app, cur_pd, cur_ld, 0, ARR_LEN(dqueue_create_info), dqueue_create_info, &device_feats, ARR_LEN(pace_extensions), pace_extensions);
+  check_err(err, app, wc, NULL)
+
+  err = dlu_create_device_queue(app, cur_ld, 0, VK_QUEUE_GRAPHICS_BIT);
+  check_err(err, app, wc, NULL)
+
+  VkSurfaceCapabilitiesKHR capabilities = dlu_get_physical_device_surface_capabilities(app, cur_pd);
+  check_err(capabilities.minImageCount == UINT32_MAX, app, wc, NULL)
+
+  VkSurfaceFormatKHR surface_fmt = dlu_choose_swap_surface_format(app, cur_pd, VK_FORMAT_B8G8R8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR);
+  check_err(surface_fmt.format == VK_FORMAT_UNDEFINED, app, wc, NULL)
+
+  VkPresentModeKHR pres_mode = dlu_choose_present_mode(app, cur_pd, DLU_PRESENT_LOW_LATENCY_NO_TEAR);
+  check_err(pres_mode == VK_PRESENT_MODE_MAX_ENUM_KHR, app, wc, NULL)
+
+  VkExtent2D extent2D = dlu_choose_swap_extent(capabilities, WIDTH, HEIGHT);
+  check_err(extent2D.width == UINT32_MAX, app, wc, NULL)
+
+  uint32_t cur_scd = 0, cur_pool = 0, cur_gpd = 0;
+  err = dlu_otba(DLU_SC_DATA_MEMS, app, cur_scd, dlu_present_policy_image_count(DLU_PRESENT_LOW_LATENCY_NO_TEAR, pres_mode, capabilities));
+  check_err(!err, app, wc, NULL)
+
+  VkSwapchainCreateInfoKHR swapchain_info = dlu_set_swap_chain_info(NULL, 0, app->surface, app->sc_data[cur_scd].sic, surface_fmt.format, surface_fmt.colorSpace,
+    extent2D, 1, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, VK_SHARING_MODE_EXCLUSIVE, 0, NULL, capabilities.supportedTransforms, capabilities.supportedCompositeAlpha,
+    pres_mode, VK_FALSE, VK_NULL_HANDLE
+  );
+
+  VkComponentMapping comp_map = dlu_set_component_mapping(VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_G, VK_COMPONENT_SWIZZLE_B, VK_COMPONENT_SWIZZLE_A);
+  VkImageSubresourceRange img_sub_rr = dlu_set_image_sub_resource_range(VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1);
+  VkImageViewCreateInfo img_view_info = dlu_set_image_view_info(0, VK_NULL_HANDLE, VK_IMAGE_VIEW_TYPE_2D, surface_fmt.format, comp_map, img_sub_rr);
+
+  err = dlu_create_swap_chain(app, cur_ld, cur_scd, &swapchain_info, &img_view_info);
+  check_err(err, app, wc, NULL)
+
+  /* One frame queued at most, every frame after the first waits on the one before it */
+  dlu_set_present_policy(app, cur_scd, DLU_PRESENT_LOW_LATENCY_NO_TEAR, 1);
+
+  /* Command buffers are recorded again after the resize, let vkBeginCommandBuffer reset them */
+  err = dlu_create_cmd_pool(app, cur_ld, cur_scd, cur_pool, app->pd_data[cur_pd].gfam_idx, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+  check_err(err, app, wc, NULL)
+
+  err = dlu_create_cmd_buffs(app, cur_pool, cur_scd, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+  check_err(err, app, wc, NULL)
+
+  err = dlu_create_syncs(app, cur_scd);
+  check_err(err, app, wc, NULL)
+
+  VkAttachmentDescription color_attachment = dlu_set_attachment_desc(surface_fmt.format,
+    VK_SAMPLE_COUNT_1_BIT, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE,
+    VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_DONT_CARE, VK_IMAGE_LAYOUT_UNDEFINED,
+    VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
+  );
+
+  VkAttachmentReference color_attachment_ref = dlu_set_attachment_ref(0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+  VkSubpassDescription subpass = dlu_set_subpass_desc(0, VK_PIPELINE_BIND_POINT_GRAPHICS, 0, NULL, 1, &color_attachment_ref, NULL, NULL, 0, NULL);
+
+  VkSubpassDependency subdep = dlu_set_subpass_dep(VK_SUBPASS_EXTERNAL, 0,
+    VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+    0, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, 0
+  );
+
+  err = dlu_create_render_pass(app, cur_gpd, 1, &color_attachment, 1, &subpass, 1, &subdep, 0);
+  check_err(err, app, wc, NULL)
+
+  VkImageView vkimg_attach[1];
+  err = dlu_create_framebuffers(app, cur_scd, cur_gpd, 1, vkimg_attach, extent2D.width, extent2D.height, 1);
+  check_err(err, app, wc, NULL)
+
+  err = record_clear(app, cur_pool, cur_scd, cur_gpd);
+  check_err(err, app, wc, NULL)
+
+  for (uint32_t frame = 0; frame < FRAMES; frame++) {
+    err = draw_frame(app, cur_ld, cur_pool, cur_scd);
+    check_err(err, app, wc, NULL)
+  }
+
+  check_err(!app->sc_data[cur_scd].submitted, app, wc, NULL)
+  check_err(app->ld_data[cur_ld].present_wait && !app->sc_data[cur_scd].present_id, app, wc, NULL)
+
+  /* Resize while the last frame may still be in flight, like a compositor configure would */
+  swapchain_info.imageExtent = dlu_choose_swap_extent(capabilities, WIDTH / 2, HEIGHT / 2);
+
+  err = dlu_recreate_swap_chain(app, cur_scd, &swapchain_info, &img_view_info, NULL);
+  check_err(err, app, wc, NULL)
+
+  /* Ids and queued frames belonged to the old swapchain */
+  check_err(app->sc_data[cur_scd].present_id || app->sc_data[cur_scd].submitted, app, wc, NULL)
+
+  /* The last frame's command buffer can't be recorded again before it's done */
+  err = dlu_vk_sync(DLU_VK_WAIT_RENDER_FENCE, app, cur_scd, 0);
+  check_err(err, app, wc, NULL)
+
+  err = record_clear(app, cur_pool, cur_scd, cur_gpd);
+  check_err(err, app, wc, NULL)
+
+  /* The first paced frame on the new swapchain must not wait on an id it never presented */
+  for (uint32_t frame = 0; frame < FRAMES; frame++) {
+    err = draw_frame(app, cur_ld, cur_pool, cur_scd);
+    check_err(err, app, wc, NULL)
+  }
+
+  dlu_vk_sync(DLU_VK_WAIT_RENDER_FENCE, app, cur_scd, 0);
+  FREEME(app, wc)
+} END_TEST;
+
+Suite *main_suite(void) {
+  Suite *s = NULL;
+  TCase *tc_core = NULL;
+
+  s = suite_create("TestSwapchain");
+
+  /* Core test case */
+  tc_core = tcase_create("Core");
+
+  tcase_add_test(tc_core, test_vulkan_recreate_then_pace);
+  suite_add_tcase(s, tc_core);
+
+  return s;
+}
+
+int main (void) {
+  int number_failed;
+  SRunner *sr = NULL;
+
+  sr = srunner_create(main_suite());
+
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  sr = NULL;
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,199 @@
+/**
+* The MIT License (MIT)
+*
+* Copyright (c) 2019-2020 Vincent Davis Jr.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*/
+
+#include <check.h>
+
+#define LUCUR_VKCOMP_API
+#include <lucom.h>
+
+#include "wayland/client.h"
+#include "test-extras.h"
+
+#define WIDTH 64
+#define HEIGHT 64
+
+static dlu_otma_mems ma = {
+  .vkcomp_cnt = 1, .scd_cnt = 2, .ld_cnt = 1, .pd_cnt = 1
+};
+
+static bool init_buffs(vkcomp *app) {
+  bool err;
+
+  err = dlu_otba(DLU_PD_DATA, app, INDEX_IGNORE, ma.pd_cnt);
+  if (!err) return err;
+
+  err = dlu_otba(DLU_LD_DATA, app, INDEX_IGNORE, ma.ld_cnt);
+  if (!err) return err;
+
+  err = dlu_otba(DLU_SC_DATA, app, INDEX_IGNORE, ma.scd_cnt);
+  if (!err) return err;
+
+  return err;
+}
+
+/* Whether the device has a lazily allocated memory type at all */
+static bool has_lazy_memory(vkcomp *app, uint32_t cur_pd) {
+  VkPhysicalDeviceMemoryProperties props;
+  vkGetPhysicalDeviceMemoryProperties(app->pd_data[cur_pd].phys_dev, &props);
+
+  for (uint32_t i = 0; i < props.memoryTypeCount; i++)
+    if (props.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)
+      return true;
+
+  return false;
+}
+
+START_TEST(test_vulkan_transient_attachments) {
+  VkResult err;
+
+  if (!dlu_otma(DLU_LARGE_BLOCK_PRIV, ma)) ck_abort_msg(NULL);
+
+  vkcomp *app = dlu_init_vk();
+  check_err(!app, NULL, NULL, NULL)
+
+  err = init_buffs(app);
+  check_err(!err, app, NULL, NULL)
+
+  err = dlu_create_instance(app, "Transient", "No Engine", 0, NULL, 0, NULL);
+  check_err(err, app, NULL, NULL)
+
+  VkPhysicalDeviceProperties device_props;
+  VkPhysicalDeviceFeatures device_feats;
+  uint32_t cur_pd = 0, cur_ld = 0;
+
+  dlu_pd_criteria criteria = {};
+  criteria.type = VK_PHYSICAL_DEVICE_TYPE_MAX_ENUM;
+  err = dlu_select_physical_device(app, cur_pd, &criteria, &device_props, &device_feats);
+  check_err(err, app, NULL, NULL)
+
+  err = dlu_create_queue_families(app, cur_pd, VK_QUEUE_GRAPHICS_BIT);
+  check_err(err, app, NULL, NULL)
+
+  float queue_priorities[1] = {1.0};
+  VkDeviceQueueCreateInfo dqueue_create_info[1];
+  dqueue_create_info[0] = dlu_set_device_queue_info(0, app->pd_data[cur_pd].gfam_idx, 1, queue_priorities);
+
+  err = dlu_create_logical_device(app, cur_pd, cur_ld, 0, ARR_LEN(dqueue_create_info), dqueue_create_info, &device_feats, 0, NULL);
+  check_err(err, app, NULL, NULL)
+
+  VkExtent2D extent2D = {WIDTH, HEIGHT};
+  VkExtent3D extent = dlu_set_extent3D(WIDTH, HEIGHT, 1);
+  VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+  VkFormat depth_format = VK_FORMAT_D16_UNORM;
+
+  /* Headless targets only stand in for a swapchain, one for each case */
+  for (uint32_t cur_scd = 0; cur_scd < ma.scd_cnt; cur_scd++) {
+    err = dlu_otba(DLU_SC_DATA_MEMS, app, cur_scd, 1);
+    check_err(!err, app, NULL, NULL)
+
+    err = dlu_create_headless_target(app, cur_ld, cur_scd, format, extent2D, 1, 0);
+    check_err(err, app, NULL, NULL)
+  }
+
+  VkComponentMapping comps = dlu_set_component_mapping(VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY,
+                                                       VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY);
+
+  VkImageSubresourceRange color_range = {};
+  color_range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  color_range.levelCount = 1;
+  color_range.layerCount = 1;
+
+  VkImageSubresourceRange depth_range = color_range;
+  depth_range.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+
+  /* Depth lives for the whole frame, the two effect targets never at the same time */
+  VkImageCreateInfo img_infos[3];
+  VkImageViewCreateInfo ivis[3];
+  const uint32_t alias_groups[3] = {0, 1, 1};
+
+  img_infos[0] = dlu_set_image_info(0, VK_IMAGE_TYPE_2D, depth_format, extent, 1, 1, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_TILING_OPTIMAL,
+                                    VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_SHARING_MODE_EXCLUSIVE, 0, NULL, VK_IMAGE_LAYOUT_UNDEFINED);
+  ivis[0] = dlu_set_image_view_info(0, VK_NULL_HANDLE, VK_IMAGE_VIEW_TYPE_2D, depth_format, comps, depth_range);
+
+  for (uint32_t i = 1; i < 3; i++) {
+    img_infos[i] = dlu_set_image_info(0, VK_IMAGE_TYPE_2D, format, extent, 1, 1, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_TILING_OPTIMAL,
+                                      VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT,
+                                      VK_SHARING_MODE_EXCLUSIVE, 0, NULL, VK_IMAGE_LAYOUT_UNDEFINED);
+    ivis[i] = dlu_set_image_view_info(0, VK_NULL_HANDLE, VK_IMAGE_VIEW_TYPE_2D, format, comps, color_range);
+  }
+
+  err = dlu_create_transient_attachments(app, 0, ARR_LEN(img_infos), img_infos, ivis, alias_groups);
+  check_err(err, app, NULL, NULL)
+
+  struct _sc_data *sc = &app->sc_data[0];
+  check_err(sc->tac != 3 || !sc->trans_mem, app, NULL, NULL)
+
+  /* One allocation, aliased targets share an offset, the depth buffer has its own */
+  check_err(sc->trans[1].offset != sc->trans[2].offset, app, NULL, NULL)
+  check_err(sc->trans[0].offset == sc->trans[1].offset, app, NULL, NULL)
+  check_err(sc->trans[1].alias != 1 || sc->trans[2].alias != 1, app, NULL, NULL)
+
+  /* Attachment only, so every image is transient and lazy memory is used when there is any */
+  for (uint32_t i = 0; i < sc->tac; i++)
+    check_err(!(sc->trans[i].img_info.usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT), app, NULL, NULL)
+  check_err(sc->trans_lazy && !has_lazy_memory(app, cur_pd), app, NULL, NULL)
+
+  /* Sampled after the pass, neither transient nor lazily allocated */
+  img_infos[0] = dlu_set_image_info(0, VK_IMAGE_TYPE_2D, format, extent, 1, 1, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_TILING_OPTIMAL,
+                                    VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                                    VK_SHARING_MODE_EXCLUSIVE, 0, NULL, VK_IMAGE_LAYOUT_UNDEFINED);
+  ivis[0] = dlu_set_image_view_info(0, VK_NULL_HANDLE, VK_IMAGE_VIEW_TYPE_2D, format, comps, color_range);
+
+  err = dlu_create_transient_attachments(app, 1, 1, img_infos, ivis, NULL);
+  check_err(err, app, NULL, NULL)
+
+  sc = &app->sc_data[1];
+  check_err(sc->trans_lazy, app, NULL, NULL)
+  check_err(sc->trans[0].img_info.usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT, app, NULL, NULL)
+
+  FREEME(app, NULL)
+} END_TEST;
+
+Suite *main_suite(void) {
+  Suite *s = NULL;
+  TCase *tc_core = NULL;
+
+  s = suite_create("TestTransient");
+
+  /* Core test case */
+  tc_core = tcase_create("Core");
+
+  tcase_add_test(tc_core, test_vulkan_transient_attachments);
+  suite_add_tcase(s, tc_core);
+
+  return s;
+}
+
+int main (void) {
+  int number_failed;
+  SRunner *sr = NULL;
+
+  sr = srunner_create(main_suite());
+
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  sr = NULL;
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -377,7 +377,7 @@ START_TEST(test_vulkan_client_create) {
   err = dlu_queue_graphics_queue(app, cur_scd, 0, 1, cmd_buffs, 1, acquire_sems, pipe_stage_flags, 1, render_sems);
   check_err(err, app, wc, NULL)
 
-  err = dlu_queue_present_queue(app, cur_ld, 1, render_sems, 1, &app->sc_data[cur_scd].swap_chain, &cur_buff, NULL);
+  err = dlu_queue_present_queue(app, cur_ld, 1, render_sems, 1, &app->sc_data[cur_scd].swap_chain, &cur_img, NULL);
   check_err(err, app, wc, NULL)
 
   sleep(1);